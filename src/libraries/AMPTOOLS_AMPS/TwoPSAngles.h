@@ -4,6 +4,7 @@
 #include "IUAmpTools/Amplitude.h"
 #include "IUAmpTools/UserAmplitude.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/wignerD.h"
 
 #include <string>
 #include <complex>
@@ -39,7 +40,26 @@ public:
 	
 	string name() const { return "TwoPSAngles"; }
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+	enum UserVars { kCosTheta = 0, kPhi, kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+
+	// the decay angles only depend on the kinematics
+	bool areUserVarsStatic() const { return true; }
+
+	// evaluates a block of events directly from the userVars array,
+	// without the per-event overhead of the default implementation
+	void calcAmplitudeAll( GDouble* pdData, GDouble* pdAmps, int iNEvents,
+	                       const vector< vector< int > >* pvPermutations,
+	                       GDouble* pdUserVars ) const;
+
+#ifndef GPU_ACCELERATION
+	// the GPU kernel works from the four-vectors, elsewhere they can be
+	// dropped once the angles are computed
+	bool needsUserVarsOnly() const { return true; }
+#endif // GPU_ACCELERATION
 	
 #ifdef GPU_ACCELERATION
   
@@ -57,6 +77,11 @@ private:
 	
 	GDouble m_bigTheta;
 	int m_reflectivityFactor;
+
+	// d^j_{m0} and d^j_{-m,0} as functions of cos(theta)
+	GDouble m_coef;
+	WignerDPoly m_dPlus;
+	WignerDPoly m_dMinus;
 };
 
 #endif
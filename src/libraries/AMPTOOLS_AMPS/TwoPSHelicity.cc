@@ -32,11 +32,15 @@ UserAmplitude< TwoPSHelicity >( args )
   
 	// the "reflectivity factor" is e*(-1)^(m)
 	m_reflectivityFactor = ( m_m % 2 == 0 ? m_e : -m_e );
+
+  m_coef = sqrt( ( 2. * m_j + 1 ) / ( 4 * 3.1416 ) );
+  m_dPlus = WignerDPoly( m_j, m_m );
+  m_dMinus = WignerDPoly( m_j, -m_m );
 }
 
 
-complex< GDouble >
-TwoPSHelicity::calcAmplitude( GDouble** pKin ) const {
+void
+TwoPSHelicity::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   
   TLorentzVector beam   ( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] ); 
   TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] ); 
@@ -63,15 +67,50 @@ TwoPSHelicity::calcAmplitude( GDouble** pKin ) const {
                    (p1_res.Vect()).Dot(y),
                    (p1_res.Vect()).Dot(z) );
   
-  GDouble cosTheta = angles.CosTheta();
-  GDouble phi = angles.Phi();
-  
-  GDouble coef = sqrt( ( 2. * m_j + 1 ) / ( 4 * 3.1416 ) );
-  
-  return complex< GDouble >( coef * m_bigTheta * 
-                            ( wignerD( m_j, m_m, 0, cosTheta, phi ) - 
-                             static_cast< GDouble>( m_reflectivityFactor ) * 
-                             wignerD( m_j, -m_m, 0, cosTheta, phi ) ) );  
+  userVars[kCosTheta] = angles.CosTheta();
+  userVars[kPhi] = angles.Phi();
+}
+
+
+complex< GDouble >
+TwoPSHelicity::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+
+  GDouble cosTheta = userVars[kCosTheta];
+  GDouble phi = userVars[kPhi];
+
+  // wignerD( j, m, 0 ) - r * wignerD( j, -m, 0 ), with
+  // wignerD( j, m, 0 ) = d^j_{m0}( theta ) * exp( -i m phi )
+  GDouble dPlus = m_dPlus( cosTheta );
+  GDouble dMinus = static_cast< GDouble>( m_reflectivityFactor ) *
+                   m_dMinus( cosTheta );
+
+  return complex< GDouble >( m_coef * m_bigTheta * ( dPlus - dMinus ) *
+                             cos( m_m * phi ),
+                             -m_coef * m_bigTheta * ( dPlus + dMinus ) *
+                             sin( m_m * phi ) );
+}
+
+void
+TwoPSHelicity::calcAmplitudeAll( GDouble* pdData, GDouble* pdAmps, int iNEvents,
+                                 const vector< vector< int > >* pvPermutations,
+                                 GDouble* pdUserVars ) const {
+
+  // same layout of the amplitude and user data arrays as in
+  // Amplitude::calcAmplitudeAll, events are contiguous for each permutation
+  int iNPermutations = pvPermutations->size();
+  for( int iPermutation = 0; iPermutation < iNPermutations; ++iPermutation ){
+
+    GDouble* userVars = &(pdUserVars[iNEvents*iPermutation*kNumUserVars]);
+    GDouble* amps = &(pdAmps[2*iNEvents*iPermutation]);
+
+    for( int iEvent = 0; iEvent < iNEvents; ++iEvent ){
+
+      complex< GDouble > amp =
+        TwoPSHelicity::calcAmplitude( NULL, &(userVars[iEvent*kNumUserVars]) );
+      amps[2*iEvent] = amp.real();
+      amps[2*iEvent+1] = amp.imag();
+    }
+  }
 }
 
 #ifdef GPU_ACCELERATION
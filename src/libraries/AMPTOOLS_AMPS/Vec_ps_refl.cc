@@ -64,7 +64,12 @@ UserAmplitude< Vec_ps_refl >( args )
   // m_s = +1 for 1 + Pgamma
   // m_s = -1 for 1 - Pgamma
   assert( abs( m_s ) == 1 );
-  
+
+  for (int lambda = -1; lambda <= 1; lambda++) {
+	  m_helAmp[lambda+1] = clebschGordan(m_l, 1, 0, lambda, m_j, lambda);
+	  m_dProd[lambda+1] = WignerDPoly(m_j, m_m, lambda);
+	  m_dVec[lambda+1] = WignerDPoly(1, lambda);
+  }
 }
 
 void
@@ -172,8 +177,13 @@ Vec_ps_refl::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
   complex <GDouble> i(0,1);
 
   for (int lambda = -1; lambda <= 1; lambda++) { // sum over vector helicity
-	  GDouble hel_amp = clebschGordan(m_l, 1, 0, lambda, m_j, lambda);
-	  amplitude += conj(wignerD( m_j, m_m, lambda, cosTheta, Phi )) * hel_amp * conj(wignerD( 1, lambda, 0, cosThetaH, PhiH )) * G;
+	  // conj(wignerD( 1, lambda, 0, cosThetaH, PhiH )) = d^1_{lambda,0} * exp(i lambda PhiH)
+	  GDouble dVec = m_dVec[lambda+1](cosThetaH);
+	  complex <GDouble> vecDecay(dVec * cos(lambda*PhiH), dVec * sin(lambda*PhiH));
+	  // conj(wignerD( m_j, m_m, lambda, cosTheta, Phi )) = d^j_{m,lambda} * exp(i m Phi)
+	  GDouble dProd = m_dProd[lambda+1](cosTheta);
+	  complex <GDouble> prod(dProd * cos(m_m*Phi), dProd * sin(m_m*Phi));
+	  amplitude += prod * m_helAmp[lambda+1] * vecDecay * G;
   } 
 
   GDouble Factor = sqrt(1 + m_s * polFraction);
@@ -192,6 +202,28 @@ Vec_ps_refl::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
   return complex< GDouble >( static_cast< GDouble>( Factor ) * zjm );
 }
 
+void
+Vec_ps_refl::calcAmplitudeAll( GDouble* pdData, GDouble* pdAmps, int iNEvents,
+                               const vector< vector< int > >* pvPermutations,
+                               GDouble* pdUserVars ) const
+{
+  // same layout of the amplitude and user data arrays as in
+  // Amplitude::calcAmplitudeAll, events are contiguous for each permutation
+  int iNPermutations = pvPermutations->size();
+  for (int iPermutation = 0; iPermutation < iNPermutations; ++iPermutation) {
+
+	  GDouble* userVars = &(pdUserVars[iNEvents*iPermutation*kNumUserVars]);
+	  GDouble* amps = &(pdAmps[2*iNEvents*iPermutation]);
+
+	  for (int iEvent = 0; iEvent < iNEvents; ++iEvent) {
+		  complex< GDouble > amp =
+			  Vec_ps_refl::calcAmplitude( NULL, &(userVars[iEvent*kNumUserVars]) );
+		  amps[2*iEvent] = amp.real();
+		  amps[2*iEvent+1] = amp.imag();
+	  }
+  }
+}
+
 
 void Vec_ps_refl::updatePar( const AmpParameter& par ){
 
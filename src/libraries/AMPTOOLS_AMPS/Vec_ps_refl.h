@@ -5,6 +5,7 @@
 #include "IUAmpTools/UserAmplitude.h"
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/wignerD.h"
 
 #include "TH1D.h"
 #include <string>
@@ -69,6 +70,12 @@ public:
 	// depend on kinematics and no arguments provided to the amplitude!
 	bool areUserVarsStatic() const { return true; }
 
+	// evaluates a block of events directly from the userVars array,
+	// without the per-event overhead of the default implementation
+	void calcAmplitudeAll( GDouble* pdData, GDouble* pdAmps, int iNEvents,
+	                       const vector< vector< int > >* pvPermutations,
+	                       GDouble* pdUserVars ) const;
+
 	void updatePar( const AmpParameter& par );
 
 #ifdef GPU_ACCELERATION
@@ -97,6 +104,13 @@ private:
 	
 	double polFraction;
 	TH1D *polFrac_vs_E;
+
+	// Clebsch-Gordan coefficient, production d^j_{m,lambda}(theta) and
+	// vector decay d^1_{lambda,0}(thetaH) for each vector helicity
+	// lambda = -1, 0, 1
+	GDouble m_helAmp[3];
+	WignerDPoly m_dProd[3];
+	WignerDPoly m_dVec[3];
 };
 
 #endif
@@ -57,26 +57,68 @@ Zlm::Zlm( const vector< string >& args ) :
    // m_s = +1 for 1 + Pgamma
    // m_s = -1 for 1 - Pgamma
    assert( abs( m_s ) == 1 );
+
+   m_ylmNorm = sqrt( ( 2*m_j + 1 ) / ( 4*PI ) );
+   m_dm0 = WignerDPoly( m_j, m_m );
 }
 
 
+// Re or Im of Y(j,m) * exp(-i bigPhi), with Y = norm * d^j_{m0}(theta) * exp(i m phi)
+inline GDouble
+Zlm::zlm( const GDouble* userVars ) const {
+
+   // cos and sin of m*phi by rotating |m| times through phi
+   GDouble cosPhi = userVars[kCosPhi];
+   GDouble sinPhi = userVars[kSinPhi];
+   GDouble cosMPhi = 1;
+   GDouble sinMPhi = 0;
+   for( int i = 0; i < abs( m_m ); ++i ){
+
+      GDouble c = cosMPhi * cosPhi - sinMPhi * sinPhi;
+      sinMPhi = sinMPhi * cosPhi + cosMPhi * sinPhi;
+      cosMPhi = c;
+   }
+   if( m_m < 0 ) sinMPhi = -sinMPhi;
+
+   GDouble cosBigPhi = userVars[kCosBigPhi];
+   GDouble sinBigPhi = userVars[kSinBigPhi];
+   GDouble trig = ( m_r == 1 ?
+      cosMPhi * cosBigPhi + sinMPhi * sinBigPhi :
+      sinMPhi * cosBigPhi - cosMPhi * sinBigPhi );
+
+   return m_ylmNorm * m_dm0( userVars[kCosTheta] ) * trig;
+}
+
 complex< GDouble >
 Zlm::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
 
    GDouble pGamma = userVars[kPgamma];
-   GDouble cosTheta = userVars[kCosTheta];
-   GDouble phi = userVars[kPhi];
-   GDouble bigPhi = userVars[kBigPhi];
-
    GDouble factor = sqrt(1 + m_s * pGamma);
-   GDouble zlm = 0;
-   complex< GDouble > rotateY = polar(1., -1.*bigPhi);
-   if (m_r == 1)
-      zlm = real(Y( m_j, m_m, cosTheta, phi ) * rotateY);
-   if (m_r == -1)
-      zlm = imag(Y( m_j, m_m, cosTheta, phi ) * rotateY);
-
-   return complex< GDouble >( factor * zlm );
+
+   return complex< GDouble >( factor * zlm( userVars ) );
+}
+
+void
+Zlm::calcAmplitudeAll( GDouble* pdData, GDouble* pdAmps, int iNEvents,
+      const vector< vector< int > >* pvPermutations,
+      GDouble* pdUserVars ) const {
+
+   // same layout of the amplitude and user data arrays as in
+   // Amplitude::calcAmplitudeAll, events are contiguous for each permutation
+   int iNPermutations = pvPermutations->size();
+   for( int iPermutation = 0; iPermutation < iNPermutations; ++iPermutation ){
+
+      GDouble* userVars = &(pdUserVars[iNEvents*iPermutation*kNumUserVars]);
+      GDouble* amps = &(pdAmps[2*iNEvents*iPermutation]);
+
+      for( int iEvent = 0; iEvent < iNEvents; ++iEvent ){
+
+         const GDouble* eventVars = &(userVars[iEvent*kNumUserVars]);
+         GDouble factor = sqrt(1 + m_s * eventVars[kPgamma]);
+         amps[2*iEvent] = factor * zlm( eventVars );
+         amps[2*iEvent+1] = 0;
+      }
+   }
 }
 
 void
@@ -123,6 +165,11 @@ Zlm::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 
    userVars[kBigPhi] = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
 
+   userVars[kCosPhi] = cos(userVars[kPhi]);
+   userVars[kSinPhi] = sin(userVars[kPhi]);
+   userVars[kCosBigPhi] = cos(userVars[kBigPhi]);
+   userVars[kSinBigPhi] = sin(userVars[kBigPhi]);
+
 
    GDouble pGamma;
    if(m_polInTree) {
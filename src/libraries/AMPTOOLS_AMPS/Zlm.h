@@ -5,6 +5,7 @@
 #include "IUAmpTools/UserAmplitude.h"
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/wignerD.h"
 
 #include "TH1D.h"
 #include <string>
@@ -39,7 +40,10 @@ class Zlm : public UserAmplitude< Zlm >
       Zlm() : UserAmplitude< Zlm >() { };
       Zlm( const vector< string >& args );
 
-      enum UserVars { kPgamma = 0, kCosTheta, kPhi, kBigPhi, kNumUserVars };
+      // the cosines and sines of phi and bigPhi are kept too, so that an
+      // amplitude can get those of m*phi - bigPhi without calling cos/sin
+      enum UserVars { kPgamma = 0, kCosTheta, kPhi, kBigPhi,
+         kCosPhi, kSinPhi, kCosBigPhi, kSinBigPhi, kNumUserVars };
       unsigned int numUserVars() const { return kNumUserVars; }
 
       string name() const { return "Zlm"; }
@@ -47,6 +51,13 @@ class Zlm : public UserAmplitude< Zlm >
       complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
       void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
 
+      // evaluates a block of events directly from the userVars array,
+      // without the per-event overhead of the default implementation;
+      // validation/Zlm_benchmark.cc times it against the old code
+      void calcAmplitudeAll( GDouble* pdData, GDouble* pdAmps, int iNEvents,
+            const vector< vector< int > >* pvPermutations,
+            GDouble* pdUserVars ) const;
+
       // we can calcualte everything we need from userVars block so allow
       // the framework to purge the four-vectors
       bool needsUserVarsOnly() const { return true; }
@@ -64,6 +75,8 @@ class Zlm : public UserAmplitude< Zlm >
 
    private:
 
+      GDouble zlm( const GDouble* userVars ) const;
+
       int m_j;
       int m_m;
       int m_r;
@@ -74,6 +87,10 @@ class Zlm : public UserAmplitude< Zlm >
       bool m_polInTree;
 
       TH1D* m_polFrac_vs_E;
+
+      // angular part of Y(j,m) = m_ylmNorm * m_dm0(cosTheta) * exp(i m phi)
+      GDouble m_ylmNorm;
+      WignerDPoly m_dm0;
 };
 
 #endif
@@ -2,6 +2,8 @@
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 
 #include <math.h>
+#include <stdlib.h>
+#include <vector>
 
 /* Name: s3j
 **       Evaluates 3j symbol
@@ -165,7 +167,7 @@ double s3j(double j1, double j2, double j3,
 }
 
 
-double clebschGordan(int ij1, int ij2, int im1, int im2, int ij, int im) {
+static double clebschGordanCalc(int ij1, int ij2, int im1, int im2, int ij, int im) {
 	
 	int esp;
 	double cgris;
@@ -191,3 +193,45 @@ double clebschGordan(int ij1, int ij2, int im1, int im2, int ij, int im) {
 }
 
 
+/* Coefficients for all j1, j2, j <= CG_MAX_J, worked out once the first
+** time one is needed (initialization of the static is thread safe).
+** Amplitudes call clebschGordan with the same few arguments for every
+** event, this saves evaluating the 3j sum each time. */
+
+#define CG_MAX_J	4
+#define CG_NJ		(CG_MAX_J+1)
+#define CG_NM		(2*CG_MAX_J+1)
+
+static int cgIndex(int j1, int j2, int m1, int m2, int j) {
+	
+	return (((j1*CG_NJ + j2)*CG_NJ + j)*CG_NM + m1+CG_MAX_J)*CG_NM + m2+CG_MAX_J;
+}
+
+static const std::vector<double>& cgTable() {
+	
+	static const std::vector<double> table = []() {
+		
+		std::vector<double> t(CG_NJ*CG_NJ*CG_NJ*CG_NM*CG_NM, 0.0);
+		for (int j1=0; j1<=CG_MAX_J; ++j1)
+			for (int j2=0; j2<=CG_MAX_J; ++j2)
+				for (int j=0; j<=CG_MAX_J; ++j)
+					for (int m1=-j1; m1<=j1; ++m1)
+						for (int m2=-j2; m2<=j2; ++m2)
+							t[cgIndex(j1, j2, m1, m2, j)] =
+								clebschGordanCalc(j1, j2, m1, m2, j, m1+m2);
+		return t;
+	}();
+	
+	return table;
+}
+
+
+double clebschGordan(int ij1, int ij2, int im1, int im2, int ij, int im) {
+	
+	if (ij1 >= 0 && ij1 <= CG_MAX_J && ij2 >= 0 && ij2 <= CG_MAX_J &&
+	    ij >= 0 && ij <= CG_MAX_J && abs(im1) <= ij1 && abs(im2) <= ij2 &&
+	    im == im1+im2)
+		return cgTable()[cgIndex(ij1, ij2, im1, im2, ij)];
+	
+	return clebschGordanCalc(ij1, ij2, im1, im2, ij, im);
+}
@@ -0,0 +1,216 @@
+// Zlm_benchmark.cc
+//
+// Times the Zlm amplitudes and a likelihood built from them on one
+// core, old against new:
+//
+//  - old: Zlm::calcAmplitude as it was before calcAmplitudeAll was
+//    overridden, Y() and polar() for every event, called through the
+//    default Amplitude::calcAmplitudeAll
+//  - new: Zlm::calcAmplitudeAll, the WignerDPoly polynomial times
+//    cos or sin of (m phi - Phi), which it gets from the cosines and
+//    sines of phi and Phi that calcUserVars stores once per event
+//
+// The amplitudes are the usual set of a two-pseudoscalar fit: every
+// j <= JMAX and m, with r and s = +-1, on random angles. For each
+// version it prints the time per event of the amplitudes alone and of
+// a likelihood evaluation that computes them and sums -2 ln I, with I
+// the coherent sum over (j,m) in each of the four (r,s) sums, and
+// the largest difference between the two.
+//
+// In a fit the amplitudes of Zlm, which has no free parameters, are
+// computed once and cached by AmpTools, so only the first likelihood
+// evaluation of a fit sees the full speed-up; the later ones spend
+// their time in the intensity sum, which is the same for both.
+//
+// It is not part of the AMPTOOLS_AMPS build. From this directory:
+//
+//   g++ -O2 -I../.. -I$AMPTOOLS Zlm_benchmark.cc ../Zlm.cc ../wignerD.cc
+//       -L$AMPTOOLS/lib -lAmpTools `root-config --cflags --libs`
+//       -o Zlm_benchmark
+//   ./Zlm_benchmark [events, default 1000000] [JMAX, default 2]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <complex>
+
+#include "IUAmpTools/UserAmplitude.h"
+#include "AMPTOOLS_AMPS/Zlm.h"
+#include "AMPTOOLS_AMPS/wignerD.h"
+
+using namespace std;
+
+// Zlm::calcAmplitude before the block version, with the default
+// per-event Amplitude::calcAmplitudeAll
+
+class ZlmOld : public UserAmplitude< ZlmOld >
+{
+
+   public:
+
+      ZlmOld() : UserAmplitude< ZlmOld >() { };
+      ZlmOld( const vector< string >& args ) : UserAmplitude< ZlmOld >( args ) {
+
+         m_j = atoi( args[0].c_str() );
+         m_m = atoi( args[1].c_str() );
+         m_r = atoi( args[2].c_str() );
+         m_s = atoi( args[3].c_str() );
+      }
+
+      unsigned int numUserVars() const { return Zlm::kNumUserVars; }
+      string name() const { return "ZlmOld"; }
+      bool needsUserVarsOnly() const { return true; }
+      bool areUserVarsStatic() const { return true; }
+
+      complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+
+         GDouble pGamma = userVars[Zlm::kPgamma];
+         GDouble cosTheta = userVars[Zlm::kCosTheta];
+         GDouble phi = userVars[Zlm::kPhi];
+         GDouble bigPhi = userVars[Zlm::kBigPhi];
+
+         GDouble factor = sqrt(1 + m_s * pGamma);
+         GDouble zlm = 0;
+         complex< GDouble > rotateY = polar(1., -1.*bigPhi);
+         if (m_r == 1)
+            zlm = real(Y( m_j, m_m, cosTheta, phi ) * rotateY);
+         if (m_r == -1)
+            zlm = imag(Y( m_j, m_m, cosTheta, phi ) * rotateY);
+
+         return complex< GDouble >( factor * zlm );
+      }
+
+   private:
+
+      int m_j;
+      int m_m;
+      int m_r;
+      int m_s;
+};
+
+static double seconds( clock_t start ){
+
+   return ( clock() - start ) / (double)CLOCKS_PER_SEC;
+}
+
+// amplitudes of every wave, then -2 ln L with the coherent sum over
+// the waves in each of the four (r,s) sums
+template< class AMP >
+static double likelihood( const vector< AMP* >& amps,
+      const vector< int >& sums, const vector< complex< GDouble > >& prod,
+      GDouble* pdData, GDouble* pdUserVars, int nEvents,
+      vector< GDouble >& pdAmps, double& tAmps ){
+
+   vector< vector< int > > perms( 1, vector< int >( 4 ) );
+   for( int i = 0; i < 4; ++i ) perms[0][i] = i;
+
+   clock_t start = clock();
+   for( size_t i = 0; i < amps.size(); ++i ){
+
+      amps[i]->calcAmplitudeAll( pdData, &pdAmps[2*nEvents*i], nEvents,
+            &perms, pdUserVars );
+   }
+   tAmps = seconds( start );
+
+   double lnL = 0;
+   vector< complex< GDouble > > sum( 4 );
+   for( int iEvent = 0; iEvent < nEvents; ++iEvent ){
+
+      for( int k = 0; k < 4; ++k ) sum[k] = 0;
+      for( size_t i = 0; i < amps.size(); ++i ){
+
+         const GDouble* a = &pdAmps[2*nEvents*i + 2*iEvent];
+         sum[sums[i]] += prod[i] * complex< GDouble >( a[0], a[1] );
+      }
+      double intensity = 0;
+      for( int k = 0; k < 4; ++k ) intensity += norm( sum[k] );
+      lnL += log( intensity );
+   }
+   return -2 * lnL;
+}
+
+int main( int argc, char* argv[] ){
+
+   int nEvents = ( argc > 1 ? atoi( argv[1] ) : 1000000 );
+   int jMax = ( argc > 2 ? atoi( argv[2] ) : 2 );
+
+   vector< Zlm* > ampsNew;
+   vector< ZlmOld* > ampsOld;
+   vector< int > sums;
+   vector< complex< GDouble > > prod;
+   srand48( 12345 );
+   for( int r = -1; r <= 1; r += 2 ){
+      for( int s = -1; s <= 1; s += 2 ){
+         for( int j = 0; j <= jMax; ++j ){
+            for( int m = -j; m <= j; ++m ){
+
+               vector< string > args;
+               ostringstream js, ms, rs, ss;
+               js << j; ms << m; rs << r; ss << s;
+               args.push_back( js.str() );
+               args.push_back( ms.str() );
+               args.push_back( rs.str() );
+               args.push_back( ss.str() );
+               args.push_back( "0" );
+               args.push_back( "0.35" );
+               ampsNew.push_back( new Zlm( args ) );
+               ampsOld.push_back( new ZlmOld( args ) );
+               sums.push_back( ( r + 1 ) + ( s + 1 ) / 2 );
+               prod.push_back( complex< GDouble >( drand48(), drand48() ) );
+            }
+         }
+      }
+   }
+
+   // four particles of four-vectors per event, only there for the
+   // default calcAmplitudeAll to point at
+   vector< GDouble > data( 16 * (size_t)nEvents, 1. );
+   vector< GDouble > userVars( Zlm::kNumUserVars * (size_t)nEvents );
+   for( int iEvent = 0; iEvent < nEvents; ++iEvent ){
+
+      GDouble* uv = &userVars[Zlm::kNumUserVars * iEvent];
+      uv[Zlm::kPgamma] = 0.35;
+      uv[Zlm::kCosTheta] = 2 * drand48() - 1;
+      uv[Zlm::kPhi] = M_PI * ( 2 * drand48() - 1 );
+      uv[Zlm::kBigPhi] = M_PI * ( 2 * drand48() - 1 );
+      // filled by Zlm::calcUserVars once, when the data are read
+      uv[Zlm::kCosPhi] = cos( uv[Zlm::kPhi] );
+      uv[Zlm::kSinPhi] = sin( uv[Zlm::kPhi] );
+      uv[Zlm::kCosBigPhi] = cos( uv[Zlm::kBigPhi] );
+      uv[Zlm::kSinBigPhi] = sin( uv[Zlm::kBigPhi] );
+   }
+
+   size_t nAmps = ampsNew.size();
+   vector< GDouble > pdAmpsOld( 2 * (size_t)nEvents * nAmps );
+   vector< GDouble > pdAmpsNew( 2 * (size_t)nEvents * nAmps );
+
+   double tAmpsOld, tAmpsNew;
+   clock_t start = clock();
+   double lnLOld = likelihood( ampsOld, sums, prod, &data[0], &userVars[0],
+         nEvents, pdAmpsOld, tAmpsOld );
+   double tOld = seconds( start );
+   start = clock();
+   double lnLNew = likelihood( ampsNew, sums, prod, &data[0], &userVars[0],
+         nEvents, pdAmpsNew, tAmpsNew );
+   double tNew = seconds( start );
+
+   double maxDiff = 0;
+   for( size_t i = 0; i < pdAmpsOld.size(); ++i )
+      maxDiff = max( maxDiff, (double)fabs( pdAmpsOld[i] - pdAmpsNew[i] ) );
+
+   printf( "%d events, %d Zlm amplitudes (j <= %d)\n",
+         nEvents, (int)nAmps, jMax );
+   printf( "amplitudes: old %.1f ns/event  new %.1f ns/event  x%.2f\n",
+         1e9 * tAmpsOld / nEvents, 1e9 * tAmpsNew / nEvents,
+         tAmpsOld / tAmpsNew );
+   printf( "likelihood: old %.1f ns/event  new %.1f ns/event  x%.2f\n",
+         1e9 * tOld / nEvents, 1e9 * tNew / nEvents, tOld / tNew );
+   printf( "largest amplitude difference %.2e, -2lnL old %.10g new %.10g\n",
+         maxDiff, lnLOld, lnLNew );
+
+   return 0;
+}
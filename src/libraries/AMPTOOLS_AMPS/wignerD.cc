@@ -1,6 +1,8 @@
 
 #include "AMPTOOLS_AMPS/wignerD.h"
 #include <complex>
+#include <vector>
+#include <cstdlib>
 
 using namespace std;
 
@@ -18,7 +20,7 @@ wignerDSmall( GDouble aj, GDouble am, GDouble an, GDouble beta ){
   
 	double f = 8.72664625997164788e-3;    
   
-  double fcl[51] = { 0 , 0 ,
+  static const double fcl[51] = { 0 , 0 ,
 		6.93147180559945309e-1 ,1.79175946922805500e00,
 		3.17805383034794562e00 ,4.78749174278204599e00,
 		6.57925121201010100e00 ,8.52516136106541430e00,
@@ -100,12 +102,40 @@ wignerDSmall( GDouble aj, GDouble am, GDouble an, GDouble beta ){
 }
 
 
+// d-functions for all l <= WignerDPoly::kMaxTableL, built the first
+// time one is needed (initialization of the static is thread safe)
+static const vector< WignerDPoly >& wignerDTable(){
+
+  static const vector< WignerDPoly > table = [](){
+
+    const int lMax = WignerDPoly::kMaxTableL;
+    const int nm = 2 * lMax + 1;
+    vector< WignerDPoly > t( ( lMax + 1 ) * nm * nm );
+    for( int l = 0; l <= lMax; ++l )
+      for( int m = -l; m <= l; ++m )
+        for( int n = -l; n <= l; ++n )
+          t[ ( l * nm + m + lMax ) * nm + n + lMax ] = WignerDPoly( l, m, n );
+    return t;
+  }();
+
+  return table;
+}
+
 complex< GDouble > wignerD( int l, int m, int n, 
                            GDouble cosTheta, GDouble phi ){
 	
-    double dtheta = acos( cosTheta ) * 180.0 / PI;
-	
-    GDouble dpart = wignerDSmall( l, m, n, dtheta );
+    GDouble dpart;
+    if( l <= WignerDPoly::kMaxTableL && abs( m ) <= l && abs( n ) <= l ){
+
+      const int lMax = WignerDPoly::kMaxTableL;
+      const int nm = 2 * lMax + 1;
+      dpart = wignerDTable()[ ( l * nm + m + lMax ) * nm + n + lMax ]( cosTheta );
+    }
+    else{
+
+      double dtheta = acos( cosTheta ) * 180.0 / PI;
+      dpart = wignerDSmall( l, m, n, dtheta );
+    }
 	
     return complex< GDouble >( cos( -1.0 * m * phi ) * dpart, 
 							sin( -1.0 * m * phi ) * dpart );
@@ -117,3 +147,55 @@ complex< GDouble > Y( int l, int m, GDouble cosTheta, GDouble phi ){
   return ( (GDouble)sqrt( (2*l+1) / (4*PI) ) ) * 
           conj( wignerD( l, m, 0, cosTheta, phi ) );
 }
+
+static double factorial( int n ){
+
+  double f = 1;
+  for( int i = 2; i <= n; ++i ) f *= i;
+  return f;
+}
+
+static double binomial( int n, int k ){
+
+  return factorial( n ) / ( factorial( k ) * factorial( n - k ) );
+}
+
+WignerDPoly::WignerDPoly( int l, int m, int n ) :
+m_sinPow( abs( m - n ) ),
+m_cosPow( abs( m + n ) )
+{
+  if( abs( m ) > l || abs( n ) > l ) return;
+
+  // d^l_{mn} = xi sqrt( s! (s+a+b)! / ( (s+a)! (s+b)! ) )
+  //    sin^a(theta/2) cos^b(theta/2) P_s^(a,b)(cos(theta))
+  // with a = |m-n|, b = |m+n|, s = l - max(|m|,|n|), xi = 1 for n >= m
+  // and (-1)^(n-m) otherwise, and the Jacobi polynomial
+  // P_s^(a,b)(x) = sum_k C(s+a,s-k) C(s+b,k) ((x-1)/2)^k ((x+1)/2)^(s-k)
+  int a = m_sinPow;
+  int b = m_cosPow;
+  int s = l - ( abs( m ) > abs( n ) ? abs( m ) : abs( n ) );
+
+  double norm = sqrt( factorial( s ) * factorial( s + a + b ) /
+                      ( factorial( s + a ) * factorial( s + b ) ) );
+  if( n < m && ( m - n ) % 2 != 0 ) norm = -norm;
+
+  m_coef.assign( s + 1, 0 );
+  for( int k = 0; k <= s; ++k ){
+
+    // coefficients of ((x-1)/2)^k ((x+1)/2)^(s-k)
+    vector< double > term( 1, binomial( s + a, s - k ) * binomial( s + b, k ) * norm );
+    for( int i = 0; i < s; ++i ){
+
+      double sign = ( i < k ? -1 : 1 );
+      vector< double > next( term.size() + 1, 0 );
+      for( size_t j = 0; j < term.size(); ++j ){
+
+        next[j] += 0.5 * sign * term[j];
+        next[j+1] += 0.5 * term[j];
+      }
+      term = next;
+    }
+
+    for( int j = 0; j <= s; ++j ) m_coef[j] += term[j];
+  }
+}
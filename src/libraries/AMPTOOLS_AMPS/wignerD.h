@@ -2,6 +2,8 @@
 #define WIGNERD
 
 #include <complex>
+#include <vector>
+#include <cmath>
 
 #include "GPUManager/GPUCustomTypes.h"
 
@@ -11,4 +13,50 @@ GDouble wignerDSmall( GDouble aj, GDouble am, GDouble an, GDouble beta );
 complex< GDouble > wignerD( int l, int m, int n, GDouble cosTheta, GDouble phi );
 complex< GDouble > Y( int l, int m, GDouble cosTheta, GDouble phi );
 
+// d^l_{mn}(theta) written as sin^|m-n|(theta/2) cos^|m+n|(theta/2) times
+// a (Jacobi) polynomial in cos(theta).  The coefficients are worked out
+// once, so that evaluating it needs neither the acos nor the log/exp sum
+// of wignerDSmall.  wignerD() takes these from a table built on first
+// use for l <= kMaxTableL; amplitudes that only need a few d-functions
+// can also hold their own.
+
+class WignerDPoly {
+
+public:
+
+  enum { kMaxTableL = 8 };
+
+  WignerDPoly() : m_sinPow( 0 ), m_cosPow( 0 ) {}
+  WignerDPoly( int l, int m, int n = 0 );
+
+  GDouble operator()( GDouble cosTheta ) const {
+
+    GDouble halfPow = 1;
+    if( m_sinPow > 0 ){
+
+      GDouble sin2 = 0.5 * ( 1 - cosTheta );
+      GDouble sinHalf = ( sin2 > 0 ? sqrt( sin2 ) : 0 );
+      for( int i = 0; i < m_sinPow; ++i ) halfPow *= sinHalf;
+    }
+    if( m_cosPow > 0 ){
+
+      GDouble cos2 = 0.5 * ( 1 + cosTheta );
+      GDouble cosHalf = ( cos2 > 0 ? sqrt( cos2 ) : 0 );
+      for( int i = 0; i < m_cosPow; ++i ) halfPow *= cosHalf;
+    }
+
+    GDouble poly = 0;
+    for( int k = (int)m_coef.size() - 1; k >= 0; --k )
+      poly = poly * cosTheta + m_coef[k];
+
+    return halfPow * poly;
+  }
+
+private:
+
+  int m_sinPow;
+  int m_cosPow;
+  std::vector< GDouble > m_coef;  // of cos^k(theta), empty if |m| or |n| > l
+};
+
 #endif
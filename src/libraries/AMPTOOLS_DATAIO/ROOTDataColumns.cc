@@ -0,0 +1,317 @@
+
+#include <vector>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <algorithm>
+
+#include "AMPTOOLS_DATAIO/ROOTDataColumns.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TVirtualMutex.h"
+
+using namespace std;
+
+ROOTDataColumns::ROOTDataColumns( const string& fileName, const string& treeName,
+                                  bool useWeight ):
+  m_fileName( fileName ),
+  m_treeName( treeName ),
+  m_useWeight( useWeight ),
+  m_first( 0 ),
+  m_last( 0 ),
+  m_current( 0 ),
+  m_nPartAddr( NULL ),
+  m_eAddr( NULL ), m_pxAddr( NULL ), m_pyAddr( NULL ), m_pzAddr( NULL ),
+  m_eBeamAddr( NULL ), m_pxBeamAddr( NULL ), m_pyBeamAddr( NULL ), m_pzBeamAddr( NULL ),
+  m_weightAddr( NULL )
+{
+}
+
+void
+ROOTDataColumns::setAddresses( int* nPart, float* e, float* px, float* py, float* pz,
+                               float* eBeam, float* pxBeam, float* pyBeam, float* pzBeam,
+                               float* weight )
+{
+  m_nPartAddr = nPart;
+  m_eAddr = e;
+  m_pxAddr = px;
+  m_pyAddr = py;
+  m_pzAddr = pz;
+  m_eBeamAddr = eBeam;
+  m_pxBeamAddr = pxBeam;
+  m_pyBeamAddr = pyBeam;
+  m_pzBeamAddr = pzBeam;
+  m_weightAddr = weight;
+}
+
+unsigned int
+ROOTDataColumns::numThreads()
+{
+  // several TFiles may only be read at once if the executable has
+  // made ROOT thread safe, which sets gGlobalMutex
+  if( gGlobalMutex == NULL ) return 1;
+
+  const char* env = getenv( "AMPTOOLS_DATAIO_THREADS" );
+  if( env != NULL && atoi( env ) > 0 ) return atoi( env );
+
+  unsigned int nThreads = thread::hardware_concurrency();
+  if( nThreads == 0 ) nThreads = 1;
+  return min( nThreads, 8u );
+}
+
+unsigned int
+ROOTDataColumns::windowEntries()
+{
+  const char* env = getenv( "AMPTOOLS_DATAIO_WINDOW" );
+  if( env != NULL && atoi( env ) > 0 ) return atoi( env );
+
+  return 500000;
+}
+
+void
+ROOTDataColumns::readClusters()
+{
+  TFile* inFile = TFile::Open( m_fileName.c_str() );
+  TTree* inTree = ( inFile == NULL ? NULL :
+                    dynamic_cast<TTree*>( inFile->Get( m_treeName.c_str() ) ) );
+  if( inTree == NULL ){
+
+    cerr << "ROOTDataColumns: cannot read tree " << m_treeName
+         << " from " << m_fileName << endl;
+    exit( 1 );
+  }
+
+  long long nEntries = inTree->GetEntries();
+  TTree::TClusterIterator clusterIter = inTree->GetClusterIterator( 0 );
+  long long start;
+  while( ( start = clusterIter() ) < nEntries ) m_clusterStart.push_back( start );
+  m_clusterStart.push_back( nEntries );
+  inFile->Close();
+  delete inFile;
+}
+
+void
+ROOTDataColumns::load( unsigned int entry )
+{
+  if( isLoaded( entry ) ) return;
+
+  if( m_clusterStart.empty() ) readClusters();
+  unsigned int nClustersTree = m_clusterStart.size() - 1;
+  assert( entry < m_clusterStart.back() );
+
+  // the window: from the cluster containing entry, at least one cluster
+  // per thread and windowEntries() entries, or up to the end of the tree
+  unsigned int firstCluster =
+    upper_bound( m_clusterStart.begin(), m_clusterStart.end(), (long long)entry ) -
+    m_clusterStart.begin() - 1;
+  unsigned int maxThreads = numThreads();
+  unsigned int lastCluster = firstCluster + 1;
+  while( lastCluster < nClustersTree &&
+         ( lastCluster - firstCluster < maxThreads ||
+           m_clusterStart[lastCluster] - m_clusterStart[firstCluster] < windowEntries() ) )
+    ++lastCluster;
+
+  // divide the window among the threads on cluster boundaries, so no
+  // basket has to be read by more than one of them
+  unsigned int nClusters = lastCluster - firstCluster;
+  unsigned int nThreads = min( maxThreads, nClusters );
+
+  vector< long long > first( nThreads ), last( nThreads );
+  for( unsigned int i = 0; i < nThreads; ++i ){
+
+    first[i] = m_clusterStart[ firstCluster + ( i * nClusters ) / nThreads ];
+    last[i] = m_clusterStart[ firstCluster + ( ( i + 1 ) * nClusters ) / nThreads ];
+  }
+
+  // give back the previous window before reading the next
+  clear();
+
+  vector< chunk_t > chunks( nThreads );
+  if( nThreads == 1 ){
+
+    readChunk( first[0], last[0], chunks[0] );
+  }
+  else{
+
+    // each thread has its own TFile and TTree
+    vector< thread > threads;
+    for( unsigned int i = 0; i < nThreads; ++i )
+      threads.push_back( thread( &ROOTDataColumns::readChunk, this,
+                                 first[i], last[i], ref( chunks[i] ) ) );
+    for( unsigned int i = 0; i < nThreads; ++i )
+      threads[i].join();
+  }
+
+  // join the chunks, releasing each as it is copied
+  long long nEntries = last[nThreads-1] - first[0];
+  unsigned long nParticles = 0;
+  for( unsigned int i = 0; i < nThreads; ++i ) nParticles += chunks[i].e.size();
+  m_offset.assign( 1, 0 );
+  m_nPart.reserve( nEntries );
+  m_offset.reserve( nEntries + 1 );
+  m_e.reserve( nParticles ); m_px.reserve( nParticles );
+  m_py.reserve( nParticles ); m_pz.reserve( nParticles );
+  m_eBeam.reserve( nEntries ); m_pxBeam.reserve( nEntries );
+  m_pyBeam.reserve( nEntries ); m_pzBeam.reserve( nEntries );
+  if( m_useWeight ) m_weight.reserve( nEntries );
+
+  for( unsigned int i = 0; i < nThreads; ++i ){
+
+    chunk_t& chunk = chunks[i];
+    for( size_t j = 0; j < chunk.nPart.size(); ++j ){
+
+      m_nPart.push_back( chunk.nPart[j] );
+      m_offset.push_back( m_offset.back() + chunk.nPart[j] );
+    }
+    m_e.insert( m_e.end(), chunk.e.begin(), chunk.e.end() );
+    m_px.insert( m_px.end(), chunk.px.begin(), chunk.px.end() );
+    m_py.insert( m_py.end(), chunk.py.begin(), chunk.py.end() );
+    m_pz.insert( m_pz.end(), chunk.pz.begin(), chunk.pz.end() );
+    m_eBeam.insert( m_eBeam.end(), chunk.eBeam.begin(), chunk.eBeam.end() );
+    m_pxBeam.insert( m_pxBeam.end(), chunk.pxBeam.begin(), chunk.pxBeam.end() );
+    m_pyBeam.insert( m_pyBeam.end(), chunk.pyBeam.begin(), chunk.pyBeam.end() );
+    m_pzBeam.insert( m_pzBeam.end(), chunk.pzBeam.begin(), chunk.pzBeam.end() );
+    m_weight.insert( m_weight.end(), chunk.weight.begin(), chunk.weight.end() );
+    chunk = chunk_t();
+  }
+
+  m_first = first[0];
+  m_last = last[nThreads-1];
+}
+
+void
+ROOTDataColumns::readChunk( long long first, long long last, chunk_t& chunk ) const
+{
+  TFile* inFile = TFile::Open( m_fileName.c_str() );
+  TTree* inTree = ( inFile == NULL ? NULL :
+                    dynamic_cast<TTree*>( inFile->Get( m_treeName.c_str() ) ) );
+  if( inTree == NULL ){
+
+    cerr << "ROOTDataColumns: cannot read tree " << m_treeName
+         << " from " << m_fileName << endl;
+    exit( 1 );
+  }
+
+  int nPart;
+  float e[Kinematics::kMaxParticles];
+  float px[Kinematics::kMaxParticles];
+  float py[Kinematics::kMaxParticles];
+  float pz[Kinematics::kMaxParticles];
+  float eBeam, pxBeam, pyBeam, pzBeam, weight;
+
+  // only the branches used are read, through a cache covering this
+  // thread's entries
+  vector< string > branches;
+  branches.push_back( "NumFinalState" );
+  branches.push_back( "E_FinalState" );
+  branches.push_back( "Px_FinalState" );
+  branches.push_back( "Py_FinalState" );
+  branches.push_back( "Pz_FinalState" );
+  branches.push_back( "E_Beam" );
+  branches.push_back( "Px_Beam" );
+  branches.push_back( "Py_Beam" );
+  branches.push_back( "Pz_Beam" );
+  if( m_useWeight ) branches.push_back( "Weight" );
+
+  inTree->SetBranchStatus( "*", 0 );
+  for( size_t i = 0; i < branches.size(); ++i )
+    inTree->SetBranchStatus( branches[i].c_str(), 1 );
+
+  inTree->SetBranchAddress( "NumFinalState", &nPart );
+  inTree->SetBranchAddress( "E_FinalState", e );
+  inTree->SetBranchAddress( "Px_FinalState", px );
+  inTree->SetBranchAddress( "Py_FinalState", py );
+  inTree->SetBranchAddress( "Pz_FinalState", pz );
+  inTree->SetBranchAddress( "E_Beam", &eBeam );
+  inTree->SetBranchAddress( "Px_Beam", &pxBeam );
+  inTree->SetBranchAddress( "Py_Beam", &pyBeam );
+  inTree->SetBranchAddress( "Pz_Beam", &pzBeam );
+  if( m_useWeight ) inTree->SetBranchAddress( "Weight", &weight );
+
+  inTree->SetCacheSize( 64 * 1024 * 1024 );
+  inTree->SetCacheEntryRange( first, last );
+  for( size_t i = 0; i < branches.size(); ++i )
+    inTree->AddBranchToCache( branches[i].c_str(), kTRUE );
+  inTree->StopCacheLearningPhase();
+
+  chunk.nPart.reserve( last - first );
+  chunk.eBeam.reserve( last - first );
+  chunk.pxBeam.reserve( last - first );
+  chunk.pyBeam.reserve( last - first );
+  chunk.pzBeam.reserve( last - first );
+  if( m_useWeight ) chunk.weight.reserve( last - first );
+
+  for( long long entry = first; entry < last; ++entry ){
+
+    inTree->GetEntry( entry );
+    assert( nPart < Kinematics::kMaxParticles );
+
+    chunk.nPart.push_back( nPart );
+    chunk.e.insert( chunk.e.end(), e, e + nPart );
+    chunk.px.insert( chunk.px.end(), px, px + nPart );
+    chunk.py.insert( chunk.py.end(), py, py + nPart );
+    chunk.pz.insert( chunk.pz.end(), pz, pz + nPart );
+    chunk.eBeam.push_back( eBeam );
+    chunk.pxBeam.push_back( pxBeam );
+    chunk.pyBeam.push_back( pyBeam );
+    chunk.pzBeam.push_back( pzBeam );
+    if( m_useWeight ) chunk.weight.push_back( weight );
+  }
+
+  inFile->Close();
+  delete inFile;
+}
+
+void
+ROOTDataColumns::clear()
+{
+  // swap with empty vectors so the memory is really given back
+  vector< int >().swap( m_nPart );
+  vector< unsigned long >().swap( m_offset );
+  vector< float >().swap( m_e );
+  vector< float >().swap( m_px );
+  vector< float >().swap( m_py );
+  vector< float >().swap( m_pz );
+  vector< float >().swap( m_eBeam );
+  vector< float >().swap( m_pxBeam );
+  vector< float >().swap( m_pyBeam );
+  vector< float >().swap( m_pzBeam );
+  vector< float >().swap( m_weight );
+  m_first = m_last = 0;
+}
+
+void
+ROOTDataColumns::getEntry( unsigned int entry )
+{
+  load( entry );
+
+  m_current = entry - m_first;
+  int nPart = m_nPart[m_current];
+  unsigned long offset = m_offset[m_current];
+
+  *m_nPartAddr = nPart;
+  copy( m_e.begin() + offset, m_e.begin() + offset + nPart, m_eAddr );
+  copy( m_px.begin() + offset, m_px.begin() + offset + nPart, m_pxAddr );
+  copy( m_py.begin() + offset, m_py.begin() + offset + nPart, m_pyAddr );
+  copy( m_pz.begin() + offset, m_pz.begin() + offset + nPart, m_pzAddr );
+  *m_eBeamAddr = m_eBeam[m_current];
+  *m_pxBeamAddr = m_pxBeam[m_current];
+  *m_pyBeamAddr = m_pyBeam[m_current];
+  *m_pzBeamAddr = m_pzBeam[m_current];
+  if( m_useWeight ) *m_weightAddr = m_weight[m_current];
+}
+
+void
+ROOTDataColumns::particleList( vector< TLorentzVector >& particleList ) const
+{
+  // clear keeps the capacity, so a list reused from one event to the
+  // next is not reallocated
+  particleList.clear();
+  particleList.push_back( TLorentzVector( m_pxBeam[m_current], m_pyBeam[m_current],
+                                          m_pzBeam[m_current], m_eBeam[m_current] ) );
+
+  for( unsigned long i = m_offset[m_current]; i < m_offset[m_current+1]; ++i )
+    particleList.push_back( TLorentzVector( m_px[i], m_py[i], m_pz[i], m_e[i] ) );
+}
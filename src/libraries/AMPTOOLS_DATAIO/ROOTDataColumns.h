@@ -0,0 +1,120 @@
+#if !defined(ROOTDATACOLUMNS)
+#define ROOTDATACOLUMNS
+
+#include "IUAmpTools/Kinematics.h"
+
+#include "TLorentzVector.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * In-memory copy of a window of the kinematic branches of an AmpTools
+ * input tree, shared by the ROOTDataReader family.  The final state and
+ * beam branches (and Weight, if requested) are read cluster by cluster
+ * into one array per quantity, with only those branches enabled and the
+ * reads going through a TTreeCache.  Only the clusters around the entry
+ * being read are held, at least AMPTOOLS_DATAIO_WINDOW entries (500000
+ * if it is not set), and the next window is read when the readers move
+ * past it, so the memory does not grow with the size of the tree.
+ *
+ * The clusters of a window are split among several threads, each
+ * reading through its own TFile, if the executable has called
+ * ROOT::EnableThreadSafety().  The number of threads is taken from the
+ * AMPTOOLS_DATAIO_THREADS environment variable, or from the number of
+ * cores (at most 8) if it is not set.
+ *
+ * Entries are then copied out with getEntry into the same buffers a
+ * reader would have passed to TTree::SetBranchAddress.  The readers go
+ * through the tree in order (the bootstrap reader in sorted order), so
+ * each window is read once per pass.
+ */
+
+class ROOTDataColumns
+{
+
+public:
+
+  ROOTDataColumns( const string& fileName, const string& treeName,
+                   bool useWeight );
+
+  /**
+   * Set where getEntry copies an entry, in place of the
+   * TTree::SetBranchAddress calls for the same branches.
+   */
+  void setAddresses( int* nPart, float* e, float* px, float* py, float* pz,
+                     float* eBeam, float* pxBeam, float* pyBeam, float* pzBeam,
+                     float* weight );
+
+  /**
+   * Read the window of clusters starting with the one containing entry.
+   */
+  void load( unsigned int entry );
+
+  /**
+   * Release the memory, e.g. once the reader has been read through.
+   * The next getEntry loads a window again.
+   */
+  void clear();
+
+  bool isLoaded( unsigned int entry ) const {
+    return entry >= m_first && entry < m_last;
+  }
+
+  void getEntry( unsigned int entry );
+
+  /**
+   * Fill particleList with the beam followed by the final state
+   * particles of the entry last read by getEntry.
+   */
+  void particleList( vector< TLorentzVector >& particleList ) const;
+
+  static unsigned int numThreads();
+  static unsigned int windowEntries();
+
+private:
+
+  // columns for a contiguous range of entries
+  struct chunk_t {
+
+    vector< int > nPart;
+    vector< float > e, px, py, pz;   // all final state particles
+    vector< float > eBeam, pxBeam, pyBeam, pzBeam;
+    vector< float > weight;
+  };
+
+  void readClusters();
+  void readChunk( long long first, long long last, chunk_t& chunk ) const;
+
+  string m_fileName;
+  string m_treeName;
+  bool m_useWeight;
+
+  vector< long long > m_clusterStart;   // and the number of entries at the end
+
+  // the window held, entries m_first .. m_last-1
+  unsigned int m_first;
+  unsigned int m_last;
+  unsigned int m_current;               // entry last read, relative to m_first
+
+  vector< int > m_nPart;
+  vector< unsigned long > m_offset;   // of each entry of the window in m_e etc.
+  vector< float > m_e, m_px, m_py, m_pz;
+  vector< float > m_eBeam, m_pxBeam, m_pyBeam, m_pzBeam;
+  vector< float > m_weight;
+
+  int* m_nPartAddr;
+  float* m_eAddr;
+  float* m_pxAddr;
+  float* m_pyAddr;
+  float* m_pzAddr;
+  float* m_eBeamAddr;
+  float* m_pxBeamAddr;
+  float* m_pyBeamAddr;
+  float* m_pzBeamAddr;
+  float* m_weightAddr;
+};
+
+#endif
@@ -38,30 +38,26 @@ ROOTDataReader::ROOTDataReader( const vector< string >& args ):
     m_inTree = dynamic_cast<TTree*>( m_inFile->Get( args[1].c_str() ) );
   }
   
-  m_inTree->SetBranchAddress( "NumFinalState", &m_nPart );
-  m_inTree->SetBranchAddress( "E_FinalState", m_e );
-  m_inTree->SetBranchAddress( "Px_FinalState", m_px );
-  m_inTree->SetBranchAddress( "Py_FinalState", m_py );
-  m_inTree->SetBranchAddress( "Pz_FinalState", m_pz );
-  m_inTree->SetBranchAddress( "E_Beam", &m_eBeam );
-  m_inTree->SetBranchAddress( "Px_Beam", &m_pxBeam );
-  m_inTree->SetBranchAddress( "Py_Beam", &m_pyBeam );
-  m_inTree->SetBranchAddress( "Pz_Beam", &m_pzBeam );
-
   if(m_inTree->GetBranch("Weight") != NULL) {
 
     m_useWeight = true;
-    m_inTree->SetBranchAddress( "Weight", &m_weight );
   }
   else{
 
     m_useWeight = false;
   }
+
+  // the tree is read into memory a window of clusters at a time, as needed
+  m_columns = new ROOTDataColumns( args[0], args.size() == 1 ? string( "kin" ) : args[1],
+                                   m_useWeight );
+  m_columns->setAddresses( &m_nPart, m_e, m_px, m_py, m_pz,
+                           &m_eBeam, &m_pxBeam, &m_pyBeam, &m_pzBeam, &m_weight );
 }
 
 ROOTDataReader::~ROOTDataReader()
 {
   if( m_inFile != NULL ) m_inFile->Close();
+  delete m_columns;
 }
 
 void
@@ -81,23 +77,20 @@ ROOTDataReader::getEvent()
   if( m_eventCounter < static_cast< unsigned int >( m_inTree->GetEntries() ) ){
     //  if( m_eventCounter < 10 ){
     
-    m_inTree->GetEntry( m_eventCounter++ );
+    m_columns->getEntry( m_eventCounter++ );
     assert( m_nPart < Kinematics::kMaxParticles );
     
-    vector< TLorentzVector > particleList;
-    
-    particleList.
-      push_back( TLorentzVector( m_pxBeam, m_pyBeam, m_pzBeam, m_eBeam ) );
-    
-    for( int i = 0; i < m_nPart; ++i ){
-      
-      particleList.push_back( TLorentzVector( m_px[i], m_py[i], m_pz[i], m_e[i] ) );
-    }
-    
-    return new Kinematics( particleList, m_useWeight ? m_weight : 1.0 );
+    m_columns->particleList( m_particleList );
+    Kinematics* kin = new Kinematics( m_particleList, m_useWeight ? m_weight : 1.0 );
+
+    // the whole tree has been read: give back the memory
+    if( m_eventCounter == numEvents() ) m_columns->clear();
+
+    return kin;
   }
   else{
     
+    m_columns->clear();
     return NULL;
   }
 }
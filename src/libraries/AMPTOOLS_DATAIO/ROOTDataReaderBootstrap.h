@@ -3,6 +3,7 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "IUAmpTools/UserDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataColumns.h"
 
 #include "TString.h"
 #include "TRandom2.h"
@@ -22,7 +23,7 @@ public:
   /**
    * Default constructor for ROOTDataReaderBootstrap
    */
-  ROOTDataReaderBootstrap() : UserDataReader< ROOTDataReaderBootstrap >(), m_inFile( NULL ) { }
+  ROOTDataReaderBootstrap() : UserDataReader< ROOTDataReaderBootstrap >(), m_inFile( NULL ), m_columns( NULL ) { }
   
   ~ROOTDataReaderBootstrap();
   
@@ -69,6 +70,9 @@ private:
   float m_pzBeam;
   float m_weight;
 
+  ROOTDataColumns* m_columns;
+  vector< TLorentzVector > m_particleList;
+
   multiset< unsigned int > m_entryOrder;
   mutable multiset< unsigned int >::const_iterator m_nextEntry;
 };
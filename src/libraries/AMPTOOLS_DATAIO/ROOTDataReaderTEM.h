@@ -3,6 +3,7 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "IUAmpTools/UserDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataColumns.h"
 
 #include "TString.h"
 #include "TFile.h"
@@ -20,7 +21,7 @@ public:
   /**
    * Default constructor for ROOTDataReaderTEM
    */
-  ROOTDataReaderTEM() : UserDataReader< ROOTDataReaderTEM >(), m_inFile( NULL ) { }
+  ROOTDataReaderTEM() : UserDataReader< ROOTDataReaderTEM >(), m_inFile( NULL ), m_columns( NULL ) { }
   
   ~ROOTDataReaderTEM();
   
@@ -63,6 +64,9 @@ private:
   float m_pyBeam;
   float m_pzBeam;
   float m_weight;
+
+  ROOTDataColumns* m_columns;
+  vector< TLorentzVector > m_particleList;
 };
 
 #endif
@@ -72,3 +72,32 @@ ROOTDataWriter::writeEvent( const Kinematics& kin )
   m_eventCounter++;
   
 }
+
+void
+ROOTDataWriter::writeEvent( int nPart, const float* e, const float* px,
+                            const float* py, const float* pz,
+                            const float* beam, float weight )
+{
+  assert( nPart < Kinematics::kMaxParticles );
+
+  m_nPart = nPart;
+
+  m_eBeam = beam[0];
+  m_pxBeam = beam[1];
+  m_pyBeam = beam[2];
+  m_pzBeam = beam[3];
+
+  for( int i = 0; i < m_nPart; ++i ){
+
+    m_e[i] = e[i];
+    m_px[i] = px[i];
+    m_py[i] = py[i];
+    m_pz[i] = pz[i];
+  }
+
+  m_weight = weight;
+
+  m_outTree->Fill();
+
+  m_eventCounter++;
+}
@@ -30,6 +30,19 @@ public:
   ~ROOTDataWriter();
   
   void writeEvent( const Kinematics& kin );
+
+  /**
+   * Write an event given in the layout of the tree itself, without
+   * going through a Kinematics object.
+   *
+   * \param[in] nPart number of final state particles
+   * \param[in] e, px, py, pz final state four-momenta, nPart of each
+   * \param[in] beam beam four-momentum as E, px, py, pz
+   * \param[in] weight event weight, only written if enabled
+   */
+  void writeEvent( int nPart, const float* e, const float* px,
+                   const float* py, const float* pz,
+                   const float* beam, float weight = 1 );
   
   int eventCounter() const { return m_eventCounter; }
   
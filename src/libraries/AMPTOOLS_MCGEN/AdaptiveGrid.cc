@@ -0,0 +1,92 @@
+
+#include <cassert>
+#include <cmath>
+
+#include "AMPTOOLS_MCGEN/AdaptiveGrid.h"
+
+const double AdaptiveGrid::kMinDensity = 0.01;
+
+AdaptiveGrid::AdaptiveGrid() :
+m_nBins( 0 )
+{}
+
+AdaptiveGrid::AdaptiveGrid( const vector< pair< double, double > >& ranges, int nBins ) :
+m_ranges( ranges ),
+m_nBins( nBins ),
+m_density( ranges.size(), vector< double >( nBins, 1.0 ) ),
+m_sumInten( ranges.size(), vector< double >( nBins, 0.0 ) ),
+m_sumInvDensity( ranges.size(), vector< double >( nBins, 0.0 ) )
+{
+    assert( nBins > 0 );
+}
+
+double
+AdaptiveGrid::density( const vector< double >& x ) const
+{
+    assert( x.size() == m_ranges.size() );
+    
+    double q = 1;
+    for( unsigned int i = 0; i < m_ranges.size(); ++i ){
+        
+        q *= m_density[i][bin( i, x[i] )];
+    }
+    
+    return q;
+}
+
+void
+AdaptiveGrid::fill( const vector< double >& x, double q, double inten )
+{
+    assert( x.size() == m_ranges.size() && q > 0 );
+    
+    for( unsigned int i = 0; i < m_ranges.size(); ++i ){
+        
+        int j = bin( i, x[i] );
+        m_sumInten[i][j] += inten;
+        m_sumInvDensity[i][j] += 1 / q;
+    }
+}
+
+void
+AdaptiveGrid::update()
+{
+    for( unsigned int i = 0; i < m_ranges.size(); ++i ){
+        
+        // the events filled were thrown according to the old density,
+        // which the 1 / q in both sums undoes
+        vector< double > avgInten( m_nBins, -1 );
+        double maxInten = 0;
+        for( int j = 0; j < m_nBins; ++j ){
+            
+            if( m_sumInvDensity[i][j] > 0 ){
+                
+                avgInten[j] = m_sumInten[i][j] / m_sumInvDensity[i][j];
+                if( avgInten[j] > maxInten ) maxInten = avgInten[j];
+            }
+        }
+        
+        // keep the old density if nothing has been learned
+        if( maxInten <= 0 ) continue;
+        
+        for( int j = 0; j < m_nBins; ++j ){
+            
+            // bins the warm-up did not reach are not suppressed
+            double q = ( avgInten[j] < 0 ? 1 : avgInten[j] / maxInten );
+            m_density[i][j] = ( q < kMinDensity ? kMinDensity : q );
+            
+            m_sumInten[i][j] = 0;
+            m_sumInvDensity[i][j] = 0;
+        }
+    }
+}
+
+int
+AdaptiveGrid::bin( int var, double x ) const
+{
+    const pair< double, double >& range = m_ranges[var];
+    int j = (int)floor( m_nBins * ( x - range.first ) / ( range.second - range.first ) );
+    
+    if( j < 0 ) return 0;
+    if( j >= m_nBins ) return m_nBins - 1;
+    return j;
+}
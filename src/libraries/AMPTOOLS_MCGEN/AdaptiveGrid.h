@@ -0,0 +1,63 @@
+#if !defined(ADAPTIVEGRID)
+#define ADAPTIVEGRID
+
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Binned proposal density for importance sampling, in the spirit of
+// VEGAS.  The density is a product of one histogram per kinematic
+// variable, each scaled so that its largest bin is 1, so that the
+// density itself can serve as the probability to keep an event thrown
+// by the generator before its intensity is ever computed.  Events that
+// are kept get their weight divided by the density, which leaves the
+// distribution after accept/reject unchanged.
+//
+// The histograms are learned from the intensity of events filled during
+// a warm-up:  each bin ends up proportional to the average intensity of
+// the generator's events in that bin.
+
+class AdaptiveGrid
+{
+    
+public:
+    
+    AdaptiveGrid();
+    
+    // one ( low, high ) pair for each variable -- values outside of
+    // the range fall in the first or last bin
+    AdaptiveGrid( const vector< pair< double, double > >& ranges, int nBins = 20 );
+    
+    // the proposal density at x, in ( 0, 1 ]
+    double density( const vector< double >& x ) const;
+    
+    // add an event thrown at x with proposal density q to the statistics
+    // for the next update -- inten is its intensity times its weight,
+    // which already includes the 1 / q
+    void fill( const vector< double >& x, double q, double inten );
+    
+    // set the density to the one learned from the events filled since
+    // the last update
+    void update();
+    
+private:
+    
+    int bin( int var, double x ) const;
+    
+    // no bin is suppressed by more than this, so that no region
+    // of phase space is left out
+    static const double kMinDensity;
+    
+    vector< pair< double, double > > m_ranges;
+    int m_nBins;
+    
+    vector< vector< double > > m_density;
+    
+    // sums over the events filled of intensity and of 1 / density, whose
+    // ratio is the average intensity of the generator's events in a bin
+    vector< vector< double > > m_sumInten;
+    vector< vector< double > > m_sumInvDensity;
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 
 #include "AMPTOOLS_MCGEN/DalitzDecayFactory.h"
+#include "AMPTOOLS_MCGEN/MCGenRandom.h"
 
 #include "TLorentzVector.h"
 #include "TLorentzRotation.h"
@@ -95,5 +96,5 @@ DalitzDecayFactory::cmMomentum( double M, double m1, double m2 ) const {
 double
 DalitzDecayFactory::random( double low, double hi ) const {
 	
-	return( ( hi - low ) * drand48() + low );
+	return( ( hi - low ) * MCGenRandom::uniform48() + low );
 }
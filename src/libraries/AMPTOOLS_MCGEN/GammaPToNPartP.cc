@@ -12,11 +12,13 @@
 #include "NBodyPhaseSpaceFactory.h"
 #include "TLorentzVector.h"
 #include "IUAmpTools/Kinematics.h"
+#include "AMPTOOLS_MCGEN/MCGenRandom.h"
 
 #include "UTILITIES/BeamProperties.h"
 
 GammaPToNPartP::GammaPToNPartP():
-	m_prodMech(ProductionMechanism::kProton,ProductionMechanism::kFlat,0,0)
+	m_prodMech(ProductionMechanism::kProton,ProductionMechanism::kFlat,0,0),
+	cobrem_vs_E(NULL)
 {}
 
 GammaPToNPartP::GammaPToNPartP( float lowMass, float highMass, 
@@ -47,6 +49,10 @@ GammaPToNPartP::GammaPToNPartP( float lowMass, float highMass,
   cobrem_vs_E = (TH1D*)beamProp.GetFlux();
   cobrem_vs_E->GetName();
 
+  // built here, so that the histogram is only read from
+  // while generating, possibly in several threads at once
+  m_fluxSampler = HistogramSampler( cobrem_vs_E );
+
 }
 
 /**
@@ -57,7 +63,8 @@ GammaPToNPartP::GammaPToNPartP( float lowMass, float highMass,
 Kinematics* 
 GammaPToNPartP::generate(){
 
-  double beamE = cobrem_vs_E->GetRandom();
+  // as TH1::GetRandom, but from the thread's own generator if it has one
+  double beamE = m_fluxSampler.Sample( MCGenRandom::uniform() );
   m_beam.SetPxPyPzE(0,0,beamE,beamE);
 
   TLorentzVector resonance;
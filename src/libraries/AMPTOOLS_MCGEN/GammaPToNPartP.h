@@ -11,6 +11,7 @@
 #include "TLorentzVector.h"
 #include "TH1.h"
 #include "AMPTOOLS_MCGEN/ProductionMechanism.h"
+#include "UTILITIES/HistogramSampler.h"
 
 class Kinematics;
 
@@ -47,6 +48,7 @@ private:
   unsigned int m_Npart;
 
   TH1D *cobrem_vs_E;
+  HistogramSampler m_fluxSampler;
 };
 
 #endif
@@ -11,6 +11,7 @@
 #include "TRandom3.h"
 
 #include "AMPTOOLS_MCGEN/GammaPToXP.h"
+#include "AMPTOOLS_MCGEN/MCGenRandom.h"
 #include "UTILITIES/BeamProperties.h"
 
 GammaPToXP::GammaPToXP( float massX, TString beamConfigFile) : 
@@ -57,6 +58,6 @@ GammaPToXP::generate(){
 double
 GammaPToXP::random( double low, double hi ) const {
 
-        return( ( hi - low ) * gRandom->Uniform() + low );
+        return( ( hi - low ) * MCGenRandom::uniform() + low );
 }
 
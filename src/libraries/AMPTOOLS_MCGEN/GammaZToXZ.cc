@@ -17,6 +17,7 @@
 #include "particleType.h"
 
 #include "AMPTOOLS_MCGEN/GammaZToXZ.h"
+#include "AMPTOOLS_MCGEN/MCGenRandom.h"
 #include "UTILITIES/BeamProperties.h"
 
 GammaZToXZ::GammaZToXZ( float massX, TString beamConfigFile, Double_t Bslope) :
@@ -40,6 +41,7 @@ m_childMass( 0 )
   BeamProperties beamProp(beamConfigFile);
   cobrem_vs_E = (TH1D*)beamProp.GetFlux();
   cobrem_vs_E->GetName();
+  m_fluxSampler = HistogramSampler( cobrem_vs_E );
 }
 
 Kinematics* 
@@ -53,7 +55,7 @@ GammaZToXZ::generate(){
   double recoilMass = m_recoil;
 // Double_t masses[2] = {EtaMass,recoilMass};
 
-  double beamE = cobrem_vs_E->GetRandom();
+  double beamE = m_fluxSampler.Sample( MCGenRandom::uniform() );
   TLorentzVector beam;
   beam.SetPxPyPzE(0,0,beamE,beamE);
   TLorentzVector cm = beam + m_target;
@@ -81,7 +83,7 @@ GammaZToXZ::generate(){
     // tMax = 1.;   // restrict max to make more efficient for Primakoff generation
     tMin = abs(pow(EtaMass,4)/(2*cmEnergy*cmEnergy) - (beamMomCM-EtaMomCM)*(beamMomCM-EtaMomCM));  // treating t as positive
 
-    double Irandom = gRandom->Uniform();
+    double Irandom = MCGenRandom::uniform();
     // generate random t with exponential between tMin and tMax
     t = -log( Irandom*(exp(-m_slope*tMax) - exp(-m_slope*tMin)) + exp(-m_slope*tMin))/m_slope;
 
@@ -132,6 +134,6 @@ GammaZToXZ::cmMomentum( double M, double m1, double m2 ) const {
 double
 GammaZToXZ::random( double low, double hi ) const {
 
-        return( ( hi - low ) * gRandom->Uniform() + low );
+        return( ( hi - low ) * MCGenRandom::uniform() + low );
 }
 
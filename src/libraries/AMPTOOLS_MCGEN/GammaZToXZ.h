@@ -16,6 +16,7 @@
 #include "TH1.h"
 
 #include "IUAmpTools/Kinematics.h"
+#include "UTILITIES/HistogramSampler.h"
 
 class Kinematics;
 
@@ -40,6 +41,7 @@ private:
   vector< double > m_childMass;
   
   TH1D *cobrem_vs_E;
+  HistogramSampler m_fluxSampler;
   
   double cmMomentum( double M, double m1, double m2 ) const;
   double random( double low, double hi ) const;
@@ -0,0 +1,11 @@
+#include <cstdlib>
+
+#include "AMPTOOLS_MCGEN/MCGenRandom.h"
+
+thread_local TRandom* MCGenRandom::m_threadGenerator = NULL;
+
+double
+MCGenRandom::uniform48() {
+	
+	return( m_threadGenerator ? m_threadGenerator->Uniform() : drand48() );
+}
@@ -0,0 +1,34 @@
+#if !defined(MCGENRANDOM)
+#define MCGENRANDOM
+
+#include "TRandom.h"
+
+// Source of random numbers for the generator classes in this library.
+// By default they draw on ROOT's gRandom (or drand48, for those that
+// always have), but a thread can install a generator of its own, so
+// that several threads can generate events at once, each from its own
+// reproducible stream.
+
+class MCGenRandom
+{
+	
+public:
+	
+	// the generator installed by the calling thread, NULL if none
+	static TRandom* threadGenerator() { return m_threadGenerator; }
+	static void setThreadGenerator( TRandom* generator ) { m_threadGenerator = generator; }
+	
+	// uniform in [0,1): the thread's generator, or else gRandom
+	static double uniform() {
+		return( m_threadGenerator ? m_threadGenerator->Uniform() : gRandom->Uniform() );
+	}
+	
+	// uniform in [0,1): the thread's generator, or else drand48
+	static double uniform48();
+	
+private:
+	
+	static thread_local TRandom* m_threadGenerator;
+};
+
+#endif
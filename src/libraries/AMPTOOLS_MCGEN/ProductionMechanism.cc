@@ -3,6 +3,7 @@
 #include <stdlib.h>
 
 #include "AMPTOOLS_MCGEN/ProductionMechanism.h"
+#include "AMPTOOLS_MCGEN/MCGenRandom.h"
 #include "particleType.h"
 
 #include "TLorentzVector.h"
@@ -228,7 +229,7 @@ ProductionMechanism::cmMomentum( double M, double m1, double m2 ) const {
 double
 ProductionMechanism::random( double low, double hi ) const {
 
-        return( ( hi - low ) * gRandom->Uniform() + low );
+        return( ( hi - low ) * MCGenRandom::uniform() + low );
 }
 
 
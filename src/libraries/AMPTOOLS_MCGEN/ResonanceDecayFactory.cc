@@ -4,6 +4,7 @@
 #include <iostream>
 
 #include "AMPTOOLS_MCGEN/ResonanceDecayFactory.h"
+#include "AMPTOOLS_MCGEN/MCGenRandom.h"
 
 #include "TLorentzVector.h"
 #include "TLorentzRotation.h"
@@ -69,5 +70,5 @@ ResonanceDecayFactory::cmMomentum( double M, double m1, double m2 ) const {
 double
 ResonanceDecayFactory::random( double low, double hi ) const {
 	
-	return( ( hi - low ) * drand48() + low );
+	return( ( hi - low ) * MCGenRandom::uniform48() + low );
 }
@@ -7,6 +7,7 @@
 #include "TLorentzRotation.h"
 
 #include "AMPTOOLS_MCGEN/TwoBodyDecayFactory.h"
+#include "AMPTOOLS_MCGEN/MCGenRandom.h"
 
 const double TwoBodyDecayFactory::kPi = 3.14159;
 
@@ -57,5 +58,5 @@ TwoBodyDecayFactory::cmMomentum( double M, double m1, double m2 ) const {
 double
 TwoBodyDecayFactory::random( double low, double hi ) const {
 	
-	return( ( hi - low ) * drand48() + low );
+	return( ( hi - low ) * MCGenRandom::uniform48() + low );
 }
@@ -9,10 +9,14 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "TROOT.h"
 #include "TFile.h"
+#include "TNamed.h"
+#include "TSystem.h"
 
 #include "BeamProperties.h"
 #include "CobremsGeneration.hh"
@@ -37,6 +41,13 @@ void BeamProperties::createHistograms( TString configFile ) {
 	bool isParsed = parseConfig();
 	if(!isParsed) exit(1);
 
+	// histograms computed or read from CCDB for the same configuration before;
+	// the key is taken before generateCobrems fills in default parameters,
+	// so that it is the same when loading and saving
+	std::string key = cacheKey();
+	if(loadFromCache(key))
+		return;
+
 	// Fill flux histogram based on config file
 	if(mIsCCDBFlux)
 		fillFluxFromCCDB();
@@ -45,6 +56,7 @@ void BeamProperties::createHistograms( TString configFile ) {
 	else {  // default to CobremsGeneration for flux and polarization
 		generateCobrems();
 		if(mIsPolFixed) fillPolFixed();	// allow user to override with fixed polarization, if desired
+		saveToCache(key);
 		return;
 	}
 
@@ -56,6 +68,8 @@ void BeamProperties::createHistograms( TString configFile ) {
 	else
 		fillPolFixed();
 
+	saveToCache(key);
+
 	return;
 }
 
@@ -135,6 +149,112 @@ bool BeamProperties::parseConfig(){
 	return true;
 }
 
+// key identifying the histograms createHistograms makes from the parsed config,
+// empty if they are read from ROOT files and are not to be cached
+std::string BeamProperties::cacheKey() {
+
+	if(mIsROOTFlux || mIsROOTPol)
+		return "";
+
+	ostringstream key;
+	key.precision(17);
+	key << "BeamProperties cache v1";
+	std::map<std::string,double>::iterator par;
+	for(par = mBeamParametersMap.begin(); par != mBeamParametersMap.end(); par++)
+		key << "\n" << par->first << " " << par->second;
+	key << "\nPolFixed " << mIsPolFixed << "\nCCDBPol " << mIsCCDBPol;
+	if(mIsCCDBFlux) {
+		const char *calib_url = getenv("JANA_CALIB_URL");
+		const char *calib_context = getenv("JANA_CALIB_CONTEXT");
+		key << "\nCCDB " << mRunNumber
+		    << "\nJANA_CALIB_URL " << (calib_url ? calib_url : "")
+		    << "\nJANA_CALIB_CONTEXT " << (calib_context ? calib_context : "");
+	}
+	return key.str();
+}
+
+// file in the cache directory for the given key, empty if the cache is disabled
+TString BeamProperties::cacheFileName( const std::string &key ) {
+
+	const char *cache_env = getenv("BEAMPROPERTIES_CACHE");
+	TString dir = (cache_env ? cache_env : "");
+	if(dir == "" || dir == "none" || key == "")
+		return "";
+
+	// FNV-1a hash of the key
+	unsigned long long hash = 14695981039346656037ULL;
+	for(unsigned int i=0; i<key.size(); i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= 1099511628211ULL;
+	}
+	return dir + Form("/beam_%016llx.root", hash);
+}
+
+// read the histograms back from the cache, if they are there
+bool BeamProperties::loadFromCache( const std::string &key ) {
+
+	TString fileName = cacheFileName(key);
+	if(fileName == "" || gSystem->AccessPathName(fileName))
+		return false;
+
+	TDirectory::TContext context(gROOT);
+	TFile *fCache = TFile::Open(fileName);
+	if(!fCache || !fCache->IsOpen()) {
+		delete fCache;
+		return false;
+	}
+	TNamed *cachedKey = (TNamed*)fCache->Get("BeamProperties_Key");
+	TH1D *flux = (TH1D*)fCache->Get("BeamProperties_FluxVsEgamma");
+	TH1D *polFrac = (TH1D*)fCache->Get("BeamProperties_PolFracVsEgamma");
+	bool found = (cachedKey && key == cachedKey->GetTitle() && flux && polFrac);
+	if(found) {
+		// keep in memory after file is closed
+		flux->SetDirectory(gROOT);
+		polFrac->SetDirectory(gROOT);
+		fluxVsEgamma = flux;
+		polFracVsEgamma = polFrac;
+		cout<<endl<<"BeamProperties: Using flux and polarization cached in "<<fileName.Data()<<endl;
+	}
+	delete cachedKey;
+	fCache->Close();
+	delete fCache;
+
+	return found;
+}
+
+// write the histograms to the cache, through a temporary file renamed into
+// place so that concurrent jobs never see a partly written one
+void BeamProperties::saveToCache( const std::string &key ) {
+
+	TString fileName = cacheFileName(key);
+	if(fileName == "")
+		return;
+
+	gSystem->mkdir(gSystem->DirName(fileName), kTRUE);
+	TString tmpName = fileName + Form(".%s.%d.tmp", gSystem->HostName(), gSystem->GetPid());
+
+	TDirectory::TContext context(gROOT);
+	TFile *fCache = TFile::Open(tmpName, "RECREATE");
+	if(!fCache || !fCache->IsOpen()) {
+		cout << "BeamProperties WARNING:  Could not write cache file " << tmpName.Data() << endl;
+		delete fCache;
+		return;
+	}
+	TNamed cachedKey("BeamProperties_Key", key.c_str());
+	cachedKey.Write();
+	fluxVsEgamma->Write("BeamProperties_FluxVsEgamma");
+	polFracVsEgamma->Write("BeamProperties_PolFracVsEgamma");
+	fCache->Close();
+	delete fCache;
+
+	if(rename(tmpName.Data(), fileName.Data()) != 0) {
+		cout << "BeamProperties WARNING:  Could not write cache file " << fileName.Data() << endl;
+		gSystem->Unlink(tmpName);
+	}
+
+	return;
+}
+
 // create histograms for flux and polarization fraction using CobremsGeneration
 void BeamProperties::generateCobrems(){
 
@@ -8,6 +8,14 @@
  *  of beam properties is from CombremsGeneration, external ROOT file or CCDB (to be implemented). 
  *
  *  Created by Justin Stevens on 12/29/17
+ *
+ *  If the BEAMPROPERTIES_CACHE environment variable names a directory,
+ *  histograms computed with CobremsGeneration or read from CCDB are also
+ *  saved there, keyed by the parsed configuration (and run number and
+ *  CCDB source, for CCDB flux), and read back from there by later jobs
+ *  with the same configuration.  The cache is off by default.  Cached
+ *  CCDB histograms are not updated when the constants in CCDB change, so
+ *  use a fresh directory (or remove the cached files) to pick them up.
  */
 
 #include <string>
@@ -40,6 +48,11 @@ private:
   void fillPolFixed();
   double PSAcceptance(double Egamma, double norm, double min, double max);
 
+  std::string cacheKey();
+  TString cacheFileName( const std::string &key );
+  bool loadFromCache( const std::string &key );
+  void saveToCache( const std::string &key );
+
   TString mConfigFile;
   std::map<std::string,double> mBeamParametersMap;
   std::map<std::string,std::string> mBeamHistNameMap;
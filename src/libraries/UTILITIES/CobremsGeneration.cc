@@ -56,6 +56,7 @@
 #include <CobremsGeneration.hh>
 #include <boost/math/special_functions/expint.hpp>
 #include <boost/math/special_functions/erf.hpp>
+#include <algorithm>
 
 const double CobremsGeneration::dpi = 3.1415926535897;
 const double CobremsGeneration::me = 0.510998910e-3;
@@ -574,11 +575,79 @@ double CobremsGeneration::Rate_dNcdxdp(double x, double phi)
    double sigma0 = 16 * dpi * fTargetThickness * Z*Z * pow(alpha, 3) *
                    fBeamEnergy * hbarc/(a*a) * pow(hbarc / (a * me), 4);
 
+   updateReciprocalLattice();
+
    fQ2theta2.clear();
    fQ2weight.clear();
    double qzmin = 99;
    int hmin, kmin, lmin;
    double sum = 0;
+   for (unsigned int n=0; n < fReciprocalLattice.size(); ++n) {
+      const reciprocal_vector &v = fReciprocalLattice[n];
+      double xmax = 2 * fBeamEnergy * v.qz;
+      xmax /= xmax + me*me;
+      if (x > xmax || xmax > 1) {
+         continue;
+      }
+
+#if COBREMS_GENERATOR_VERBOSITY > 2
+      else {
+         std::cout << v.h << "," << v.k << "," << v.l << ","
+                   << v.S2 << "," << v.q2 << "," << xmax
+                   << std::endl;
+      }
+#endif
+
+      if (v.qz < qzmin) {
+         qzmin = v.qz;
+         hmin = v.h;
+         kmin = v.k;
+         lmin = v.l;
+      }
+      double theta2 = (1 - x) * xmax / (x * (1 - xmax) + 1e-99) - 1;
+      sum += sigma0 * v.qT2 * v.S2 * v.FF2 * v.DW *
+             ((1 - x) / pow(x * (1 + theta2) + 1e-99, 2)) *
+             ((1 + pow(1 - x, 2)) - 8 * (theta2 / pow(1 + theta2, 2) * 
+                                        (1 - x) * pow(cos(phi), 2))) *
+             ((fCollimatedFlag)? Acceptance(theta2) : 1) *
+             ((fPolarizedFlag)? Polarization(x, theta2, phi) : 1);
+      fQ2theta2.push_back(theta2);
+      fQ2weight.push_back(sum);
+   }
+
+#if COBREMS_GENERATOR_VERBOSITY > 1
+   if (qzmin < 99) {
+#else
+   if (false) {
+#endif
+      std::cout << hmin << "," << kmin << "," << lmin
+                << " is the best plane at x=" << x
+                << std::endl;
+   }
+
+   return sum;
+}
+
+void CobremsGeneration::updateReciprocalLattice()
+{
+   // Rebuild the list of reciprocal lattice vectors that can contribute
+   // to the coherent sum in Rate_dNcdxdp, unless it is already there for
+   // the present crystal and orientation. This is the part of the sum
+   // that does not depend on x or phi.
+
+   std::vector<double> key;
+   for (int i=0; i < 3; ++i)
+      for (int j=0; j < 3; ++j)
+         key.push_back(fTargetRmatrix[i][j]);
+   key.push_back(fTargetCrystal.lattice_constant);
+   key.push_back(fTargetCrystal.betaFF);
+   key.push_back(fTargetCrystal.Debye_Waller_const);
+   if (key == fReciprocalLatticeKey)
+      return;
+   fReciprocalLatticeKey = key;
+   fReciprocalLattice.clear();
+
+   double a = fTargetCrystal.lattice_constant;
    // can restrict to h=0 for cpu speedup, if crystal alignment is "reasonable"
    for (int h = -4; h <= 4; ++h) {
       for (int k = -10; k <= 10; ++k) {
@@ -616,55 +685,22 @@ double CobremsGeneration::Rate_dNcdxdp(double x, double phi)
             q[2] = qnorm * (fTargetRmatrix[2][0] * h +
                             fTargetRmatrix[2][1] * k +
                             fTargetRmatrix[2][2] * l);
-            double q2 = q[0]*q[0] + q[1]*q[1] + q[2]*q[2];
-            double qT2 = q[0]*q[0] + q[1]*q[1];
-            double xmax = 2 * fBeamEnergy * q[2];
-            xmax /= xmax + me*me;
-            if (x > xmax || xmax > 1) {
-               continue;
-            }
-
-#if COBREMS_GENERATOR_VERBOSITY > 2
-            else {
-               std::cout << h << "," << k << "," << l << ","
-                         << S2 << "," << q2 << "," << xmax
-                         << std::endl;
-            }
-#endif
-
-            if (q[2] < qzmin) {
-               qzmin = q[2];
-               hmin = h;
-               kmin = k;
-               lmin = l;
-            }
-            double theta2 = (1 - x) * xmax / (x * (1 - xmax) + 1e-99) - 1;
+            reciprocal_vector v;
+            v.h = h;
+            v.k = k;
+            v.l = l;
+            v.qz = q[2];
+            v.q2 = q[0]*q[0] + q[1]*q[1] + q[2]*q[2];
+            v.qT2 = q[0]*q[0] + q[1]*q[1];
+            v.S2 = S2;
             double betaFF2 = pow(fTargetCrystal.betaFF, 2);
-            double FF = 1 / (1 + q2 * betaFF2);
-            sum += sigma0 * qT2 * S2 * pow(FF * betaFF2, 2) *
-                   exp(-q2 * fTargetCrystal.Debye_Waller_const) *
-                   ((1 - x) / pow(x * (1 + theta2) + 1e-99, 2)) *
-                   ((1 + pow(1 - x, 2)) - 8 * (theta2 / pow(1 + theta2, 2) * 
-                                              (1 - x) * pow(cos(phi), 2))) *
-                   ((fCollimatedFlag)? Acceptance(theta2) : 1) *
-                   ((fPolarizedFlag)? Polarization(x, theta2, phi) : 1);
-            fQ2theta2.push_back(theta2);
-            fQ2weight.push_back(sum);
+            double FF = 1 / (1 + v.q2 * betaFF2);
+            v.FF2 = pow(FF * betaFF2, 2);
+            v.DW = exp(-v.q2 * fTargetCrystal.Debye_Waller_const);
+            fReciprocalLattice.push_back(v);
          }
       }
    }
-
-#if COBREMS_GENERATOR_VERBOSITY > 1
-   if (qzmin < 99) {
-#else
-   if (false) {
-#endif
-      std::cout << hmin << "," << kmin << "," << lmin
-                << " is the best plane at x=" << x
-                << std::endl;
-   }
-
-   return sum;
 }
 
 double CobremsGeneration::Rate_dNidx(double x)
@@ -866,7 +902,140 @@ double CobremsGeneration::Acceptance(double theta2)
    // multiple-scattering in the target contribute to smearing of the
    // angular acceptance at the the collimator edge. The argument theta2
    // is the production polar angle theta^2 expressed in units of 
-   // (me/fBeamEnergy)^2.
+   // (me/fBeamEnergy)^2. The value is interpolated from a table of
+   // AcceptanceIntegral that is rebuilt when the beamline changes.
+
+   updateAcceptanceTable();
+   const acceptance_table &table = fAcceptanceTables[0];
+   double theta = sqrt(theta2);
+   if (theta <= table.theta_one)
+      return 1;
+   else if (theta >= table.theta_zero)
+      return 0;
+   int n = std::upper_bound(table.theta.begin(), table.theta.end(), theta) -
+           table.theta.begin();
+   if (n < 1)
+      n = 1;
+   else if (n > (int)table.theta.size() - 1)
+      n = table.theta.size() - 1;
+   double h = table.theta[n] - table.theta[n-1];
+   double a = (table.theta[n] - theta) / h;
+   double b = 1 - a;
+   return a * table.value[n-1] + b * table.value[n] +
+          ((a*a*a - a) * table.d2value[n-1] +
+           (b*b*b - b) * table.d2value[n]) * h*h / 6;
+}
+
+void CobremsGeneration::updateAcceptanceTable()
+{
+   // Make sure fAcceptanceTables[0] holds the acceptance table for the
+   // present beamline and radiator, either by moving it to the front if
+   // it was built already, or by building it. The nodes are placed by
+   // splitting intervals in theta until linear interpolation across each
+   // is good to 1e-6, so they cluster around the collimator edge. The few
+   // most recent tables are kept, for callers that switch back and forth
+   // between collimator settings like Rate_dNtdx(x, distance, diameter).
+
+   std::vector<double> key;
+   key.push_back(fCollimatorDiameter);
+   key.push_back(fCollimatorDistance);
+   key.push_back(fCollimatorSpotrms);
+   key.push_back(fBeamEnergy);
+   key.push_back(fTargetThickness);
+   key.push_back(fTargetCrystal.Z);
+   key.push_back(fTargetCrystal.A);
+   key.push_back(fTargetCrystal.density);
+   key.push_back(fTargetCrystal.lattice_constant);
+   key.push_back(fTargetCrystal.radiation_length);
+   for (unsigned int i=0; i < fAcceptanceTables.size(); ++i) {
+      if (fAcceptanceTables[i].key == key) {
+         if (i > 0)
+            std::swap(fAcceptanceTables[0], fAcceptanceTables[i]);
+         return;
+      }
+   }
+   const unsigned int max_tables = 4;
+   if (fAcceptanceTables.size() == max_tables)
+      fAcceptanceTables.pop_back();
+   fAcceptanceTables.insert(fAcceptanceTables.begin(), acceptance_table());
+   acceptance_table &table = fAcceptanceTables[0];
+   table.key = key;
+
+   // same limits as in AcceptanceIntegral, beyond theta_zero the
+   // acceptance is below exp(-40)
+   double thetaC = fCollimatorDiameter / (2 * fCollimatorDistance) *
+                                              fBeamEnergy / me;
+   double var0 = pow((fCollimatorSpotrms / fCollimatorDistance) *
+                                              fBeamEnergy / me, 2);
+   double varMS = Sigma2MS(fTargetThickness) * pow(fBeamEnergy / me, 2);
+   table.theta_one = thetaC - sqrt(20 * (var0 + varMS));
+   table.theta_zero = thetaC + sqrt(80 * (var0 + varMS));
+   double theta0 = (table.theta_one > 0)? table.theta_one : 0;
+
+   const int ninitial = 32;
+   const int maxdepth = 16;
+   const double tolerance = 1e-6;
+   double dtheta = (table.theta_zero - theta0) / ninitial;
+   table.theta.push_back(theta0);
+   table.value.push_back(AcceptanceIntegral(theta0 * theta0));
+   for (int n=0; n < ninitial; ++n) {
+      double t1 = theta0 + (n + 1) * dtheta;
+      double v1 = AcceptanceIntegral(t1 * t1);
+      // depth-first split of [theta.back(),t1], with the right
+      // halves still to be done kept on a stack
+      std::vector<double> stack_t(1, t1);
+      std::vector<double> stack_v(1, v1);
+      std::vector<int> stack_depth(1, 0);
+      while (stack_t.size() > 0) {
+         double ta = table.theta.back();
+         double va = table.value.back();
+         double tb = stack_t.back();
+         double vb = stack_v.back();
+         int depth = stack_depth.back();
+         double tm = (ta + tb) / 2;
+         double vm = AcceptanceIntegral(tm * tm);
+         if (depth < maxdepth && fabs(vm - (va + vb) / 2) > tolerance) {
+            stack_t.push_back(tm);
+            stack_v.push_back(vm);
+            stack_depth.back() = depth + 1;
+            stack_depth.push_back(depth + 1);
+         }
+         else {
+            table.theta.push_back(tm);
+            table.value.push_back(vm);
+            table.theta.push_back(tb);
+            table.value.push_back(vb);
+            stack_t.pop_back();
+            stack_v.pop_back();
+            stack_depth.pop_back();
+         }
+      }
+   }
+
+   // natural cubic spline through the nodes
+   int nnodes = table.theta.size();
+   table.d2value.assign(nnodes, 0);
+   std::vector<double> work(nnodes, 0);
+   for (int i=1; i < nnodes - 1; ++i) {
+      double sig = (table.theta[i] - table.theta[i-1]) /
+                   (table.theta[i+1] - table.theta[i-1]);
+      double p = sig * table.d2value[i-1] + 2;
+      table.d2value[i] = (sig - 1) / p;
+      work[i] = (table.value[i+1] - table.value[i]) /
+                (table.theta[i+1] - table.theta[i]) -
+                (table.value[i] - table.value[i-1]) /
+                (table.theta[i] - table.theta[i-1]);
+      work[i] = (6 * work[i] / (table.theta[i+1] - table.theta[i-1]) -
+                 sig * work[i-1]) / p;
+   }
+   for (int i = nnodes - 2; i > 0; --i)
+      table.d2value[i] = table.d2value[i] * table.d2value[i+1] + work[i];
+}
+
+double CobremsGeneration::AcceptanceIntegral(double theta2)
+{
+   // Computes the acceptance returned by Acceptance(theta2) by direct
+   // numerical integration over the smearing of the collimator edge.
 
    double acceptance = 0;
    double niter = 50;
@@ -172,6 +172,9 @@ class CobremsGeneration {
  private:
    void resetTargetOrientation();
    void updateTargetOrientation();
+   void updateReciprocalLattice();
+   void updateAcceptanceTable();
+   double AcceptanceIntegral(double theta2);
 
    // description of the radiator crystal lattice, here configured for diamond
    // but may be customized to describe any regular crystal
@@ -228,6 +231,36 @@ class CobremsGeneration {
 
    // parameters controlling Monte Carlo generation of photons
    double fPhotonEnergyMin;            // GeV
+
+   // reciprocal lattice vectors entering the coherent sum, with the
+   // factors in each term that depend only on the crystal and its
+   // orientation, built for the settings recorded in the key
+   struct reciprocal_vector {
+      int h;
+      int k;
+      int l;
+      double qz;                       // GeV
+      double q2;                       // GeV^2
+      double qT2;                      // GeV^2
+      double S2;                       // unit cell structure factor squared
+      double FF2;                      // (FF * betaFF^2)^2, 1/GeV^4
+      double DW;                       // Debye-Waller factor
+   };
+   std::vector<reciprocal_vector> fReciprocalLattice;
+   std::vector<double> fReciprocalLatticeKey;
+
+   // collimator acceptance tabulated in theta (units of me/fBeamEnergy)
+   // at adaptively chosen nodes, interpolated with a cubic spline, one
+   // table for each of the last few beamline settings used
+   struct acceptance_table {
+      std::vector<double> key;
+      double theta_one;                // acceptance is 1 below this
+      double theta_zero;               // acceptance is 0 above this
+      std::vector<double> theta;
+      std::vector<double> value;
+      std::vector<double> d2value;     // spline second derivatives
+   };
+   std::vector<acceptance_table> fAcceptanceTables;   // most recent first
 };
 
 inline void CobremsGeneration::setBeamEmittance(double emit_m_r) {
@@ -0,0 +1,97 @@
+/*
+ *  ForkedFits.cc
+ *
+ *  Running a set of fits in forked child processes, see ForkedFits.h.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ForkedFits.h"
+
+using namespace std;
+
+void runForked( int numFits, int numProc, function<void(int)> setup,
+                function<FitOutcome(int)> fit, vector<FitOutcome>& outcomes ) {
+
+	// the mapping starts out zeroed, i.e. with no fit done
+	struct shared_outcome_t {
+		FitOutcome outcome;
+		bool done;
+	};
+
+	size_t size = numFits * sizeof(shared_outcome_t);
+	void* mem = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+	if( mem == MAP_FAILED ){
+		cout << "ERROR: unable to map memory for the fit results, running fits sequentially" << endl;
+		for( int i = 0; i < numFits; i++ ){
+			setup( i );
+			outcomes[i] = fit( i );
+		}
+		return;
+	}
+	shared_outcome_t* shared = (shared_outcome_t*)mem;
+
+	int running = 0;
+	for( int i = 0; i < numFits; i++ ){
+
+		// wait for a free slot
+		while( running >= numProc ){
+			if( wait( NULL ) > 0 ) running--;
+		}
+
+		setup( i );
+
+		// don't let the children repeat what is still buffered
+		cout.flush();
+		fflush( stdout );
+
+		pid_t pid = fork();
+		if( pid == 0 ){
+			shared[i].outcome = fit( i );
+			shared[i].done = true;
+			cout.flush();
+			fflush( stdout );
+			_exit( 0 );
+		}
+		else if( pid < 0 ){
+			cout << "ERROR: unable to fork, running fit " << i << " in this process" << endl;
+			shared[i].outcome = fit( i );
+			shared[i].done = true;
+		}
+		else running++;
+	}
+	while( running > 0 ){
+		if( wait( NULL ) > 0 ) running--;
+		else break;
+	}
+
+	for( int i = 0; i < numFits; i++ ){
+		if( shared[i].done ){
+			outcomes[i] = shared[i].outcome;
+		}
+		else {
+			cout << "ERROR: fit " << i << " did not finish" << endl;
+			outcomes[i].likelihood = 1e6;
+			outcomes[i].failed = true;
+		}
+	}
+	munmap( mem, size );
+}
+
+bool copyFile( const string& from, const string& to ) {
+
+	ifstream in( from.c_str(), ios::binary );
+	ofstream out( to.c_str(), ios::binary );
+	if( !in.is_open() || !out.is_open() ){
+		cout << "ERROR: unable to copy " << from << " to " << to << endl;
+		return false;
+	}
+	out << in.rdbuf();
+	return true;
+}
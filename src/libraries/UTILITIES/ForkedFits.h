@@ -0,0 +1,35 @@
+#if !defined(FORKEDFITS)
+#define FORKEDFITS
+
+/*
+ *  ForkedFits.h
+ *
+ *  Running a set of AmpTools fits in parallel as child processes forked
+ *  from the one that loaded the data, shared by fit -j and fit_bins.
+ */
+
+#include <string>
+#include <vector>
+#include <functional>
+
+// outcome of one of the fits
+struct FitOutcome {
+  double likelihood;
+  bool failed;
+};
+
+// Runs fit(i) for i = 0 .. numFits-1, at most numProc at a time, each in
+// a child process forked from this one.  The children share the data and
+// normalization integrals already loaded into the AmpToolsInterface (the
+// pages are only copied if written to), and hand their outcome back
+// through shared memory.  setup(i) is called here, in order, just before
+// fit i is forked off, so each fit starts from the parameters it would
+// have had in a sequential loop.
+void runForked( int numFits, int numProc, std::function<void(int)> setup,
+                std::function<FitOutcome(int)> fit,
+                std::vector<FitOutcome>& outcomes );
+
+// copies the file from to the file to, false if either can't be opened
+bool copyFile( const std::string& from, const std::string& to );
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ *  HistogramSampler.cc
+ *
+ *  Inverse-CDF tables for drawing random numbers from histograms, see
+ *  HistogramSampler.h.
+ */
+
+#include <algorithm>
+
+#include "TRandom.h"
+
+#include "HistogramSampler.h"
+
+using namespace std;
+
+HistogramSampler::HistogramSampler( const TH1* hist ) {
+
+	int nBins = hist->GetNbinsX();
+	vector<double> contents( nBins );
+	for( int i = 0; i < nBins; i++ )
+		contents[i] = hist->GetBinContent( i + 1 );
+
+	fillTable( hist->GetXaxis(), contents );
+}
+
+void HistogramSampler::fillTable( const TAxis* axis, const vector<double>& contents ) {
+
+	// cumulative sum over the bins, without under- and overflow,
+	// as TH1::ComputeIntegral; bins with negative contents count as empty
+	int nBins = contents.size();
+	mEdges.resize( nBins + 1 );
+	mCdf.resize( nBins + 1 );
+	mCdf[0] = 0;
+	for( int i = 0; i < nBins; i++ ) {
+		mEdges[i] = axis->GetBinLowEdge( i + 1 );
+		mCdf[i + 1] = mCdf[i] + max( contents[i], 0. );
+	}
+	mEdges[nBins] = axis->GetBinUpEdge( nBins );
+
+	double total = mCdf[nBins];
+	if( !( total > 0 ) ) {
+		mEdges.clear();
+		mCdf.clear();
+		return;
+	}
+	for( int i = 1; i <= nBins; i++ )
+		mCdf[i] /= total;
+}
+
+double HistogramSampler::Sample( double r ) const {
+
+	if( mCdf.empty() ) return 0;
+
+	// bin with mCdf[bin] < r <= mCdf[bin + 1], or the first bin with
+	// mCdf[bin] == r, as TMath::BinarySearch does for TH1::GetRandom
+	int nBins = mCdf.size() - 1;
+	int bin = lower_bound( mCdf.begin(), mCdf.begin() + nBins, r ) - mCdf.begin();
+	if( bin == nBins || mCdf[bin] != r ) bin--;
+
+	double x = mEdges[bin];
+	if( r > mCdf[bin] )
+		x += ( mEdges[bin + 1] - mEdges[bin] ) *
+			( r - mCdf[bin] ) / ( mCdf[bin + 1] - mCdf[bin] );
+	return x;
+}
+
+double HistogramSampler::Sample() const {
+
+	return Sample( gRandom->Rndm() );
+}
+
+HistogramSliceSampler::HistogramSliceSampler( const TH2* hist, bool interpolate ) :
+	mInterpolate( interpolate ) {
+
+	const TAxis* xAxis = hist->GetXaxis();
+	int nBinsX = hist->GetNbinsX();
+	int nBinsY = hist->GetNbinsY();
+
+	mSlices.resize( nBinsX );
+	mXEdges.resize( nBinsX + 1 );
+	mCenters.resize( nBinsX );
+	vector<double> contents( nBinsY );
+	for( int ix = 0; ix < nBinsX; ix++ ) {
+		mXEdges[ix] = xAxis->GetBinLowEdge( ix + 1 );
+		mCenters[ix] = xAxis->GetBinCenter( ix + 1 );
+		for( int iy = 0; iy < nBinsY; iy++ )
+			contents[iy] = hist->GetBinContent( ix + 1, iy + 1 );
+		mSlices[ix].fillTable( hist->GetYaxis(), contents );
+	}
+	mXEdges[nBinsX] = xAxis->GetBinUpEdge( nBinsX );
+}
+
+bool HistogramSliceSampler::Sample( double x, double r1, double r2, double& y ) const {
+
+	int nBins = mSlices.size();
+	if( nBins == 0 || !( x >= mXEdges[0] && x < mXEdges[nBins] ) )
+		return false;
+
+	int bin = upper_bound( mXEdges.begin(), mXEdges.end(), x ) - mXEdges.begin() - 1;
+
+	// the neighbouring slice on the side of x, picked with a probability
+	// growing from 0 at the center of this bin to 1/2 at its edge
+	int other = bin;
+	double weight = 0;
+	if( mInterpolate ) {
+		if( x < mCenters[bin] && bin > 0 ) {
+			other = bin - 1;
+			weight = ( mCenters[bin] - x ) / ( mCenters[bin] - mCenters[other] );
+		}
+		else if( x > mCenters[bin] && bin < nBins - 1 ) {
+			other = bin + 1;
+			weight = ( x - mCenters[bin] ) / ( mCenters[other] - mCenters[bin] );
+		}
+	}
+
+	int slice = ( r1 < weight ? other : bin );
+	if( mSlices[slice].IsEmpty() )
+		slice = ( slice == bin ? other : bin );
+	if( mSlices[slice].IsEmpty() )
+		return false;
+
+	y = mSlices[slice].Sample( r2 );
+	return true;
+}
+
+bool HistogramSliceSampler::Sample( double x, double& y ) const {
+
+	double r1 = gRandom->Rndm();
+	double r2 = gRandom->Rndm();
+	return Sample( x, r1, r2, y );
+}
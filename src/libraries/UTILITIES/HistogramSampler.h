@@ -0,0 +1,75 @@
+#if !defined(HISTOGRAMSAMPLER)
+#define HISTOGRAMSAMPLER
+
+/*
+ *  HistogramSampler.h
+ *
+ *  Inverse-CDF tables for drawing random numbers from histograms in the
+ *  event loop of a generator, built once at startup.
+ *
+ *  HistogramSampler draws x distributed as a TH1, e.g. the beam flux from
+ *  BeamProperties.  For the same uniform number it returns the same x as
+ *  TH1::GetRandom, but it only reads its own table, so several threads
+ *  can draw from it at once, each with its own generator.
+ *
+ *  HistogramSliceSampler draws y from the slice of a TH2 at a given x,
+ *  e.g. the polar angle from a differential cross section vs. beam energy,
+ *  in place of h->ProjectionY(...)->GetRandom() for every event.  One
+ *  table is kept per x bin; between the centers of two neighbouring bins
+ *  the slice is chosen at random, with weights falling off linearly with
+ *  the distance to each center, so that the y distribution follows x
+ *  smoothly instead of jumping at the bin edges.
+ */
+
+#include <vector>
+
+#include "TH1.h"
+#include "TH2.h"
+
+class HistogramSampler {
+
+public:
+
+  HistogramSampler() {};
+  HistogramSampler( const TH1* hist );
+
+  // x for the uniform number r in [0,1), as TH1::GetRandom
+  double Sample( double r ) const;
+  // x from gRandom
+  double Sample() const;
+
+  // true if the histogram had no positive contents
+  inline bool IsEmpty() const { return mCdf.empty(); };
+
+private:
+
+  friend class HistogramSliceSampler;
+
+  void fillTable( const TAxis* axis, const std::vector<double>& contents );
+
+  std::vector<double> mEdges;   // low edges of the bins and the upper edge
+  std::vector<double> mCdf;     // normalized, mCdf[0] = 0, one per edge
+};
+
+class HistogramSliceSampler {
+
+public:
+
+  HistogramSliceSampler() {};
+  HistogramSliceSampler( const TH2* hist, bool interpolate = true );
+
+  // y at x, from the uniform numbers r1 (for the choice of slice) and r2
+  // in [0,1); false if neither slice nearest to x has any contents
+  bool Sample( double x, double r1, double r2, double& y ) const;
+  // y at x from gRandom
+  bool Sample( double x, double& y ) const;
+
+private:
+
+  std::vector<HistogramSampler> mSlices;   // one per x bin, mSlices[0] for bin 1
+  std::vector<double> mXEdges;             // low edges of the x bins and the upper edge
+  std::vector<double> mCenters;            // of the x bins
+  bool mInterpolate;
+};
+
+#endif
@@ -6,8 +6,10 @@
 #include <vector>
 #include <utility>
 #include <map>
+#include <functional>
 
 #include "TSystem.h"
+#include "TROOT.h"
 
 #include "AMPTOOLS_DATAIO/ROOTDataReader.h"
 #include "AMPTOOLS_DATAIO/ROOTDataReaderBootstrap.h"
@@ -47,6 +49,8 @@
 #include "IUAmpTools/ConfigFileParser.h"
 #include "IUAmpTools/ConfigurationInfo.h"
 
+#include "UTILITIES/ForkedFits.h"
+
 using std::complex;
 using namespace std;
 
@@ -86,7 +90,7 @@ double runSingleFit(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, stri
    return ati.likelihood();
 }
 
-void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string seedfile, int numRnd, double maxFraction) {
+void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string seedfile, int numRnd, double maxFraction, int numProc) {
    AmpToolsInterface ati( cfgInfo );
    string fitName = cfgInfo->fitName();
 
@@ -97,11 +101,7 @@ void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
 
    vector< vector<string> > parRangeKeywords = cfgInfo->userKeywordArguments("parRange");
 
-   // keep track of best fit (mininum log-likelihood)
-   double minLL = 0;
-   int minFitTag = -1;
-
-   for(int i=0; i<numRnd; i++) {
+   auto setup = [&](int i) {
       cout << endl << "###############################" << endl;
       cout << "FIT " << i << " OF " << numRnd << endl;
       cout << endl << "###############################" << endl;
@@ -111,7 +111,9 @@ void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
       for(size_t ipar=0; ipar<parRangeKeywords.size(); ipar++) {
          ati.randomizeParameter(parRangeKeywords[ipar][0], atof(parRangeKeywords[ipar][1].c_str()), atof(parRangeKeywords[ipar][2].c_str()));
       }
+   };
 
+   auto fit = [&](int i) -> FitOutcome {
       if(useMinos)
          fitManager->minosMinimization();
       else
@@ -131,9 +133,27 @@ void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
          ati.fitResults()->writeSeed( seedfile_rand );
       }
 
-      // update best fit
-      if( !fitFailed && ati.likelihood() < minLL ) {
-         minLL = ati.likelihood();
+      FitOutcome outcome = { ati.likelihood(), fitFailed };
+      return outcome;
+   };
+
+   vector<FitOutcome> outcomes(numRnd);
+   if( numProc > 1 )
+      runForked(numRnd, numProc, setup, fit, outcomes);
+   else {
+      for(int i=0; i<numRnd; i++) {
+         setup(i);
+         outcomes[i] = fit(i);
+      }
+   }
+
+   // keep track of best fit (mininum log-likelihood)
+   double minLL = 0;
+   int minFitTag = -1;
+
+   for(int i=0; i<numRnd; i++) {
+      if( !outcomes[i].failed && outcomes[i].likelihood < minLL ) {
+         minLL = outcomes[i].likelihood;
          minFitTag = i;
       }
    }
@@ -142,13 +162,13 @@ void runRndFits(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
    if(minFitTag < 0) cout << "ALL FITS FAILED!" << endl;
    else {
       cout << "MINIMUM LIKELIHOOD FROM " << minFitTag << " of " << numRnd << " RANDOM PRODUCTION PARS = " << minLL << endl;
-      gSystem->Exec(Form("cp %s_%d.fit %s.fit", fitName.data(), minFitTag, fitName.data()));
+      copyFile(Form("%s_%d.fit", fitName.data(), minFitTag), fitName + ".fit");
       if( seedfile.size() != 0 )
-         gSystem->Exec(Form("cp %s_%d.txt %s.txt", seedfile.data(), minFitTag, seedfile.data()));
+         copyFile(Form("%s_%d.txt", seedfile.data(), minFitTag), seedfile + ".txt");
    }
 }
 
-void runParScan(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string seedfile, string parScan) {
+void runParScan(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string seedfile, string parScan, int numProc) {
    double minVal=0, maxVal=0, stepSize=0;
    int steps=0;
 
@@ -180,30 +200,32 @@ void runParScan(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
    fitManager->setMaxIterations(maxIter);
 
 
-   for(int i=0; i<steps; i++) {
-      cout << endl << "###############################" << endl;
-      cout << "FIT " << i << " OF " << steps << endl;
-      cout << endl << "###############################" << endl;
+   // set parameter to be scanned
+   vector<ParameterInfo*> parInfoVec = cfgInfo->parameterList();
 
-      // set parameter to be scanned
-      vector<ParameterInfo*> parInfoVec = cfgInfo->parameterList();
+   auto parItr = parInfoVec.begin();
+   for( ; parItr != parInfoVec.end(); ++parItr ) {
+      if( (**parItr).parName() == parScan ) break;
+   }
 
-      auto parItr = parInfoVec.begin();
-      for( ; parItr != parInfoVec.end(); ++parItr ) {
-         if( (**parItr).parName() == parScan ) break;
-      }
+   if( parItr == parInfoVec.end() ){
+      cout << "ERROR:  request to scan nonexistent parameter:  " << parScan << endl;
+      return;
+   }
 
-      if( parItr == parInfoVec.end() ){
-         cout << "ERROR:  request to scan nonexistent parameter:  " << parScan << endl;
-         return;
-      }
+   auto setup = [&](int i) {
+      cout << endl << "###############################" << endl;
+      cout << "FIT " << i << " OF " << steps << endl;
+      cout << endl << "###############################" << endl;
 
       // set and fix parameter for scan
       double value = minVal + i*stepSize;
       parMgr->setAmpParameter( parScan, value );
 
       cfgInfo->setFitName(fitName + "_scan");
+   };
 
+   auto fit = [&](int i) -> FitOutcome {
       if(useMinos)
          fitManager->minosMinimization();
       else
@@ -222,6 +244,25 @@ void runParScan(ConfigurationInfo* cfgInfo, bool useMinos, int maxIter, string s
          string seedfile_scan = seedfile + Form("_scan_%d.txt", i);
          ati.fitResults()->writeSeed( seedfile_scan );
       }
+
+      FitOutcome outcome = { ati.likelihood(), fitFailed };
+      return outcome;
+   };
+
+   vector<FitOutcome> outcomes(steps);
+   if( numProc > 1 )
+      runForked(steps, numProc, setup, fit, outcomes);
+   else {
+      for(int i=0; i<steps; i++) {
+         setup(i);
+         outcomes[i] = fit(i);
+      }
+   }
+
+   cout << endl << "SCAN OF " << parScan << ":" << endl;
+   for(int i=0; i<steps; i++) {
+      cout << "   " << parScan << " = " << minVal + i*stepSize << "   LIKELIHOOD = " << outcomes[i].likelihood
+           << ( outcomes[i].failed ? "   (FIT FAILED)" : "" ) << endl;
    }
 }
 
@@ -236,6 +277,7 @@ int main( int argc, char* argv[] ){
    string scanPar;
    int numRnd = 0;
    int maxIter = 10000;
+   int numProc = 1;
 
    // parse command line
 
@@ -255,6 +297,9 @@ int main( int argc, char* argv[] ){
       if (arg == "-m"){
          if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
          else  maxIter = atoi(argv[++i]); }
+      if (arg == "-j"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  numProc = atoi(argv[++i]); }
       if (arg == "-n") useMinos = true;
       if (arg == "-p"){
          if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
@@ -267,6 +312,7 @@ int main( int argc, char* argv[] ){
          cout << "   -r <int>\t\t\t Perform <int> fits each seeded with random parameters" << endl;
          cout << "   -p <parameter> \t\t\t\t Perform a scan of given parameter. Stepsize, min, max are to be set in cfg file" << endl;
          cout << "   -m <int>\t\t\t Maximum number of fit iterations" << endl; 
+         cout << "   -j <int>\t\t\t Run up to <int> of the -r or -p fits at a time, in separate processes" << endl;
          exit(1);}
    }
 
@@ -275,6 +321,10 @@ int main( int argc, char* argv[] ){
       exit(1);
    }
 
+   // the ROOTDataReaders read their input with several threads only
+   // if ROOT has been made thread safe
+   ROOT::EnableThreadSafety();
+
    ConfigFileParser parser(configfile);
    ConfigurationInfo* cfgInfo = parser.getConfigurationInfo();
    cfgInfo->display();
@@ -312,9 +362,9 @@ int main( int argc, char* argv[] ){
       if(scanPar=="")
          runSingleFit(cfgInfo, useMinos, maxIter, seedfile);
       else
-         runParScan(cfgInfo, useMinos, maxIter, seedfile, scanPar);
+         runParScan(cfgInfo, useMinos, maxIter, seedfile, scanPar, numProc);
    } else {
-      runRndFits(cfgInfo, useMinos, maxIter, seedfile, numRnd, 0.5);
+      runRndFits(cfgInfo, useMinos, maxIter, seedfile, numRnd, 0.5, numProc);
    }
 
    return 0;
@@ -0,0 +1,533 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <complex>
+#include <string>
+#include <vector>
+#include <utility>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "TSystem.h"
+#include "TROOT.h"
+
+#include "AMPTOOLS_DATAIO/ROOTDataReader.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderBootstrap.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderWithTCut.h"
+#include "AMPTOOLS_DATAIO/ROOTDataReaderTEM.h"
+#include "AMPTOOLS_AMPS/TwoPSAngles.h"
+#include "AMPTOOLS_AMPS/TwoPSHelicity.h"
+#include "AMPTOOLS_AMPS/TwoPiAngles.h"
+#include "AMPTOOLS_AMPS/TwoPiAngles_amp.h"
+#include "AMPTOOLS_AMPS/TwoPiWt_primakoff.h"
+#include "AMPTOOLS_AMPS/TwoPiWt_sigma.h"
+#include "AMPTOOLS_AMPS/TwoPiW_brokenetas.h"
+#include "AMPTOOLS_AMPS/TwoPitdist.h"
+#include "AMPTOOLS_AMPS/TwoPiNC_tdist.h"
+#include "AMPTOOLS_AMPS/TwoPiEtas_tdist.h"
+#include "AMPTOOLS_AMPS/TwoPiAngles_primakoff.h"
+#include "AMPTOOLS_AMPS/ThreePiAngles.h"
+#include "AMPTOOLS_AMPS/ThreePiAnglesSchilling.h"
+#include "AMPTOOLS_AMPS/TwoPiAnglesRadiative.h"
+#include "AMPTOOLS_AMPS/Zlm.h"
+#include "AMPTOOLS_AMPS/BreitWigner.h"
+#include "AMPTOOLS_AMPS/BreitWigner3body.h"
+#include "AMPTOOLS_AMPS/b1piAngAmp.h"
+#include "AMPTOOLS_AMPS/omegapiAngAmp.h"
+#include "AMPTOOLS_AMPS/Uniform.h"
+#include "AMPTOOLS_AMPS/polCoef.h"
+#include "AMPTOOLS_AMPS/dblRegge.h"
+#include "AMPTOOLS_AMPS/dblReggeMod.h"
+#include "AMPTOOLS_AMPS/omegapi_amplitude.h"
+#include "AMPTOOLS_AMPS/Vec_ps_refl.h"
+#include "AMPTOOLS_AMPS/PhaseOffset.h"
+#include "AMPTOOLS_AMPS/Piecewise.h"
+
+#include "MinuitInterface/MinuitMinimizationManager.h"
+#include "IUAmpTools/AmpToolsInterface.h"
+#include "IUAmpTools/FitResults.h"
+#include "IUAmpTools/ConfigFileParser.h"
+#include "IUAmpTools/ConfigurationInfo.h"
+
+#include "UTILITIES/ForkedFits.h"
+
+using std::complex;
+using namespace std;
+
+// Fits every bin of a binned analysis (the bin_<i> directories made by
+// split_mass, split_t or divideData.pl) from one templated config file.
+//
+// The fits run in a pool of -j worker processes forked from this one.
+// Each bin is fit by a job that writes the bin's config file from the
+// template, loads the data and normalization integrals once, and then
+// does the -r random starts of that bin, forking each one off as fit -j
+// does so that they share the loaded data.  A job is normally given one
+// worker; when fewer bins are left than workers are free, the remaining
+// bins share the free workers for their starts.  With -M a job is only
+// started if the peak memory of the jobs already finished says that it
+// fits in the budget next to the ones running.
+//
+// The best start of each bin is copied to <fitname>.fit in its
+// directory, and a summary with one line per bin (likelihood, status and
+// the full path of the .fit file) is written at the end, which
+// project_moments -s reads in place of walking the bin directories.
+
+// outcome of a bin job, shared with the scheduler
+struct BinOutcome {
+   bool done;
+   double likelihood;   // of the best start
+   int bestStart;       // -1 if all starts failed
+   int numConverged;
+   char fitName[256];
+};
+
+struct BinInfo {
+   string name;              // bin_<i>, the last part of the directory
+   string dir;               // full path of the bin directory
+   int index;                // line in the bin list, the histogram bin - 1 for projections
+   map<string, string> subs; // @KEY substitutions in the template
+};
+
+// replaces @KEY, where KEY is a word of letters, digits and _, by its
+// value in subs; unknown keys are left alone
+string substitute(const string& line, const map<string, string>& subs) {
+   string out;
+   size_t i = 0;
+   while( i < line.size() ) {
+      if( line[i] != '@' ) {
+         out += line[i++];
+         continue;
+      }
+      size_t end = i + 1;
+      while( end < line.size() && ( isalnum((unsigned char)line[end]) || line[end] == '_' ) ) end++;
+      auto it = subs.find(line.substr(i + 1, end - i - 1));
+      if( it != subs.end() ) out += it->second;
+      else out += line.substr(i, end - i);
+      i = end;
+   }
+   return out;
+}
+
+bool writeBinConfig(const vector<string>& templ, const BinInfo& bin, const string& cfgFile) {
+   ofstream out(cfgFile.c_str());
+   if( !out.is_open() ) {
+      cout << "ERROR: unable to write " << cfgFile << endl;
+      return false;
+   }
+   for(size_t i=0; i<templ.size(); i++)
+      out << substitute(templ[i], bin.subs) << endl;
+   return true;
+}
+
+string fullPath(const string& path) {
+   char buf[PATH_MAX];
+   if( realpath(path.c_str(), buf) == NULL ) return "";
+   return string(buf);
+}
+
+// Lines of <bin directory> [KEY=value ...], relative to the directory
+// given with -d, or bin_0 .. bin_<n-1> in it if there is no list.
+bool readBins(const string& binList, int numBins, const string& fitDir, vector<BinInfo>& bins) {
+   vector<string> lines;
+   if( binList.size() != 0 ) {
+      ifstream in(binList.c_str());
+      if( !in.is_open() ) {
+         cout << "ERROR: unable to open bin list " << binList << endl;
+         return false;
+      }
+      string line;
+      while( getline(in, line) ) {
+         size_t pos = line.find('#');
+         if( pos != string::npos ) line.erase(pos);
+         if( line.find_first_not_of(" \t\r") != string::npos ) lines.push_back(line);
+      }
+   }
+   else {
+      for(int i=0; i<numBins; i++) lines.push_back("bin_" + to_string(i));
+   }
+
+   for(size_t i=0; i<lines.size(); i++) {
+      istringstream words(lines[i]);
+      string dir, word;
+      words >> dir;
+
+      BinInfo bin;
+      bin.index = i;
+      bin.dir = fullPath(dir[0] == '/' ? dir : fitDir + "/" + dir);
+      if( bin.dir.size() == 0 ) {
+         cout << "ERROR: bin directory " << dir << " does not exist" << endl;
+         return false;
+      }
+      bin.name = bin.dir.substr(bin.dir.rfind('/') + 1);
+      bin.subs["BIN"] = bin.name;
+      bin.subs["DIR"] = bin.dir;
+      bin.subs["INDEX"] = to_string(i);
+      while( words >> word ) {
+         size_t eq = word.find('=');
+         if( eq == string::npos || eq == 0 ) {
+            cout << "ERROR: expected KEY=value, got " << word << " for bin " << dir << endl;
+            return false;
+         }
+         bin.subs[word.substr(0, eq)] = word.substr(eq + 1);
+      }
+      bins.push_back(bin);
+   }
+   return true;
+}
+
+// Runs in the job of one bin, in the bin directory, with the output
+// going to its log file.
+void runBin(const string& cfgFile, bool useMinos, int maxIter, int numRnd,
+            double maxFraction, int numProc, BinOutcome& result) {
+
+   ConfigFileParser parser(cfgFile);
+   ConfigurationInfo* cfgInfo = parser.getConfigurationInfo();
+   cfgInfo->display();
+
+   string fitName = cfgInfo->fitName();
+   strncpy(result.fitName, fitName.c_str(), sizeof(result.fitName) - 1);
+
+   AmpToolsInterface ati( cfgInfo );
+
+   cout << "LIKELIHOOD BEFORE MINIMIZATION:  " << ati.likelihood() << endl;
+
+   MinuitMinimizationManager* fitManager = ati.minuitMinimizationManager();
+   fitManager->setMaxIterations(maxIter);
+
+   vector< vector<string> > parRangeKeywords = cfgInfo->userKeywordArguments("parRange");
+
+   // without -r, a single fit from the values in the config file
+   int numFits = ( numRnd > 0 ? numRnd : 1 );
+
+   auto setup = [&](int i) {
+      if( numRnd == 0 ) return;
+
+      cout << endl << "###############################" << endl;
+      cout << "FIT " << i << " OF " << numRnd << endl;
+      cout << endl << "###############################" << endl;
+
+      ati.randomizeProductionPars(maxFraction);
+      for(size_t ipar=0; ipar<parRangeKeywords.size(); ipar++) {
+         ati.randomizeParameter(parRangeKeywords[ipar][0], atof(parRangeKeywords[ipar][1].c_str()), atof(parRangeKeywords[ipar][2].c_str()));
+      }
+   };
+
+   auto fit = [&](int i) -> FitOutcome {
+      if(useMinos)
+         fitManager->minosMinimization();
+      else
+         fitManager->migradMinimization();
+
+      bool fitFailed = (fitManager->status() != 0 && fitManager->eMatrixStatus() != 3);
+
+      if( fitFailed )
+         cout << "ERROR: fit failed use results with caution..." << endl;
+
+      cout << "LIKELIHOOD AFTER MINIMIZATION:  " << ati.likelihood() << endl;
+
+      if( numRnd > 0 ) ati.finalizeFit(to_string(i));
+      else ati.finalizeFit();
+
+      FitOutcome outcome = { ati.likelihood(), fitFailed };
+      return outcome;
+   };
+
+   vector<FitOutcome> outcomes(numFits);
+   if( numProc > 1 && numFits > 1 )
+      runForked(numFits, numProc, setup, fit, outcomes);
+   else {
+      for(int i=0; i<numFits; i++) {
+         setup(i);
+         outcomes[i] = fit(i);
+      }
+   }
+
+   result.bestStart = -1;
+   result.numConverged = 0;
+   result.likelihood = 0;
+   for(int i=0; i<numFits; i++) {
+      if( outcomes[i].failed ) continue;
+      result.numConverged++;
+      if( result.bestStart < 0 || outcomes[i].likelihood < result.likelihood ) {
+         result.likelihood = outcomes[i].likelihood;
+         result.bestStart = i;
+      }
+   }
+
+   if( result.bestStart < 0 ) cout << "ALL FITS FAILED!" << endl;
+   else if( numRnd > 0 ) {
+      cout << "MINIMUM LIKELIHOOD FROM " << result.bestStart << " of " << numRnd << " RANDOM PRODUCTION PARS = " << result.likelihood << endl;
+      if( !copyFile(Form("%s_%d.fit", fitName.data(), result.bestStart), fitName + ".fit") )
+         result.bestStart = -1;
+   }
+}
+
+// peak resident memory of a finished job in MB
+double peakMB(const struct rusage& usage) {
+   return usage.ru_maxrss / 1024.;   // kB on Linux
+}
+
+int main( int argc, char* argv[] ){
+
+   // set default parameters
+
+   bool useMinos = false;
+
+   string templFile;
+   string binList;
+   string fitDir(".");
+   string summaryFile("fit_bins.txt");
+   int numBins = 0;
+   int numRnd = 0;
+   int maxIter = 10000;
+   int numProc = 1;
+   double memBudget = 0;
+   double memEstimate = 0;
+
+   // parse command line
+
+   for (int i = 1; i < argc; i++){
+
+      string arg(argv[i]);
+
+      if (arg == "-c"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  templFile = argv[++i]; }
+      if (arg == "-l"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  binList = argv[++i]; }
+      if (arg == "-b"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  numBins = atoi(argv[++i]); }
+      if (arg == "-d"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  fitDir = argv[++i]; }
+      if (arg == "-o"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  summaryFile = argv[++i]; }
+      if (arg == "-r"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  numRnd = atoi(argv[++i]); }
+      if (arg == "-m"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  maxIter = atoi(argv[++i]); }
+      if (arg == "-j"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  numProc = atoi(argv[++i]); }
+      if (arg == "-M"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  memBudget = atof(argv[++i]); }
+      if (arg == "-e"){
+         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+         else  memEstimate = atof(argv[++i]); }
+      if (arg == "-n") useMinos = true;
+      if (arg == "-h"){
+         cout << endl << " Usage for: " << argv[0] << endl << endl;
+         cout << "   -c <file>\t\t\t\t template config file, @BIN, @DIR and @INDEX are replaced by" << endl;
+         cout << "            \t\t\t\t the name, full path and index of each bin, @KEY by the values in the bin list" << endl;
+         cout << "   -l <file>\t\t\t\t bin list, one line of <bin directory> [KEY=value ...] per bin" << endl;
+         cout << "   -b <int>\t\t\t\t without -l, fit the bins bin_0 .. bin_<int-1>" << endl;
+         cout << "   -d <dir>\t\t\t\t directory containing the bins (default: .)" << endl;
+         cout << "   -o <file>\t\t\t\t summary of the best fit of each bin (default: fit_bins.txt)" << endl;
+         cout << "   -r <int>\t\t\t\t Perform <int> fits in each bin each seeded with random parameters" << endl;
+         cout << "   -n \t\t\t\t\t use MINOS instead of MIGRAD" << endl;
+         cout << "   -m <int>\t\t\t\t Maximum number of fit iterations" << endl;
+         cout << "   -j <int>\t\t\t\t Run up to <int> fits at a time, in separate processes" << endl;
+         cout << "   -M <MB>\t\t\t\t Memory budget for the fits running at a time" << endl;
+         cout << "   -e <MB>\t\t\t\t Memory of one fit until the first bin is done (default: budget / -j)" << endl;
+         exit(1);}
+   }
+
+   if (templFile.size() == 0){
+      cout << "No config file specified" << endl;
+      exit(1);
+   }
+   if (binList.size() == 0 && numBins <= 0){
+      cout << "No bins specified, use -l or -b" << endl;
+      exit(1);
+   }
+   if (numProc < 1) numProc = 1;
+   if (memBudget > 0 && memEstimate <= 0) memEstimate = memBudget / numProc;
+
+   // the ROOTDataReaders read their input with several threads only
+   // if ROOT has been made thread safe
+   ROOT::EnableThreadSafety();
+
+   vector<string> templ;
+   ifstream templIn(templFile.c_str());
+   if( !templIn.is_open() ){
+      cout << "ERROR: unable to open " << templFile << endl;
+      exit(1);
+   }
+   string line;
+   while( getline(templIn, line) ) templ.push_back(line);
+
+   vector<BinInfo> bins;
+   if( !readBins(binList, numBins, fitDir, bins) ) exit(1);
+
+   AmpToolsInterface::registerAmplitude( BreitWigner() );
+   AmpToolsInterface::registerAmplitude( BreitWigner3body() );
+   AmpToolsInterface::registerAmplitude( TwoPSAngles() );
+   AmpToolsInterface::registerAmplitude( TwoPSHelicity() );
+   AmpToolsInterface::registerAmplitude( TwoPiAngles() );
+   AmpToolsInterface::registerAmplitude( TwoPiAngles_amp() );
+   AmpToolsInterface::registerAmplitude( TwoPiAngles_primakoff() );
+   AmpToolsInterface::registerAmplitude( TwoPiWt_primakoff() );
+   AmpToolsInterface::registerAmplitude( TwoPiWt_sigma() );
+   AmpToolsInterface::registerAmplitude( TwoPitdist() );
+   AmpToolsInterface::registerAmplitude( ThreePiAngles() );
+   AmpToolsInterface::registerAmplitude( ThreePiAnglesSchilling() );
+   AmpToolsInterface::registerAmplitude( TwoPiAnglesRadiative() );
+   AmpToolsInterface::registerAmplitude( Zlm() );
+   AmpToolsInterface::registerAmplitude( b1piAngAmp() );
+   AmpToolsInterface::registerAmplitude( omegapiAngAmp() );
+   AmpToolsInterface::registerAmplitude( polCoef() );
+   AmpToolsInterface::registerAmplitude( Uniform() );
+   AmpToolsInterface::registerAmplitude( dblRegge() );
+   AmpToolsInterface::registerAmplitude( omegapi_amplitude() );
+   AmpToolsInterface::registerAmplitude( Vec_ps_refl() );
+   AmpToolsInterface::registerAmplitude( PhaseOffset() );
+   AmpToolsInterface::registerAmplitude( Piecewise() );
+
+   AmpToolsInterface::registerDataReader( ROOTDataReader() );
+   AmpToolsInterface::registerDataReader( ROOTDataReaderBootstrap() );
+   AmpToolsInterface::registerDataReader( ROOTDataReaderWithTCut() );
+   AmpToolsInterface::registerDataReader( ROOTDataReaderTEM() );
+
+   int numJobs = bins.size();
+   size_t size = numJobs * sizeof(BinOutcome);
+   void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+   if( mem == MAP_FAILED ){
+      cout << "ERROR: unable to map memory for the fit results" << endl;
+      exit(1);
+   }
+   BinOutcome* outcomes = (BinOutcome*)mem;
+
+   // the workers and the memory held by each running job
+   struct job_t { int bin; int slots; double memory; };
+   map<pid_t, job_t> running;
+   int freeSlots = numProc;
+   double memUsed = 0;
+   double memPeak = 0;   // largest peak of a finished job, per worker
+   int numStarts = ( numRnd > 0 ? numRnd : 1 );
+
+   int next = 0;
+   while( next < numJobs || !running.empty() ) {
+
+      // start as many jobs as there are workers and memory for
+      while( next < numJobs && freeSlots > 0 ) {
+
+         // share the free workers between the bins that are left
+         int slots = max(1, freeSlots / (numJobs - next));
+         slots = min(slots, numStarts);
+
+         if( memBudget > 0 ) {
+            double perSlot = ( memPeak > 0 ? memPeak : memEstimate );
+            int inBudget = (int)((memBudget - memUsed) / perSlot);
+            if( inBudget < 1 && !running.empty() ) break;
+            if( inBudget < 1 )
+               cout << "WARNING: " << bins[next].name << " may need more than the memory budget" << endl;
+            slots = max(1, min(slots, inBudget));
+         }
+
+         const BinInfo& bin = bins[next];
+         string cfgFile = bin.dir + "/" + bin.name + ".cfg";
+         if( !writeBinConfig(templ, bin, cfgFile) ) {
+            next++;
+            continue;
+         }
+
+         cout.flush();
+         fflush(stdout);
+
+         pid_t pid = fork();
+         if( pid == 0 ) {
+            string logFile = bin.dir + "/" + bin.name + ".log";
+            int fd = open(logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if( fd < 0 || chdir(bin.dir.c_str()) != 0 ) _exit(1);
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+
+            runBin(cfgFile, useMinos, maxIter, numRnd, 0.5, slots, outcomes[next]);
+            outcomes[next].done = true;
+            cout.flush();
+            fflush(stdout);
+            _exit(0);
+         }
+         else if( pid < 0 ) {
+            cout << "ERROR: unable to fork, waiting for a running fit" << endl;
+            if( running.empty() ) exit(1);
+            break;
+         }
+
+         job_t job = { next, slots, slots * ( memPeak > 0 ? memPeak : memEstimate ) };
+         running[pid] = job;
+         freeSlots -= slots;
+         memUsed += job.memory;
+         cout << "Fitting " << bin.name << " with " << slots << ( slots > 1 ? " processes" : " process" ) << endl;
+         next++;
+      }
+
+      // wait for a job to finish
+      int status;
+      struct rusage usage;
+      pid_t pid = wait4(-1, &status, 0, &usage);
+      if( pid < 0 ) break;
+      auto it = running.find(pid);
+      if( it == running.end() ) continue;
+
+      job_t job = it->second;
+      running.erase(it);
+      freeSlots += job.slots;
+      memUsed -= job.memory;
+      memPeak = max(memPeak, peakMB(usage));
+
+      const BinInfo& bin = bins[job.bin];
+      const BinOutcome& outcome = outcomes[job.bin];
+      if( !outcome.done )
+         cout << "ERROR: " << bin.name << " did not finish, see " << bin.dir << "/" << bin.name << ".log" << endl;
+      else if( outcome.bestStart < 0 )
+         cout << "ERROR: all fits failed in " << bin.name << endl;
+      else
+         cout << bin.name << ":  LIKELIHOOD = " << outcome.likelihood << "  (" << outcome.numConverged
+              << " of " << numStarts << " fits converged)" << endl;
+   }
+
+   // one line per bin, in the order of the bin list
+   ofstream summary(summaryFile.c_str());
+   if( !summary.is_open() ){
+      cout << "ERROR: unable to write " << summaryFile << endl;
+      exit(1);
+   }
+   summary << "# fit_bins -c " << templFile << " -r " << numRnd << endl;
+   summary << "# index  bin  status  likelihood  best_start  converged  starts  fit_file" << endl;
+   int numGood = 0;
+   for(int i=0; i<numJobs; i++) {
+      const BinInfo& bin = bins[i];
+      const BinOutcome& outcome = outcomes[i];
+      bool good = ( outcome.done && outcome.bestStart >= 0 );
+      summary << bin.index << " " << bin.name << " " << ( good ? "ok" : "failed" ) << " "
+              << setprecision(12) << ( good ? outcome.likelihood : 0 ) << " "
+              << ( good ? outcome.bestStart : -1 ) << " " << outcome.numConverged << " " << numStarts << " "
+              << ( good ? bin.dir + "/" + outcome.fitName + ".fit" : string("-") ) << endl;
+      if( good ) numGood++;
+   }
+   munmap(mem, size);
+
+   cout << numGood << " of " << numJobs << " bins fit, summary written to " << summaryFile << endl;
+
+   return ( numGood == numJobs ? 0 : 1 );
+}
@@ -6,7 +6,6 @@
 #include <vector>
 #include <cassert>
 #include <cstdlib>
-#include <unistd.h>
 
 #include "IUAmpTools/FitResults.h"
 
@@ -25,6 +24,7 @@ int main( int argc, char* argv[] ){
   double highMass = 2.00;
   int kNumBins = 86;
   string fitDir("");
+  string summaryFile("");
   
   string outfileName("moments.root");
   bool print = false;
@@ -38,6 +38,9 @@ int main( int argc, char* argv[] ){
     if (arg == "-f"){  
       if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
       else  fitDir = argv[++i]; }
+    if (arg == "-s"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+      else  summaryFile = argv[++i]; }
     if (arg == "-o"){  
       if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
       else  outfileName = argv[++i]; }
@@ -46,6 +49,7 @@ int main( int argc, char* argv[] ){
     if (arg == "-h"){
       cout << endl << " Usage for: " << argv[0] << endl << endl;
       cout << "(optional) -f <fit dir>\t : Fit Directory" << endl;
+      cout << "(optional) -s <file>\t : Summary written by fit_bins, in place of -f" << endl;
       cout << "(optional) -o <file>\t : Output file (default: moments.root)" << endl;
       cout << "(optional) -p\t\t : Print equations" << endl;
       exit(1);}
@@ -136,32 +140,57 @@ int main( int argc, char* argv[] ){
     }
   
   
-  if (fitDir.size() == 0){
+  if (fitDir.size() == 0 && summaryFile.size() == 0){
     cout << "No fit directory specified. Try -h for usage." << endl;
     exit(1);
   }
+
+  // the fit results of each bin, from the bin directories or the
+  // full paths listed in the fit_bins summary
+  vector<string> resultsFiles( kNumBins );
+  if (summaryFile.size() != 0){
+    ifstream summary( summaryFile.c_str() );
+    if (!summary.is_open()){
+      cout << "Unable to open " << summaryFile << endl;
+      exit(1);
+    }
+    string line;
+    while (getline( summary, line )){
+      if (line.size() == 0 || line[0] == '#') continue;
+      istringstream words( line );
+      int index;
+      string bin, status, fitFile;
+      double likelihood;
+      int bestStart, converged, starts;
+      if (!(words >> index >> bin >> status >> likelihood >> bestStart >> converged >> starts >> fitFile)){
+        cout << "Unable to read line of " << summaryFile << ": " << line << endl;
+        exit(1);
+      }
+      if (status != "ok") continue;
+      if (index < 0 || index >= kNumBins){
+        cout << "Bin " << bin << " of the summary is out of range, skipping it" << endl;
+        continue;
+      }
+      resultsFiles[index] = fitFile;
+    }
+  }
+  else{
+    for( int i = 0; i < kNumBins; ++i ){
+      ostringstream resultsFile;
+      resultsFile << fitDir << "/bin_" << i << "/bin_" << i << ".fit";
+      resultsFiles[i] = resultsFile.str();
+    }
+  }
   
   TFile *outfile = new TFile(outfileName.c_str(), "recreate");
   if (!outfile->IsOpen()) exit(1);
 
-  // descend into the directory that contains the bins
-  chdir( fitDir.c_str() );
-  
   for( int i = 0; i < kNumBins; ++i ){
     
-    ostringstream dir;
-    dir << "bin_" << i;
-    chdir( dir.str().c_str() );
-    
-    ostringstream resultsFile;
-    resultsFile << "bin_" << i << ".fit";
-    
-    FitResults results( resultsFile.str() );
-    if( !results.valid() ){
-      
-      chdir( ".." );
-      continue;
-    }
+    if( resultsFiles[i].size() == 0 ) continue;
+
+    FitResults results( resultsFiles[i] );
+    if( !results.valid() ) continue;
 
     if (  2*ws.getNwaves() != results.parValueList().size() ){
       cout << "Different number of waves in fit result. Check waveset!" << endl;
@@ -174,8 +203,6 @@ int main( int argc, char* argv[] ){
 	hMoments[*it]->SetBinContent(i + 1, decomposeMoment(*it, ws, results.parValueList()));
 	hMoments[*it]->SetBinError(i + 1, decomposeMomentError(*it, ws, results.parValueList(), results.errorMatrix()));
       }
-    
-    chdir( ".." );
   }
   
   
@@ -0,0 +1,417 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cassert>
+#include <cstdlib>
+#include <cmath>
+#include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
+#include "IUAmpTools/Kinematics.h"
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TROOT.h"
+#include "TLorentzVector.h"
+
+using namespace std;
+
+#define DEFTREENAME "kin"
+
+// Splits a tree into bins of any combination of the final state mass,
+// t and the beam energy in one pass.  The input is read once, through a
+// TTreeCache holding only the kinematic branches, and the events of each
+// bin are collected in a buffer that is handed to a pool of writer
+// threads when it is full.  Every output file belongs to one writer, so
+// the writers need no locking.  The events held in the buffers and
+// waiting to be written are limited by -b.
+
+void Usage()
+{
+  cout << "Usage:\n  split_bins <infile> <outputBase> <binning> [<binning> ...] [OPTIONS]\n\n";
+  cout << "  Binnings, the output is <outputBase>_<bin>[_<bin>...].root in the order given: \n";
+  cout << "   -m <low> <high> <nBins>    : mass of the final state, without the recoil\n";
+  cout << "   -t <low> <high> <nBins>    : -t, from the recoil and a proton target\n";
+  cout << "   -tlog <low> <high> <nBins> : -t, logarithmic bins (cannot have low = 0)\n";
+  cout << "   -e <low> <high> <nBins>    : beam energy\n";
+  cout << "  Options: \n";
+  cout << "   -M [maxEvents] : Limit total number of events\n";
+  cout << "   -T [treeName]  : Overwrites the default ROOT tree name (\"kin\") in output and/or input files\n";
+  cout << "                    To specify input and output names delimit with \':\' ex. -T inKin:outKin\n";
+  cout << "   -U [treeName]  : Update existing files with new tree, instead of overwriting.\n";
+  cout << "   -j [nThreads]  : Number of writer threads (default 4)\n";
+  cout << "   -b [MB]        : Memory for events waiting to be written (default 512)\n";
+  exit(1);
+}
+
+
+pair <string,string> GetTreeNames(char* treeArg)
+{
+  pair <string,string> treeNames(DEFTREENAME,"");
+  string treeArgStr(treeArg);
+  size_t delimPos=treeArgStr.find(':',1);
+
+  if (delimPos != string::npos){
+    treeNames.first=treeArgStr.substr(0,delimPos);
+    treeNames.second=treeArgStr.substr(delimPos+1);
+  }else
+    treeNames.second=treeArgStr;
+
+  return treeNames;
+}
+
+
+struct Binning {
+
+  enum Variable { kMass, kT, kBeamE };
+
+  Variable var;
+  bool logarithmic;
+  double low;
+  double high;
+  int numBins;
+
+  // bin of value, -1 if it is out of range
+  int bin( double value ) const {
+
+    double x;
+    if( logarithmic ){
+      if( value <= 0 ) return -1;
+      x = ( log10( value ) - log10( low ) ) / ( log10( high ) - log10( low ) );
+    }
+    else
+      x = ( value - low ) / ( high - low );
+
+    int i = static_cast< int >( floor( x * numBins ) );
+    return( ( i >= 0 && i < numBins ) ? i : -1 );
+  }
+};
+
+
+// The events of one bin waiting to be written, one record after another:
+// nPart, then nPart each of E, px, py, pz, then the beam E, px, py, pz
+// and the weight
+struct EventBuffer {
+
+  int bin;
+  vector< float > data;
+};
+
+
+class WriterPool {
+
+public:
+
+  WriterPool( int numThreads, size_t maxQueued ) :
+    m_maxQueued( maxQueued ), m_queued( 0 ), m_done( false ),
+    m_queues( numThreads ) {}
+
+  int numThreads() const { return m_queues.size(); }
+
+  // start the writers, writer i owning the files of the bins
+  // with bin % numThreads == i
+  void start( vector< ROOTDataWriter* >& outFiles, vector< string >& outNames,
+              const string& treeName, bool recreate, bool useWeight ){
+
+    for( int i = 0; i < numThreads(); ++i )
+      m_threads.push_back( thread( &WriterPool::run, this, i, ref( outFiles ),
+                                   ref( outNames ), treeName, recreate, useWeight ) );
+  }
+
+  // hand over a buffer to be written, waiting if too much is queued
+  void push( EventBuffer& buffer ){
+
+    unique_lock< mutex > lock( m_mutex );
+    m_notFull.wait( lock, [&]{ return m_queued < m_maxQueued; } );
+    m_queued += buffer.data.size();
+    deque< EventBuffer >& queue = m_queues[ buffer.bin % numThreads() ];
+    queue.push_back( EventBuffer() );
+    queue.back().bin = buffer.bin;
+    queue.back().data.swap( buffer.data );
+    m_notEmpty.notify_all();
+  }
+
+  // write out what is left and wait for the writers to finish
+  void finish(){
+
+    {
+      lock_guard< mutex > lock( m_mutex );
+      m_done = true;
+    }
+    m_notEmpty.notify_all();
+    for( size_t i = 0; i < m_threads.size(); ++i ) m_threads[i].join();
+  }
+
+private:
+
+  void run( int id, vector< ROOTDataWriter* >& outFiles, vector< string >& outNames,
+            string treeName, bool recreate, bool useWeight ){
+
+    // the files are opened, written and closed by the thread that owns them
+    for( size_t bin = id; bin < outFiles.size(); bin += numThreads() )
+      outFiles[bin] = new ROOTDataWriter( outNames[bin], treeName, recreate, useWeight );
+
+    while( true ){
+
+      EventBuffer buffer;
+      {
+        unique_lock< mutex > lock( m_mutex );
+        m_notEmpty.wait( lock, [&]{ return m_done || !m_queues[id].empty(); } );
+        if( m_queues[id].empty() ) break;
+        buffer.bin = m_queues[id].front().bin;
+        buffer.data.swap( m_queues[id].front().data );
+        m_queues[id].pop_front();
+      }
+
+      ROOTDataWriter* out = outFiles[buffer.bin];
+      const float* record = buffer.data.data();
+      const float* end = record + buffer.data.size();
+      while( record < end ){
+
+        int nPart = static_cast< int >( record[0] );
+        const float* e = record + 1;
+        const float* beam = e + 4 * nPart;
+        out->writeEvent( nPart, e, e + nPart, e + 2 * nPart, e + 3 * nPart,
+                         beam, beam[4] );
+        record = beam + 5;
+      }
+
+      {
+        lock_guard< mutex > lock( m_mutex );
+        m_queued -= buffer.data.size();
+      }
+      m_notFull.notify_all();
+    }
+
+    for( size_t bin = id; bin < outFiles.size(); bin += numThreads() ){
+
+      delete outFiles[bin];
+      outFiles[bin] = NULL;
+    }
+  }
+
+  size_t m_maxQueued;   // in floats
+  size_t m_queued;
+  bool m_done;
+  vector< deque< EventBuffer > > m_queues;
+  vector< thread > m_threads;
+  mutex m_mutex;
+  condition_variable m_notFull;
+  condition_variable m_notEmpty;
+};
+
+
+int main( int argc, char* argv[] ){
+
+  unsigned int maxEvents = 4294967000; //close to 4byte int range
+
+  pair <string,string> treeNames(DEFTREENAME,DEFTREENAME);
+
+  bool recreate=true;
+  int numThreads = 4;
+  double bufferMB = 512;
+
+  if( argc < 4 ) Usage();
+
+  string inName( argv[1] );
+  string outBase( argv[2] );
+
+  vector< Binning > binnings;
+
+  for( int i = 3; i < argc; ++i ){
+
+    string arg=argv[i];
+    if (arg == "-m" || arg == "-t" || arg == "-tlog" || arg == "-e"){
+      if (i+3 >= argc) Usage();
+      Binning binning;
+      binning.var = ( arg == "-m" ? Binning::kMass :
+                      arg == "-e" ? Binning::kBeamE : Binning::kT );
+      binning.logarithmic = ( arg == "-tlog" );
+      binning.low = atof( argv[++i] );
+      binning.high = atof( argv[++i] );
+      binning.numBins = atoi( argv[++i] );
+      if( binning.numBins < 1 || binning.high <= binning.low ||
+          ( binning.logarithmic && binning.low <= 0 ) ) Usage();
+      binnings.push_back( binning );
+    }else if (arg == "-T" || arg == "-U"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else{
+        treeNames = GetTreeNames(argv[++i]);
+        recreate = ( arg == "-T" );
+      }
+    }else if (arg == "-M"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else maxEvents = atoi( argv[++i] );
+    }else if (arg == "-j"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else numThreads = atoi( argv[++i] );
+    }else if (arg == "-b"){
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) Usage();
+      else bufferMB = atof( argv[++i] );
+    }
+    else Usage();
+  }
+
+  if( binnings.size() == 0 || numThreads < 1 || bufferMB <= 0 ) Usage();
+
+  // the bins of the first binning are the slowest changing
+  int numBins = 1;
+  for( size_t i = 0; i < binnings.size(); ++i ) numBins *= binnings[i].numBins;
+
+  vector< string > outNames( numBins );
+  for( int bin = 0; bin < numBins; ++bin ){
+
+    ostringstream outName;
+    outName << outBase;
+    int stride = numBins;
+    for( size_t i = 0; i < binnings.size(); ++i ){
+      stride /= binnings[i].numBins;
+      outName << "_" << ( bin / stride ) % binnings[i].numBins;
+    }
+    outName << ".root";
+    outNames[bin] = outName.str();
+  }
+
+  // open reader, with only the branches we need read through the cache
+  TFile* inFile = TFile::Open( inName.c_str() );
+  TTree* inTree = ( inFile == NULL ? NULL :
+                    dynamic_cast<TTree*>( inFile->Get( treeNames.first.c_str() ) ) );
+  if( inTree == NULL ){
+
+    cerr << "Cannot read tree " << treeNames.first << " from " << inName << endl;
+    exit( 1 );
+  }
+
+  bool useWeight = ( inTree->GetBranch( "Weight" ) != NULL );
+
+  int nPart;
+  float e[Kinematics::kMaxParticles];
+  float px[Kinematics::kMaxParticles];
+  float py[Kinematics::kMaxParticles];
+  float pz[Kinematics::kMaxParticles];
+  float beam[4];
+  float weight = 1;
+
+  vector< string > branches;
+  branches.push_back( "NumFinalState" );
+  branches.push_back( "E_FinalState" );
+  branches.push_back( "Px_FinalState" );
+  branches.push_back( "Py_FinalState" );
+  branches.push_back( "Pz_FinalState" );
+  branches.push_back( "E_Beam" );
+  branches.push_back( "Px_Beam" );
+  branches.push_back( "Py_Beam" );
+  branches.push_back( "Pz_Beam" );
+  if( useWeight ) branches.push_back( "Weight" );
+
+  inTree->SetBranchStatus( "*", 0 );
+  for( size_t i = 0; i < branches.size(); ++i )
+    inTree->SetBranchStatus( branches[i].c_str(), 1 );
+
+  inTree->SetBranchAddress( "NumFinalState", &nPart );
+  inTree->SetBranchAddress( "E_FinalState", e );
+  inTree->SetBranchAddress( "Px_FinalState", px );
+  inTree->SetBranchAddress( "Py_FinalState", py );
+  inTree->SetBranchAddress( "Pz_FinalState", pz );
+  inTree->SetBranchAddress( "E_Beam", &beam[0] );
+  inTree->SetBranchAddress( "Px_Beam", &beam[1] );
+  inTree->SetBranchAddress( "Py_Beam", &beam[2] );
+  inTree->SetBranchAddress( "Pz_Beam", &beam[3] );
+  if( useWeight ) inTree->SetBranchAddress( "Weight", &weight );
+
+  inTree->SetCacheSize( 64 * 1024 * 1024 );
+  for( size_t i = 0; i < branches.size(); ++i )
+    inTree->AddBranchToCache( branches[i].c_str(), kTRUE );
+  inTree->StopCacheLearningPhase();
+
+  // half of the memory for the buffers being filled, half for those
+  // waiting to be written
+  size_t maxFloats = static_cast< size_t >( bufferMB * 1024 * 1024 / sizeof( float ) );
+  size_t flushFloats = maxFloats / 2 / numBins;
+  if( flushFloats < 1024 ) flushFloats = 1024;
+  if( flushFloats > 1024 * 1024 ) flushFloats = 1024 * 1024;
+
+  ROOT::EnableThreadSafety();
+
+  vector< ROOTDataWriter* > outFiles( numBins, (ROOTDataWriter*)NULL );
+  WriterPool writers( numThreads < numBins ? numThreads : numBins, maxFloats / 2 );
+  writers.start( outFiles, outNames, treeNames.second, recreate, useWeight );
+
+  vector< EventBuffer > buffers( numBins );
+  for( int bin = 0; bin < numBins; ++bin ){
+
+    buffers[bin].bin = bin;
+    buffers[bin].data.reserve( flushFloats + 4 * Kinematics::kMaxParticles + 6 );
+  }
+
+  vector< unsigned long > events( numBins, 0 );
+
+  TLorentzVector Target(0,0,0,0.938272046);
+
+  long long nEntries = inTree->GetEntries();
+  if( nEntries > maxEvents ) nEntries = maxEvents;
+
+  for( long long entry = 0; entry < nEntries; ++entry ){
+
+    inTree->GetEntry( entry );
+    assert( nPart < Kinematics::kMaxParticles );
+
+    int bin = 0;
+    for( size_t i = 0; i < binnings.size() && bin >= 0; ++i ){
+
+      double value = 0;
+      if( binnings[i].var == Binning::kMass ){
+
+        // the first final state particle is the recoil
+        TLorentzVector x;
+        for( int j = 1; j < nPart; ++j ) x += TLorentzVector( px[j], py[j], pz[j], e[j] );
+        value = x.M();
+      }
+      else if( binnings[i].var == Binning::kT ){
+
+        TLorentzVector Recoil( px[0], py[0], pz[0], e[0] );
+        value = -1 * (Recoil - Target).M2();
+      }
+      else value = beam[0];
+
+      int ibin = binnings[i].bin( value );
+      bin = ( ibin < 0 ? -1 : bin * binnings[i].numBins + ibin );
+    }
+    if( bin < 0 ) continue;
+
+    vector< float >& data = buffers[bin].data;
+    data.push_back( nPart );
+    data.insert( data.end(), e, e + nPart );
+    data.insert( data.end(), px, px + nPart );
+    data.insert( data.end(), py, py + nPart );
+    data.insert( data.end(), pz, pz + nPart );
+    data.insert( data.end(), beam, beam + 4 );
+    data.push_back( weight );
+    events[bin]++;
+
+    if( data.size() >= flushFloats ){
+
+      writers.push( buffers[bin] );
+      data.reserve( flushFloats + 4 * Kinematics::kMaxParticles + 6 );
+    }
+  }
+
+  for( int bin = 0; bin < numBins; ++bin ){
+
+    if( buffers[bin].data.size() > 0 ) writers.push( buffers[bin] );
+  }
+  writers.finish();
+
+  inFile->Close();
+
+  for( int bin = 0; bin < numBins; ++bin )
+    printf("%s  %10lu events\n", outNames[bin].c_str(), events[bin]);
+
+  return 0;
+}
@@ -129,8 +129,8 @@ int main( int argc, char* argv[] ){
     if( ( bin < numBins ) && ( bin >= 0 ) ){
       
       outFile[bin]->writeEvent( *event );
-      delete event;
     }
+    delete event;
   }
   
   for( int i = 0; i < numBins; ++i ){
@@ -154,8 +154,8 @@ int main( int argc, char* argv[] ){
       TsumSq[bin]+=t*t;
       events[bin]++;
       outFile[bin]->writeEvent( *event );
-      delete event;
     }
+    delete event;
   }
   
   for( int i = 0; i < numBins; ++i ){
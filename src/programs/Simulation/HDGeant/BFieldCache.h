@@ -0,0 +1,187 @@
+// BFieldCache.h
+//
+// Field lookups for gufld_db_ and gufld_ps_ through a regular grid
+// laid over the field map. All of the maps initcalibdb_ can set up are
+// two dimensional: the solenoid maps depend only on r and z, the pair
+// spectrometer maps only on x and z. The field is sampled from the map
+// at the nodes of a square grid in those two coordinates the first time
+// a node is needed, and kept for the rest of the job, in tiles of
+// 32x32 nodes allocated as the tracks reach them. The 4 nodes around
+// the cell last queried are also kept aside, so that the usual query,
+// a few mm from the one before, is just a bilinear interpolation
+// between them.
+//
+// The interpolation error is of order cell^2 times the second
+// derivative of the field, so with the cell smaller than the spacing
+// of the map's own grid the result stays within the interpolation
+// error the map already has. Near the edges of the map, where the
+// field drops to zero, it is smeared over one cell.
+//
+// That has only been checked on mock maps, so the cache is off unless
+// the BFIELD_CACHE_CELL or PS_BFIELD_CACHE_CELL parameter gives a cell
+// size; validation/BFieldCache_benchmark.cc measures the error and the
+// speed-up on the real maps. Each thread has its own cache, see
+// GetFieldCache in calibDB.cc.
+
+#ifndef _BFIELDCACHE_H_
+#define _BFIELDCACHE_H_
+
+#include <cmath>
+#include <stdint.h>
+#include <unordered_map>
+
+template <class MAP>
+class BFieldCache
+{
+   public:
+      enum symmetry_t {
+         kAxial,    // field depends on r and z, (Br,Bphi,Bz) at y=0
+         kPlanar    // field depends on x and z
+      };
+
+      BFieldCache(const MAP *map, symmetry_t symmetry, double cell_cm);
+      ~BFieldCache();
+
+      inline void GetField(float x, float y, float z, float *B);
+
+   private:
+      enum { kTileBits = 5, kTileSize = 1 << kTileBits };
+
+      struct tile_t {
+         float B[kTileSize * kTileSize][3];
+         bool filled[kTileSize * kTileSize];
+      };
+
+      void LoadCell(int iu, int iv);
+      const float *Node(int iu, int iv);
+
+      const MAP *map;
+      symmetry_t symmetry;
+      float cell;
+      float inv_cell;
+      int cell_iu, cell_iv;    // cell whose corners are in Bc
+      bool loaded;
+      float Bc[4][3];          // corner (i,j) at Bc[i + 2*j]
+
+      std::unordered_map<uint64_t, tile_t*> tiles;
+      uint64_t last_key;       // of last_tile
+      tile_t *last_tile;
+};
+
+//----------------
+// BFieldCache (constructor)
+//----------------
+template <class MAP>
+BFieldCache<MAP>::BFieldCache(const MAP *bmap, symmetry_t sym, double cell_cm)
+ : map(bmap), symmetry(sym), cell(cell_cm), inv_cell(1 / cell_cm),
+   cell_iu(0), cell_iv(0), loaded(false),
+   last_key(0), last_tile(NULL)
+{
+}
+
+//----------------
+// BFieldCache (destructor)
+//----------------
+template <class MAP>
+BFieldCache<MAP>::~BFieldCache()
+{
+   typename std::unordered_map<uint64_t, tile_t*>::iterator iter;
+   for (iter = tiles.begin(); iter != tiles.end(); ++iter)
+      delete iter->second;
+}
+
+//----------------
+// GetField
+//----------------
+template <class MAP>
+inline void BFieldCache<MAP>::GetField(float x, float y, float z, float *B)
+{
+   float r = 0;
+   float u;
+   if (symmetry == kAxial) {
+      r = std::sqrt(x*x + y*y);
+      u = r * inv_cell;
+   }
+   else {
+      u = x * inv_cell;
+   }
+   float v = z * inv_cell;
+   int iu = (int)std::floor(u);
+   int iv = (int)std::floor(v);
+   if (!loaded || iu != cell_iu || iv != cell_iv)
+      LoadCell(iu, iv);
+   u -= iu;
+   v -= iv;
+   float Bi[3];
+   for (int i=0; i < 3; ++i) {
+      float b0 = Bc[0][i] + u * (Bc[1][i] - Bc[0][i]);
+      float b1 = Bc[2][i] + u * (Bc[3][i] - Bc[2][i]);
+      Bi[i] = b0 + v * (b1 - b0);
+   }
+   if (symmetry == kAxial && r > 0) {
+      float c = x / r;
+      float s = y / r;
+      B[0] = Bi[0] * c - Bi[1] * s;
+      B[1] = Bi[0] * s + Bi[1] * c;
+      B[2] = Bi[2];
+   }
+   else {
+      B[0] = Bi[0];
+      B[1] = Bi[1];
+      B[2] = Bi[2];
+   }
+}
+
+//----------------
+// LoadCell
+//----------------
+template <class MAP>
+void BFieldCache<MAP>::LoadCell(int iu, int iv)
+{
+   for (int j=0; j < 2; ++j) {
+      for (int i=0; i < 2; ++i) {
+         const float *Bnode = Node(iu + i, iv + j);
+         float *Bdest = Bc[i + 2*j];
+         Bdest[0] = Bnode[0];
+         Bdest[1] = Bnode[1];
+         Bdest[2] = Bnode[2];
+      }
+   }
+   cell_iu = iu;
+   cell_iv = iv;
+   loaded = true;
+}
+
+//----------------
+// Node
+//----------------
+template <class MAP>
+const float *BFieldCache<MAP>::Node(int iu, int iv)
+{
+   uint64_t key = ((uint64_t)(uint32_t)(iu >> kTileBits) << 32) |
+                   (uint64_t)(uint32_t)(iv >> kTileBits);
+   if (last_tile == NULL || key != last_key) {
+      tile_t *&tile = tiles[key];
+      if (tile == NULL) {
+         tile = new tile_t;
+         for (int i=0; i < kTileSize * kTileSize; ++i)
+            tile->filled[i] = false;
+      }
+      last_tile = tile;
+      last_key = key;
+   }
+
+   int inode = (iu & (kTileSize - 1)) + kTileSize * (iv & (kTileSize - 1));
+   float *Bnode = last_tile->B[inode];
+   if (!last_tile->filled[inode]) {
+      double Bx, By, Bz;
+      map->GetField(iu * (double)cell, 0.0, iv * (double)cell, Bx, By, Bz);
+      Bnode[0] = Bx;
+      Bnode[1] = By;
+      Bnode[2] = Bz;
+      last_tile->filled[inode] = true;
+   }
+   return Bnode;
+}
+
+#endif // _BFIELDCACHE_H_
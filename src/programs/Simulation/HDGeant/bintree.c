@@ -2,55 +2,246 @@
  * bintree.c - library for managing binary tree of hits pointers
  *
  *	version 1.0 	-Richard Jones July 16, 2001
+ *
+ *	version 2.0	- the binary tree is replaced by an open-addressing
+ *	hash table over nodes taken from a block arena. The marks used by
+ *	the hits packages arrive nearly sorted, which turned the unbalanced
+ *	tree into a linked list, with a malloc per node and a free per pick.
+ *	Now getTwig costs O(1), the first pickTwig sorts the marks once, and
+ *	picking the last twig resets the whole index in O(1) so the memory
+ *	is reused by the next event. The interface and its contract are the
+ *	same as before: getTwig returns a slot that stays put until the mark
+ *	is picked, and pickTwig returns the twigs in increasing mark order,
+ *	removing each from the index, and 0 once the index is empty.
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <bintree.h>
 
-void** getTwig(binTree_t** tree, int mark)
+#define TWIGS_PER_BLOCK 1024
+#define MIN_TABLE_SIZE 256
+
+typedef struct twig_s {
+   int mark;
+   int picked;
+   void* this_node;
+} twig_t;
+
+typedef struct twigBlock_s {
+   struct twigBlock_s* next;
+   twig_t twigs[TWIGS_PER_BLOCK];
+} twigBlock_t;
+
+struct hitTree_s {
+   twigBlock_t* blocks;         /* arena, kept from one event to the next */
+   twigBlock_t* current;        /* block being filled */
+   int used;                    /* twigs taken from the current block */
+   int count;                   /* twigs taken from the arena in all */
+   twig_t** table;              /* hash table of twigs, linear probing */
+   unsigned int* stamp;         /* slot is in use if stamp == generation */
+   unsigned int generation;
+   int tableSize;               /* a power of 2 */
+   twig_t** sorted;             /* twigs not yet picked, by mark */
+   int sortedSize;
+   int nsorted;
+   int next;                    /* next twig in sorted to pick */
+   int dirty;                   /* sorted needs to be rebuilt */
+};
+
+static unsigned int hashMark(int mark, int tableSize)
+{
+   return ((unsigned int)mark * 2654435761u) & (tableSize - 1);
+}
+
+static binTree_t* newTree(void)
+{
+   binTree_t* tree = malloc(sizeof(binTree_t));
+   tree->blocks = tree->current = malloc(sizeof(twigBlock_t));
+   tree->blocks->next = 0;
+   tree->used = 0;
+   tree->count = 0;
+   tree->tableSize = MIN_TABLE_SIZE;
+   tree->table = malloc(tree->tableSize * sizeof(twig_t*));
+   tree->stamp = calloc(tree->tableSize, sizeof(unsigned int));
+   tree->generation = 1;
+   tree->sorted = 0;
+   tree->sortedSize = 0;
+   tree->nsorted = 0;
+   tree->next = 0;
+   tree->dirty = 1;
+   return tree;
+}
+
+static void resetTree(binTree_t* tree)
+{
+   tree->current = tree->blocks;
+   tree->used = 0;
+   tree->count = 0;
+   tree->nsorted = 0;
+   tree->next = 0;
+   tree->dirty = 1;
+   if (++tree->generation == 0)
+   {
+      /* stamps have wrapped around, clear them for real */
+      memset(tree->stamp, 0, tree->tableSize * sizeof(unsigned int));
+      tree->generation = 1;
+   }
+}
+
+static twig_t* newTwig(binTree_t* tree, int mark)
+{
+   twig_t* twig;
+   if (tree->used == TWIGS_PER_BLOCK)
+   {
+      if (tree->current->next == 0)
+      {
+         tree->current->next = malloc(sizeof(twigBlock_t));
+         tree->current->next->next = 0;
+      }
+      tree->current = tree->current->next;
+      tree->used = 0;
+   }
+   twig = &tree->current->twigs[tree->used++];
+   ++tree->count;
+   twig->mark = mark;
+   twig->picked = 0;
+   twig->this_node = 0;
+   return twig;
+}
+
+static void insertTwig(binTree_t* tree, twig_t* twig)
 {
-   binTree_t* node = *tree;
-   if (node == 0)
+   unsigned int slot = hashMark(twig->mark, tree->tableSize);
+   while (tree->stamp[slot] == tree->generation)
    {
-      node = *tree = malloc(sizeof(binTree_t));
-      node->mark = mark;
-      node->left = 0;
-      node->right = 0;
-      node->this_node = 0;
-      return &node->this_node;
+      slot = (slot + 1) & (tree->tableSize - 1);
    }
-   else if (mark == node->mark)
+   tree->table[slot] = twig;
+   tree->stamp[slot] = tree->generation;
+}
+
+static void growTable(binTree_t* tree)
+{
+   twig_t** oldTable = tree->table;
+   unsigned int* oldStamp = tree->stamp;
+   int oldSize = tree->tableSize;
+   int slot;
+   tree->tableSize *= 2;
+   tree->table = malloc(tree->tableSize * sizeof(twig_t*));
+   tree->stamp = calloc(tree->tableSize, sizeof(unsigned int));
+   for (slot = 0; slot < oldSize; ++slot)
+   {
+      if (oldStamp[slot] == tree->generation)
+      {
+         insertTwig(tree, oldTable[slot]);
+      }
+   }
+   free(oldTable);
+   free(oldStamp);
+}
+
+static int compareTwigs(const void* a, const void* b)
+{
+   int markA = (*(twig_t**)a)->mark;
+   int markB = (*(twig_t**)b)->mark;
+   return (markA < markB)? -1 : (markA > markB)? 1 : 0;
+}
+
+static void sortTwigs(binTree_t* tree)
+{
+   twigBlock_t* block;
+   int n = 0;
+   if (tree->sortedSize < tree->count)
    {
-      return &node->this_node;
+      free(tree->sorted);
+      tree->sortedSize = tree->count;
+      tree->sorted = malloc(tree->sortedSize * sizeof(twig_t*));
    }
-   else if (mark < node->mark)
+   for (block = tree->blocks; ; block = block->next)
    {
-      return getTwig(&node->left, mark);
+      int last = (block == tree->current)? tree->used : TWIGS_PER_BLOCK;
+      int i;
+      for (i = 0; i < last; ++i)
+      {
+         if (! block->twigs[i].picked)
+         {
+            tree->sorted[n++] = &block->twigs[i];
+         }
+      }
+      if (block == tree->current)
+      {
+         break;
+      }
    }
-   else
+   qsort(tree->sorted, n, sizeof(twig_t*), compareTwigs);
+   tree->nsorted = n;
+   tree->next = 0;
+   tree->dirty = 0;
+}
+
+void** getTwig(binTree_t** tree, int mark)
+{
+   binTree_t* index = *tree;
+   unsigned int slot;
+   twig_t* twig;
+   if (index == 0)
+   {
+      index = *tree = newTree();
+   }
+   slot = hashMark(mark, index->tableSize);
+   while (index->stamp[slot] == index->generation)
    {
-      assert (node->mark >= 0);
-      return getTwig(&node->right, mark);
+      twig = index->table[slot];
+      if (twig->mark == mark)
+      {
+         if (twig->picked)
+         {
+            /* picked already, so it starts over as a new twig */
+            twig->picked = 0;
+            twig->this_node = 0;
+            index->dirty = 1;
+         }
+         return &twig->this_node;
+      }
+      slot = (slot + 1) & (index->tableSize - 1);
    }
+   if (2 * (index->count + 1) > index->tableSize)
+   {
+      growTable(index);
+   }
+   twig = newTwig(index, mark);
+   insertTwig(index, twig);
+   index->dirty = 1;
+   return &twig->this_node;
 }
 
 void* pickTwig(binTree_t** tree)
 {
-   binTree_t* node = *tree;
-   if (node == 0)
+   binTree_t* index = *tree;
+   twig_t* twig;
+   void* this_node;
+   if (index == 0)
    {
       return 0;
    }
-   else if (node->left)
+   if (index->dirty)
    {
-      return pickTwig(&node->left);
+      sortTwigs(index);
+   }
+   if (index->next == index->nsorted)
+   {
+      resetTree(index);
+      return 0;
    }
-   else
+   twig = index->sorted[index->next++];
+   twig->picked = 1;
+   this_node = twig->this_node;
+   if (index->next == index->nsorted)
    {
-      void* twig = node->this_node;
-      *tree = node->right;
-      free(node);
-      return twig;
+      /* that was the last one, the arena can be reused */
+      resetTree(index);
    }
+   return this_node;
 }
@@ -1,9 +1,8 @@
-typedef struct hitTree_s {
-  int mark;
-  struct hitTree_s* left;
-  struct hitTree_s* right;
-  void* this_node;
-} binTree_t;
+/*
+ * bintree.h - index of hits pointers by integer mark, see bintree.c
+ */
+
+typedef struct hitTree_s binTree_t;
 
 void** getTwig(binTree_t** tree, int mark);
 void* pickTwig(binTree_t** tree);
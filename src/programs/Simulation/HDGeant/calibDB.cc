@@ -24,6 +24,7 @@ extern "C" {
 #include "calibDB.h"
 };
 #include "controlparams.h"
+#include "BFieldCache.h"
 
 
 extern "C" int hddsgeant3_runtime_(void);  // called from uginit.F. defined in calibDB.cc
@@ -50,6 +51,14 @@ DMagneticFieldMap *Bmap=NULL;
 DMagneticFieldMapPS *PS_Bmap=NULL;
 static JCalibration *jcalib=NULL;
 
+// Cell size in cm of the field caches, 0 (the default) to query the
+// maps directly. The caches take the solenoid maps set up in
+// initcalibdb_ to depend only on r and z, and the pair spectrometer
+// maps only on x and z. validation/BFieldCache_benchmark.cc measures
+// the speed and the field error of a cell size on the real maps.
+static double bfield_cache_cell=0.0;
+static double PS_bfield_cache_cell=0.0;
+
 extern "C" {
    void md5geom_wrapper_(char *md5);
 }
@@ -69,6 +78,13 @@ void initcalibdb_(char *bfield_type, char *bfield_map, char *PS_bfield_type, cha
 
    // Get the JCalibration object
    jcalib = japp->GetJCalibration(*runno);
+
+   gPARMS->SetDefaultParameter("BFIELD_CACHE_CELL", bfield_cache_cell,
+      "Size in cm of the cells over which the solenoid field is"
+      " interpolated from its values at the corners (0 = no caching)");
+   gPARMS->SetDefaultParameter("PS_BFIELD_CACHE_CELL", PS_bfield_cache_cell,
+      "Size in cm of the cells over which the pair spectrometer field"
+      " is interpolated from its values at the corners (0 = no caching)");
  
    // The actual DMagneticFieldMap subclass can be specified in
    // the control.in file. Since it is read in as integers of
@@ -177,6 +193,58 @@ void initcalibdb_(char *bfield_type, char *bfield_map, char *PS_bfield_type, cha
 
 }
 
+//----------------
+// GetPSFieldCache
+//----------------
+static BFieldCache<DMagneticFieldMapPS> *GetPSFieldCache(void)
+{
+   /// Field cache of the calling thread for PS_Bmap, or NULL if
+   /// the map is to be queried directly.
+
+   static thread_local BFieldCache<DMagneticFieldMapPS> *cache=NULL;
+   static thread_local const DMagneticFieldMapPS *cached_map=NULL;
+
+   if(!PS_Bmap){
+      _DBG_<<"Call to gufld_ps when PS_Bmap not intialized! Exiting."<<endl;
+      exit(-1);
+   }
+   if(cached_map != PS_Bmap){
+      delete cache;
+      cache = NULL;
+      if(PS_bfield_cache_cell > 0)
+         cache = new BFieldCache<DMagneticFieldMapPS>(PS_Bmap,
+                      BFieldCache<DMagneticFieldMapPS>::kPlanar, PS_bfield_cache_cell);
+      cached_map = PS_Bmap;
+   }
+   return cache;
+}
+
+//----------------
+// GetFieldCache
+//----------------
+static BFieldCache<DMagneticFieldMap> *GetFieldCache(void)
+{
+   /// Field cache of the calling thread for Bmap, or NULL if
+   /// the map is to be queried directly.
+
+   static thread_local BFieldCache<DMagneticFieldMap> *cache=NULL;
+   static thread_local const DMagneticFieldMap *cached_map=NULL;
+
+   if(!Bmap){
+      _DBG_<<"Call to gufld_db when Bmap not intialized! Exiting."<<endl;
+      exit(-1);
+   }
+   if(cached_map != Bmap){
+      delete cache;
+      cache = NULL;
+      if(bfield_cache_cell > 0)
+         cache = new BFieldCache<DMagneticFieldMap>(Bmap,
+                      BFieldCache<DMagneticFieldMap>::kAxial, bfield_cache_cell);
+      cached_map = Bmap;
+   }
+   return cache;
+}
+
 //----------------
 // gufld_ps_
 //----------------
@@ -186,9 +254,10 @@ void gufld_ps_(float *r, float *B)
    /// use the C++ class DMagneticFieldMap to access the 
    /// B-field.
 
-   if(!PS_Bmap){
-      _DBG_<<"Call to gufld_ps when PS_Bmap not intialized! Exiting."<<endl;
-      exit(-1);
+   BFieldCache<DMagneticFieldMapPS> *cache = GetPSFieldCache();
+   if(cache){
+      cache->GetField(r[0], r[1], r[2], B);
+      return;
    }
    
    double x = r[0];
@@ -219,10 +288,10 @@ void gufld_db_(float *r, float *B)
     return;
   }
   
-
-   if(!Bmap){
-      _DBG_<<"Call to gufld_db when Bmap not intialized! Exiting."<<endl;
-      exit(-1);
+   BFieldCache<DMagneticFieldMap> *cache = GetFieldCache();
+   if(cache){
+      cache->GetField(r[0], r[1], r[2], B);
+      return;
    }
    
    double x = r[0];
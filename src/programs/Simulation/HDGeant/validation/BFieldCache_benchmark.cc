@@ -0,0 +1,276 @@
+// BFieldCache_benchmark.cc
+//
+// Step-trace benchmark of the field caches behind gufld_db_ and
+// gufld_ps_ (see BFieldCache.h), on the real field maps, to choose
+// the BFIELD_CACHE_CELL and PS_BFIELD_CACHE_CELL parameters.
+//
+// Charged tracks from the target are stepped through the solenoid map
+// as Geant would, with steps of 0.1-1 cm, and the field at every step
+// is recorded. The points are then looked up again through the map
+// directly and through a BFieldCache of each cell size asked for, and
+// for each the time per lookup and the largest and rms difference from
+// the map are printed. As a yardstick for the map's own interpolation
+// error, the difference between its usual and its bicubic
+// interpolation on the same points is printed too. With -p, straight
+// tracks through the given (x,z) region of the pair spectrometer map
+// are treated the same way.
+//
+// It is not part of the HDGeant build. From this directory, in a
+// shell set up for halld_recon:
+//
+//   g++ -O2 -std=c++11 -I.. BFieldCache_benchmark.cc
+//       -I$HALLD_RECON_HOME/$BMS_OSNAME/include -I$JANA_HOME/include
+//       `root-config --cflags` -o BFieldCache_benchmark
+//
+// linked like hdgeant against the halld_recon libraries (HDGEOMETRY,
+// DANA and those they need), JANA, CCDB and ROOT. Then
+//
+//   ./BFieldCache_benchmark -r run -s solenoid_map [-n tracks]
+//       [-p ps_map xmin xmax zmin zmax] [cell_cm ...]
+//
+// e.g. -s Magnets/Solenoid/solenoid_1350A_poisson_20160222 and cell
+// sizes 1 0.5 0.25 0.1 (the default). JANA -P options, such as
+// -PJANA_CALIB_URL, are passed on to the application.
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+using namespace std;
+
+#include <DANA/DApplication.h>
+#include <HDGEOMETRY/DMagneticFieldMapFineMesh.h>
+#include <HDGEOMETRY/DMagneticFieldMapPS2DMap.h>
+
+#include "BFieldCache.h"
+
+struct difference_t {
+   double max;
+   double rms;
+};
+
+//----------------
+// Difference
+//----------------
+static difference_t Difference(const vector<float> &B1, const vector<float> &B2)
+{
+   difference_t diff = {0, 0};
+   size_t n = B1.size() / 3;
+   for (size_t i=0; i < n; i++) {
+      double dx = B1[3*i] - B2[3*i];
+      double dy = B1[3*i+1] - B2[3*i+1];
+      double dz = B1[3*i+2] - B2[3*i+2];
+      double d2 = dx*dx + dy*dy + dz*dz;
+      diff.rms += d2;
+      if (d2 > diff.max)
+         diff.max = d2;
+   }
+   diff.max = sqrt(diff.max);
+   diff.rms = sqrt(diff.rms / (n > 0 ? n : 1));
+   return diff;
+}
+
+//----------------
+// Seconds
+//----------------
+static double Seconds(clock_t start)
+{
+   return (clock() - start) / (double)CLOCKS_PER_SEC;
+}
+
+//----------------
+// TraceSolenoid
+//----------------
+static void TraceSolenoid(const DMagneticFieldMap *map, int ntracks,
+                          vector<float> &r)
+{
+   /// Points along charged tracks from the target, stepped through the
+   /// field with the same float coordinates gufld_db_ is given.
+
+   const double kCurv = 0.002998;   // GeV/c per T per cm
+   srand48(12345);
+   for (int itrack=0; itrack < ntracks; itrack++) {
+      double p = 0.1 + 2.9 * drand48();
+      double theta = (1 + 139 * drand48()) * M_PI / 180;
+      double phi = 2 * M_PI * drand48();
+      double q = (drand48() < 0.5) ? -1 : 1;
+      double x[3] = {0.5 * (drand48() - 0.5), 0.5 * (drand48() - 0.5),
+                     50 + 30 * drand48()};
+      double u[3] = {sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta)};
+      for (int istep=0; istep < 5000; istep++) {
+         if (x[0]*x[0] + x[1]*x[1] > 65*65 || x[2] < 0 || x[2] > 420)
+            break;
+         r.push_back(x[0]);
+         r.push_back(x[1]);
+         r.push_back(x[2]);
+         double Bx, By, Bz;
+         map->GetField(x[0], x[1], x[2], Bx, By, Bz);
+         double step = 0.1 + 0.9 * drand48();
+         double k = q * kCurv * step / p;
+         double du[3] = {k * (u[1]*Bz - u[2]*By),
+                         k * (u[2]*Bx - u[0]*Bz),
+                         k * (u[0]*By - u[1]*Bx)};
+         double norm = 0;
+         for (int i=0; i < 3; i++) {
+            x[i] += step * (u[i] + 0.5 * du[i]);
+            u[i] += du[i];
+            norm += u[i] * u[i];
+         }
+         norm = sqrt(norm);
+         for (int i=0; i < 3; i++)
+            u[i] /= norm;
+      }
+   }
+}
+
+//----------------
+// TracePS
+//----------------
+static void TracePS(double xmin, double xmax, double zmin, double zmax,
+                    int ntracks, vector<float> &r)
+{
+   /// Points along straight tracks across the given region of the
+   /// pair spectrometer map, in steps of 0.1-1 cm.
+
+   srand48(12345);
+   for (int itrack=0; itrack < ntracks; itrack++) {
+      double x0 = xmin + (xmax - xmin) * drand48();
+      double x1 = xmin + (xmax - xmin) * drand48();
+      double y = 2 * (drand48() - 0.5);
+      double length = sqrt((x1 - x0)*(x1 - x0) + (zmax - zmin)*(zmax - zmin));
+      for (double s=0; s < length; s += 0.1 + 0.9 * drand48()) {
+         r.push_back(x0 + (x1 - x0) * s / length);
+         r.push_back(y);
+         r.push_back(zmin + (zmax - zmin) * s / length);
+      }
+   }
+}
+
+//----------------
+// Benchmark
+//----------------
+template <class MAP>
+static void Benchmark(const char *name, const MAP *map,
+                      typename BFieldCache<MAP>::symmetry_t symmetry,
+                      const vector<float> &r, const vector<double> &cells,
+                      const vector<float> *Bref2, const char *ref2_name)
+{
+   size_t n = r.size() / 3;
+   cout << name << ": " << n << " steps" << endl;
+
+   vector<float> Bmap(r.size());
+   clock_t start = clock();
+   for (size_t i=0; i < n; i++) {
+      double Bx, By, Bz;
+      map->GetField(r[3*i], r[3*i+1], r[3*i+2], Bx, By, Bz);
+      Bmap[3*i] = Bx;
+      Bmap[3*i+1] = By;
+      Bmap[3*i+2] = Bz;
+   }
+   double tmap = Seconds(start);
+   printf("   map             %7.1f ns/step\n", 1e9 * tmap / n);
+   if (Bref2) {
+      difference_t diff = Difference(Bmap, *Bref2);
+      printf("   map vs %-8s                     max %.2e T  rms %.2e T\n",
+             ref2_name, diff.max, diff.rms);
+   }
+
+   for (size_t icell=0; icell < cells.size(); icell++) {
+      // a new cache, so the time includes filling it
+      vector<float> B(r.size());
+      start = clock();
+      BFieldCache<MAP> cache(map, symmetry, cells[icell]);
+      for (size_t i=0; i < n; i++)
+         cache.GetField(r[3*i], r[3*i+1], r[3*i+2], &B[3*i]);
+      double t = Seconds(start);
+      difference_t diff = Difference(B, Bmap);
+      printf("   cell %5.2f cm   %7.1f ns/step  x%5.2f  max %.2e T  rms %.2e T\n",
+             cells[icell], 1e9 * t / n, tmap / t, diff.max, diff.rms);
+   }
+}
+
+//----------------
+// Usage
+//----------------
+static void Usage(void)
+{
+   cout << endl;
+   cout << "Usage:" << endl;
+   cout << "   BFieldCache_benchmark -r run -s solenoid_map [-n tracks]" << endl;
+   cout << "       [-p ps_map xmin xmax zmin zmax] [cell_cm ...]" << endl;
+   cout << endl;
+   exit(0);
+}
+
+//----------------
+// main
+//----------------
+int main(int narg, char *argv[])
+{
+   int run = 0;
+   int ntracks = 2000;
+   string solenoid_map;
+   string ps_map;
+   double ps_region[4] = {0, 0, 0, 0};
+   vector<double> cells;
+   for (int i=1; i < narg; i++) {
+      if (strcmp(argv[i], "-r") == 0 && i+1 < narg)
+         run = atoi(argv[++i]);
+      else if (strcmp(argv[i], "-n") == 0 && i+1 < narg)
+         ntracks = atoi(argv[++i]);
+      else if (strcmp(argv[i], "-s") == 0 && i+1 < narg)
+         solenoid_map = argv[++i];
+      else if (strcmp(argv[i], "-p") == 0 && i+5 < narg) {
+         ps_map = argv[++i];
+         for (int j=0; j < 4; j++)
+            ps_region[j] = atof(argv[++i]);
+      }
+      else if (strcmp(argv[i], "-h") == 0)
+         Usage();
+      else if (argv[i][0] != '-')
+         cells.push_back(atof(argv[i]));
+   }
+   if (run == 0 || solenoid_map.size() == 0)
+      Usage();
+   if (cells.size() == 0) {
+      cells.push_back(1.0);
+      cells.push_back(0.5);
+      cells.push_back(0.25);
+      cells.push_back(0.1);
+   }
+
+   DApplication *dapp = new DApplication(narg, argv);
+
+   DMagneticFieldMapFineMesh *Bmap;
+   Bmap = new DMagneticFieldMapFineMesh(dapp, run, solenoid_map);
+   vector<float> r;
+   TraceSolenoid(Bmap, ntracks, r);
+   vector<float> Bbicubic(r.size());
+   for (size_t i=0; i < r.size() / 3; i++) {
+      double Bx, By, Bz;
+      Bmap->GetFieldBicubic(r[3*i], r[3*i+1], r[3*i+2], Bx, By, Bz);
+      Bbicubic[3*i] = Bx;
+      Bbicubic[3*i+1] = By;
+      Bbicubic[3*i+2] = Bz;
+   }
+   Benchmark<DMagneticFieldMap>(solenoid_map.c_str(), Bmap,
+                                BFieldCache<DMagneticFieldMap>::kAxial,
+                                r, cells, &Bbicubic, "bicubic");
+
+   if (ps_map.size() > 0) {
+      DMagneticFieldMapPS *PS_Bmap;
+      PS_Bmap = new DMagneticFieldMapPS2DMap(dapp, run, ps_map);
+      r.clear();
+      TracePS(ps_region[0], ps_region[1], ps_region[2], ps_region[3],
+              ntracks, r);
+      Benchmark<DMagneticFieldMapPS>(ps_map.c_str(), PS_Bmap,
+                                     BFieldCache<DMagneticFieldMapPS>::kPlanar,
+                                     r, cells, NULL, NULL);
+   }
+
+   return 0;
+}
@@ -4,6 +4,7 @@
 
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -295,6 +296,20 @@ int main(int narg, char *argv[])
 	  cerr << "No input file!" << endl;
 	}
 
+	// A file name of "-" reads from stdin or writes to stdout, so that
+	// decay_evtgen can sit in a pipe, e.g. between genr8 -H- and hdgeant.
+	// When writing to stdout everything else printed there (by EvtGen
+	// too) goes to stderr.
+	if (INPUT_FILE == "-")
+	  INPUT_FILE = "/dev/stdin";
+	if (OUTPUT_FILE == "-") {
+	  cout.flush();
+	  fflush(stdout);
+	  int fd = dup(1);
+	  dup2(2, 1);
+	  OUTPUT_FILE = "/dev/fd/" + to_string(fd);
+	}
+
 	// Open input file
 	ifstream *infile = new ifstream(INPUT_FILE);
 	if (! infile->is_open()) {
@@ -362,7 +377,7 @@ void ParseCommandLineArguments(int narg,char *argv[])
    }
 
    for(int i=1; i < narg; i++) {
-      if (argv[i][0]=='-') {
+      if (argv[i][0]=='-' && argv[i][1]!='\0') {
          char *ptr = &argv[i][1];
          switch(*ptr) {
             case 'n':
@@ -390,7 +405,10 @@ void ParseCommandLineArguments(int narg,char *argv[])
       }
    }
    
-   if(OUTPUT_FILE == "") {
+   if(OUTPUT_FILE == "" && INPUT_FILE == "-") {
+      OUTPUT_FILE = "-";
+   }
+   else if(OUTPUT_FILE == "") {
 	   // Determine output filename from input filename
 	   OUTPUT_FILE = INPUT_FILE;
 	   size_t pos = OUTPUT_FILE.find_last_of(".");
@@ -407,6 +425,7 @@ void Usage(void)
   cout << endl;
   cout << "Usage:" << endl;
   cout << "       decay_evtgen [options] file.hddm" << endl;
+  cout << "       genr8 -H- ... | decay_evtgen [options] - | ..." << endl;
   cout << endl;
   cout << "Decay thrown particles via EvtGen" << endl;
   cout << "The particle types and decays are defined in $EVTGENDIR/evt.pdl " << endl
@@ -421,6 +440,8 @@ void Usage(void)
                "number of events to process (default: all)" << endl;
   cout << "  -o\"output_file_name\"    "
                "set the file name used for output (default: append \"_decayed\")" << endl;
+  cout << "                            "
+               "- for stdout, the default when reading from stdin" << endl;
   cout << "  -u\"user_decay_file_name\"    "
                "set the file name of the user decay file (default: userDecay.dec)" << endl;
   cout << "  -h                        "
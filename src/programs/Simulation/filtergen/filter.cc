@@ -15,8 +15,10 @@ using namespace std;
 //-----------
 // Filter
 //-----------
-bool Filter(hddm_s::HDDM &record)
+static bool Filter(hddm_s::HDDM &record)
 {
+   // Filter is static so that a plugin built from a copy of this file
+   // calls its own Filter, not the one compiled into filtergen
    // Return "true" to keep event, "false" to throw it away
    
    // Loop over Physics Events
@@ -75,3 +77,13 @@ bool Filter(hddm_s::HDDM &record)
    
    return true;
 }
+
+//-----------
+// FilterEvent
+//-----------
+extern "C" bool FilterEvent(hddm_s::HDDM &record)
+{
+   // entry point for filtergen, both for the compiled-in filter and
+   // when this file is built as a plugin
+   return Filter(record);
+}
@@ -3,25 +3,71 @@
 // Created August 24, 2007  David Lawrence
 
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 using namespace std;
 
 #include <signal.h>
 #include <time.h>
+#include <dlfcn.h>
 
 #include "HDDM/hddm_s.hpp"
 
-bool Filter(hddm_s::HDDM &record);
+extern "C" bool FilterEvent(hddm_s::HDDM &record);   // filter.cc
 void ParseCommandLineArguments(int narg, char* argv[]);
 void Usage(void);
 void ctrlCHandle(int x);
 
+// Filter plugins are shared libraries exporting
+//
+//    extern "C" bool FilterEvent(hddm_s::HDDM &record);
+//
+// which returns true to keep the event, like the one in filter.cc (so
+// that file can itself be built as a plugin). With more than one plugin
+// an event must pass all of them. FilterEvent may be called from several
+// threads at once. filtergen is linked with -rdynamic so plugins can use
+// its HDDM code, which also means a global function in a plugin with the
+// same name as one in filtergen resolves to filtergen's: other functions
+// in a plugin must be static, or the plugin linked with -Wl,-Bsymbolic.
+typedef bool filter_t(hddm_s::HDDM &record);
+
+void LoadPlugins(void);
+bool KeepEvent(hddm_s::HDDM &record);
+void ReadIndex(void);
+
 char *INFILENAME = NULL;
 char *OUTFILENAME = NULL;
+char *INDEX_IN = NULL;
+char *INDEX_OUT = NULL;
+int NTHREADS = 1;
 int QUIT = 0;
 
+vector<char*> PLUGINS;
+vector<filter_t*> FILTERS;
+
+// Index files list the stream positions of the events that passed,
+// one after another, in the binary layout of hddm_s::streamposition.
+static const string INDEX_MAGIC = "filtergen event index v1";
+vector<hddm_s::streamposition> INDEX;
+
+// Events are handed to the filter threads in batches of this many
+const size_t BATCH_SIZE = 100;
+
+struct batch_t {
+   vector<hddm_s::HDDM*> records;
+   vector<hddm_s::streamposition> positions;
+   vector<bool> keep;
+};
+
 
 //-----------
 // main
@@ -44,6 +90,10 @@ int main(int narg,char* argv[])
       exit(-1);
    }
    hddm_s::istream *fin = new hddm_s::istream(*ifs);
+
+   LoadPlugins();
+   if (INDEX_IN)
+      ReadIndex();
    
    // Output file
    std::ofstream *ofs = new ofstream(OUTFILENAME);
@@ -53,15 +103,151 @@ int main(int narg,char* argv[])
       exit(-1);
    }
    hddm_s::ostream *fout = new hddm_s::ostream(*ofs);
-   
-   // Loop over events in input file
+
+   std::ofstream *idxout = NULL;
+   if (INDEX_OUT) {
+      idxout = new ofstream(INDEX_OUT, ios::binary);
+      if (! idxout->is_open()) {
+         std::cout << " Error opening index file \"" << INDEX_OUT << "\"!"
+                   << std::endl;
+         exit(-1);
+      }
+      *idxout << INDEX_MAGIC << std::endl;
+   }
+
+   // The input is read in batches, which are filtered by NTHREADS
+   // threads and then written out here in the order they were read.
    int NEvents_read = 0;
    int NEvents_written = 0;
+   size_t next_index = 0;
+   bool input_done = false;
+   long nbatches_read = 0;
+   long nbatches_written = 0;
+   deque<pair<long, batch_t*> > todo;   // read, to be filtered
+   map<long, batch_t*> done;            // filtered, to be written
+   mutex pipe_mutex;
+   condition_variable batch_read;
+   condition_variable batch_filtered;
+   condition_variable batch_written;
+   size_t max_batches = 4 * NTHREADS;  // in memory at any time
+
+   // reads the next batch, NULL at the end of the input
+   auto ReadBatch = [&]() -> batch_t* {
+      batch_t *batch = new batch_t;
+      while (batch->records.size() < BATCH_SIZE && !QUIT) {
+         if (INDEX_IN) {
+            if (next_index == INDEX.size())
+               break;
+            fin->setPosition(INDEX[next_index++]);
+         }
+         hddm_s::streamposition pos = fin->getPosition();
+         hddm_s::HDDM *record = new hddm_s::HDDM;
+         if (! (*fin >> *record)) {
+            delete record;
+            break;
+         }
+         batch->records.push_back(record);
+         batch->positions.push_back(pos);
+      }
+      if (batch->records.size() == 0) {
+         delete batch;
+         return NULL;
+      }
+      return batch;
+   };
+
+   auto FilterBatch = [&](batch_t *batch) {
+      batch->keep.resize(batch->records.size());
+      for (size_t i=0; i < batch->records.size(); ++i)
+         batch->keep[i] = KeepEvent(*batch->records[i]);
+   };
+
+   auto WriteBatch = [&](batch_t *batch) {
+      for (size_t i=0; i < batch->records.size(); ++i) {
+         NEvents_read++;
+         // Write or don't depending on return value of the filters
+         if (batch->keep[i]) {
+            *fout << *batch->records[i];
+            if (idxout)
+               idxout->write((const char*)&batch->positions[i],
+                             sizeof(hddm_s::streamposition));
+            NEvents_written++;
+         }
+         delete batch->records[i];
+      }
+      delete batch;
+   };
+
+   // filter threads
+   vector<thread> workers;
+   for (int i=0; NTHREADS > 1 && i < NTHREADS; i++) {
+      workers.push_back(thread([&]() {
+         while (true) {
+            pair<long, batch_t*> job;
+            {
+               unique_lock<mutex> lock(pipe_mutex);
+               batch_read.wait(lock, [&]{ return todo.size() > 0 || input_done; });
+               if (todo.size() == 0)
+                  break;
+               job = todo.front();
+               todo.pop_front();
+            }
+            FilterBatch(job.second);
+            {
+               lock_guard<mutex> lock(pipe_mutex);
+               done[job.first] = job.second;
+            }
+            batch_filtered.notify_all();
+         }
+      }));
+   }
+
+   // reader thread
+   thread reader;
+   if (NTHREADS > 1) {
+      reader = thread([&]() {
+         while (true) {
+            {
+               unique_lock<mutex> lock(pipe_mutex);
+               batch_written.wait(lock, [&]{ return nbatches_read <
+                                  nbatches_written + (long)max_batches; });
+            }
+            batch_t *batch = ReadBatch();
+            lock_guard<mutex> lock(pipe_mutex);
+            if (batch == NULL) {
+               input_done = true;
+               batch_read.notify_all();
+               batch_filtered.notify_all();
+               break;
+            }
+            todo.push_back(pair<long, batch_t*>(nbatches_read++, batch));
+            batch_read.notify_one();
+         }
+      });
+   }
+
    time_t last_time = time(NULL);
-   while (ifs->good()) {
-      NEvents_read++;
-      hddm_s::HDDM record;
-      *fin >> record;
+   while (true) {
+      batch_t *batch;
+      if (NTHREADS > 1) {
+         unique_lock<mutex> lock(pipe_mutex);
+         batch_filtered.wait(lock, [&]{ return done.count(nbatches_written) > 0 ||
+                             (input_done && nbatches_written == nbatches_read); });
+         if (done.count(nbatches_written) == 0)
+            break;
+         batch = done[nbatches_written];
+         done.erase(nbatches_written);
+         ++nbatches_written;
+         batch_written.notify_all();
+      }
+      else {
+         batch = ReadBatch();
+         if (batch == NULL)
+            break;
+         FilterBatch(batch);
+      }
+      WriteBatch(batch);
+
       time_t now = time(NULL);
       if (now != last_time) {
          std::cout << " " << NEvents_read << " events read -- " 
@@ -69,22 +255,19 @@ int main(int narg,char* argv[])
          std::cout.flush();
          last_time = now;
       }
-      
-      // Write or don't depending on return value of Filter()
-      if (Filter(record)) {
-         *fout << record;
-         NEvents_written++;
-      }
-      
-      if (QUIT)
-         break;
    }
+
+   if (reader.joinable())
+      reader.join();
+   for (size_t i=0; i < workers.size(); ++i)
+      workers[i].join();
    
    // close input and output files
    delete fin;
    delete ifs;
    delete fout;
    delete ofs;
+   delete idxout;
 
    std::cout << std::endl << "FINAL:" << endl;
    std::cout << " " << NEvents_read << " events read -- " 
@@ -95,6 +278,64 @@ int main(int narg,char* argv[])
    return 0;
 }
 
+//-----------
+// LoadPlugins
+//-----------
+void LoadPlugins(void)
+{
+   for (size_t i=0; i < PLUGINS.size(); i++) {
+      void *handle = dlopen(PLUGINS[i], RTLD_NOW);
+      if (! handle) {
+         std::cout << " Unable to open filter plugin \"" << PLUGINS[i]
+                   << "\"!" << std::endl << dlerror() << std::endl;
+         exit(-1);
+      }
+      filter_t *filter = (filter_t*)dlsym(handle, "FilterEvent");
+      if (! filter) {
+         std::cout << " No FilterEvent routine in filter plugin \""
+                   << PLUGINS[i] << "\"!" << std::endl;
+         exit(-1);
+      }
+      std::cout << " filter plugin: " << PLUGINS[i] << std::endl;
+      FILTERS.push_back(filter);
+   }
+}
+
+//-----------
+// KeepEvent
+//-----------
+bool KeepEvent(hddm_s::HDDM &record)
+{
+   // the compiled-in filter is used unless plugins were given
+   if (FILTERS.size() == 0)
+      return FilterEvent(record);
+   for (size_t i=0; i < FILTERS.size(); i++) {
+      if (! FILTERS[i](record))
+         return false;
+   }
+   return true;
+}
+
+//-----------
+// ReadIndex
+//-----------
+void ReadIndex(void)
+{
+   std::ifstream idxin(INDEX_IN, ios::binary);
+   std::string magic;
+   std::getline(idxin, magic);
+   if (magic != INDEX_MAGIC) {
+      std::cout << " \"" << INDEX_IN << "\" is not a filtergen index file!"
+                << std::endl;
+      exit(-1);
+   }
+   hddm_s::streamposition pos;
+   while (idxin.read((char*)&pos, sizeof(pos)))
+      INDEX.push_back(pos);
+   std::cout << " reading the " << INDEX.size() << " events listed in "
+             << INDEX_IN << std::endl;
+}
+
 //-----------
 // ParseCommandLineArguments
 //-----------
@@ -105,9 +346,19 @@ void ParseCommandLineArguments(int narg, char* argv[])
       char *ptr = argv[i];
       
       if (ptr[0] == '-') {
+         if (ptr[1] != 'h' && i+1 == narg)
+            Usage();
          switch(ptr[1]) {
           case 'h': Usage();
             break;
+          case 'P': PLUGINS.push_back(argv[++i]);
+            break;
+          case 'j': NTHREADS = atoi(argv[++i]);
+            break;
+          case 'i': INDEX_OUT = argv[++i];
+            break;
+          case 'I': INDEX_IN = argv[++i];
+            break;
          }
       }
       else {
@@ -151,16 +402,28 @@ void Usage(void)
    std::cout << "not want to waste time tracking through the whole detector."
              << std::endl;
    std::cout << std::endl;
-   std::cout << "At this point, the filtering conditions are hardwired and"
+   std::cout << "The filtering conditions compiled in from filter.cc can be"
+             << std::endl;
+   std::cout << "replaced by those in filter plugins, shared libraries that"
+             << std::endl;
+   std::cout << "export extern \"C\" bool FilterEvent(hddm_s::HDDM &record)."
+             << std::endl;
+   std::cout << "Any other functions in a plugin, like Filter() in a copy of"
              << std::endl;
-   std::cout << "can only be changed by editing the source. In the future, we"
+   std::cout << "filter.cc, must be static (or the plugin linked with"
              << std::endl;
-   std::cout << "will want command line options so the filter can be tuned" 
+   std::cout << "-Wl,-Bsymbolic), or filtergen's own functions of the same"
              << std::endl;
-   std::cout << "without recompiling." << std::endl;
+   std::cout << "name are called instead." << std::endl;
    std::cout << std::endl;
    std::cout << "  options:" << std::endl;
-   std::cout << "    -h       Print this usage statement." << std::endl;
+   std::cout << "    -h         Print this usage statement." << std::endl;
+   std::cout << "    -P plugin  Filter with the given plugin (may be repeated," << std::endl;
+   std::cout << "               events must pass all of them)." << std::endl;
+   std::cout << "    -j N       Filter events in N threads." << std::endl;
+   std::cout << "    -i file    Write an index of the events kept to file." << std::endl;
+   std::cout << "    -I file    Read only the events listed in the index file," << std::endl;
+   std::cout << "               written by -i from the same input file." << std::endl;
    std::cout << std::endl;
 
    exit(0);
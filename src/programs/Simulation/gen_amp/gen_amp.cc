@@ -8,6 +8,9 @@
 #include <map>
 #include <cassert>
 #include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "particleType.h"
 
@@ -37,6 +40,8 @@
 #include "AMPTOOLS_MCGEN/ProductionMechanism.h"
 #include "AMPTOOLS_MCGEN/GammaPToNPartP.h"
 #include "AMPTOOLS_MCGEN/NBodyPhaseSpaceFactory.h"
+#include "AMPTOOLS_MCGEN/MCGenRandom.h"
+#include "AMPTOOLS_MCGEN/AdaptiveGrid.h"
 
 #include "IUAmpTools/AmpToolsInterface.h"
 #include "IUAmpTools/ConfigFileParser.h"
@@ -49,6 +54,7 @@
 #include "TLorentzVector.h"
 #include "TLorentzRotation.h"
 #include "TRandom3.h"
+#include "TROOT.h"
 
 using std::complex;
 using namespace std;
@@ -81,6 +87,9 @@ int main( int argc, char* argv[] ){
 
 	int nEvents = 10000;
 	int batchSize = 10000;
+	int nThreads = 0;
+	int nWarmUp = 0;
+	double safetyFactor = 1.5;
 	
 	//parse command line:
 	for (int i = 1; i < argc; i++){
@@ -132,6 +141,15 @@ int main( int argc, char* argv[] ){
 		if (arg == "-tmax"){
                         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
                         else  highT = atof( argv[++i] ); }
+		if (arg == "-is"){
+                        if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+                        else  nWarmUp = atoi( argv[++i] ); }
+		if (arg == "-sf"){
+                        if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+                        else  safetyFactor = atof( argv[++i] ); }
+		if (arg == "-j"){
+                        if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+                        else  nThreads = atoi( argv[++i] ); }
 		if (arg == "-d"){
 			diag = true; }
 		if (arg == "-v"){
@@ -155,6 +173,9 @@ int main( int argc, char* argv[] ){
 			cout << "\t -t    <value>\t Momentum transfer slope [optional]" << endl;
 			cout << "\t -tmin <value>\t Minimum momentum transfer [optional]" << endl;
 			cout << "\t -tmax <value>\t Maximum momentum transfer [optional]" << endl;
+			cout << "\t -is   <value>\t Number of warm-up batches to learn an importance sampling grid [optional]" << endl;
+			cout << "\t -sf   <value>\t Safety factor on the maximum intensity (default 1.5) [optional]" << endl;
+			cout << "\t -j    <value>\t Number of threads generating events [optional]" << endl;
 			cout << "\t -v \t\t Throw vertex distribution in gen_amp, not in hdgeant(4) [not recommended]" << endl;
 			cout << "\t -f \t\t Generate flat in M(X) (no physics) [optional]" << endl;
 			cout << "\t -d \t\t Plot only diagnostic histograms [optional]" << endl << endl;
@@ -167,6 +188,9 @@ int main( int argc, char* argv[] ){
 		exit(1);
 	}
 	
+	// the worker threads each fill their own ROOT objects
+	if( nThreads > 0 ) ROOT::EnableThreadSafety();
+
 	// open config file and be sure only one reaction is specified
 	ConfigFileParser parser( configfile );
 	ConfigurationInfo* cfgInfo = parser.getConfigurationInfo();
@@ -398,7 +422,411 @@ int main( int argc, char* argv[] ){
 	TH2F* M_Phi = new TH2F( "M_Phi", "M vs. #varphi", 180, lowMass, highMass, 200, -3.14, 3.14);
 	TH2F* M_Phi_lab = new TH2F( "M_Phi_lab", "M vs. #varphi", 180, lowMass, highMass, 200, -3.14, 3.14);
 	
+	// With -is, events are thrown with a proposal density in M, t and the
+	// helicity angles that is learned from the intensity during a warm-up,
+	// see AdaptiveGrid.  This is off for flat generation, where there is
+	// nothing to learn.
+	if( genFlat ) nWarmUp = 0;
+	bool useGrid = ( nWarmUp > 0 );
+	vector< pair< double, double > > gridRanges;
+	gridRanges.push_back( pair< double, double >( minMass, highMass ) );
+	// most events are at small t, larger t fall in the last bin
+	double gridHighT = ( slope > 0 && lowT + 10 / slope < highT ? lowT + 10 / slope : highT );
+	gridRanges.push_back( pair< double, double >( lowT, gridHighT ) );
+	gridRanges.push_back( pair< double, double >( -1, 1 ) );
+	gridRanges.push_back( pair< double, double >( -PI, PI ) );
+	AdaptiveGrid grid( gridRanges );
+
+	// the point on the grid of an event:  M, t, cos(theta) and phi
+	auto gridPoint = [&]( Kinematics& evt ) -> vector< double > {
+
+		TLorentzVector resonance;
+		for (unsigned int j=2; j<Particles.size(); j++)
+		  resonance += evt.particle( j );
+
+		TLorentzVector recoil = evt.particle( 1 );
+		if(bwGenLowerVertex.size()) {
+			for(unsigned int j=Particles.size(); j<evt.particleList().size(); j++)
+				recoil += evt.particle( j );
+		}
+
+		TLorentzVector beam = evt.particle ( 0 );
+		TLorentzVector rec = evt.particle ( 1 );
+		TLorentzVector p1 = evt.particle ( 2 );
+		TLorentzVector target(0,0,0,rec[3]);
+
+		double tval = ( isBaryonResonance ? -1*(beam-rec).M2() : -1*(recoil-target).M2() );
+
+		TLorentzRotation resonanceBoost( -resonance.BoostVector() );
+		TLorentzVector rec_res = resonanceBoost * rec;
+		TLorentzVector p1_res = resonanceBoost * p1;
+
+		TVector3 y = (beam.Vect().Unit().Cross(-rec.Vect().Unit())).Unit();
+		TVector3 z = -1. * rec_res.Vect().Unit();
+		TVector3 x = y.Cross(z).Unit();
+		TVector3 angles( (p1_res.Vect()).Dot(x),
+		                 (p1_res.Vect()).Dot(y),
+		                 (p1_res.Vect()).Dot(z) );
+
+		vector< double > point;
+		point.push_back( resonance.M() );
+		point.push_back( tval );
+		point.push_back( angles.CosTheta() );
+		point.push_back( angles.Phi() );
+		return point;
+	};
+
+	// generate the kinematics of one event, NULL if it is to be thrown away
+	auto generateEvent = [&]( GammaPToNPartP& prod ) -> Kinematics* {
+
+		double weight = 1.;
+
+		Kinematics* kin;
+		if(bwGenLowerVertex.size() == 0) 
+			kin = prod.generate(); // stable particle at lower vertex
+		else { 
+			// unstable particle at lower vertex
+			pair< double, double > bwLowerVertex = bwGenLowerVertex[0]();
+			double lowerVertex_mass_bw = bwLowerVertex.first;
+			weight *= bwLowerVertex.second;
+
+			if ( lowerVertex_mass_bw < thresholdLowerVertex || lowerVertex_mass_bw > 2.0) return NULL;
+			prod.getProductionMechanism().setRecoilMass( lowerVertex_mass_bw );
+			
+			Kinematics* step1 = prod.generate();
+			TLorentzVector beam = step1->particle( 0 );
+			TLorentzVector recoil = step1->particle( 1 );
+			
+			// loop over meson decay
+			vector<TLorentzVector> mesonChild;
+			for(unsigned int i=0; i<childMasses.size(); i++) 
+				mesonChild.push_back(step1->particle( 2+i ));
+			
+			// decay step for lower vertex
+			TLorentzVector nucleon; // proton or neutron
+			NBodyPhaseSpaceFactory lowerVertex_decay = NBodyPhaseSpaceFactory( lowerVertex_mass_bw, massesLowerVertex);
+			vector<TLorentzVector> lowerVertexChild = lowerVertex_decay.generateDecay();
+			// boost to lab frame via recoil kinematics
+			for(unsigned int j=0; j<lowerVertexChild.size(); j++) 
+			  lowerVertexChild[j].Boost( recoil.BoostVector() );
+			nucleon = lowerVertexChild[0];
+
+			// store particles in kinematic class
+			vector< TLorentzVector > allPart;
+			allPart.push_back( beam );
+			allPart.push_back( nucleon );
+			// loop over meson decay particles
+			for(unsigned int j=0; j<mesonChild.size(); j++) 
+				allPart.push_back(mesonChild[j]);
+			// loop over lower vertex decay particles
+			for(unsigned int j=1; j<lowerVertexChild.size(); j++) 
+				allPart.push_back(lowerVertexChild[j]);
+		
+			weight *= step1->weight();	
+			kin = new Kinematics( allPart, weight );
+			delete step1;				
+		}
+
+		if( useGrid ){
+
+			// keep the event with the proposal density, and weight it back
+			double q = grid.density( gridPoint( *kin ) );
+			if( MCGenRandom::uniform() > q ){
+
+				delete kin;
+				return NULL;
+			}
+			kin->setWeight( kin->weight() / q );
+		}
+		return kin;
+	};
+
+	// fill the histograms for an event and, unless only diagnostics are
+	// wanted, write it out
+	auto recordEvent = [&]( Kinematics* evt, double weightedInten ){
+
+		TLorentzVector resonance;
+		for (unsigned int j=2; j<Particles.size(); j++)
+		  resonance += evt->particle( j );
+
+		TLorentzVector isobar;
+		for (unsigned int j=3; j<Particles.size(); j++)
+		  isobar += evt->particle( j );
+
+		TLorentzVector recoil = evt->particle( 1 );
+		if(bwGenLowerVertex.size()) {
+			for(unsigned int j=Particles.size(); j<evt->particleList().size(); j++)
+				recoil += evt->particle( j );
+		}
+
+		double genWeight = evt->weight();
+		
+		if( !diag ){
+			
+			mass->Fill( resonance.M() );
+			massW->Fill( resonance.M(), genWeight );
+			
+			intenW->Fill( weightedInten );
+			intenWVsM->Fill( resonance.M(), weightedInten );
+
+			M_isobar->Fill( isobar.M() );
+			M_recoil->Fill( recoil.M() );
+			
+			// calculate angular variables
+			TLorentzVector beam = evt->particle ( 0 );
+			TLorentzVector rec = evt->particle ( 1 );
+			TLorentzVector p1 = evt->particle ( 2 );
+			TLorentzVector target(0,0,0,rec[3]);
+			
+			if(isBaryonResonance) // assume t-channel
+				t->Fill(-1*(beam-evt->particle(1)).M2());
+			else
+				t->Fill(-1*(recoil-target).M2());
+
+			E->Fill(beam.E());
+			EvsM->Fill(beam.E(),resonance.M());
+
+			TLorentzRotation resonanceBoost( -resonance.BoostVector() );
+			
+			TLorentzVector beam_res = resonanceBoost * beam;
+			TLorentzVector rec_res = resonanceBoost * rec;
+			TLorentzVector p1_res = resonanceBoost * p1;
+			
+			// normal to the production plane
+                        TVector3 y = (beam.Vect().Unit().Cross(-rec.Vect().Unit())).Unit();
+
+                        // choose helicity frame: z-axis opposite recoil proton in rho rest frame
+                        TVector3 z = -1. * rec_res.Vect().Unit();
+                        TVector3 x = y.Cross(z).Unit();
+                        TVector3 angles( (p1_res.Vect()).Dot(x),
+                                         (p1_res.Vect()).Dot(y),
+                                         (p1_res.Vect()).Dot(z) );
+
+                        double cosTheta = angles.CosTheta();
+                        double phi = angles.Phi();
+
+			M_CosTheta->Fill( resonance.M(), cosTheta);
+			M_Phi->Fill( resonance.M(), phi);
+			M_Phi_lab->Fill( resonance.M(), rec.Phi());
+			
+			TVector3 eps(1.0, 0.0, 0.0); // beam polarization vector
+                        double Phi = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
+
+                        GDouble psi = phi - Phi;
+                        if(psi < -1*PI) psi += 2*PI;
+                        if(psi > PI) psi -= 2*PI;
+			
+			CosTheta_psi->Fill( psi, cosTheta);
+			
+			// we want to save events with weight 1
+			evt->setWeight( 1.0 );
+			
+			if( hddmOut ) hddmOut->writeEvent( *evt, pTypes, centeredVertex );
+			rootOut.writeEvent( *evt );
+		}
+		else{
+			
+			mass->Fill( resonance.M() );
+			massW->Fill( resonance.M(), genWeight );
+			
+			intenW->Fill( weightedInten );
+			intenWVsM->Fill( resonance.M(), weightedInten );
+		}
+	};
+
+	// The warm-up batches are only used to learn the grid, and the last
+	// one, thrown with the final grid, to find the maximum intensity.
+	// This maximum is then used for every batch, so any event above it
+	// is counted, and a safety factor can be set with -sf.
+	double gridMaxInten = 0;
+	long long nEvaluated = 0;   // events whose intensity was computed
+	for( int iWarmUp = 0; iWarmUp <= nWarmUp && useGrid; ++iWarmUp ){
+
+		cout << "Warm-up batch " << iWarmUp + 1 << " of " << nWarmUp + 1 << "..." << endl;
+
+		ati.clearEvents();
+		int i=0;
+		while( i < batchSize ){
+
+			Kinematics* kin = generateEvent( resProd );
+			if( !kin ) continue;
+			ati.loadEvent( kin, i, batchSize );
+			delete kin;
+			i++;
+		}
+		nEvaluated += batchSize;
+
+		double maxInten = ati.processEvents( reaction->reactionName() );
+		if( iWarmUp == nWarmUp ){
+
+			gridMaxInten = safetyFactor * maxInten;
+			break;
+		}
+
+		for( int i = 0; i < batchSize; ++i ){
+
+			Kinematics* evt = ati.kinematics( i );
+			vector< double > point = gridPoint( *evt );
+			grid.fill( point, grid.density( point ), ati.intensity( i ) );
+			delete evt;
+		}
+		grid.update();
+	}
+
+	// events whose intensity was above the maximum used for accept/reject
+	int nAboveMax = 0;
+	double maxAboveMax = 0;
+	auto checkMax = [&]( double weightedInten, double maxInten ){
+
+		if( weightedInten <= maxInten ) return;
+		++nAboveMax;
+		if( weightedInten / maxInten > maxAboveMax ) maxAboveMax = weightedInten / maxInten;
+	};
+
 	int eventCounter = 0;
+	if( nThreads > 0 ){
+
+		// Batches are generated by the worker threads, each with its own
+		// copy of the generator and of the AmpToolsInterface, and handed
+		// back here to be written out in order. Every batch draws on its
+		// own random number stream, seeded from the batch number, so the
+		// output depends only on the seed and not on the number of threads.
+
+		if( batchSize < 1E4 ){
+			
+			cout << "WARNING:  small batches could have batch-to-batch variations\n"
+			     << "          due to different maximum intensities!" << endl;
+		}
+
+		struct batch_t {
+			vector< Kinematics* > events;
+			vector< double > intensities;
+			vector< double > maxIntens;   // used for each event, if not diag
+		};
+		map< unsigned int, batch_t > doneBatches;
+		unsigned int nextBatch = 0;      // to be started by a worker
+		unsigned int writeBatch = 0;     // to be written out next
+		bool stopWorkers = false;
+		mutex batchMutex;
+		condition_variable batchReady;   // a worker finished a batch
+		condition_variable batchWritten; // a batch was taken off doneBatches
+
+		auto batchSeed = [seed]( unsigned int batch ) -> unsigned int {
+			unsigned long long z = ( (unsigned long long)seed << 32 ) + batch + 0x9E3779B97F4A7C15ULL;
+			z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+			z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+			z ^= z >> 31;
+			unsigned int s = z & 0xffffffff;
+			return( s == 0 ? 1 : s );  // 0 asks TRandom3 for a random seed
+		};
+
+		// the generator objects for each worker are made here, one at a time
+		vector< GammaPToNPartP > workerProd( nThreads, resProd );
+		vector< AmpToolsInterface* > workerATI;
+		for( int iThread = 0; iThread < nThreads; ++iThread )
+			workerATI.push_back( new AmpToolsInterface( cfgInfo, AmpToolsInterface::kMCGeneration ) );
+
+		auto worker = [&]( int iThread ){
+
+			GammaPToNPartP& prod = workerProd[iThread];
+			AmpToolsInterface* wati = workerATI[iThread];
+			TRandom3 random;
+			MCGenRandom::setThreadGenerator( &random );
+
+			while( true ){
+
+				unsigned int batch;
+				{
+					unique_lock< mutex > lock( batchMutex );
+					// stay at most two batches per thread ahead of the writer
+					batchWritten.wait( lock, [&]{ return stopWorkers ||
+					                       nextBatch < writeBatch + 2 * nThreads; } );
+					if( stopWorkers ) break;
+					batch = nextBatch++;
+				}
+				random.SetSeed( batchSeed( batch ) );
+
+				wati->clearEvents();
+				int i=0;
+				while( i < batchSize ){
+
+					Kinematics* kin = generateEvent( prod );
+					if( !kin ) continue;
+					wati->loadEvent( kin, i, batchSize );
+					delete kin;
+					i++;
+				}
+
+				double maxInten = ( genFlat ? 1 : safetyFactor * wati->processEvents( reaction->reactionName() ) );
+				if( useGrid ) maxInten = gridMaxInten;
+
+				batch_t result;
+				for( int i = 0; i < batchSize; ++i ){
+
+					double weightedInten = ( genFlat ? 1 : wati->intensity( i ) );
+					if( !diag && !genFlat && !( weightedInten > random.Uniform() * maxInten ) )
+						continue;
+					if( !diag ) result.maxIntens.push_back( maxInten );
+					result.events.push_back( wati->kinematics( i ) );
+					result.intensities.push_back( weightedInten );
+				}
+
+				{
+					lock_guard< mutex > lock( batchMutex );
+					doneBatches[batch] = result;
+				}
+				batchReady.notify_all();
+			}
+			MCGenRandom::setThreadGenerator( NULL );
+		};
+
+		cout << "Generating events in " << nThreads << " threads..." << endl;
+		vector< thread > workers;
+		for( int iThread = 0; iThread < nThreads; ++iThread )
+			workers.push_back( thread( worker, iThread ) );
+
+		while( eventCounter < nEvents ){
+
+			batch_t result;
+			{
+				unique_lock< mutex > lock( batchMutex );
+				batchReady.wait( lock, [&]{ return doneBatches.count( writeBatch ) > 0; } );
+				result = doneBatches[writeBatch];
+				doneBatches.erase( writeBatch );
+				++writeBatch;
+			}
+			nEvaluated += batchSize;
+			batchWritten.notify_all();
+
+			for( unsigned int i = 0; i < result.events.size(); ++i ){
+
+				if( diag || eventCounter < nEvents ){
+
+					recordEvent( result.events[i], result.intensities[i] );
+					if( !diag ) checkMax( result.intensities[i], result.maxIntens[i] );
+					++eventCounter;
+				}
+				delete result.events[i];
+			}
+
+			cout << eventCounter << " events were processed." << endl;
+		}
+
+		{
+			lock_guard< mutex > lock( batchMutex );
+			stopWorkers = true;
+		}
+		batchWritten.notify_all();
+		for( int iThread = 0; iThread < nThreads; ++iThread ){
+
+			workers[iThread].join();
+			delete workerATI[iThread];
+		}
+		for( map< unsigned int, batch_t >::iterator it = doneBatches.begin(); it != doneBatches.end(); ++it )
+			for( unsigned int i = 0; i < it->second.events.size(); ++i )
+				delete it->second.events[i];
+	}
+
 	while( eventCounter < nEvents ){
 		
 		if( batchSize < 1E4 ){
@@ -413,85 +841,26 @@ int main( int argc, char* argv[] ){
 		int i=0;
                 while( i < batchSize ){
 
-			double weight = 1.;
-
-			Kinematics* kin;
-			if(bwGenLowerVertex.size() == 0) 
-				kin = resProd.generate(); // stable particle at lower vertex
-			else { 
-				// unstable particle at lower vertex
-				pair< double, double > bwLowerVertex = bwGenLowerVertex[0]();
-				double lowerVertex_mass_bw = bwLowerVertex.first;
-				weight *= bwLowerVertex.second;
-
-				if ( lowerVertex_mass_bw < thresholdLowerVertex || lowerVertex_mass_bw > 2.0) continue;
-				resProd.getProductionMechanism().setRecoilMass( lowerVertex_mass_bw );
-				
-				Kinematics* step1 = resProd.generate();
-				TLorentzVector beam = step1->particle( 0 );
-				TLorentzVector recoil = step1->particle( 1 );
-				
-				// loop over meson decay
-				vector<TLorentzVector> mesonChild;
-				for(unsigned int i=0; i<childMasses.size(); i++) 
-					mesonChild.push_back(step1->particle( 2+i ));
-				
-				// decay step for lower vertex
-				TLorentzVector nucleon; // proton or neutron
-				NBodyPhaseSpaceFactory lowerVertex_decay = NBodyPhaseSpaceFactory( lowerVertex_mass_bw, massesLowerVertex);
-				vector<TLorentzVector> lowerVertexChild = lowerVertex_decay.generateDecay();
-				// boost to lab frame via recoil kinematics
-				for(unsigned int j=0; j<lowerVertexChild.size(); j++) 
-				  lowerVertexChild[j].Boost( recoil.BoostVector() );
-				nucleon = lowerVertexChild[0];
-
-				// store particles in kinematic class
-				vector< TLorentzVector > allPart;
-				allPart.push_back( beam );
-				allPart.push_back( nucleon );
-				// loop over meson decay particles
-				for(unsigned int j=0; j<mesonChild.size(); j++) 
-					allPart.push_back(mesonChild[j]);
-				// loop over lower vertex decay particles
-				for(unsigned int j=1; j<lowerVertexChild.size(); j++) 
-					allPart.push_back(lowerVertexChild[j]);
-			
-				weight *= step1->weight();	
-				kin = new Kinematics( allPart, weight );
-				delete step1;				
-			}
-			
+			Kinematics* kin = generateEvent( resProd );
+			if( !kin ) continue;
 			ati.loadEvent( kin, i, batchSize );
 			delete kin;
 			i++;
 		}
+		nEvaluated += batchSize;
 		
 		cout << "Processing events..." << endl;
 		
-		// include factor of 1.5 to be safe in case we miss peak -- avoid
+		// include a safety factor in case we miss peak -- avoid
 		// intensity calculation of we are generating flat data
-		double maxInten = ( genFlat ? 1 : 1.5 * ati.processEvents( reaction->reactionName() ) );
+		double maxInten = ( genFlat ? 1 : safetyFactor * ati.processEvents( reaction->reactionName() ) );
+		if( useGrid ) maxInten = gridMaxInten;
 		
 		
 		for( int i = 0; i < batchSize; ++i ){
 			
 			Kinematics* evt = ati.kinematics( i );
-			TLorentzVector resonance;
-			for (unsigned int j=2; j<Particles.size(); j++)
-			  resonance += evt->particle( j );
-
-			TLorentzVector isobar;
-			for (unsigned int j=3; j<Particles.size(); j++)
-			  isobar += evt->particle( j );
-
-			TLorentzVector recoil = evt->particle( 1 );
-			if(bwGenLowerVertex.size()) {
-				for(unsigned int j=Particles.size(); j<evt->particleList().size(); j++)
-					recoil += evt->particle( j );
-			}
 
-			double genWeight = evt->weight();
-			
 			// cannot ask for the intensity if we haven't called process events above
 			double weightedInten = ( genFlat ? 1 : ati.intensity( i ) ); 
 			// cout << " i=" << i << "  intensity_i=" << weightedInten << endl;
@@ -503,79 +872,15 @@ int main( int argc, char* argv[] ){
 				
 				if( weightedInten > rand || genFlat ){
 
-					mass->Fill( resonance.M() );
-					massW->Fill( resonance.M(), genWeight );
-					
-					intenW->Fill( weightedInten );
-					intenWVsM->Fill( resonance.M(), weightedInten );
-
-					M_isobar->Fill( isobar.M() );
-					M_recoil->Fill( recoil.M() );
-					
-					// calculate angular variables
-					TLorentzVector beam = evt->particle ( 0 );
-					TLorentzVector rec = evt->particle ( 1 );
-					TLorentzVector p1 = evt->particle ( 2 );
-					TLorentzVector target(0,0,0,rec[3]);
-					
-					if(isBaryonResonance) // assume t-channel
-						t->Fill(-1*(beam-evt->particle(1)).M2());
-					else
-						t->Fill(-1*(recoil-target).M2());
-
-					E->Fill(beam.E());
-					EvsM->Fill(beam.E(),resonance.M());
-
-					TLorentzRotation resonanceBoost( -resonance.BoostVector() );
-					
-					TLorentzVector beam_res = resonanceBoost * beam;
-					TLorentzVector rec_res = resonanceBoost * rec;
-					TLorentzVector p1_res = resonanceBoost * p1;
-					
-					// normal to the production plane
-                                        TVector3 y = (beam.Vect().Unit().Cross(-rec.Vect().Unit())).Unit();
-
-                                        // choose helicity frame: z-axis opposite recoil proton in rho rest frame
-                                        TVector3 z = -1. * rec_res.Vect().Unit();
-                                        TVector3 x = y.Cross(z).Unit();
-                                        TVector3 angles( (p1_res.Vect()).Dot(x),
-                                                         (p1_res.Vect()).Dot(y),
-                                                         (p1_res.Vect()).Dot(z) );
-
-                                        double cosTheta = angles.CosTheta();
-                                        double phi = angles.Phi();
-
-					M_CosTheta->Fill( resonance.M(), cosTheta);
-					M_Phi->Fill( resonance.M(), phi);
-					M_Phi_lab->Fill( resonance.M(), rec.Phi());
-					
-					TVector3 eps(1.0, 0.0, 0.0); // beam polarization vector
-                                        double Phi = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
-
-                                        GDouble psi = phi - Phi;
-                                        if(psi < -1*PI) psi += 2*PI;
-                                        if(psi > PI) psi -= 2*PI;
-					
-					CosTheta_psi->Fill( psi, cosTheta);
-					
-					// we want to save events with weight 1
-					evt->setWeight( 1.0 );
-					
-					if( hddmOut ) hddmOut->writeEvent( *evt, pTypes, centeredVertex );
-					rootOut.writeEvent( *evt );
+					recordEvent( evt, weightedInten );
+					checkMax( weightedInten, maxInten );
 					++eventCounter;
-					if(eventCounter >= nEvents) break;
+					if(eventCounter >= nEvents) { delete evt; break; }
 				}
 			}
 			else{
 				
-				mass->Fill( resonance.M() );
-				massW->Fill( resonance.M(), genWeight );
-				
-				intenW->Fill( weightedInten );
-				intenWVsM->Fill( resonance.M(), weightedInten );
-				TLorentzVector rec = evt->particle ( 1 );
-				
+				recordEvent( evt, weightedInten );
 				++eventCounter;
 			}
 			
@@ -584,6 +889,15 @@ int main( int argc, char* argv[] ){
 		
 		cout << eventCounter << " events were processed." << endl;
 	}
+
+	if( !diag && !genFlat ){
+
+		cout << "Intensity was computed for " << nEvaluated << " events, "
+		     << 100. * eventCounter / nEvaluated << "% were accepted." << endl;
+		if( nAboveMax > 0 )
+			cout << "WARNING:  " << nAboveMax << " events were above the maximum intensity, by up to a factor "
+			     << maxAboveMax << " -- increase the safety factor with -sf" << endl;
+	}
 	
 	mass->Write();
 	massW->Write();
@@ -0,0 +1,163 @@
+#ifndef _DIRACALGEBRA_
+#define _DIRACALGEBRA_
+
+#include <complex>
+#include <cmath>
+
+// Fixed size Dirac algebra for ampSqPTDirac, with the conventions of
+// QedElement: Dirac representation, metric (+,-,-,-), the same spinors
+// and normalization. Spinors are 4 complex numbers and matrices 4x4,
+// all on the stack. Each gamma matrix has one non-zero entry per row,
+// so the products with a gamma^mu are written out from the tables
+// below, one template instance per Lorentz index.
+
+namespace dirac {
+
+typedef std::complex<double> cplx;
+
+struct Spinor    { cplx c[4]; };     // column: u, v, or M*u
+struct SpinorBar { cplx c[4]; };     // row: ubar = u^dagger gamma0
+struct Matrix    { cplx m[4][4]; };
+struct Current   { cplx mu[4]; };    // components 0,x,y,z of a vector
+
+// gamma^mu[i][gammaCol[mu][i]] = gammaVal[mu][i], all other entries 0
+static const int gammaCol[4][4] = {
+  {0, 1, 2, 3},
+  {3, 2, 1, 0},
+  {3, 2, 1, 0},
+  {2, 3, 0, 1}
+};
+static const cplx gammaVal[4][4] = {
+  {cplx(1,0), cplx(1,0), cplx(-1,0), cplx(-1,0)},
+  {cplx(1,0), cplx(1,0), cplx(-1,0), cplx(-1,0)},
+  {cplx(0,-1), cplx(0,1), cplx(0,1), cplx(0,-1)},
+  {cplx(1,0), cplx(-1,0), cplx(-1,0), cplx(1,0)}
+};
+
+// abar gamma^MU b
+template <int MU>
+inline cplx sandwich(const SpinorBar& a, const Spinor& b)
+{
+  return a.c[0] * gammaVal[MU][0] * b.c[gammaCol[MU][0]]
+       + a.c[1] * gammaVal[MU][1] * b.c[gammaCol[MU][1]]
+       + a.c[2] * gammaVal[MU][2] * b.c[gammaCol[MU][2]]
+       + a.c[3] * gammaVal[MU][3] * b.c[gammaCol[MU][3]];
+}
+
+// J^mu = abar gamma^mu b
+inline Current current(const SpinorBar& a, const Spinor& b)
+{
+  Current j;
+  j.mu[0] = sandwich<0>(a, b);
+  j.mu[1] = sandwich<1>(a, b);
+  j.mu[2] = sandwich<2>(a, b);
+  j.mu[3] = sandwich<3>(a, b);
+  return j;
+}
+
+// J1^mu J2_mu
+inline cplx contract(const Current& j1, const Current& j2)
+{
+  return j1.mu[0] * j2.mu[0] - j1.mu[1] * j2.mu[1]
+       - j1.mu[2] * j2.mu[2] - j1.mu[3] * j2.mu[3];
+}
+
+// (e,px,py,pz) slashed plus m times the unit matrix, as
+// QedElement's SetMomentumSlash (and SetEpsilonSlash, with e = m = 0)
+inline Matrix slash(double e, double px, double py, double pz, double m = 0)
+{
+  const double p[4] = {e, -px, -py, -pz};
+  Matrix s;
+  for (int i=0; i<4; i++) {
+    for (int j=0; j<4; j++)
+      s.m[i][j] = 0;
+    s.m[i][i] = m;
+  }
+  for (int mu=0; mu<4; mu++)
+    for (int i=0; i<4; i++)
+      s.m[i][gammaCol[mu][i]] += p[mu] * gammaVal[mu][i];
+  return s;
+}
+
+inline Matrix slashOnShell(double px, double py, double pz, double mass, double m = 0)
+{
+  double e = sqrt(px*px + py*py + pz*pz + mass*mass);
+  return slash(e, px, py, pz, m);
+}
+
+inline Spinor operator*(const Matrix& a, const Spinor& b)
+{
+  Spinor r;
+  for (int i=0; i<4; i++)
+    r.c[i] = a.m[i][0] * b.c[0] + a.m[i][1] * b.c[1]
+           + a.m[i][2] * b.c[2] + a.m[i][3] * b.c[3];
+  return r;
+}
+
+inline SpinorBar operator*(const SpinorBar& a, const Matrix& b)
+{
+  SpinorBar r;
+  for (int j=0; j<4; j++)
+    r.c[j] = a.c[0] * b.m[0][j] + a.c[1] * b.m[1][j]
+           + a.c[2] * b.m[2][j] + a.c[3] * b.m[3][j];
+  return r;
+}
+
+// as QedElement::SetU
+inline Spinor spinorU(double px, double py, double pz, double mass, int spin)
+{
+  double energy = sqrt(px*px + py*py + pz*pz + mass*mass);
+  double norm = sqrt(energy + mass);
+  double f = norm / (energy + mass);
+  Spinor u;
+  if (spin == 1) {
+    u.c[0] = norm;
+    u.c[1] = 0;
+    u.c[2] = f * pz;
+    u.c[3] = cplx(f * px, f * py);
+  }
+  else {
+    u.c[0] = 0;
+    u.c[1] = norm;
+    u.c[2] = cplx(f * px, -f * py);
+    u.c[3] = -f * pz;
+  }
+  return u;
+}
+
+// as QedElement::SetV
+inline Spinor spinorV(double px, double py, double pz, double mass, int spin)
+{
+  double energy = sqrt(px*px + py*py + pz*pz + mass*mass);
+  double norm = sqrt(energy + mass);
+  double f = norm / (energy + mass);
+  Spinor v;
+  if (spin == 1) {
+    v.c[0] = cplx(f * px, -f * py);
+    v.c[1] = -f * pz;
+    v.c[2] = 0;
+    v.c[3] = norm;
+  }
+  else {
+    v.c[0] = -f * pz;
+    v.c[1] = cplx(-f * px, -f * py);
+    v.c[2] = -norm;
+    v.c[3] = 0;
+  }
+  return v;
+}
+
+// u^dagger gamma0, as QedElement::SetUBar and SetVBar
+inline SpinorBar bar(const Spinor& u)
+{
+  SpinorBar b;
+  b.c[0] = std::conj(u.c[0]);
+  b.c[1] = std::conj(u.c[1]);
+  b.c[2] = -std::conj(u.c[2]);
+  b.c[3] = -std::conj(u.c[3]);
+  return b;
+}
+
+} // namespace dirac
+
+#endif // _DIRACALGEBRA_
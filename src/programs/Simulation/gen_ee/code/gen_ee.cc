@@ -1,5 +1,7 @@
 #include <string>
 #include <iostream>
+#include <vector>
+#include <ctime>
 #include "TTree.h"
 #include "TFile.h"
 #include "TLorentzVector.h"
@@ -29,6 +31,7 @@ struct genSettings_t {
   int tOut;             //type of output file (1->ROOT; 2->HDDM)
   int reaction;         //reaction (2->pair; 3->triplet)
   char outFile[80];     //name of output file
+  int nBenchmark;       //number of events to benchmark ampSqPTDirac on (0-> generate as usual)
   //char inFileBrem[80];  //name of input root file that contains spectra histogram cobrem_vs_E
   string  beamconfigfile = "beam.cfg"; //beam cfg file 
   TString genconfigfile = "gen.cfg"; //generator cfg file
@@ -37,6 +40,9 @@ struct genSettings_t {
 //FUNCTION PROTOTYPES
 double ampSqPT(int type, int polDir, TLorentzVector target, TLorentzVector beam,
                  TLorentzVector recoil,TLorentzVector q1,TLorentzVector q2);
+double ampSqPTDirac(int type, int polDir, TLorentzVector target, TLorentzVector beam,
+                    TLorentzVector recoil,TLorentzVector q1,TLorentzVector q2);
+void benchmarkAmpSq(genSettings_t genSettings, PhasePT &phaseGen, TRandom3 *random);
 void printUsage(genSettings_t genSettings, int goYes);
 
 int main(int argc, char **argv){
@@ -56,6 +62,7 @@ int main(int argc, char **argv){
   genSettings.nToGen       = 100000;
   genSettings.prescale     = 1000;
   genSettings.rSeed        = 103;
+  genSettings.nBenchmark   = 0;
   sprintf(genSettings.outFile,"genOut.root");
   //sprintf(genSettings.inFileBrem,"cobrems.root");
     
@@ -113,6 +120,9 @@ int main(int argc, char **argv){
       case 'u':
         genSettings.eUpper = atof(++argptr);
         break;
+      case 'B':
+        genSettings.nBenchmark = atoi(++argptr);
+        break;
       case 'o':
 	outFileSet = 1;
         strcpy(genSettings.outFile,++argptr);
@@ -295,6 +305,12 @@ int main(int argc, char **argv){
   double sumTest4=0.0;
   double sumTest5=0.0;
 
+  //COMPARE ampSqPTDirac WITH ampSqPT INSTEAD OF GENERATING
+  if (genSettings.nBenchmark > 0) {
+    benchmarkAmpSq(genSettings,phaseGenR,random);
+    return 0;
+  }
+
   int genVal;
   int nTest = 0;
   double yMax,yVal,testValY;
@@ -408,13 +424,13 @@ int main(int argc, char **argv){
     if (genSettings.reaction == 2) { //PAIR PRODUCTION
       radFactor = radFactorPair;
       sHfactor = sHfactorPair;
-      crossSection = ampSqPT(2,genSettings.polDir,target,beam,recoil,q1,q2)*hbarcSqr*pow(alphaQED,3)
+      crossSection = ampSqPTDirac(2,genSettings.polDir,target,beam,recoil,q1,q2)*hbarcSqr*pow(alphaQED,3)
 	/ fluxFactor * rhoFactor * piFactor;
     }
     if (genSettings.reaction == 3) { //TRIPLET PRODUCTION
       radFactor = radFactorTrip;
       sHfactor = sHfactorTrip;
-      crossSection = ampSqPT(3,genSettings.polDir,target,beam,recoil,q1,q2)*hbarcSqr*pow(alphaQED,3)
+      crossSection = ampSqPTDirac(3,genSettings.polDir,target,beam,recoil,q1,q2)*hbarcSqr*pow(alphaQED,3)
 	/ fluxFactor * rhoFactor * piFactor;
     }
 
@@ -487,6 +503,49 @@ int main(int argc, char **argv){
   cout<<"All done. Bye"<<endl;
 }
 
+//COMPARE ampSqPTDirac WITH ampSqPT ON THE SAME PHASE SPACE EVENTS
+//AND PRINT THE LARGEST DIFFERENCE AND THE EVENT RATE OF EACH
+void benchmarkAmpSq(genSettings_t genSettings, PhasePT &phaseGen, TRandom3 *random){
+  int nEvents = genSettings.nBenchmark;
+  std::vector<TLorentzVector> beam(nEvents),target(nEvents),recoil(nEvents),q1(nEvents),q2(nEvents);
+  for (int n=0; n<nEvents; n++) {
+    while (phaseGen.Gen(random) < 0) {}
+    beam[n]   = phaseGen.GetBeam();
+    target[n] = phaseGen.GetTarget();
+    recoil[n] = phaseGen.GetRecoil();
+    q1[n]     = phaseGen.GetQ1();
+    q2[n]     = phaseGen.GetQ2();
+  }
+
+  int rxn = genSettings.reaction;
+  int pol = genSettings.polDir;
+  std::vector<double> ampQed(nEvents),ampDirac(nEvents);
+  clock_t start = clock();
+  for (int n=0; n<nEvents; n++)
+    ampQed[n] = ampSqPT(rxn,pol,target[n],beam[n],recoil[n],q1[n],q2[n]);
+  double tQed = double(clock() - start)/CLOCKS_PER_SEC;
+  start = clock();
+  for (int n=0; n<nEvents; n++)
+    ampDirac[n] = ampSqPTDirac(rxn,pol,target[n],beam[n],recoil[n],q1[n],q2[n]);
+  double tDirac = double(clock() - start)/CLOCKS_PER_SEC;
+
+  //Where the diagrams cancel to many digits the two differ by more
+  //than their rounding, so count those events separately
+  double maxDiff = 0.0;
+  int nOff = 0;
+  for (int n=0; n<nEvents; n++) {
+    double scale = fabs(ampQed[n]) > 0 ? fabs(ampQed[n]) : 1.0;
+    double diff = fabs(ampDirac[n] - ampQed[n])/scale;
+    if (diff > maxDiff) maxDiff = diff;
+    if (diff > 1e-10) nOff++;
+  }
+  cout<<"Benchmark of "<<nEvents<<" events, reaction "<<rxn<<", polarization "<<pol<<endl;
+  cout<<"  ampSqPT      : "<<tQed<<" s, "<<(tQed > 0 ? nEvents/tQed : 0)<<" events/s"<<endl;
+  cout<<"  ampSqPTDirac : "<<tDirac<<" s, "<<(tDirac > 0 ? nEvents/tDirac : 0)<<" events/s"<<endl;
+  cout<<"  largest relative difference : "<<maxDiff<<endl;
+  cout<<"  events differing by more than 1e-10 : "<<nOff<<endl;
+}
+
 void printUsage(genSettings_t genSettings, int goYes){
   if (goYes == 0){
     fprintf(stderr,"\nSWITCHES:\n");
@@ -517,6 +576,7 @@ void printUsage(genSettings_t genSettings, int goYes){
     fprintf(stderr,"-u<arg>\tMaximum incident photon energy in GeV. ONLY USED IF -b2\n");
     //fprintf(stderr,"-s<arg>\tfile with histogram cobrem_vs_E.       ONLY USED IF -b2\n");
     fprintf(stderr,"-o<arg>\tOutFile name\n");
+    fprintf(stderr,"-B<arg>\tCompare the matrix element with the old QedElement one on <arg> events and exit\n");
 
     cout<<""<<endl;
     cout<<"The above switches overide the default setting."<<endl;
@@ -10,6 +10,7 @@
 #include "TLorentzVector.h"
 #include "TGenPhaseSpace.h"
 #include "qDevilLib.h"
+#include "DiracAlgebra.h"
 
 // define overloaded + (plus) operator
 Complx Complx::operator+ (const Complx& c) const
@@ -1467,6 +1468,198 @@ double ampSqPT(int rxnType,int polDirection, TLorentzVector target, TLorentzVect
 }
 
 
+//////////////////////////////////////////////
+// Same as ampSqPT, with the fixed size algebra of DiracAlgebra.h in
+// place of QedElement. Every spinor, propagator and current is built
+// once per spin state before the spin sum, which is then a sum of
+// products of currents. The diagrams are combined as in ampSqPT.
+
+double ampSqPTDirac(int rxnType,int polDirection, TLorentzVector target, TLorentzVector beam,
+                    TLorentzVector recoil,TLorentzVector q1,TLorentzVector q2){
+  using namespace dirac;
+
+  double sumFactor = 0.5;
+  double massElectron = 0.51099907e-3; //Mass in GeV
+  double massTarget = target.Mag();
+
+  //IF UNPOLARIZED SET SUM FACTOR
+  if (polDirection == 0) {
+    sumFactor = 0.25;
+  }
+
+  //Same kinematics and numbering as in ampSqPT
+  double p1  = beam.E();
+  double E1  = p1;
+  double px1 = 0.0;
+  double py1 = 0.0;
+  double pz1 = p1;
+
+  double E2  = target.E();
+  double px2 = target.Px();
+  double py2 = target.Py();
+  double pz2 = target.Pz();
+
+  double E3  = q1.E();
+  double px3 = q1.Px();
+  double py3 = q1.Py();
+  double pz3 = q1.Pz();
+
+  double E4  = q2.E();
+  double px4 = q2.Px();
+  double py4 = q2.Py();
+  double pz4 = q2.Pz();
+
+  double E5  = recoil.E();
+  double px5 = recoil.Px();
+  double py5 = recoil.Py();
+  double pz5 = recoil.Pz();
+
+  if (p1 <= 2*massElectron) return 0.0;
+  if (rxnType != 2 && rxnType != 3) return 0.0;
+
+  //Dot products, propagators and kinematic factors as in ampSqPT
+  double p1p2 = E1*E2 - px1*px2 - py1*py2 - pz1*pz2;
+  double p1p3 = E1*E3 - px1*px3 - py1*py3 - pz1*pz3;
+  double p1p4 = E1*E4 - px1*px4 - py1*py4 - pz1*pz4;
+  double p1p5 = E1*E5 - px1*px5 - py1*py5 - pz1*pz5;
+  double p2p3 = E2*E3 - px2*px3 - py2*py3 - pz2*pz3;
+  double p2p5 = E2*E5 - px2*px5 - py2*py5 - pz2*pz5;
+  double p3p4 = E3*E4 - px3*px4 - py3*py4 - pz3*pz4;
+  double p4p5 = E4*E5 - px4*px5 - py4*py5 - pz4*pz5;
+
+  double q21 = pow(massTarget,2) + pow(massTarget,2) - 2*p2p5;
+  double q22 = q21;
+  double q23 = pow(massElectron,2) + pow(massTarget,2) - 2*p2p3;
+  double q24 = q23;
+  double q25 = 2*pow(massElectron,2) + 2*p3p4;
+  double q26 = q25;
+  double q27 = pow(massTarget,2) + pow(massElectron,2) + 2*p4p5;
+  double q28 = q27;
+
+  double kf1 = -1.0/(2.0*p1p3)/q21;
+  double kf2 = -1.0/(2.0*p1p4)/q22;
+  double kf5 = 1.0/(2.0*p1p2)/q25;
+  double kf6 = -1.0/(2.0*p1p5)/q26;
+  // kf3, kf4, kf7 and kf8 are not used by ampSqPT either
+  (void)q23; (void)q24; (void)q27; (void)q28;
+
+  //Photon polarizations summed over, as in ampSqPT
+  int phoSpin1 = -1;
+  int phoSpin2 = 1;
+  if (polDirection == 2){
+    phoSpin1 = -1; //Y-DIRECTION
+    phoSpin2 = -1; //Y-DIRECTION
+  }
+  if (polDirection == 1){
+    phoSpin1 = 1; //X-DIRECTION
+    phoSpin2 = 1; //X-DIRECTION
+  }
+
+  //Slash terms, with the mass term of the propagators added
+  Matrix prop31 = slashOnShell(px3,py3,pz3,massElectron,massElectron);
+  Matrix prop14 = slashOnShell(px1,py1,pz1,0.0,massElectron);
+  Matrix prop51 = slashOnShell(px5,py5,pz5,massTarget,massElectron);
+  Matrix prop12 = slashOnShell(px1,py1,pz1,0.0,massTarget);
+  Matrix prop5t = slashOnShell(px5,py5,pz5,massTarget,massTarget);
+  Matrix p1Slash = slashOnShell(px1,py1,pz1,0.0);
+  Matrix p2Slash = slashOnShell(px2,py2,pz2,massTarget);
+  Matrix p4Slash = slashOnShell(px4,py4,pz4,massElectron);
+  for (int i=0; i<4; i++) {
+    for (int j=0; j<4; j++) {
+      prop31.m[i][j] -= p1Slash.m[i][j];
+      prop14.m[i][j] -= p4Slash.m[i][j];
+      prop51.m[i][j] -= p1Slash.m[i][j];
+      prop12.m[i][j] += p2Slash.m[i][j];
+      prop5t.m[i][j] -= p1Slash.m[i][j];
+    }
+  }
+
+  //Spinors and photon polarization vectors, index 0 for spin -1
+  Spinor u2[2], v4[2];
+  SpinorBar u3Bar[2], u5Bar[2];
+  Matrix ep1Slash[2];
+  for (int s=0; s<2; s++) {
+    int spin = 2*s - 1;
+    u2[s] = spinorU(px2,py2,pz2,massTarget,spin);
+    u3Bar[s] = bar(spinorU(px3,py3,pz3,massElectron,spin));
+    v4[s] = spinorV(px4,py4,pz4,massElectron,spin);
+    u5Bar[s] = bar(spinorU(px5,py5,pz5,massTarget,spin));
+  }
+  ep1Slash[0] = slash(0.0,0.0,1.0,0.0); //PHOTON POLARIZED IN Y-DIRECTION
+  ep1Slash[1] = slash(0.0,1.0,0.0,0.0); //PHOTON POLARIZED IN X-DIRECTION
+
+  //Currents of each diagram, by the spins they depend on
+  Current j52[2][2], j32[2][2], j34[2][2], j54[2][2];
+  for (int a=0; a<2; a++) {
+    for (int b=0; b<2; b++) {
+      j52[a][b] = current(u5Bar[a],u2[b]);
+      j32[a][b] = current(u3Bar[a],u2[b]);
+      j34[a][b] = current(u3Bar[a],v4[b]);
+      j54[a][b] = current(u5Bar[a],v4[b]);
+    }
+  }
+  Current a1[2][2][2], a2[2][2][2];   //[photon][3][4]
+  Current a3[2][2][2], a4[2][2][2];   //[photon][5][4]
+  Current a5[2][2][2], a6[2][2][2];   //[photon][5][2]
+  Current a7[2][2][2];                //[photon][3][2]
+  for (int s1=(phoSpin1+1)/2; s1<=(phoSpin2+1)/2; s1++) {
+    for (int a=0; a<2; a++) {
+      SpinorBar r1 = u3Bar[a]*ep1Slash[s1]*prop31;
+      Spinor c2 = prop14*(ep1Slash[s1]*v4[a]);
+      for (int b=0; b<2; b++) {
+        a1[s1][a][b] = current(r1,v4[b]);
+        a2[s1][b][a] = current(u3Bar[b],c2);
+      }
+      if (rxnType == 3) {
+        SpinorBar r3 = u5Bar[a]*ep1Slash[s1]*prop51;
+        SpinorBar r6 = u5Bar[a]*ep1Slash[s1]*prop5t;
+        Spinor c5 = prop12*(ep1Slash[s1]*u2[a]);
+        for (int b=0; b<2; b++) {
+          a3[s1][a][b] = current(r3,v4[b]);
+          a4[s1][b][a] = current(u5Bar[b],c2);
+          a5[s1][b][a] = current(u5Bar[b],c5);
+          a6[s1][a][b] = current(r6,u2[b]);
+          a7[s1][b][a] = current(u3Bar[b],c5);
+        }
+      }
+    }
+  }
+
+  //Sum over spin assignments
+  double mAmplSq = 0.0;
+  for (int s1=(phoSpin1+1)/2; s1<=(phoSpin2+1)/2; s1++) {
+    for (int s2=0; s2<2; s2++) {
+      for (int s3=0; s3<2; s3++) {
+        for (int s4=0; s4<2; s4++) {
+          for (int s5=0; s5<2; s5++) {
+            cplx m = kf1*contract(a1[s1][s3][s4],j52[s5][s2])
+                   + kf2*contract(a2[s1][s3][s4],j52[s5][s2]);
+            if (rxnType == 3) {
+              m += kf5*contract(a3[s1][s5][s4],j32[s3][s2])
+                 + kf6*contract(a4[s1][s5][s4],j32[s3][s2])
+                 + kf5*contract(a5[s1][s5][s2],j34[s3][s4])
+                 + kf6*contract(a6[s1][s5][s2],j34[s3][s4])
+                 + (kf5 + kf6)*contract(a7[s1][s3][s2],j54[s5][s4]);
+            }
+            mAmplSq += std::norm(m);
+          }
+        }
+      }
+    }
+  } //Finished with the spin sum
+
+  double mAmplSqSum = mAmplSq*sumFactor;
+
+  if (mAmplSqSum >= 0 || mAmplSqSum <=0){
+    //do nothing
+  } else {
+    cout<<"!!!!!Bad Event!!!!!"<<endl;
+    mAmplSqSum = 0.0;
+  }
+
+  return mAmplSqSum;
+}
+
 //////////////////////////////////////////////
 
 int PhasePT::Gen(TRandom3 *random){
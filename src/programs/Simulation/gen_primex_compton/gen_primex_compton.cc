@@ -21,6 +21,7 @@
 #include "particleType.h"
 
 #include "UTILITIES/BeamProperties.h"
+#include "UTILITIES/HistogramSampler.h"
 
 #include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
 #include "AMPTOOLS_MCGEN/HDDMDataWriter.h"
@@ -153,15 +154,15 @@ int main( int argc, char* argv[] ){
   if (hddmname != "")
     hddmWriter = new HddmOut(hddmname.c_str());
   
-  // Assume a beam energy spectrum of 1/E(gamma)
-  TF1 ebeam_spectrum("beam_spectrum","1/x",beamLowE,beamHighE);
-  
-  // Get beam properties from configuration file
+  // Get beam properties from configuration file, otherwise
+  // assume a beam energy spectrum of 1/E(gamma)
   TH1D * cobrem_vs_E = 0;
+  HistogramSampler ebeam_sampler;
   if (beamconfigfile != "") {
     BeamProperties beamProp( beamconfigfile );
     cobrem_vs_E = (TH1D*)beamProp.GetFlux();
     cout << cobrem_vs_E->GetEntries() << endl;
+    ebeam_sampler = HistogramSampler(cobrem_vs_E);
   }
   
   // Get generator config file
@@ -194,9 +195,9 @@ int main( int argc, char* argv[] ){
 	// get beam energy
 	double ebeam = 0;
 	if (beamconfigfile == "" || cobrem_vs_E == 0) 
-	  ebeam = ebeam_spectrum.GetRandom();
+	  ebeam = beamLowE * pow(beamHighE / beamLowE, gRandom->Rndm());
 	else if (beamconfigfile != "")
-	  ebeam = cobrem_vs_E->GetRandom();
+	  ebeam = ebeam_sampler.Sample();
 	
 	h_egam1->Fill(ebeam);
       } 
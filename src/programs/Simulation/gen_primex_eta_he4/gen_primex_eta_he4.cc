@@ -21,6 +21,7 @@
 #include "particleType.h"
 
 #include "UTILITIES/BeamProperties.h"
+#include "UTILITIES/HistogramSampler.h"
 
 #include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
 #include "AMPTOOLS_MCGEN/HDDMDataWriter.h"
@@ -162,14 +163,14 @@ int main( int argc, char* argv[] ){
   if (outname != "")
     asciiWriter = new ofstream(outname.c_str());
   
-  // Assume a beam energy spectrum of 1/E(gamma)
-  TF1 ebeam_spectrum("beam_spectrum","1/x",beamLowE,beamHighE);
-  
-  // Get beam properties from configuration file
+  // Get beam properties from configuration file, otherwise
+  // assume a beam energy spectrum of 1/E(gamma)
   TH1D * cobrem_vs_E = 0;
+  HistogramSampler ebeam_sampler;
   if (beamconfigfile != "") {
     BeamProperties beamProp( beamconfigfile );
     cobrem_vs_E = (TH1D*)beamProp.GetFlux();
+    ebeam_sampler = HistogramSampler(cobrem_vs_E);
   }
   
   // Get generator config file
@@ -196,6 +197,8 @@ int main( int argc, char* argv[] ){
   // Load eta-meson differential cross-section based on Ilya Larin's calculation, see the *.F program in this directory 
   TFile * ifile = new TFile(m_rfile);
   TH2F * h_dxs = (TH2F *) ifile->Get(m_histo);
+  // LAB polar angle distribution for each beam energy bin
+  HistogramSliceSampler theta_sampler(h_dxs);
 
   double M_meson = 0;
   if (m_decay.Contains("eta"))
@@ -222,9 +225,9 @@ int main( int argc, char* argv[] ){
     // get beam energy
     double ebeam = 0;
     if (beamconfigfile == "" || cobrem_vs_E == 0) 
-      ebeam = ebeam_spectrum.GetRandom();
+      ebeam = beamLowE * pow(beamHighE / beamLowE, gRandom->Rndm());
     else if (beamconfigfile != "")
-      ebeam = cobrem_vs_E->GetRandom();
+      ebeam = ebeam_sampler.Sample();
     
     // Incident photon-beam 4Vec
     TLorentzVector InGamma_4Vec(0, 0, ebeam, ebeam);
@@ -236,10 +239,10 @@ int main( int argc, char* argv[] ){
     double sqrt_s = IS_4Vec.M();
     double s = pow(sqrt_s, 2);
     
-    // Histo. creation that will store the calculated diff. xs. vs. LAB polar angle
-    int ebeam_bin = h_dxs->GetXaxis()->FindBin(ebeam);
-    TH1F * h_ThetaLAB = (TH1F *) h_dxs->ProjectionY("h_ThetaLAB", ebeam_bin, ebeam_bin);
-    if (h_ThetaLAB->GetEntries() == 0) continue;
+    // Generate eta-meson theta in LAB from the diff. xs. near this beam energy
+    double ThetaLAB = 0;
+    if (!theta_sampler.Sample(ebeam, ThetaLAB)) continue;
+    ThetaLAB *= TMath::DegToRad();
     
     /*
     // XS initialization
@@ -319,10 +322,6 @@ int main( int argc, char* argv[] ){
     in_incoherent.close();
     }
     */
-    // Generate eta-meson theta in LAB
-    double ThetaLAB = h_ThetaLAB->GetRandom();
-    ThetaLAB *= TMath::DegToRad();
-    
     // Generate eta-meson phi in LAB
     double PhiLAB = gRandom->Uniform(-TMath::Pi(), TMath::Pi());
     
@@ -463,9 +462,6 @@ int main( int argc, char* argv[] ){
       if (m_target == "Neutron") (*asciiWriter)<<"2 "<<Neutron_TYPE<<" "<<M_n<<endl;
       (*asciiWriter)<<"   "<<1<<" "<<He4_LAB_4Vec.Px()<<" "<<He4_LAB_4Vec.Py()<<" "<<He4_LAB_4Vec.Pz()<<" "<<He4_LAB_4Vec.E()<<endl;			
     }
-    
-    // deletion
-    delete h_ThetaLAB;
   }
   h_Tkin_eta_vs_egam->Write();
   h_Tkin_photon_vs_egam->Write();
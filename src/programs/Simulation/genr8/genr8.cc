@@ -20,6 +20,7 @@
 #include <unistd.h>
 #include <math.h>
 #include <string>
+#include <fstream>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/signal.h>
@@ -30,6 +31,7 @@
 #include <particleType.h>
 
 #include "UTILITIES/BeamProperties.h"
+#include "HDDM/hddm_s.hpp"
 
 #define TRUE 1
 #define FALSE 0
@@ -86,6 +88,12 @@ int runNo=9000;
 int NFinalParts=0;
 unsigned int RandomSeed=0;
 int UseCurrentTimeForRandomSeed = TRUE;
+int WriteHddm=0;
+char *HddmFileName=NULL;
+int HddmCompression=2;  /* 0 = none, 1 = bz2, 2 = z */
+float Vertex[4]={0.0,0.0,65.0,65.0};  /* x, y, z_min, z_max */
+unsigned short VertexRand[3];  /* erand48 state for the vertex z */
+struct particleMC_t *Printed[20];  /* particles of the current event */
 /***********************/
 /* Declarations         */
 /***********************/
@@ -111,6 +119,10 @@ void checkFamily(struct particleMC_t *Isobar);
 int setChildrenMass(struct particleMC_t *Isobar);
 void printFamily(struct particleMC_t *Isobar);
 void lorentzFactor(double *lf,struct particleMC_t *Isobar);
+hddm_s::ostream *openHddm(const char *filename,std::ofstream **file);
+void writeHddm(hddm_s::ostream *out,int eventNo,
+	       struct particleMC_t *beam,struct particleMC_t *target);
+unsigned int eventSeed(int eventNo,int iseed);
 
 /*
  ***********************
@@ -123,7 +135,7 @@ void lorentzFactor(double *lf,struct particleMC_t *Isobar);
 void PrintUsage(char *processName)
 {
  
-  fprintf(stderr,"%s usage: [-A<name>]   < infile \n",processName);
+  fprintf(stderr,"%s usage: [-A<name>] [-H<name>]   < infile \n",processName);
   fprintf(stderr,"\t-d debug flag\n");
   fprintf(stderr,"\t-n Use a particle name and not its ID number (ascii only) \n");
   fprintf(stderr,"\t-M<max> Process first max events\n");
@@ -134,6 +146,9 @@ void PrintUsage(char *processName)
   /* fprintf(stderr,"\t-R Save recoiling baryon information. \n"); */
  
   fprintf(stderr,"\t-A<filename> Save in ascii format. \n");
+  fprintf(stderr,"\t-H<filename> Save in hddm format, or to stdout if <filename> is - \n");
+  fprintf(stderr,"\t-V\"x y z_min z_max\" Set the vertex (hddm only, default: 0 0 65 65) \n");
+  fprintf(stderr,"\t-Z<n> hddm compression: 0 none, 1 bz2, 2 z (default) \n");
   fprintf(stderr,"\t-s<seed> Set random number seed to <seed>. \n");
   fprintf(stderr,"\t         (default is to set using current time + pid) \n");
   fprintf(stderr,"\t-h Print this help message\n\n");
@@ -155,7 +170,9 @@ int main(int argc,char **argv)
   int i,npart=0,ngenerated=0,naccepted=0, imassc, imassc2;
   int nv4,max=10,part=0,chld1=-1,chld2=-1,prnt=-1,lfevents=10000;
   FILE *fout=stdout;
-  struct particleMC_t particle[20],beam,target,CM;
+  hddm_s::ostream *hddmout=NULL;
+  std::ofstream *hddmfile=NULL;
+  struct particleMC_t particle[20],beam,target,CM,lab_beam,lab_target;
   //struct particleMC_t recoil;
   struct particleMC_t *X,*Y;
   vector4_t beta,v4[2];
@@ -210,6 +227,20 @@ int main(int argc,char **argv)
 	  fout = fopen(++argptr,"w");
 	  fprintf(stderr,"Opening file %s for output. \n",argptr);
 	  break;
+	case 'H':
+	  WriteHddm=1;
+	  HddmFileName = ++argptr;
+	  break;
+	case 'V':
+	  sscanf(++argptr,"%f %f %f %f",&Vertex[0],&Vertex[1],&Vertex[2],&Vertex[3]);
+	  if(Vertex[2] > Vertex[3]){
+	    fprintf(stderr,"Invalid vertex: z_min > z_max\n");
+	    exit(-1);
+	  }
+	  break;
+	case 'Z':
+	  HddmCompression = atoi(++argptr);
+	  break;
 	case 'R':
 	  fprintf(stderr,"Printing recoil information.\n");
 	  PrintRecoil=1;
@@ -252,8 +283,22 @@ int main(int argc,char **argv)
     RandomSeed=time(NULL);
 	RandomSeed += getpid();
   }
-  printf("Setting random number seed to: %d\n",RandomSeed);
+  fprintf(stderr,"Setting random number seed to: %d\n",RandomSeed);
   srand48(RandomSeed); 
+  /* the vertex has its own stream, so -H leaves the events unchanged */
+  VertexRand[0] = 0x330e;
+  VertexRand[1] = RandomSeed & 0xffff;
+  VertexRand[2] = RandomSeed >> 16;
+
+  /*
+   * Without -A the ascii events go to stdout,
+   * unless that is where the hddm events go.
+   */
+  if(WriteHddm){
+    if(!WriteAscii)
+      fout = NULL;
+    hddmout = openHddm(HddmFileName,&hddmfile);
+  }
 
   /*
    * Now read the input.gen file 
@@ -501,6 +546,8 @@ int main(int argc,char **argv)
 
     event_beam.p.t = energy(event_beam.mass,&(event_beam.p.space));
     event_target.p.t = energy(event_target.mass,&(event_target.p.space));
+    lab_beam = event_beam;
+    lab_target = event_target;
 
     sqrt_s = sqrt( SQ(event_beam.mass) +SQ(event_target.mass) + 2.0*event_beam.p.t * event_target.p.t);
     MassHighBW = sqrt_s; /* see do loop below */
@@ -724,7 +771,8 @@ l2:	  imassc=setChildrenMass(Y->child[i]);
 	Nprinted =0;
 	/* event header information 
 	fprintf(fout,"RunNo %d EventNo %d\n",runNo,naccepted);*/
-	fprintf(fout,"%d %d %d\n",runNo,naccepted, NFinalParts);
+	if(fout)
+	  fprintf(fout,"%d %d %d\n",runNo,naccepted, NFinalParts);
 
 	/*
 	 * Print out the production
@@ -755,6 +803,8 @@ l2:	  imassc=setChildrenMass(Y->child[i]);
 	  else
 	    printFinal(fout,Y);
 	}
+	if(hddmout)
+	  writeHddm(hddmout,naccepted,&lab_beam,&lab_target);
 	
 
       }
@@ -773,8 +823,14 @@ l2:	  imassc=setChildrenMass(Y->child[i]);
   /*
    * Close the output file.
    */
-  fflush(fout);
-  fclose(fout);
+  if(fout){
+    fflush(fout);
+    fclose(fout);
+  }
+  if(hddmout){
+    delete hddmout;
+    delete hddmfile;
+  }
   
   return 0;
 }/* end of main */
@@ -1122,7 +1178,9 @@ void printFinal(FILE *fp,struct particleMC_t *Isobar)
  *******************************/
 void printp2ascii(FILE *fp,struct particleMC_t *Isobar)
 {
-  Nprinted++;
+  Printed[Nprinted++] = Isobar;
+  if(fp==NULL)
+    return;
   if(UseName)
     fprintf(fp,"%d %s %lf\n",Nprinted,ParticleType(Isobar->particleID),Isobar->mass);
   else
@@ -1136,6 +1194,143 @@ void printp2ascii(FILE *fp,struct particleMC_t *Isobar)
 
 }
 
+/********************************
+ *
+ * openHddm()
+ *
+ * Open the hddm output stream.  A filename
+ * of - (or none) sends the events to stdout,
+ * e.g. to be piped into decay_evtgen, and
+ * anything else printed to stdout is sent
+ * to stderr instead.
+ *******************************/
+hddm_s::ostream *openHddm(const char *filename,std::ofstream **file)
+{
+  static char buffer[1 << 20];
+  char path[64];
+  hddm_s::ostream *out;
+
+  if(filename==NULL || *filename=='\0' || strcmp(filename,"-")==0){
+    int fd;
+    fflush(stdout);
+    fd = dup(1);
+    dup2(2,1);
+    snprintf(path,sizeof(path),"/dev/fd/%d",fd);
+    filename = path;
+    fprintf(stderr,"Writing hddm events to stdout. \n");
+  }
+  else
+    fprintf(stderr,"Opening file %s for hddm output. \n",filename);
+
+  *file = new std::ofstream;
+  (*file)->rdbuf()->pubsetbuf(buffer,sizeof(buffer));
+  (*file)->open(filename,std::ios::out | std::ios::binary);
+  if(!(*file)->is_open()){
+    fprintf(stderr,"Unable to open %s for hddm output\n",filename);
+    exit(-1);
+  }
+  out = new hddm_s::ostream(**file);
+  if(HddmCompression==1)
+    out->setCompression(hddm_s::k_bz2_compression);
+  else if(HddmCompression==2)
+    out->setCompression(hddm_s::k_z_compression);
+  return out;
+}
+
+/********************************
+ *
+ * writeHddm()
+ *
+ * Write the particles printed for this event
+ * as an hddm_s record, the same record that
+ * genr8_2_hddm makes from the ascii output,
+ * but with the beam and target as generated.
+ *******************************/
+void writeHddm(hddm_s::ostream *out,int eventNo,
+	       struct particleMC_t *beam,struct particleMC_t *target)
+{
+  int i;
+  hddm_s::HDDM record;
+  hddm_s::PhysicsEventList pes = record.addPhysicsEvents();
+  pes().setRunNo(runNo);
+  pes().setEventNo(eventNo);
+  hddm_s::ReactionList rs = pes().addReactions();
+
+  /*
+   * Seeds for hdgeant and mcsmear, different for every
+   * event and reproducible from the genr8 seed.
+   */
+  hddm_s::RandomList rnds = rs().addRandoms();
+  rnds().setSeed1(eventSeed(eventNo,1));
+  rnds().setSeed2(eventSeed(eventNo,2));
+  rnds().setSeed3(eventSeed(eventNo,3));
+  rnds().setSeed4(eventSeed(eventNo,4));
+
+  hddm_s::TargetList ts = rs().addTargets();
+  ts().setType(Proton);
+  hddm_s::PropertiesList tpros = ts().addPropertiesList();
+  tpros().setCharge(ParticleCharge(Proton));
+  tpros().setMass(target->mass);
+  hddm_s::MomentumList tmoms = ts().addMomenta();
+  tmoms().setPx(target->p.space.x);
+  tmoms().setPy(target->p.space.y);
+  tmoms().setPz(target->p.space.z);
+  tmoms().setE(target->p.t);
+
+  hddm_s::BeamList bs = rs().addBeams();
+  bs().setType(Gamma);
+  hddm_s::PropertiesList bpros = bs().addPropertiesList();
+  bpros().setCharge(ParticleCharge(Gamma));
+  bpros().setMass(beam->mass);
+  hddm_s::MomentumList bmoms = bs().addMomenta();
+  bmoms().setPx(beam->p.space.x);
+  bmoms().setPy(beam->p.space.y);
+  bmoms().setPz(beam->p.space.z);
+  bmoms().setE(beam->p.t);
+
+  hddm_s::VertexList vs = rs().addVertices();
+  hddm_s::OriginList os = vs().addOrigins();
+  os().setT(0.0);
+  os().setVx(Vertex[0]);
+  os().setVy(Vertex[1]);
+  os().setVz(Vertex[2] + (Vertex[3] - Vertex[2])*erand48(VertexRand));
+
+  hddm_s::ProductList ps = vs().addProducts(Nprinted);
+  for(i=0;i<Nprinted;i++){
+    ps(i).setType(Printed[i]->particleID);
+    ps(i).setPdgtype(PDGtype(Printed[i]->particleID));
+    ps(i).setId(i+1);
+    ps(i).setParentid(0);
+    ps(i).setMech(0);
+    hddm_s::MomentumList pmoms = ps(i).addMomenta();
+    pmoms().setPx(Printed[i]->p.space.x);
+    pmoms().setPy(Printed[i]->p.space.y);
+    pmoms().setPz(Printed[i]->p.space.z);
+    pmoms().setE(Printed[i]->p.t);
+  }
+  *out << record;
+}
+
+/********************************
+ *
+ * eventSeed()
+ *
+ * A hash of the genr8 seed, the event number
+ * and iseed, in the range hdgeant's ranecu
+ * generator accepts (1 to 2147483398).
+ *******************************/
+unsigned int eventSeed(int eventNo,int iseed)
+{
+  unsigned long long z;
+
+  z = ((unsigned long long)RandomSeed << 32) + (unsigned int)eventNo;
+  z += 0x9e3779b97f4a7c15ULL * (unsigned long long)iseed;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return 1 + (unsigned int)(z % 2147483398ULL);
+}
+
 /********************************
  *
  * printFamily()
@@ -8,6 +8,8 @@
 
 #include "DRandom2.h"
 
+#include <algorithm>
+
 #ifndef _DBG_
 #define _DBG_ cout<<__FILE__<<":"<<__LINE__<<" "
 #define _DBG__ cout<<__FILE__<<":"<<__LINE__<<endl
@@ -15,6 +17,19 @@
 
 //TH1D *hNincident_particles = NULL;
 
+std::atomic<unsigned long> BCALSmearer::Nallocations(0);
+
+//-----------
+// push_back_counted
+//-----------
+template <class T>
+static inline void push_back_counted(vector<T> &v, const T &x)
+{
+   // keep track of how often the reused containers have to grow
+   if(v.size() == v.capacity()) ++BCALSmearer::Nallocations;
+   v.push_back(x);
+}
+
 
 // Defined in this file
 //int32_t GetRunNumber(hddm_s::HDDM *record);
@@ -42,55 +57,46 @@ void BCALSmearer::SmearEvent(hddm_s::HDDM *record)
    /// In addition to the sampling fluctuations, Poisson statistics and
    /// dark pulses are applied.
    
-   // n.b. This code is slightly more complex than it might otherwise be because
-   // it uses sparsified lists as opposed to full data structures for every SiPM
-   // and every summed cell. It is done this way for two reasons:
-   //
-   // 1.) Sparsified lists are quicker to loop through and make the code faster.
-   //
-   // 2.) Sparsified lists are easier to keep on the stack rather than the heap
-   //     avoiding expensive, large memory allocations every event. Alternatively
-   //     one could keep the large structures in global variables but that would 
-   //     not allow for efficient multi-threading.
-   
+   // n.b. All of the per-event bookkeeping lives in containers that are
+   // kept from one event to the next (one set per thread) rather than
+   // in maps that are built and torn down for every event. Readout
+   // channels are held in flat arrays, along with a list of the channels
+   // actually used, so that no time is spent on empty channels and, once
+   // the containers are large enough, no memory is allocated.
+   static thread_local bcal_workspace_t ws;
+   ClearWorkspace(ws);
+
     // First, we extract the energies and times for hit cells
-    map<bcal_index, CellHits> SiPMHits;
-    vector<IncidentParticle_t> incident_particles;
-    GetSiPMHits(record, SiPMHits, incident_particles);
+    GetSiPMHits(record, ws.SiPMHits, ws.incident_particles);
 
     // Sampling fluctuations
     if(config->SMEAR_HITS) {
-    	ApplySamplingFluctuations(SiPMHits, incident_particles);
+    	ApplySamplingFluctuations(ws.SiPMHits, ws.incident_particles);
     }
 	
     // Merge hits associated with different incident particles
-    MergeHits(SiPMHits, bcal_config->BCAL_TWO_HIT_RESO);
+    MergeHits(ws.SiPMHits, bcal_config->BCAL_TWO_HIT_RESO);
 
     // Poisson Statistics
 	if(config->SMEAR_HITS) 
-    	ApplyPoissonStatistics(SiPMHits);
+    	ApplyPoissonStatistics(ws);
    
-    // Place all hit cells into list indexed by fADC ID
-    map<int, SumHits> bcalfADC;
-    SortSiPMHits(SiPMHits, bcalfADC, bcal_config->BCAL_TWO_HIT_RESO);
+    // Place all hit cells into list indexed by fADC channel
+    SortSiPMHits(ws, bcal_config->BCAL_TWO_HIT_RESO);
 
     // Electronic noise/Dark hits Smearing
 	if(config->SMEAR_HITS) 
-    	SimpleDarkHitsSmear(bcalfADC);
+    	SimpleDarkHitsSmear(ws);
     
     // Apply energy threshold to dismiss low-energy hits
-    map<int, fADCHitList> fADCHits;
-    map<int, TDCHitList> TDCHits;
-    FindHits(bcal_config->BCAL_ADC_THRESHOLD_MEV, bcalfADC, fADCHits, TDCHits);
+    FindHits(bcal_config->BCAL_ADC_THRESHOLD_MEV, ws);
 
     // Apply time smearing to emulate the fADC resolution
 	if(config->SMEAR_HITS) 
-    	ApplyTimeSmearing(bcal_config->BCAL_FADC_TIME_RESOLUTION, bcal_config->BCAL_TDC_TIME_RESOLUTION, fADCHits, TDCHits);
+    	ApplyTimeSmearing(bcal_config->BCAL_FADC_TIME_RESOLUTION, bcal_config->BCAL_TDC_TIME_RESOLUTION, ws);
    
     // Copy hits into HDDM tree
-    CopyBCALHitsToHDDM(fADCHits, TDCHits, record);
-   
-    bcalfADC.clear();
+    CopyBCALHitsToHDDM(ws, record);
 }
 
 int inline BCALSmearer::GetCalibIndex(int module, int layer, int sector) {
@@ -98,12 +104,69 @@ int inline BCALSmearer::GetCalibIndex(int module, int layer, int sector) {
    		+ bcal_config->BCAL_NUM_SECTORS*(layer-1) + (sector-1);
 }
 
+//-----------
+// GetChannel
+//-----------
+int BCALSmearer::GetChannel(int fADCId)
+{
+   /// Position of an fADC readout cell in the flat channel arrays
+   return GetCalibIndex(dBCALGeom->module(fADCId),
+                        dBCALGeom->layer(fADCId),
+                        dBCALGeom->sector(fADCId));
+}
+
+//-----------
+// ClearWorkspace
+//-----------
+void BCALSmearer::ClearWorkspace(bcal_workspace_t &ws)
+{
+   /// Empty the containers left over from the previous event, keeping
+   /// their memory. Only the channels that were used are touched.
+
+   size_t nchannels = bcal_config->BCAL_NUM_MODULES * 
+                      bcal_config->BCAL_NUM_LAYERS * 
+                      bcal_config->BCAL_NUM_SECTORS;
+   if(ws.bcalfADC.size() != nchannels){
+      ws.bcalfADC.assign(nchannels, SumHits());
+      ws.fADCHits.assign(nchannels, fADCHitList());
+      ws.TDCHits.assign(nchannels, TDCHitList());
+      ws.occupied.clear();
+      ws.fADC_occupied.clear();
+      ws.TDC_occupied.clear();
+      ++Nallocations;
+   }
+
+   for(size_t i=0; i<ws.occupied.size(); i++)
+      ws.bcalfADC[ws.occupied[i]].clear();
+   for(size_t i=0; i<ws.fADC_occupied.size(); i++){
+      ws.fADCHits[ws.fADC_occupied[i]].uphits.clear();
+      ws.fADCHits[ws.fADC_occupied[i]].dnhits.clear();
+   }
+   for(size_t i=0; i<ws.TDC_occupied.size(); i++){
+      ws.TDCHits[ws.TDC_occupied[i]].uphits.clear();
+      ws.TDCHits[ws.TDC_occupied[i]].dnhits.clear();
+   }
+   ws.occupied.clear();
+   ws.fADC_occupied.clear();
+   ws.TDC_occupied.clear();
+   ws.SiPMHits.clear();
+   ws.incident_particles.clear();
+}
+
+//-----------
+// SiPMHitOrder
+//-----------
+static bool SiPMHitOrder(const SiPMHit &a, const SiPMHit &b)
+{
+   return a.first < b.first;
+}
+
 
 //-----------
 // GetSiPMHits
 //-----------
 void BCALSmearer::GetSiPMHits(hddm_s::HDDM *record,
-                   			  map<bcal_index, CellHits> &SiPMHits,
+                   			  vector<SiPMHit> &SiPMHits,
                    			  vector<IncidentParticle_t> &incident_particles)
 {
    /// Loop through input HDDM data and extract the energy and time info into
@@ -125,14 +188,14 @@ void BCALSmearer::GetSiPMHits(hddm_s::HDDM *record,
    hddm_s::BcalTruthHitList hits = record->getBcalTruthHits();
    hddm_s::BcalTruthHitList::iterator iter;
    for (iter = hits.begin(); iter != hits.end(); ++iter) {
-      bcal_index idxup(iter->getModule(), iter->getLayer(),
-                     iter->getSector(), 
-                     iter->getIncident_id(),
-                     bcal_index::kUp);
-      bcal_index idxdn(iter->getModule(), iter->getLayer(),
-                     iter->getSector(), 
-                     iter->getIncident_id(),
-                     bcal_index::kDown);
+      SiPMHit hitup(bcal_index(iter->getModule(), iter->getLayer(),
+                               iter->getSector(), 
+                               iter->getIncident_id(),
+                               bcal_index::kUp), CellHits());
+      SiPMHit hitdn(bcal_index(iter->getModule(), iter->getLayer(),
+                               iter->getSector(), 
+                               iter->getIncident_id(),
+                               bcal_index::kDown), CellHits());
 
      double Z = iter->getZLocal();
      double dist_up = 390.0/2.0 + Z;
@@ -154,29 +217,42 @@ void BCALSmearer::GetSiPMHits(hddm_s::HDDM *record,
      //double attenuation_L1=-1., attenuation_L2=-1.;  // these parameters are ignored for now
      //bcal_config->GetAttenuationParameters(table_id, attenuation_length, attenuation_L1, attenuation_L2);
     
-     // Get reference to existing CellHits, or create one if it doesn't exist
-     CellHits &cellhitsup = SiPMHits[idxup];
+     CellHits &cellhitsup = hitup.second;
      cellhitsup.Etruth = iter->getE(); // Energy deposited in the cell in GeV
      //cellhitsup.E = iter->getE()*exp(-dist_up/attenuation_length)*1000.; // in attenuated MeV
      cellhitsup.E = iter->getE()*exp(-dist_up/bcal_config->BCAL_ATTENUATION_LENGTH)*1000.; // in attenuated MeV
      cellhitsup.t = iter->getT() + dist_up/cEff; // in ns
      cellhitsup.end = CellHits::kUp; // Keep track of BCal end
+     push_back_counted(SiPMHits, hitup);
 
-     // Get reference to existing CellHits, or create one if it doesn't exist
-     CellHits &cellhitsdn = SiPMHits[idxdn];
+     CellHits &cellhitsdn = hitdn.second;
      cellhitsdn.Etruth = iter->getE(); // Energy deposited in the cell in GeV
      cellhitsdn.E = iter->getE()*exp(-dist_dn/bcal_config->BCAL_ATTENUATION_LENGTH)*1000.; // in attenuated MeV
      cellhitsdn.t = iter->getT() + dist_dn/cEff; // in ns
      cellhitsdn.end = CellHits::kDown; // Keep track of BCal end
+     push_back_counted(SiPMHits, hitdn);
    }
 
+   // Sort the hits by bcal_index. If the same index turns up more than
+   // once only the last hit is kept, as it would be overwritten in a map.
+   stable_sort(SiPMHits.begin(), SiPMHits.end(), SiPMHitOrder);
+   size_t nkeep = 0;
+   for (size_t i=0; i < SiPMHits.size(); i++) {
+      if (i+1 < SiPMHits.size() && !(SiPMHits[i].first < SiPMHits[i+1].first))
+         continue;
+      if (nkeep != i)
+         SiPMHits[nkeep] = SiPMHits[i];
+      nkeep++;
+   }
+   SiPMHits.erase(SiPMHits.begin() + nkeep, SiPMHits.end());
+
    // Loop over incident particle list
    hddm_s::BcalTruthIncidentParticleList iparts = 
                                     bcals().getBcalTruthIncidentParticles();
    hddm_s::BcalTruthIncidentParticleList::iterator piter;
    int pcount = 0;
    for (piter = iparts.begin(); piter != iparts.end(); ++piter) {
-      incident_particles.push_back(IncidentParticle_t(*piter));
+      push_back_counted(incident_particles, IncidentParticle_t(*piter));
       if (piter->getId() != ++pcount) {
          // If this ever gets called, we'll need to implement a sort routine
          _DBG_ << "Incident particle order not preserved!" << endl;
@@ -191,7 +267,7 @@ void BCALSmearer::GetSiPMHits(hddm_s::HDDM *record,
 //-----------
 // ApplySamplingFluctuations
 //-----------
-void BCALSmearer::ApplySamplingFluctuations(map<bcal_index, CellHits> &SiPMHits, vector<IncidentParticle_t> &incident_particles)
+void BCALSmearer::ApplySamplingFluctuations(vector<SiPMHit> &SiPMHits, vector<IncidentParticle_t> &incident_particles)
 {
    /// Loop over the CellHits objects and apply sampling fluctuations.
    ///
@@ -211,7 +287,10 @@ void BCALSmearer::ApplySamplingFluctuations(map<bcal_index, CellHits> &SiPMHits,
    if(bcal_config->NO_SAMPLING_FLOOR_TERM)
    		bcal_config->BCAL_SAMPLINGCOEFB=0.0; // (redundant, yes, but located in more obvious place here)
 
-   map<bcal_index, CellHits>::iterator iter=SiPMHits.begin();
+   // one Gaussian number per hit, drawn in one block
+   DRandomBuffer noise(SiPMHits.size());
+
+   vector<SiPMHit>::iterator iter=SiPMHits.begin();
    
    for(; iter!=SiPMHits.end(); iter++){
       CellHits &cellhits = iter->second;
@@ -226,7 +305,7 @@ void BCALSmearer::ApplySamplingFluctuations(map<bcal_index, CellHits> &SiPMHits,
       sigmaSamp *= Etruth;
 
       // Randomly sample the fluctuation
-      double Esmeared = gDRandom.Gaus(Etruth,sigmaSamp);
+      double Esmeared = noise.Gaus(Etruth,sigmaSamp);
 
       // Calculate ratio of smeared to unsmeared
       double ratio = Esmeared/Etruth;
@@ -236,79 +315,115 @@ void BCALSmearer::ApplySamplingFluctuations(map<bcal_index, CellHits> &SiPMHits,
    }
 }
 
+//-----------
+// MergeCellHits
+//-----------
+static void MergeCellHits(vector<SiPMHit> &SiPMHits, vector<char> &erased,
+                          vector<size_t> &hits, double Resolution)
+{
+   /// Merge the hits from one end of one cell, given as positions in
+   /// SiPMHits in incident_id order. Each hit absorbs every later hit
+   /// that comes within Resolution of it. Since a merged hit always
+   /// takes the time of one of its two inputs, a hit that has finished
+   /// absorbing can never again come within Resolution of a later one,
+   /// so a single forward pass gives the same result as restarting
+   /// after every merge.
+
+   for(size_t i = 0; i < hits.size(); i++){
+      CellHits &cellhits1 = SiPMHits[hits[i]].second;
+      size_t j = i + 1;
+      while(j < hits.size()){
+         CellHits &cellhits2 = SiPMHits[hits[j]].second;
+
+         // If hits are far enough apart in time, don't merge them
+         if(!(fabs(cellhits1.t - cellhits2.t) < Resolution)){
+            j++;
+            continue;
+         }
+
+         // Get values
+         double E1 = cellhits1.E;
+         double t1 = cellhits1.t;
+         double E2 = cellhits2.E;
+         double t2 = cellhits2.t;
+         // It may be possible that one or both of the hits we wish to merge
+         // don't exist. Check for this and handle accordingly.
+         if(E1!=0.0 && E2!=0.0){
+            cellhits1.E += E2;
+            if(t1 > t2) cellhits1.t = t2; // Keep the earlier of the two times
+         }
+         if(E1==0.0 && E2!=0.0){
+            cellhits1.E = E2;
+            cellhits1.t = t2;
+         }
+
+         // Erase second one
+         erased[hits[j]] = 1;
+         hits.erase(hits.begin() + j);
+
+         // A new time may now reach hits that were passed over
+         if(cellhits1.t != t1) j = i + 1;
+      }
+   }
+   hits.clear();
+}
+
 //-----------
 // MergeHits
 //-----------
-void BCALSmearer::MergeHits(map<bcal_index, CellHits> &SiPMHits, double Resolution)
+void BCALSmearer::MergeHits(vector<SiPMHit> &SiPMHits, double Resolution)
 {
    /// Combine all SiPM CellHits corresponding to the same
    /// cell but different incident particles into a single
    /// hit. This is done after the sampling fluctuations
    /// have been applied so there is no more dependence on
    /// the incident particle parameters.
+   ///
+   /// The list is ordered by module, layer and sector ahead of the
+   /// incident_id, so all the hits in one cell are adjacent. They are
+   /// collected here one cell at a time, split by end, and merged by
+   /// MergeCellHits, rather than comparing every pair in the list and
+   /// starting over after each merge.
    
-   // Loop until no merges are made
-   while(true){
-      bool merge=false;
-      bool merged=false;
-      map<bcal_index, CellHits>::iterator iter1=SiPMHits.begin();
-      for(;iter1!=SiPMHits.end(); iter1++){
-         map<bcal_index, CellHits>::iterator iter2 = iter1;
-         for(++iter2; iter2!=SiPMHits.end(); iter2++){
-         
-            // If hits are not from same module,layer,sector,end
-            // then just continue the loop
-            if(iter1->first.module != iter2->first.module)continue;
-            if(iter1->first.layer  != iter2->first.layer )continue;
-            if(iter1->first.sector != iter2->first.sector)continue;
-            if(iter1->first.end    != iter2->first.end   )continue;
-
-            // If hits are far enough apart in time, don't merge them
-            if(fabs(iter1->second.t - iter2->second.t) < Resolution) merge = true;
-            if(!merge)continue;
-
-            // ----- Merge hits -----
-            if(merge){
-              // Get values
-              double E1 = iter1->second.E;
-              double t1 = iter1->second.t;
-              double E2 = iter2->second.E;
-              double t2 = iter2->second.t;
-              // It may be possible that one or both of the hits we wish to merge
-              // don't exist. Check for this and handle accordingly.
-              if(E1!=0.0 && E2!=0.0){
-                 iter1->second.E += E2;
-                 if(t1 > t2) iter1->second.t = t2; // Keep the earlier of the two times
-              }
-              if(E1==0.0 && E2!=0.0){
-                 iter1->second.E = E2;
-                 iter1->second.t = t2;
-                 iter2->second.E = 0.0;
-                 iter2->second.t = 0.0;
-              }
-            }
-
-            // Erase second one
-            SiPMHits.erase(iter2);
-
-            // Set flag that we did merge hits and break
-            // the loops so we can try again.
-            merged = true;
-            break;
-         }
-         if(merged)break;
+   static thread_local vector<size_t> hits_up;
+   static thread_local vector<size_t> hits_dn;
+   static thread_local vector<char> erased;
+   if(erased.capacity() < SiPMHits.size()) ++Nallocations;
+   erased.assign(SiPMHits.size(), 0);
+
+   size_t first = 0;
+   while(first < SiPMHits.size()){
+      const bcal_index &idx = SiPMHits[first].first;
+      size_t last = first;
+      for(; last < SiPMHits.size(); last++){
+         const bcal_index &idx2 = SiPMHits[last].first;
+         if(idx2.module != idx.module) break;
+         if(idx2.layer  != idx.layer ) break;
+         if(idx2.sector != idx.sector) break;
+         if(idx2.end == bcal_index::kUp)
+            push_back_counted(hits_up, last);
+         else
+            push_back_counted(hits_dn, last);
       }
+      MergeCellHits(SiPMHits, erased, hits_up, Resolution);
+      MergeCellHits(SiPMHits, erased, hits_dn, Resolution);
+      first = last;
+   }
 
-      // When we make it through without merging any hits,
-      // we're done so break out of the infinite while loop.
-      if(!merged)break;
+   // Remove the hits that were merged into others, keeping the order
+   size_t nkeep = 0;
+   for(size_t i = 0; i < SiPMHits.size(); i++){
+      if(erased[i]) continue;
+      if(nkeep != i) SiPMHits[nkeep] = SiPMHits[i];
+      nkeep++;
    }
+   SiPMHits.erase(SiPMHits.begin() + nkeep, SiPMHits.end());
 }
 
 //-----------
 // ApplyPoissonStatistics
 //-----------
-void BCALSmearer::ApplyPoissonStatistics(map<bcal_index, CellHits> &SiPMHits)
+void BCALSmearer::ApplyPoissonStatistics(bcal_workspace_t &ws)
 {
    /// Loop over the CellHits objects and apply Poisson Statistics.
    ///
@@ -323,16 +438,26 @@ void BCALSmearer::ApplyPoissonStatistics(map<bcal_index, CellHits> &SiPMHits)
 
    if(bcal_config->NO_POISSON_STATISTICS) return;
 
-   map<bcal_index, CellHits>::iterator iter=SiPMHits.begin();
+   vector<SiPMHit> &SiPMHits = ws.SiPMHits;
+
+   // Convert to number of PE, and sample all of them in one block
+   ws.mean_pe.clear();
+   vector<SiPMHit>::iterator iter=SiPMHits.begin();
    for(; iter!=SiPMHits.end(); iter++){
+      if(iter->second.E>0.0)
+         ws.mean_pe.push_back(iter->second.E/bcal_config->BCAL_mevPerPE);
+   }
+   ws.Npe.resize(ws.mean_pe.size());
+   if(!ws.mean_pe.empty())
+      gDRandom.FillPoisson(&ws.mean_pe[0], &ws.Npe[0], ws.mean_pe.size());
+
+   size_t ipe = 0;
+   for(iter=SiPMHits.begin(); iter!=SiPMHits.end(); iter++){
       CellHits &cellhits = iter->second;
 
       if(cellhits.E>0.0){
-         // Convert to number of PE
-         double mean_pe = cellhits.E/bcal_config->BCAL_mevPerPE;
-         
-         int Npe = gDRandom.Poisson(mean_pe);
-         double ratio = (double)Npe/mean_pe;
+         double ratio = (double)ws.Npe[ipe]/ws.mean_pe[ipe];
+         ipe++;
 
          cellhits.E *= ratio;
       }
@@ -342,7 +467,7 @@ void BCALSmearer::ApplyPoissonStatistics(map<bcal_index, CellHits> &SiPMHits)
 //-----------
 // SortSiPMHits
 //-----------
-void BCALSmearer::SortSiPMHits(map<bcal_index, CellHits> &SiPMHits, map<int, SumHits> &bcalfADC, double Resolution)
+void BCALSmearer::SortSiPMHits(bcal_workspace_t &ws, double Resolution)
 {
    /// Loop over the CellHits objects and copy pointers to them into SumHits objects.
    ///
@@ -353,21 +478,26 @@ void BCALSmearer::SortSiPMHits(map<bcal_index, CellHits> &SiPMHits, map<int, Sum
    /// contributing.
    
    // Loop over SiPMHits and copy a pointer to it to the correct SumHits
-   // element in the bcalfADC container. The bcalfADC container is an STL map which is
-   // convenient since it creates a new SumHits object for us if it doesn't exist,
-   // but otherwise, returns a reference to the existing object.
+   // element in the bcalfADC array. The first time a channel is used in
+   // this event it is added to the occupied list.
    
-   map<bcal_index, CellHits>::iterator iter = SiPMHits.begin();
+   vector<SiPMHit> &SiPMHits = ws.SiPMHits;
+   vector<SiPMHit>::iterator iter = SiPMHits.begin();
    for(; iter!=SiPMHits.end(); iter++){
       
       // Get reference to SumHits object
       const bcal_index &idx = iter->first;
       int fADCId = dBCALGeom->fADCId( idx.module, idx.layer, idx.sector);
-      SumHits &sumhits = bcalfADC[fADCId];
+      int channel = GetChannel(fADCId);
+      SumHits &sumhits = ws.bcalfADC[channel];
+      if(sumhits.cellhits.empty()){
+         sumhits.fADCId = fADCId;
+         push_back_counted(ws.occupied, channel);
+      }
       
       // Add CellHits object to list in SumHits
       CellHits &cellhits = iter->second;
-      sumhits.cellhits.push_back(&cellhits);
+      push_back_counted(sumhits.cellhits, &cellhits);
       
       // If this is the first cell added to the SumHits, assign its
       // values to the first elements of the data arrays. Otherwise,
@@ -378,8 +508,8 @@ void BCALSmearer::SortSiPMHits(map<bcal_index, CellHits> &SiPMHits, map<int, Sum
       // Upstream
       if(cellhits.end == CellHits::kUp && cellhits.E != 0.0){
         if(sumhits.EUP.empty()){
-          sumhits.EUP.push_back(cellhits.E);
-          sumhits.tUP.push_back(cellhits.t);
+          push_back_counted(sumhits.EUP, cellhits.E);
+          push_back_counted(sumhits.tUP, cellhits.t);
         }else{
           for(int ii = 0; ii < (int)sumhits.EUP.size(); ii++){
             if(fabs(cellhits.t - sumhits.tUP[ii]) < Resolution){
@@ -390,8 +520,8 @@ void BCALSmearer::SortSiPMHits(map<bcal_index, CellHits> &SiPMHits, map<int, Sum
             }
           }
           if (!mergedUP){
-            sumhits.EUP.push_back(cellhits.E);
-            sumhits.tUP.push_back(cellhits.t);
+            push_back_counted(sumhits.EUP, cellhits.E);
+            push_back_counted(sumhits.tUP, cellhits.t);
           }
         }
       }
@@ -399,8 +529,8 @@ void BCALSmearer::SortSiPMHits(map<bcal_index, CellHits> &SiPMHits, map<int, Sum
       // Downstream
       if(cellhits.end == CellHits::kDown && cellhits.E != 0.0){
         if(sumhits.EDN.empty()){
-          sumhits.EDN.push_back(cellhits.E);
-          sumhits.tDN.push_back(cellhits.t);
+          push_back_counted(sumhits.EDN, cellhits.E);
+          push_back_counted(sumhits.tDN, cellhits.t);
         }else{
           for(int ii = 0; ii < (int)sumhits.EDN.size(); ii++){
             if(fabs(cellhits.t - sumhits.tDN[ii]) < Resolution){
@@ -411,18 +541,21 @@ void BCALSmearer::SortSiPMHits(map<bcal_index, CellHits> &SiPMHits, map<int, Sum
             }
           }
           if (!mergedDN){
-            sumhits.EDN.push_back(cellhits.E);
-            sumhits.tDN.push_back(cellhits.t);
+            push_back_counted(sumhits.EDN, cellhits.E);
+            push_back_counted(sumhits.tDN, cellhits.t);
           }
         }
       }
    }
+
+   // Visit the channels in order later on, as the map they replace did
+   sort(ws.occupied.begin(), ws.occupied.end());
 }
 
 //-----------
 // SimpleDarkHitsSmear
 //-----------
-void BCALSmearer::SimpleDarkHitsSmear(map<int, SumHits> &bcalfADC)
+void BCALSmearer::SimpleDarkHitsSmear(bcal_workspace_t &ws)
 {
    /// Loop over the SumHits objects and add Electronic noise and
    /// Dark hits smearing.
@@ -442,42 +575,36 @@ void BCALSmearer::SimpleDarkHitsSmear(map<int, SumHits> &bcalfADC)
    double sigma3 = bcal_config->BCAL_LAYER3_SIGMA_SCALE*bcal_config->BCAL_MEV_PER_ADC_COUNT; 
    double sigma4 = bcal_config->BCAL_LAYER4_SIGMA_SCALE*bcal_config->BCAL_MEV_PER_ADC_COUNT; 
 
-   // Loop over all fADC readout cells
-   for(int imodule=1; imodule<=bcal_config->BCAL_NUM_MODULES; imodule++){
-
-      int n_layers = bcal_config->BCAL_NUM_LAYERS;
-      for(int fADC_lay=1; fADC_lay<=n_layers; fADC_lay++){
-         if(fADC_lay == 1) 
-         	sigma = sigma1;
-         else if(fADC_lay == 2) 
-         	sigma = sigma2;
-         else if(fADC_lay == 3) 
-         	sigma = sigma3;
-         else if(fADC_lay == 4) 
-         	sigma = sigma4;
-
-		 // there's a constant number of sectors now...
-         //int n_sectors = (fADC_lay <= dBCALGeom->GetBCAL_NInnerLayers())? dBCALGeom->GetBCAL_NInnerSectors() : dBCALGeom->GetBCAL_NOuterSectors();
-		 int n_sectors = bcal_config->BCAL_NUM_SECTORS;
-         for(int fADC_sec=1; fADC_sec<=n_sectors; fADC_sec++){
-
-            // Use cellId(...) to convert fADC layer and sector into fADCId
-            // (see dBCALGeom->fADCId)
-            int fADCId = dBCALGeom->cellId(imodule, fADC_lay, fADC_sec);
-            
-            // Get SumHits object if it already exists or create new one 
-            // if it doesn't.
-            SumHits &sumhits = bcalfADC[fADCId];
-
-            for(int ii = 0; ii < (int)sumhits.EUP.size(); ii++){
-				Esmeared = gDRandom.Gaus(sumhits.EUP[ii],sigma);
-				sumhits.EUP[ii] = Esmeared;
-            }
-            for(int ii = 0; ii < (int)sumhits.EDN.size(); ii++){
-            	Esmeared = gDRandom.Gaus(sumhits.EDN[ii],sigma);
-            	sumhits.EDN[ii] = Esmeared;
-            }
-         }
+   // one Gaussian number per summed hit, drawn in one block
+   size_t nhits = 0;
+   for(size_t i=0; i<ws.occupied.size(); i++){
+      SumHits &sumhits = ws.bcalfADC[ws.occupied[i]];
+      nhits += sumhits.EUP.size() + sumhits.EDN.size();
+   }
+   DRandomBuffer noise(nhits);
+
+   // Loop over the fADC readout cells with hits, in the same order
+   // as module, layer, sector. Cells without hits are left alone.
+   for(size_t i=0; i<ws.occupied.size(); i++){
+      SumHits &sumhits = ws.bcalfADC[ws.occupied[i]];
+
+      int fADC_lay = dBCALGeom->layer(sumhits.fADCId);
+      if(fADC_lay == 1) 
+         sigma = sigma1;
+      else if(fADC_lay == 2) 
+         sigma = sigma2;
+      else if(fADC_lay == 3) 
+         sigma = sigma3;
+      else if(fADC_lay == 4) 
+         sigma = sigma4;
+
+      for(int ii = 0; ii < (int)sumhits.EUP.size(); ii++){
+         Esmeared = noise.Gaus(sumhits.EUP[ii],sigma);
+         sumhits.EUP[ii] = Esmeared;
+      }
+      for(int ii = 0; ii < (int)sumhits.EDN.size(); ii++){
+         Esmeared = noise.Gaus(sumhits.EDN[ii],sigma);
+         sumhits.EDN[ii] = Esmeared;
       }
    }
 }
@@ -485,7 +612,7 @@ void BCALSmearer::SimpleDarkHitsSmear(map<int, SumHits> &bcalfADC)
 //-----------
 // ApplyTimeSmearing
 //-----------
-void BCALSmearer::ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, map<int, fADCHitList> &fADCHits, map<int, TDCHitList> &TDCHits)
+void BCALSmearer::ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, bcal_workspace_t &ws)
 {
    /// The fADC250 will extract a time from the samples by applying an algorithm
    /// to a few of the samples taken every 4ns. The perfect times from HDGeant
@@ -498,9 +625,20 @@ void BCALSmearer::ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, map<in
    double BCAL_TIMINGADCCOEFA = 0.055;
    double BCAL_TIMINGADCCOEFB = 0.000;
 
-   map<int, fADCHitList>::iterator it = fADCHits.begin();
-   for(; it!=fADCHits.end(); it++){
-      fADCHitList &hitlist = it->second;
+   // one Gaussian number per fADC and TDC hit, drawn in one block
+   size_t nhits = 0;
+   for(size_t ich=0; ich<ws.fADC_occupied.size(); ich++){
+      fADCHitList &hitlist = ws.fADCHits[ws.fADC_occupied[ich]];
+      nhits += hitlist.uphits.size() + hitlist.dnhits.size();
+   }
+   for(size_t ich=0; ich<ws.TDC_occupied.size(); ich++){
+      TDCHitList &TDChitlist = ws.TDCHits[ws.TDC_occupied[ich]];
+      nhits += TDChitlist.uphits.size() + TDChitlist.dnhits.size();
+   }
+   DRandomBuffer noise(nhits);
+
+   for(size_t ich=0; ich<ws.fADC_occupied.size(); ich++){
+      fADCHitList &hitlist = ws.fADCHits[ws.fADC_occupied[ich]];
       
       // upstream
       for(unsigned int i=0; i<hitlist.uphits.size(); i++){
@@ -508,7 +646,7 @@ void BCALSmearer::ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, map<in
          double sqrtterm = BCAL_TIMINGADCCOEFA / sqrt(EGeV);
          double linterm = BCAL_TIMINGADCCOEFB;
          double sigma_ns_ADC = sqrt(sqrtterm*sqrtterm + linterm*linterm);
-         hitlist.uphits[i].t += gDRandom.SampleGaussian(sigma_ns_ADC);
+         hitlist.uphits[i].t += noise.SampleGaussian(sigma_ns_ADC);
       }
 
       // downstream
@@ -517,22 +655,21 @@ void BCALSmearer::ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, map<in
          double sqrtterm = BCAL_TIMINGADCCOEFA / sqrt(EGeV);
          double linterm = BCAL_TIMINGADCCOEFB;
          double sigma_ns_ADC = sqrt(sqrtterm*sqrtterm + linterm*linterm);
-         hitlist.dnhits[i].t += gDRandom.SampleGaussian(sigma_ns_ADC);
+         hitlist.dnhits[i].t += noise.SampleGaussian(sigma_ns_ADC);
       }
    }
 
-   map<int, TDCHitList>::iterator itTDC = TDCHits.begin();
-   for(; itTDC!=TDCHits.end(); itTDC++){
-      TDCHitList &TDChitlist = itTDC->second;
+   for(size_t ich=0; ich<ws.TDC_occupied.size(); ich++){
+      TDCHitList &TDChitlist = ws.TDCHits[ws.TDC_occupied[ich]];
       
       // upstream
       for(unsigned int i=0; i<TDChitlist.uphits.size(); i++){
-         TDChitlist.uphits[i] += gDRandom.SampleGaussian(sigma_ns_TDC);
+         TDChitlist.uphits[i] += noise.SampleGaussian(sigma_ns_TDC);
       }
 
       // downstream
       for(unsigned int i=0; i<TDChitlist.dnhits.size(); i++){
-         TDChitlist.dnhits[i] += gDRandom.SampleGaussian(sigma_ns_TDC);
+         TDChitlist.dnhits[i] += noise.SampleGaussian(sigma_ns_TDC);
       }
    }
 }
@@ -540,20 +677,36 @@ void BCALSmearer::ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, map<in
 //-----------
 // FindHits
 //-----------
-void BCALSmearer::FindHits(double thresh_MeV, map<int, SumHits> &bcalfADC, map<int, fADCHitList> &fADCHits, map<int,TDCHitList> &TDCHits)
+void BCALSmearer::FindHits(double thresh_MeV, bcal_workspace_t &ws)
 {
    /// Loop over Sumhits objects and find hits that cross the energy threshold (ADC)
-   map<int, SumHits>::iterator iter = bcalfADC.begin();
-   for(; iter!=bcalfADC.end(); iter++){
+
+   // one uniform number per summed hit for the efficiency corrections,
+   // drawn in one block
+   size_t nhits = 0;
+   if (config->APPLY_EFFICIENCY_CORRECTIONS) {
+      for(size_t ich=0; ich<ws.occupied.size(); ich++){
+         SumHits &sumhits = ws.bcalfADC[ws.occupied[ich]];
+         nhits += sumhits.EUP.size() + sumhits.EDN.size();
+      }
+   }
+   DRandomBuffer noise(0, nhits);
+
+   for(size_t ich=0; ich<ws.occupied.size(); ich++){
       
-      int fADCId = iter->first;
-      SumHits &sumhits = iter->second;
+      int channel = ws.occupied[ich];
+      SumHits &sumhits = ws.bcalfADC[channel];
+      int fADCId = sumhits.fADCId;
 
-      vector<fADCHit> uphits;
-      vector<fADCHit> dnhits;
+      // Hits are written straight into the channel's (empty) lists,
+      // which only count as used if something ends up in them
+      fADCHitList &hitlist = ws.fADCHits[channel];
+      TDCHitList &hitlistTDC = ws.TDCHits[channel];
+      vector<fADCHit> &uphits = hitlist.uphits;
+      vector<fADCHit> &dnhits = hitlist.dnhits;
 
-      vector<double> uphitsTDC;
-      vector<double> dnhitsTDC;
+      vector<double> &uphitsTDC = hitlistTDC.uphits;
+      vector<double> &dnhitsTDC = hitlistTDC.dnhits;
 
       // The histogram should have the signal size for the ADC, but the TDC
       // leg will actually have a larger size since the pre-amp gain will be
@@ -566,31 +719,31 @@ void BCALSmearer::FindHits(double thresh_MeV, map<int, SumHits> &bcalfADC, map<i
       for(int ii = 0; ii < (int)sumhits.EUP.size(); ii++){
         // correct simulation efficiencies 
 		if (config->APPLY_EFFICIENCY_CORRECTIONS
-		 		&& !gDRandom.DecideToAcceptHit(bcal_config->GetEfficiencyCorrectionFactor(GetCalibIndex(dBCALGeom->module(fADCId),
+		 		&& !noise.DecideToAcceptHit(bcal_config->GetEfficiencyCorrectionFactor(GetCalibIndex(dBCALGeom->module(fADCId),
 		 																				  dBCALGeom->layer(fADCId),
 		 																				  dBCALGeom->sector(fADCId)),
 		 																				  DBCALGeometry::End::kUpstream)))
 		 			continue;
 		 			
-        if(sumhits.EUP[ii] > thresh_MeV && sumhits.tUP[ii] < 2000) uphits.push_back(fADCHit(sumhits.EUP[ii],sumhits.tUP[ii])); // Fill uphits and dnhits with energies (in MeV)
-        if(layer != 4 && sumhits.EUP[ii] > thresh_MeV_TDC && sumhits.tUP[ii] < 2000) uphitsTDC.push_back(sumhits.tUP[ii]);     // and times when they cross an energy threshold.
+        if(sumhits.EUP[ii] > thresh_MeV && sumhits.tUP[ii] < 2000) push_back_counted(uphits, fADCHit(sumhits.EUP[ii],sumhits.tUP[ii])); // Fill uphits and dnhits with energies (in MeV)
+        if(layer != 4 && sumhits.EUP[ii] > thresh_MeV_TDC && sumhits.tUP[ii] < 2000) push_back_counted(uphitsTDC, sumhits.tUP[ii]);     // and times when they cross an energy threshold.
       }                                                                                                                        // Also fill TDC uphits and dnhits with times if
       for(int ii = 0; ii < (int)sumhits.EDN.size(); ii++){                                                                     // they are not layer 4 hits and cross threshold.
         // correct simulation efficiencies 
 		if (config->APPLY_EFFICIENCY_CORRECTIONS
-		 		&& !gDRandom.DecideToAcceptHit(bcal_config->GetEfficiencyCorrectionFactor(GetCalibIndex(dBCALGeom->module(fADCId),
+		 		&& !noise.DecideToAcceptHit(bcal_config->GetEfficiencyCorrectionFactor(GetCalibIndex(dBCALGeom->module(fADCId),
 		 																				  dBCALGeom->layer(fADCId),
 		 																				  dBCALGeom->sector(fADCId)),
 		 																				  DBCALGeometry::End::kDownstream)))
 		 			continue;
 
-        if(sumhits.EDN[ii] > thresh_MeV && sumhits.tDN[ii] < 2000) dnhits.push_back(fADCHit(sumhits.EDN[ii],sumhits.tDN[ii]));
-        if(layer != 4 && sumhits.EDN[ii] > thresh_MeV_TDC && sumhits.tDN[ii] < 2000) dnhitsTDC.push_back(sumhits.tDN[ii]);
+        if(sumhits.EDN[ii] > thresh_MeV && sumhits.tDN[ii] < 2000) push_back_counted(dnhits, fADCHit(sumhits.EDN[ii],sumhits.tDN[ii]));
+        if(layer != 4 && sumhits.EDN[ii] > thresh_MeV_TDC && sumhits.tDN[ii] < 2000) push_back_counted(dnhitsTDC, sumhits.tDN[ii]);
       }
       
       // If at least one ADC readout channel has a hit, add the readout cell to fADCHits
       if(uphits.size()>0 || dnhits.size()>0){
-         fADCHitList &hitlist = fADCHits[fADCId];
+         push_back_counted(ws.fADC_occupied, channel);
 
          // The module, fADC layer, and fADC sector are encoded in fADCId
          // (n.b. yes, these are the same methods used for extracting 
@@ -598,14 +751,11 @@ void BCALSmearer::FindHits(double thresh_MeV, map<int, SumHits> &bcalfADC, map<i
          hitlist.module = dBCALGeom->module(fADCId);
          hitlist.sumlayer = dBCALGeom->layer(fADCId);
          hitlist.sumsector = dBCALGeom->sector(fADCId);
-         
-         hitlist.uphits = uphits;
-         hitlist.dnhits = dnhits;
       }
       
       // If at least one TDC readout channel has a hit, add the readout cell to TDCHits
       if(uphitsTDC.size()>0 || dnhitsTDC.size()>0){
-         TDCHitList &hitlistTDC = TDCHits[fADCId];
+         push_back_counted(ws.TDC_occupied, channel);
 
          // The module, fADC layer, and fADC sector are encoded in fADCId
          // (n.b. yes, these are the same methods used for extracting 
@@ -613,9 +763,6 @@ void BCALSmearer::FindHits(double thresh_MeV, map<int, SumHits> &bcalfADC, map<i
          hitlistTDC.module = dBCALGeom->module(fADCId);
          hitlistTDC.sumlayer = dBCALGeom->layer(fADCId);
          hitlistTDC.sumsector = dBCALGeom->sector(fADCId);
-         
-         hitlistTDC.uphits = uphitsTDC;
-         hitlistTDC.dnhits = dnhitsTDC;
       }
    }
 }
@@ -623,8 +770,7 @@ void BCALSmearer::FindHits(double thresh_MeV, map<int, SumHits> &bcalfADC, map<i
 //-----------
 // CopyBCALHitsToHDDM
 //-----------
-void BCALSmearer::CopyBCALHitsToHDDM(map<int, fADCHitList> &fADCHits,
-						map<int, TDCHitList> &TDCHits,
+void BCALSmearer::CopyBCALHitsToHDDM(bcal_workspace_t &ws,
                         hddm_s::HDDM *record)
 {
    /// Loop over fADCHitList objects and copy the fADC hits into the HDDM tree.
@@ -659,20 +805,19 @@ void BCALSmearer::CopyBCALHitsToHDDM(map<int, fADCHitList> &fADCHits,
    }
 
    // If we have no cells over threshold, then bail now.
-   if (fADCHits.size() == 0 && TDCHits.size() == 0)
+   if (ws.fADC_occupied.size() == 0 && ws.TDC_occupied.size() == 0)
       return;
    
    // Create bcalfADCHit structures to hold our fADC hits
-   map<int, fADCHitList>::iterator it;
-   for (it = fADCHits.begin(); it != fADCHits.end(); ++it) {
+   for (size_t ich = 0; ich < ws.fADC_occupied.size(); ++ich) {
       // Get pointer to our fADC cell information that needs to be copied to HDDM
-      fADCHitList &hitlist = it->second;
+      fADCHitList &hitlist = ws.fADCHits[ws.fADC_occupied[ich]];
       // Check if this cell is already present in the cells list
       cells = bcals().getBcalCells();
       for (iter = cells.begin(); iter != cells.end(); ++iter) {
-         if (iter->getModule() == it->second.module &&
-             iter->getSector() == it->second.sumsector &&
-             iter->getLayer() == it->second.sumlayer)
+         if (iter->getModule() == hitlist.module &&
+             iter->getSector() == hitlist.sumsector &&
+             iter->getLayer() == hitlist.sumlayer)
          {
             break;
          }
@@ -771,16 +916,15 @@ void BCALSmearer::CopyBCALHitsToHDDM(map<int, fADCHitList> &fADCHits,
    }
    
    // Create bcalTDCDigiHit structures to hold our F1TDC hits
-   map<int, TDCHitList>::iterator ittdc;
-   for (ittdc = TDCHits.begin(); ittdc != TDCHits.end(); ittdc++) {
+   for (size_t ich = 0; ich < ws.TDC_occupied.size(); ich++) {
       // Get pointer to our TDC hit information that needs to be copied to HDDM
-      TDCHitList &hitlist = ittdc->second;
+      TDCHitList &hitlist = ws.TDCHits[ws.TDC_occupied[ich]];
       // Check if this cell is already present in the cells list
       cells = bcals().getBcalCells();
       for (iter = cells.begin(); iter != cells.end(); ++iter) {
-         if (iter->getModule() == ittdc->second.module &&
-             iter->getSector() == ittdc->second.sumsector &&
-             iter->getLayer() == ittdc->second.sumlayer)
+         if (iter->getModule() == hitlist.module &&
+             iter->getSector() == hitlist.sumsector &&
+             iter->getLayer() == hitlist.sumlayer)
          {
             break;
          }
@@ -858,7 +1002,7 @@ bcal_config_t::bcal_config_t(JEventLoop *loop)
 	// Load parameters from CCDB
     cout << "get BCAL/bcal_smear_parms_v2 parameters from CCDB..." << endl;
     map<string, double> bcalparms;
-    if(loop->GetCalib("BCAL/bcal_smear_parms_v2", bcalparms)) {
+    if(CalibSnapshot::GetCalib(loop, "BCAL/bcal_smear_parms_v2", bcalparms)) {
      	jerr << "Problem loading BCAL/bcal_smear_parms_v2 from CCDB!" << endl;
      } else {
      	BCAL_SAMPLINGCOEFA 		  = bcalparms["BCAL_SAMPLINGCOEFA"];
@@ -880,7 +1024,7 @@ bcal_config_t::bcal_config_t(JEventLoop *loop)
 	
     //cout << "Get BCAL/attenuation_parameters from CCDB..." <<endl;
     //vector< vector<double> > in_atten_parameters;
-    //if(loop->GetCalib("BCAL/attenuation_parameters", in_atten_parameters)) {
+    //if(CalibSnapshot::GetCalib(loop, "BCAL/attenuation_parameters", in_atten_parameters)) {
     // 	jerr << "Problem loading BCAL/bcal_parms from CCDB!" << endl;
 	//} else {
     // 	attenuation_parameters.clear();
@@ -892,7 +1036,7 @@ bcal_config_t::bcal_config_t(JEventLoop *loop)
 		
      cout << "Get BCAL/digi_scales parameters from CCDB..." << endl;
      map<string, double> bcaldigiscales;
-     if(loop->GetCalib("BCAL/digi_scales", bcaldigiscales)) {
+     if(CalibSnapshot::GetCalib(loop, "BCAL/digi_scales", bcaldigiscales)) {
      	jerr << "Problem loading BCAL/digi_scales from CCDB!" << endl;
      } else {
      	BCAL_NS_PER_ADC_COUNT = bcaldigiscales["BCAL_ADC_TSCALE"];
@@ -901,7 +1045,7 @@ bcal_config_t::bcal_config_t(JEventLoop *loop)
 
     cout << "Get BCAL/base_time_offset parameters from CCDB..." << endl;
     map<string, double> bcaltimeoffsets;
-    if(loop->GetCalib("BCAL/base_time_offset", bcaltimeoffsets)) {
+    if(CalibSnapshot::GetCalib(loop, "BCAL/base_time_offset", bcaltimeoffsets)) {
      	jerr << "Problem loading BCAL/base_time_offset from CCDB!" << endl;
  	} else {
      	BCAL_BASE_TIME_OFFSET = bcaltimeoffsets["BCAL_BASE_TIME_OFFSET"];
@@ -911,7 +1055,7 @@ bcal_config_t::bcal_config_t(JEventLoop *loop)
    	// load per-channel efficiencies
     cout << "Get BCAL/channel_mc_efficiency tables from CCDB..." << endl;
 	vector<double> raw_table;
-	if(loop->GetCalib("BCAL/channel_mc_efficiency", raw_table)) {
+	if(CalibSnapshot::GetCalib(loop, "BCAL/channel_mc_efficiency", raw_table)) {
     	jerr << "Problem loading BCAL/channel_mc_efficiency from CCDB!" << endl;
     } else {
    	    int channel = 0;
@@ -930,7 +1074,7 @@ bcal_config_t::bcal_config_t(JEventLoop *loop)
 
     cout << "Get BCAL/ADC_saturation parameters from CCDB..." << endl;
     std::vector<std::map<string,double> > saturation_ADC_pars;
-    if(loop->GetCalib("/BCAL/ADC_saturation", saturation_ADC_pars))
+    if(CalibSnapshot::GetCalib(loop, "/BCAL/ADC_saturation", saturation_ADC_pars))
 	    jout << "Error loading /BCAL/ADC_saturation !" << endl;
     for (unsigned int i=0; i < saturation_ADC_pars.size(); i++) {
 	    int end = (saturation_ADC_pars[i])["end"];
@@ -944,7 +1088,7 @@ bcal_config_t::bcal_config_t(JEventLoop *loop)
 
     cout << "Get BCAL/SiPM_saturation parameters from CCDB..." << endl;
    std::vector<std::map<string,double> > saturation_SiPM_pars;
-   if(loop->GetCalib("/BCAL/SiPM_saturation", saturation_SiPM_pars))
+   if(CalibSnapshot::GetCalib(loop, "/BCAL/SiPM_saturation", saturation_SiPM_pars))
       jout << "Error loading /SiPM/SiPM_saturation !" << endl;
    for (unsigned int i=0; i < saturation_SiPM_pars.size(); i++) {
 	   int end = (saturation_SiPM_pars[i])["END"];
@@ -11,6 +11,7 @@
 #include <sstream>
 #include <queue>
 #include <cmath>
+#include <atomic>
 using namespace std;
 
 #include <DHistogram.h>
@@ -175,6 +176,13 @@ class CellHits{
       EndType end;
 };
 
+//..........................
+// SiPMHit is one entry in the list of SiPM hits for an event.
+// The list is kept sorted by bcal_index, so it can be walked
+// just like a map<bcal_index, CellHits>.
+//..........................
+typedef pair<bcal_index, CellHits> SiPMHit;
+
 //..........................
 // SumHits is a utility class that is used to hold info
 // from the SiPMs contributing to that readout channel.
@@ -184,9 +192,18 @@ class CellHits{
 //..........................
 class SumHits{
    public:
-      SumHits()
+      SumHits() : fADCId(0)
       {}
       
+      void clear() {
+         cellhits.clear();
+         EUP.clear();
+         tUP.clear();
+         EDN.clear();
+         tDN.clear();
+      }
+
+      int fADCId;
       vector<CellHits *> cellhits;
       vector<double> EUP;
       vector<double> tUP;
@@ -263,6 +280,32 @@ class IncidentParticle_t{
       int ptype, track;
 };
 
+//..........................
+// bcal_workspace_t holds the containers BCALSmearer fills for each
+// event. There is one per thread, and they are emptied rather than
+// freed between events, so once they have grown to fit the busiest
+// events the BCAL smearing does not allocate any more memory. The
+// readout channel arrays are indexed by GetCalibIndex of the fADC
+// cell, and the occupied lists record (in increasing order) which
+// channels were used so that only those are visited and reset.
+//..........................
+class bcal_workspace_t{
+   public:
+      vector<SiPMHit> SiPMHits;
+      vector<IncidentParticle_t> incident_particles;
+
+      vector<SumHits> bcalfADC;
+      vector<fADCHitList> fADCHits;
+      vector<TDCHitList> TDCHits;
+
+      vector<int> occupied;       // channels of bcalfADC with SiPM hits
+      vector<int> fADC_occupied;  // channels of fADCHits with hits
+      vector<int> TDC_occupied;   // channels of TDCHits with hits
+
+      vector<double> mean_pe;     // Poisson means and counts of the
+      vector<int> Npe;            // SiPM hits with energy, in order
+};
+
 // MAIN CLASS
 class BCALSmearer : public Smearer
 {
@@ -292,32 +335,32 @@ class BCALSmearer : public Smearer
 
 		void SmearEvent(hddm_s::HDDM *record);  // main smearing function
 
+		// Number of times the per-thread BCAL containers have had to
+		// grow, summed over all threads. This should stop increasing
+		// once the first few events have been smeared.
+		static unsigned long GetNAllocations() { return Nallocations; }
+		static std::atomic<unsigned long> Nallocations;
+
 	protected:
 		bcal_config_t *bcal_config;
         const DBCALGeometry *dBCALGeom;
 		
 		int inline GetCalibIndex(int module, int layer, int sector);
+		int GetChannel(int fADCId);
 
+		void ClearWorkspace(bcal_workspace_t &ws);
 		void GetSiPMHits(hddm_s::HDDM *record,
-        	             map<bcal_index, CellHits> &SiPMHits,
+        	             vector<SiPMHit> &SiPMHits,
               	         vector<IncidentParticle_t> &incident_particles);
-		void ApplySamplingFluctuations(map<bcal_index,
-           		                       CellHits> &SiPMHits,
+		void ApplySamplingFluctuations(vector<SiPMHit> &SiPMHits,
                    		               vector<IncidentParticle_t> &incident_particles);
-		void MergeHits(map<bcal_index, CellHits> &SiPMHits, double Resolution);
-		void ApplyPoissonStatistics(map<bcal_index, CellHits> &SiPMHits);
-		void SortSiPMHits(map<bcal_index,
-        	              CellHits> &SiPMHits,
-             	          map<int, SumHits> &bcalfADC, double Resolution);
-		void SimpleDarkHitsSmear(map<int, SumHits> &bcalfADC);
-		void ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, map<int, fADCHitList> &fADCHits, 
-							   map<int, TDCHitList> &TDCHits);
-		void FindHits(double thresh_MeV,
-              		  map<int, SumHits> &bcalfADC,
-              		  map<int, fADCHitList> &fADCHits,
-              		  map<int, TDCHitList> &TDCHits);
-		void CopyBCALHitsToHDDM(map<int, fADCHitList> &fADCHits,
-                        		map<int, TDCHitList> &TDCHits,
+		void MergeHits(vector<SiPMHit> &SiPMHits, double Resolution);
+		void ApplyPoissonStatistics(bcal_workspace_t &ws);
+		void SortSiPMHits(bcal_workspace_t &ws, double Resolution);
+		void SimpleDarkHitsSmear(bcal_workspace_t &ws);
+		void ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, bcal_workspace_t &ws);
+		void FindHits(double thresh_MeV, bcal_workspace_t &ws);
+		void CopyBCALHitsToHDDM(bcal_workspace_t &ws,
                         		hddm_s::HDDM *record);
 		
 };
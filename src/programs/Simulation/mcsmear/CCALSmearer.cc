@@ -37,7 +37,7 @@ ccal_config_t::ccal_config_t(JEventLoop *loop) {
 
 	map<string, double> ccalparms;
 
-	if(loop->GetCalib("CCAL/mc_energy", ccalparms)) { 
+	if(CalibSnapshot::GetCalib(loop, "CCAL/mc_energy", ccalparms)) { 
 	  jerr << "Problem loading CCAL/mc_energy from CCDB!" << endl;
 	} else {
 	  CCAL_EN_SCALE   = ccalparms["CCAL_EN_SCALE"]; 
@@ -54,7 +54,7 @@ ccal_config_t::ccal_config_t(JEventLoop *loop) {
 	cout<<"get CCAL/mc_time parameters from calibDB"<<endl;
 
 	map<string, double> ccaltime;
-	if(loop->GetCalib("CCAL/mc_time", ccaltime)) {
+	if(CalibSnapshot::GetCalib(loop, "CCAL/mc_time", ccaltime)) {
 	  jerr << "Problem loading CCAL/mc_time from CCDB!" << endl;
 	} else {
 	  CCAL_TSIGMA = ccaltime["CCAL_TSIGMA"];
@@ -18,7 +18,7 @@ cdc_config_t::cdc_config_t(JEventLoop *loop)
  	// load data from CCDB
  	jout << "get CDC/cdc_parms parameters from CCDB..." << endl;
     map<string, double> cdcparms;
-    if(loop->GetCalib("CDC/cdc_parms", cdcparms)) {
+    if(CalibSnapshot::GetCalib(loop, "CDC/cdc_parms", cdcparms)) {
     	jerr << "Problem loading CDC/cdc_parms from CCDB!" << endl;
     } else {
      	CDC_TDRIFT_SIGMA   = cdcparms["CDC_TDRIFT_SIGMA"]; 
@@ -29,7 +29,7 @@ cdc_config_t::cdc_config_t(JEventLoop *loop)
  	
     jout << "get CDC/diffusion_parms parameters from CCDB..." << endl;
     map<string, double> diffusionparms;
-    if(loop->GetCalib("CDC/diffusion_parms", diffusionparms)) {
+    if(CalibSnapshot::GetCalib(loop, "CDC/diffusion_parms", diffusionparms)) {
       jerr << "Problem loading CDC/diffusion_parms from CCDB!" << endl;
     } else {
       CDC_DIFFUSION_PAR1  = diffusionparms["d1"];
@@ -39,7 +39,7 @@ cdc_config_t::cdc_config_t(JEventLoop *loop)
 	
  	jout << "get CDC/digi_scales parameters from CCDB..." << endl;
     map<string, double> digi_scales;
-    if(loop->GetCalib("CDC/digi_scales", cdcparms)) {
+    if(CalibSnapshot::GetCalib(loop, "CDC/digi_scales", cdcparms)) {
     	jerr << "Problem loading CDC/digi_scales from CCDB!" << endl;
     } else {
      	CDC_ASCALE = cdcparms["CDC_ADC_ASCALE"]; 
@@ -48,13 +48,13 @@ cdc_config_t::cdc_config_t(JEventLoop *loop)
 
       // CDC correction for gain drop from progressive gas deterioration in spring 2018
       jout << "get CDC/gain_doca_correction parameters from CCDB..." << endl;
-      if(loop->GetCalib("CDC/gain_doca_correction", CDC_GAIN_DOCA_PARS))
+      if(CalibSnapshot::GetCalib(loop, "CDC/gain_doca_correction", CDC_GAIN_DOCA_PARS))
 		jout << "Error loading CDC/gain_doca_correction !" << endl;
 
 
       // CDC correction for gain drop from progressive gas deterioration in spring 2018
       jout << "get CDC/gain_doca_corr_ext parameters from CCDB..." << endl;
-      if(loop->GetCalib("CDC/gain_doca_corr_ext", CDC_GAIN_DOCA_EXT))
+      if(CalibSnapshot::GetCalib(loop, "CDC/gain_doca_corr_ext", CDC_GAIN_DOCA_EXT))
 		jout << "Error loading CDC/gain_doca_corr_ext !" << endl;
 
 
@@ -69,7 +69,7 @@ cdc_config_t::cdc_config_t(JEventLoop *loop)
 
 	// then load the CCDB table
 	vector<double> raw_table;
-	if(loop->GetCalib("CDC/wire_mc_efficiency", raw_table)) {
+	if(CalibSnapshot::GetCalib(loop, "CDC/wire_mc_efficiency", raw_table)) {
     	jerr << "Problem loading CDC/wire_mc_efficiency from CCDB!" << endl;
     } else {
 		// now fill the table
@@ -90,7 +90,7 @@ cdc_config_t::cdc_config_t(JEventLoop *loop)
     }
 
 
-	if(loop->GetCalib("CDC/hit_thresholds", raw_table)) {
+	if(CalibSnapshot::GetCalib(loop, "CDC/hit_thresholds", raw_table)) {
     	jerr << "Problem loading CDC/hit_thresholds from CCDB!" << endl;
     } else {
 		// now fill the table
@@ -110,6 +110,63 @@ cdc_config_t::cdc_config_t(JEventLoop *loop)
     	}
     }
 
+    CalcDerivedConstants(Nstraws);
+}
+
+//------------------
+// CalcDerivedConstants
+//------------------
+void cdc_config_t::CalcDerivedConstants(const vector<unsigned int> &Nstraws)
+{
+    // per-straw constants, with all straws accepted and no threshold
+    // if a table could not be loaded
+    ring_offset.clear();
+    straws.clear();
+    for (unsigned int ring=0; ring<Nstraws.size(); ring++) {
+        ring_offset.push_back( straws.size() );
+        for (unsigned int straw=0; straw<Nstraws[ring]; straw++) {
+            straw_t s;
+            s.efficiency = 1.0;
+            s.threshold = 0.0;
+            if (ring < wire_efficiencies.size() && straw < wire_efficiencies[ring].size())
+                s.efficiency = wire_efficiencies[ring][straw];
+            if (ring < wire_thresholds.size() && straw < wire_thresholds[ring].size())
+                s.threshold = wire_thresholds[ring][straw];
+            straws.push_back(s);
+        }
+    }
+
+    // gain/DOCA correction lines, see SmearEvent
+    gain_doca_t &g = gain_doca;
+    g.suppress_gain = false;
+    if (CDC_GAIN_DOCA_PARS.size() >= 6 && CDC_GAIN_DOCA_EXT.size() >= 2) {
+        g.dmax = CDC_GAIN_DOCA_PARS[0];
+        g.dmin = CDC_GAIN_DOCA_PARS[1];
+        g.refp0 = CDC_GAIN_DOCA_PARS[2];
+        g.refp1 = CDC_GAIN_DOCA_PARS[3];
+        g.thisp0 = CDC_GAIN_DOCA_PARS[4];
+        g.thisp1 = CDC_GAIN_DOCA_PARS[5];
+        g.refdmax = CDC_GAIN_DOCA_EXT[0];
+        double xd = CDC_GAIN_DOCA_EXT[1];
+
+        g.suppress_gain = (g.dmin < g.dmax);   // default values for good-gas runs have dmin=dmax=1.0cm
+
+        g.ref_ext_p1 = -1*(g.refp0 + g.refdmax*g.refp1)/xd;
+        g.ref_ext_p0 = -1*(g.refdmax+xd)*g.ref_ext_p1;
+        g.this_ext_p1 = -1*(g.thisp0 + g.dmax*g.thisp1)/xd;
+        g.this_ext_p0 = -1*(g.dmax+xd)*g.this_ext_p1;
+
+        g.ref_half_p1 = 0.5*g.refp1;
+        g.this_half_p1 = 0.5*g.thisp1;
+
+        g.ref_near_slope = g.refp0 + g.refp1*g.dmin;
+        g.ref_near_const = (g.refp0 + g.ref_half_p1*(g.dmin+g.dmax)) * (g.dmax - g.dmin);
+        g.this_near_slope = g.thisp0 + g.thisp1*g.dmin;
+        g.this_near_const = (g.thisp0 + g.this_half_p1*(g.dmin+g.dmax)) * (g.dmax - g.dmin);
+    }
+
+    sig_electronics = CDC_TDRIFT_SIGMA*1.0e9;
+    amplitude_saturation = 3995*CDC_ASCALE/CDC_INTEGRAL_TO_AMPLITUDE;
 }
 
 //------------------
@@ -159,6 +216,11 @@ void CDCSmearer::SmearEvent(hddm_s::HDDM *record)
    // move to wire-dependent sparsification thresholds compared to an overall factor
    //double threshold = cdc_config->CDC_THRESHOLD_FACTOR * cdc_config->CDC_PEDESTAL_SIGMA; // for sparsification
 
+   // Noise for all hits of the event, drawn in one block
+   size_t nthits = record->getCdcStrawTruthHits().size();
+   DRandomBuffer noise(config->SMEAR_HITS ? 2*nthits : 0,
+                       config->APPLY_EFFICIENCY_CORRECTIONS ? nthits : 0);
+
    // Loop over all cdcStraw tags
    hddm_s::CdcStrawList straws = record->getCdcStraws();
    hddm_s::CdcStrawList::iterator iter;
@@ -177,13 +239,16 @@ void CDCSmearer::SmearEvent(hddm_s::HDDM *record)
          }
       }
 
+      // per-straw constants
+      const cdc_config_t::straw_t &straw = cdc_config->GetStraw(iter->getRing(), iter->getStraw());
+
       // Create new cdcStrawHit from cdcStrawTruthHit information
       hddm_s::CdcStrawTruthHitList thits = iter->getCdcStrawTruthHits();
       hddm_s::CdcStrawTruthHitList::iterator titer;
       for (titer = thits.begin(); titer != thits.end(); ++ titer) {
          // correct simulation efficiencies 
 		 if (config->APPLY_EFFICIENCY_CORRECTIONS
-		 		&& !gDRandom.DecideToAcceptHit(cdc_config->GetEfficiencyCorrectionFactor(iter->getRing(), iter->getStraw())))
+		 		&& !noise.DecideToAcceptHit(straw.efficiency))
 		 	continue;
 
         double t = titer->getT();
@@ -203,24 +268,11 @@ void CDCSmearer::SmearEvent(hddm_s::HDDM *record)
         // 1: dcorr  Hits inside this DOCA are not corrected (not necessary)
 
         // Here the same linear functions are used to scale the hit amplitude & charge down.
+        // The lines are set up once per run, see cdc_config_t::CalcDerivedConstants.
 
-        double dmax = cdc_config->CDC_GAIN_DOCA_PARS[0];  //hits with doca > dmax are not used for dE/dx in recon
-        double dmin = cdc_config->CDC_GAIN_DOCA_PARS[1];  //gain is not suppressed for doca < dmin
-
-        double refp0 = cdc_config->CDC_GAIN_DOCA_PARS[2];  // reference p0
-        double refp1 = cdc_config->CDC_GAIN_DOCA_PARS[3];  // reference p1
-
-        double thisp0 = cdc_config->CDC_GAIN_DOCA_PARS[4];  // p0 for this run
-        double thisp1 = cdc_config->CDC_GAIN_DOCA_PARS[5];  // p1 for this run
+        const cdc_config_t::gain_doca_t &g = cdc_config->gain_doca;
 
-        double refdmax = cdc_config->CDC_GAIN_DOCA_EXT[0];  // dmax for reference run
-        double xd = cdc_config->CDC_GAIN_DOCA_EXT[1];  // length of 3rd line segment
-
-
-        bool suppress_gain = 0;
-        if (dmin < dmax) suppress_gain = 1;   // default values for good-gas runs have dmin=dmax=1.0cm 
-
-        if (suppress_gain) { 
+        if (g.suppress_gain) { 
 
           // apply correction for pulse amplitude.  Convert from charge to amplitude later on, after adding pedestal charge smearing 
 
@@ -229,42 +281,35 @@ void CDCSmearer::SmearEvent(hddm_s::HDDM *record)
 
           // match a third line segment to the second at dmax, descending to 0 at dmax+xd
 
-          if (d > dmin) {
+          if (d > g.dmin) {
 
-	      if (d <= refdmax) {
-		  reference = refp0 + d*refp1;
-              } else {
-    		  double newp1 = -1*(refp0 + refdmax*refp1)/xd;
-                  double newp0 =  -1*(refdmax+xd)*newp1;
-                  reference = newp0 + d*newp1;
-              }
+              if (d <= g.refdmax)
+                  reference = g.refp0 + d*g.refp1;
+              else
+                  reference = g.ref_ext_p0 + d*g.ref_ext_p1;
 
-	      if (d <= dmax) {
-                  this_run = thisp0 + d*thisp1;
-              } else {
-  		  double newp1 = -1*(thisp0 + dmax*thisp1)/xd;
-                  double newp0 =  -1*(dmax+xd)*newp1;
-                  this_run = newp0 + d*newp1;
-	      }
+              if (d <= g.dmax)
+                  this_run = g.thisp0 + d*g.thisp1;
+              else
+                  this_run = g.this_ext_p0 + d*g.this_ext_p1;
 
               amplitude = amplitude * this_run/reference;   
           }  
 
-       
-  	  // This is the correction for pulse integral.
+          // This is the correction for pulse integral.
  
-          if (d < dmin) {
+          if (d < g.dmin) {
 
-             reference    = (refp0 + refp1*dmin) * (dmin - d);
-             reference += (refp0 + 0.5*refp1*(dmin+dmax)) * (dmax - dmin);
+             reference = g.ref_near_slope * (g.dmin - d);
+             reference += g.ref_near_const;
 
-             this_run    = (thisp0 + thisp1*dmin) * (dmin - d);
-             this_run += (thisp0 + 0.5*thisp1*(dmin+dmax)) * (dmax - dmin);
+             this_run = g.this_near_slope * (g.dmin - d);
+             this_run += g.this_near_const;
 
           } else { 
 
-             reference = (refp0 + 0.5*refp1*(d+dmax)) * (dmax - d);
-             this_run   = (thisp0 + 0.5*thisp1*(d+dmax)) * (dmax - d);
+             reference = (g.refp0 + g.ref_half_p1*(d+g.dmax)) * (g.dmax - d);
+             this_run = (g.thisp0 + g.this_half_p1*(d+g.dmax)) * (g.dmax - d);
 
           }
 
@@ -281,12 +326,11 @@ void CDCSmearer::SmearEvent(hddm_s::HDDM *record)
 	  double sig_diffusion=cdc_config->CDC_DIFFUSION_PAR1*d
 	    +cdc_config->CDC_DIFFUSION_PAR2*dsq
 	    +cdc_config->CDC_DIFFUSION_PAR3*dsq*d;
-	  double sig_electronics=cdc_config->CDC_TDRIFT_SIGMA*1.0e9;
-	  double t_sig=sig_electronics+sig_diffusion;
+	  double t_sig=cdc_config->sig_electronics+sig_diffusion;
 
-	  t += gDRandom.SampleGaussian(t_sig);
+	  t += noise.SampleGaussian(t_sig);
 	  // Pedestal-smeared charge
-	  smearcharge =  gDRandom.SampleGaussian(cdc_config->CDC_PEDESTAL_SIGMA);
+	  smearcharge =  noise.SampleGaussian(cdc_config->CDC_PEDESTAL_SIGMA);
 	}
 
         q += smearcharge;
@@ -306,14 +350,13 @@ void CDCSmearer::SmearEvent(hddm_s::HDDM *record)
         if (raw_amplitude > saturation) raw_amplitude = saturation;
 
         // convert this from raw amplitude scale back into amplitude scale 
-        saturation = 3995*cdc_config->CDC_ASCALE/cdc_config->CDC_INTEGRAL_TO_AMPLITUDE;
+        saturation = cdc_config->amplitude_saturation;
 
         // apply saturation to amplitude
         if (amplitude > saturation) amplitude = saturation;
        
         // per-wire threshold in ADC units
-        double threshold = cdc_config->GetWireThreshold(iter->getRing(), iter->getStraw());
-        if (t > config->TRIGGER_LOOKBACK_TIME && t < t_max && raw_amplitude > threshold) {
+        if (t > config->TRIGGER_LOOKBACK_TIME && t < t_max && raw_amplitude > straw.threshold) {
             hits = iter->addCdcStrawHits();
             hits().setT(t);
             hits().setQ(q);
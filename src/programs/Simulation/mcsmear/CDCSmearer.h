@@ -25,7 +25,39 @@ class cdc_config_t
 	vector< vector<double> > wire_efficiencies;
 	vector< vector<double> > wire_thresholds;
 
+	// Constants derived from the ones above for the hit loop, once per
+	// run by CalcDerivedConstants, so that each hit only needs one
+	// indexed load and the arithmetic that depends on the hit itself.
+	// They are computed with the same operations in the same order as
+	// the loop used to, so the smeared hits do not change.
+	struct straw_t {
+		double efficiency;
+		double threshold;     // in ADC units
+	};
+	vector<straw_t> straws;             // in CCDB channel order
+	vector<unsigned int> ring_offset;   // index of each ring's first straw
+
+	struct gain_doca_t {
+		bool suppress_gain;          // dmin < dmax, i.e. a spring 2018 run
+		double dmin, dmax, refdmax;
+		double refp0, refp1;         // reference and this run's lines,
+		double thisp0, thisp1;       // for the amplitude up to (ref)dmax
+		double ref_ext_p0, ref_ext_p1;     // third line segments, from
+		double this_ext_p0, this_ext_p1;   // (ref)dmax down to 0 at +xd
+		double ref_half_p1, this_half_p1;  // 0.5*p1, for the integral
+		double ref_near_slope, ref_near_const;    // integral below dmin:
+		double this_near_slope, this_near_const;  // slope*(dmin-d) + const
+	} gain_doca;
+
+	double sig_electronics;        // CDC_TDRIFT_SIGMA in ns
+	double amplitude_saturation;   // fADC saturation in amplitude units
+
+	inline const straw_t &GetStraw(int ring, int straw) const {
+		return straws[ring_offset[ring-1] + straw-1];
+	}
+
 	void CalcNstraws(JEventLoop *loop, int32_t runnumber, vector<unsigned int> &Nstraws);
+	void CalcDerivedConstants(const vector<unsigned int> &Nstraws);
 	double GetEfficiencyCorrectionFactor(int ring, int straw) {
 		return wire_efficiencies.at(ring-1).at(straw-1);
 	}
@@ -0,0 +1,267 @@
+// CalibSnapshot.cc
+//
+
+#include <iostream>
+#include <fstream>
+#include <set>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+#include <DANA/DApplication.h>
+#include <JANA/JCalibration.h>
+
+#include "CalibSnapshot.h"
+
+// first line of a snapshot file
+static const std::string SNAPSHOT_MAGIC = "mcsmear calibration snapshot v1";
+
+std::map<CalibSnapshot::snapshot_key_t, CalibSnapshot::snapshot_t> CalibSnapshot::snapshots;
+std::vector<CalibSnapshot::table_key_t> CalibSnapshot::unsaved;
+std::string CalibSnapshot::filename;
+int CalibSnapshot::nfetched = 0;
+int CalibSnapshot::ncached = 0;
+pthread_mutex_t CalibSnapshot::mutex = PTHREAD_MUTEX_INITIALIZER;
+
+//-----------
+// GetSource
+//-----------
+void CalibSnapshot::GetSource(JEventLoop *loop, std::string &source, int &run)
+{
+   run = loop->GetJEvent().GetRunNumber();
+   DApplication* dapp = dynamic_cast<DApplication*>(loop->GetJApplication());
+   JCalibration *jcalib = dapp->GetJCalibration(run);
+   source = jcalib->GetURL() + " " + jcalib->GetContext();
+}
+
+//-----------
+// Find
+//-----------
+bool CalibSnapshot::Find(const std::string &source, int run,
+                         const std::string &namepath, table_t &table)
+{
+   pthread_mutex_lock(&mutex);
+   bool found = false;
+   std::map<snapshot_key_t, snapshot_t>::iterator snap;
+   snap = snapshots.find(snapshot_key_t(source, run));
+   if (snap != snapshots.end()) {
+      snapshot_t::iterator iter = snap->second.find(namepath);
+      if (iter != snap->second.end()) {
+         table = iter->second;
+         found = true;
+         ++ncached;
+      }
+   }
+   pthread_mutex_unlock(&mutex);
+   return found;
+}
+
+//-----------
+// Insert
+//-----------
+void CalibSnapshot::Insert(const std::string &source, int run,
+                           const std::string &namepath, const table_t &table)
+{
+   pthread_mutex_lock(&mutex);
+   snapshot_key_t key(source, run);
+   snapshots[key][namepath] = table;
+   // A failed lookup is remembered for this job only: it may be a
+   // passing CCDB or network error, which must not turn into a missing
+   // table for every later job that reads the file.
+   if (!table.failed)
+      unsaved.push_back(table_key_t(key, namepath));
+   ++nfetched;
+   pthread_mutex_unlock(&mutex);
+}
+
+//-----------
+// SetFile
+//-----------
+void CalibSnapshot::SetFile(const std::string &fname)
+{
+   pthread_mutex_lock(&mutex);
+   filename = fname;
+   std::ifstream ifs(filename.c_str(), std::ios::binary);
+   if (ifs.is_open()) {
+      std::string magic;
+      std::getline(ifs, magic);
+      if (magic != SNAPSHOT_MAGIC) {
+         jerr << filename << " is not an mcsmear calibration snapshot file,"
+              << " it will not be used!" << endl;
+         filename = "";
+      }
+      else {
+         std::string source;
+         std::string namepath;
+         int run;
+         table_t table;
+         int ntables = 0;
+         std::set<snapshot_key_t> runs;
+         while (ReadRecord(ifs, source, run, namepath, table)) {
+            if (table.failed)   // left by older versions, ask CCDB again
+               continue;
+            snapshot_key_t key(source, run);
+            snapshots[key][namepath] = table;
+            runs.insert(key);
+            ++ntables;
+         }
+         jout << "Read " << ntables << " calibration tables for "
+              << runs.size() << " runs from " << filename << endl;
+      }
+   }
+   pthread_mutex_unlock(&mutex);
+}
+
+//-----------
+// Save
+//-----------
+void CalibSnapshot::Save()
+{
+   pthread_mutex_lock(&mutex);
+   jout << "Calibration tables: " << nfetched << " read from CCDB, "
+        << ncached << " taken from the snapshot cache" << endl;
+   nfetched = 0;
+   ncached = 0;
+
+   if (filename.size() > 0 && unsaved.size() > 0)
+      WriteFile();
+   unsaved.clear();
+   pthread_mutex_unlock(&mutex);
+}
+
+//-----------
+// WriteFile
+//-----------
+void CalibSnapshot::WriteFile()
+{
+   // Jobs sharing the file take turns through a lock on a separate
+   // file, since the snapshot itself is replaced by the rename below.
+   std::string lockname = filename + ".lock";
+   int lockfd = open(lockname.c_str(), O_RDWR | O_CREAT, 0644);
+   if (lockfd < 0 || flock(lockfd, LOCK_EX) != 0) {
+      jerr << "Unable to lock calibration snapshot file "
+           << lockname << ", tables not saved" << endl;
+      if (lockfd >= 0)
+         close(lockfd);
+      return;
+   }
+
+   // start from the records other jobs have written since SetFile
+   std::ostringstream records;
+   std::set<table_key_t> ondisk;
+   std::ifstream ifs(filename.c_str(), std::ios::binary);
+   if (ifs.is_open()) {
+      std::string magic;
+      std::getline(ifs, magic);
+      if (magic != SNAPSHOT_MAGIC) {
+         jerr << filename << " is not an mcsmear calibration snapshot file,"
+              << " tables not saved" << endl;
+         flock(lockfd, LOCK_UN);
+         close(lockfd);
+         return;
+      }
+      std::string source;
+      std::string namepath;
+      int run;
+      table_t table;
+      while (ReadRecord(ifs, source, run, namepath, table)) {
+         if (table.failed)
+            continue;
+         table_key_t key(snapshot_key_t(source, run), namepath);
+         if (ondisk.insert(key).second)
+            WriteRecord(records, source, run, namepath, table);
+      }
+      ifs.close();
+   }
+   for (size_t i=0; i < unsaved.size(); ++i) {
+      if (ondisk.count(unsaved[i]))
+         continue;
+      const snapshot_key_t &key = unsaved[i].first;
+      const std::string &namepath = unsaved[i].second;
+      WriteRecord(records, key.first, key.second, namepath,
+                  snapshots[key][namepath]);
+   }
+
+   // write the whole file next to the old one and rename it into place,
+   // so readers never see a partly written file
+   char host[256] = "";
+   gethostname(host, sizeof(host) - 1);
+   std::ostringstream tmpname;
+   tmpname << filename << "." << host << "." << getpid() << ".tmp";
+   std::ofstream ofs(tmpname.str().c_str(), std::ios::binary | std::ios::trunc);
+   if (ofs.is_open()) {
+      ofs << SNAPSHOT_MAGIC << std::endl;
+      ofs << records.str();
+      ofs.close();
+   }
+   if (!ofs || rename(tmpname.str().c_str(), filename.c_str()) != 0) {
+      jerr << "Unable to write calibration snapshot file "
+           << filename << endl;
+      unlink(tmpname.str().c_str());
+   }
+
+   flock(lockfd, LOCK_UN);
+   close(lockfd);
+}
+
+//-----------
+// Encode
+//-----------
+void CalibSnapshot::Encode(std::ostream &os, const std::string &val)
+{
+   int n = val.size();
+   Encode(os, n);
+   os.write(val.data(), n);
+}
+
+//-----------
+// Decode
+//-----------
+void CalibSnapshot::Decode(std::istream &is, std::string &val)
+{
+   int n = 0;
+   Decode(is, n);
+   if (n < 0 || !is) {
+      val.clear();
+      is.setstate(std::ios::failbit);
+      return;
+   }
+   val.resize(n);
+   if (n > 0)
+      is.read(&val[0], n);
+}
+
+//-----------
+// ReadRecord
+//-----------
+bool CalibSnapshot::ReadRecord(std::istream &is, std::string &source, int &run,
+                               std::string &namepath, table_t &table)
+{
+   int failed = 0;
+   Decode(is, source);
+   Decode(is, run);
+   Decode(is, namepath);
+   Decode(is, table.type);
+   Decode(is, failed);
+   Decode(is, table.data);
+   table.failed = (failed != 0);
+   // a record cut short (e.g. by a job that was killed) is ignored
+   return (bool)is;
+}
+
+//-----------
+// WriteRecord
+//-----------
+void CalibSnapshot::WriteRecord(std::ostream &os, const std::string &source, int run,
+                                const std::string &namepath, const table_t &table)
+{
+   int failed = table.failed;
+   Encode(os, source);
+   Encode(os, run);
+   Encode(os, namepath);
+   Encode(os, table.type);
+   Encode(os, failed);
+   Encode(os, table.data);
+}
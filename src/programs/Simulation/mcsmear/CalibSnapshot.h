@@ -0,0 +1,201 @@
+// CalibSnapshot.h
+//
+// Cache of the CCDB tables read by the mcsmear detector configuration
+// classes, keyed by calibration source (URL and context), run number
+// and table name. Smear is rebuilt by MyProcessor::brun every time the
+// run number changes, and with this only the first time a run is seen
+// do its tables have to be fetched through the event loop.
+//
+// If the MCSMEAR:CALIB_SNAPSHOT parameter names a file, every table
+// fetched is also added to it and the file is read back at startup,
+// so later jobs over the same runs make no CCDB table queries at all.
+// Jobs sharing the file update it one at a time under an flock on
+// <file>.lock, each merging its new tables with what is on disk and
+// renaming the result into place.
+// Tables CCDB failed to return are cached for the running job but never
+// written to the file, so later jobs ask for them again.
+// The tables are stored in the native binary layout of the machine
+// that wrote them, so the file is meant to be kept locally.
+
+#ifndef _CALIBSNAPSHOT_H_
+#define _CALIBSNAPSHOT_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <pthread.h>
+
+#include <JANA/JEventLoop.h>
+using namespace jana;
+
+class CalibSnapshot
+{
+   public:
+      // Drop-in replacement for loop->GetCalib(namepath, vals), with the
+      // same return value (true if the table could not be loaded).
+      template <class T>
+      static bool GetCalib(JEventLoop *loop, const std::string &namepath,
+                           T &vals);
+
+      // Read any snapshots already in the file and add new tables
+      // to it from now on.
+      static void SetFile(const std::string &filename);
+
+      // Write out the tables fetched since the last call, and report
+      // how many came from CCDB and how many from the cache.
+      static void Save();
+
+   private:
+      struct table_t {
+         std::string type;    // encoding of T, see TypeTag
+         bool failed;         // GetCalib returned an error
+         std::string data;
+      };
+
+      static void GetSource(JEventLoop *loop, std::string &source, int &run);
+      // merge the unsaved tables into the file, with the mutex held
+      static void WriteFile();
+      // name is the type tag followed by the table name
+      static bool Find(const std::string &source, int run,
+                       const std::string &namepath, table_t &table);
+      static void Insert(const std::string &source, int run,
+                         const std::string &namepath, const table_t &table);
+
+      static void Encode(std::ostream &os, const int &val)
+       { os.write((const char*)&val, sizeof(val)); }
+      static void Encode(std::ostream &os, const float &val)
+       { os.write((const char*)&val, sizeof(val)); }
+      static void Encode(std::ostream &os, const double &val)
+       { os.write((const char*)&val, sizeof(val)); }
+      static void Encode(std::ostream &os, const std::string &val);
+      template <class T>
+      static void Encode(std::ostream &os, const std::vector<T> &vals);
+      template <class T>
+      static void Encode(std::ostream &os, const std::map<std::string,T> &vals);
+
+      static void Decode(std::istream &is, int &val)
+       { is.read((char*)&val, sizeof(val)); }
+      static void Decode(std::istream &is, float &val)
+       { is.read((char*)&val, sizeof(val)); }
+      static void Decode(std::istream &is, double &val)
+       { is.read((char*)&val, sizeof(val)); }
+      static void Decode(std::istream &is, std::string &val);
+      template <class T>
+      static void Decode(std::istream &is, std::vector<T> &vals);
+      template <class T>
+      static void Decode(std::istream &is, std::map<std::string,T> &vals);
+
+      static std::string TypeTag(const int&) { return "i"; }
+      static std::string TypeTag(const float&) { return "f"; }
+      static std::string TypeTag(const double&) { return "d"; }
+      static std::string TypeTag(const std::string&) { return "s"; }
+      template <class T>
+      static std::string TypeTag(const std::vector<T>&)
+       { return "v" + TypeTag(T()); }
+      template <class T>
+      static std::string TypeTag(const std::map<std::string,T>&)
+       { return "m" + TypeTag(T()); }
+
+      static bool ReadRecord(std::istream &is, std::string &source, int &run,
+                             std::string &namepath, table_t &table);
+      static void WriteRecord(std::ostream &os, const std::string &source, int run,
+                              const std::string &namepath, const table_t &table);
+
+      typedef std::map<std::string, table_t> snapshot_t;  // by type, table name
+      typedef std::pair<std::string, int> snapshot_key_t; // source, run
+      typedef std::pair<snapshot_key_t, std::string> table_key_t;
+
+      static std::map<snapshot_key_t, snapshot_t> snapshots;
+      static std::vector<table_key_t> unsaved;
+      static std::string filename;
+      static int nfetched;
+      static int ncached;
+      static pthread_mutex_t mutex;
+};
+
+//-----------
+// GetCalib
+//-----------
+template <class T>
+bool CalibSnapshot::GetCalib(JEventLoop *loop, const std::string &namepath,
+                             T &vals)
+{
+   std::string source;
+   int run;
+   GetSource(loop, source, run);
+
+   // the same table is sometimes read into different types
+   std::string name = TypeTag(vals) + " " + namepath;
+
+   table_t table;
+   if (Find(source, run, name, table)) {
+      if (!table.failed) {
+         std::istringstream is(table.data);
+         Decode(is, vals);
+      }
+      return table.failed;
+   }
+
+   table.type = TypeTag(vals);
+   table.failed = loop->GetCalib(namepath, vals);
+   if (!table.failed) {
+      std::ostringstream os;
+      Encode(os, vals);
+      table.data = os.str();
+   }
+   Insert(source, run, name, table);
+   return table.failed;
+}
+
+//-----------
+// Encode
+//-----------
+template <class T>
+void CalibSnapshot::Encode(std::ostream &os, const std::vector<T> &vals)
+{
+   int n = vals.size();
+   Encode(os, n);
+   for (int i=0; i < n; ++i)
+      Encode(os, vals[i]);
+}
+
+template <class T>
+void CalibSnapshot::Encode(std::ostream &os, const std::map<std::string,T> &vals)
+{
+   int n = vals.size();
+   Encode(os, n);
+   typename std::map<std::string,T>::const_iterator iter;
+   for (iter = vals.begin(); iter != vals.end(); ++iter) {
+      Encode(os, iter->first);
+      Encode(os, iter->second);
+   }
+}
+
+//-----------
+// Decode
+//-----------
+template <class T>
+void CalibSnapshot::Decode(std::istream &is, std::vector<T> &vals)
+{
+   int n = 0;
+   Decode(is, n);
+   vals.resize(n);
+   for (int i=0; i < n; ++i)
+      Decode(is, vals[i]);
+}
+
+template <class T>
+void CalibSnapshot::Decode(std::istream &is, std::map<std::string,T> &vals)
+{
+   int n = 0;
+   Decode(is, n);
+   vals.clear();
+   for (int i=0; i < n; ++i) {
+      std::string key;
+      Decode(is, key);
+      Decode(is, vals[key]);
+   }
+}
+
+#endif // _CALIBSNAPSHOT_H_
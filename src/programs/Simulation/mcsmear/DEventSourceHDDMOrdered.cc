@@ -0,0 +1,69 @@
+// DEventSourceHDDMOrdered.cc
+//
+
+#include <map>
+#include <mutex>
+
+#include "DEventSourceHDDMOrdered.h"
+
+// declared in MyProcessor.cc
+extern void mcsmear_release_event(uint64_t seq);
+
+// Sequence numbers keep counting across input files, so the
+// bookkeeping is shared by all instances of this source.
+static std::mutex sequence_mutex;
+static uint64_t next_sequence = 0;
+static std::map<void*, uint64_t> sequence_of_ref;
+
+//-----------
+// GetEvent
+//-----------
+jerror_t DEventSourceHDDMOrdered::GetEvent(JEvent &event)
+{
+   jerror_t err = DEventSourceHDDM::GetEvent(event);
+   if (err == NOERROR && event.GetRef() != NULL) {
+      std::lock_guard<std::mutex> lock(sequence_mutex);
+      sequence_of_ref[event.GetRef()] = next_sequence++;
+   }
+   return err;
+}
+
+//-----------
+// FreeEvent
+//-----------
+void DEventSourceHDDMOrdered::FreeEvent(JEvent &event)
+{
+   // Let the ordered stages in MyProcessor move past this event,
+   // in case it never made it that far. This has to happen before
+   // the record is deleted, since its address is the lookup key.
+   uint64_t seq;
+   bool known = false;
+   {
+      std::lock_guard<std::mutex> lock(sequence_mutex);
+      std::map<void*, uint64_t>::iterator iter;
+      iter = sequence_of_ref.find(event.GetRef());
+      if (iter != sequence_of_ref.end()) {
+         seq = iter->second;
+         sequence_of_ref.erase(iter);
+         known = true;
+      }
+   }
+   if (known)
+      mcsmear_release_event(seq);
+
+   DEventSourceHDDM::FreeEvent(event);
+}
+
+//-----------
+// GetSequenceNumber
+//-----------
+bool DEventSourceHDDMOrdered::GetSequenceNumber(JEvent &event, uint64_t &seq)
+{
+   std::lock_guard<std::mutex> lock(sequence_mutex);
+   std::map<void*, uint64_t>::iterator iter;
+   iter = sequence_of_ref.find(event.GetRef());
+   if (iter == sequence_of_ref.end())
+      return false;
+   seq = iter->second;
+   return true;
+}
@@ -0,0 +1,56 @@
+// DEventSourceHDDMOrdered.h
+//
+// HDDM event source for mcsmear that tags every event with its
+// position in the input file. When mcsmear runs with more than
+// one processing thread, MyProcessor uses this sequence number to
+// write the smeared events out in the same order they were read,
+// independent of which thread finished first.
+
+#ifndef _DEVENTSOURCEHDDMORDERED_H_
+#define _DEVENTSOURCEHDDMORDERED_H_
+
+#include <stdint.h>
+
+#include <JANA/JEvent.h>
+#include <HDDM/DEventSourceHDDM.h>
+#include <HDDM/DEventSourceHDDMGenerator.h>
+using namespace jana;
+
+class DEventSourceHDDMOrdered: public DEventSourceHDDM
+{
+   public:
+      DEventSourceHDDMOrdered(const char* source_name)
+       : DEventSourceHDDM(source_name) {}
+      virtual ~DEventSourceHDDMOrdered() {}
+      virtual const char* className(void){return static_className();}
+      static const char* static_className(void){return "DEventSourceHDDMOrdered";}
+
+      jerror_t GetEvent(JEvent &event);
+      void FreeEvent(JEvent &event);
+
+      // Look up the input sequence number of an event read by
+      // this source, returns false if the event is unknown.
+      static bool GetSequenceNumber(JEvent &event, uint64_t &seq);
+};
+
+class DEventSourceHDDMOrderedGenerator: public DEventSourceHDDMGenerator
+{
+   public:
+      DEventSourceHDDMOrderedGenerator() {}
+      ~DEventSourceHDDMOrderedGenerator() {}
+      const char* className(void){return static_className();}
+      static const char* static_className(void){return "DEventSourceHDDMOrderedGenerator";}
+
+      const char* Description(void) {
+         return "HDDM simulated events, tagged with input order";
+      }
+      double CheckOpenable(string source) {
+         // outbid the standard HDDM source for any file it accepts
+         return (DEventSourceHDDMGenerator::CheckOpenable(source) > 0)? 0.99 : 0;
+      }
+      JEventSource* MakeJEventSource(string source) {
+         return new DEventSourceHDDMOrdered(source.c_str());
+      }
+};
+
+#endif // _DEVENTSOURCEHDDMORDERED_H_
@@ -0,0 +1,249 @@
+// DRandom2.cc
+//
+// Block streams of DRandom2 and DRandomBuffer, see DRandom2.h.
+//
+// The Philox4x32-10 generator is that of Salmon et al., "Parallel
+// random numbers: as easy as 1, 2, 3" (SC11), the ziggurat that of
+// Marsaglia and Tsang in the form given by Doornik (2005), with 128
+// layers, and Poisson numbers with mean of 10 or more come from the
+// transformed rejection (PTRS) of Hoermann (1993).
+
+#include <algorithm>
+
+#include "DRandom2.h"
+
+//-----------
+// SplitMix64
+//-----------
+static uint64_t SplitMix64(uint64_t x)
+{
+   x += 0x9e3779b97f4a7c15ULL;
+   x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+   return x ^ (x >> 31);
+}
+
+//-----------
+// StartBlockStreams
+//-----------
+void DRandom2::StartBlockStreams()
+{
+   uint64_t k = SplitMix64(((uint64_t)fSeed << 32) | fSeed1);
+   key[0] = (uint32_t)k;
+   key[1] = (uint32_t)(k >> 32);
+   stream_tag = (uint32_t)SplitMix64(k ^ fSeed2);
+   for (int i=0; i < kNumStreams; ++i) {
+      streams[i].block = 0;
+      streams[i].nused = 4;
+   }
+}
+
+//-----------
+// Philox
+//-----------
+void DRandom2::Philox(const uint32_t ctr[4], uint32_t out[4]) const
+{
+   const uint32_t M0 = 0xD2511F53;
+   const uint32_t M1 = 0xCD9E8D57;
+   const uint32_t W0 = 0x9E3779B9;
+   const uint32_t W1 = 0xBB67AE85;
+
+   uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+   uint32_t k0 = key[0], k1 = key[1];
+   for (int round=0; round < 10; ++round) {
+      uint64_t p0 = (uint64_t)M0 * c0;
+      uint64_t p1 = (uint64_t)M1 * c2;
+      c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+      c1 = (uint32_t)p1;
+      c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+      c3 = (uint32_t)p0;
+      k0 += W0;
+      k1 += W1;
+   }
+   out[0] = c0;
+   out[1] = c1;
+   out[2] = c2;
+   out[3] = c3;
+}
+
+//-----------
+// NextWord
+//-----------
+uint32_t DRandom2::NextWord(int stream)
+{
+   block_stream_t &s = streams[stream];
+   if (s.nused == 4) {
+      uint32_t ctr[4] = {(uint32_t)s.block, (uint32_t)(s.block >> 32),
+                         (uint32_t)stream, stream_tag};
+      Philox(ctr, s.word);
+      ++s.block;
+      s.nused = 0;
+   }
+   return s.word[s.nused++];
+}
+
+//-----------
+// NextUniform
+//-----------
+double DRandom2::NextUniform(int stream)
+{
+   uint64_t hi = NextWord(stream);
+   uint64_t lo = NextWord(stream);
+   uint64_t bits = ((hi << 32) | lo) >> 11;
+   return (bits + 0.5) * (1.0 / 9007199254740992.0);   // 2^-53
+}
+
+//-----------
+// NextGaussian
+//-----------
+namespace {
+   const int kZigLayers = 128;
+   const double kZigR = 3.442619855899;          // start of the tail
+   const double kZigV = 9.91256303526217e-3;     // area of each layer
+
+   struct ziggurat_t {
+      double x[kZigLayers + 1];   // right edges of the layers
+      double ratio[kZigLayers];   // x[i+1]/x[i], inner part of layer i
+      ziggurat_t() {
+         double f = exp(-0.5 * kZigR * kZigR);
+         x[0] = kZigV / f;       // the base layer with the tail
+         x[1] = kZigR;
+         x[kZigLayers] = 0;
+         for (int i=2; i < kZigLayers; ++i) {
+            x[i] = sqrt(-2 * log(kZigV / x[i-1] + f));
+            f = exp(-0.5 * x[i] * x[i]);
+         }
+         for (int i=0; i < kZigLayers; ++i)
+            ratio[i] = x[i+1] / x[i];
+      }
+   };
+}
+
+double DRandom2::NextGaussian()
+{
+   static const ziggurat_t zig;
+
+   for (;;) {
+      // 7 bits for the layer, 53 for the position in it
+      uint64_t bits = ((uint64_t)NextWord(kGaussianStream) << 32) |
+                      NextWord(kGaussianStream);
+      int i = bits & (kZigLayers - 1);
+      double u = 2 * (((bits >> 11) + 0.5) * (1.0 / 9007199254740992.0)) - 1;
+
+      // inside the rectangle under the curve
+      if (fabs(u) < zig.ratio[i])
+         return u * zig.x[i];
+
+      // in the base layer, outside the rectangle: from the tail
+      if (i == 0) {
+         double x, y;
+         do {
+            x = log(NextUniform(kGaussianStream)) / kZigR;
+            y = log(NextUniform(kGaussianStream));
+         } while (-2 * y < x * x);
+         return (u < 0) ? x - kZigR : kZigR - x;
+      }
+
+      // in the wedge between the rectangle and the next layer up
+      double x = u * zig.x[i];
+      double f0 = exp(-0.5 * (zig.x[i] * zig.x[i] - x * x));
+      double f1 = exp(-0.5 * (zig.x[i+1] * zig.x[i+1] - x * x));
+      if (f1 + NextUniform(kGaussianStream) * (f0 - f1) < 1.0)
+         return x;
+   }
+}
+
+//-----------
+// NextPoisson
+//-----------
+int DRandom2::NextPoisson(double mean)
+{
+   if (mean <= 0)
+      return 0;
+
+   if (mean < 10) {
+      // inversion, summing up the probabilities from k=0
+      double u = NextUniform(kPoissonStream);
+      double p = exp(-mean);
+      double cdf = p;
+      int k = 0;
+      while (u > cdf && k < 1000) {
+         ++k;
+         p *= mean / k;
+         cdf += p;
+      }
+      return k;
+   }
+
+   double slam = sqrt(mean);
+   double loglam = log(mean);
+   double b = 0.931 + 2.53 * slam;
+   double a = -0.059 + 0.02483 * b;
+   double invalpha = 1.1239 + 1.1328 / (b - 3.4);
+   double vr = 0.9277 - 3.6224 / (b - 2);
+   for (;;) {
+      double u = NextUniform(kPoissonStream) - 0.5;
+      double v = NextUniform(kPoissonStream);
+      double us = 0.5 - fabs(u);
+      double k = floor((2 * a / us + b) * u + mean + 0.43);
+      if (us >= 0.07 && v <= vr)
+         return (int)k;
+      if (k < 0 || (us < 0.013 && v > us))
+         continue;
+      if (log(v) + log(invalpha) - log(a / (us * us) + b) <=
+          -mean + k * loglam - lgamma(k + 1))
+         return (int)k;
+   }
+}
+
+//-----------
+// FillUniform
+//-----------
+void DRandom2::FillUniform(double *u, size_t n)
+{
+   for (size_t i=0; i < n; ++i)
+      u[i] = NextUniform(kUniformStream);
+}
+
+//-----------
+// FillGaussian
+//-----------
+void DRandom2::FillGaussian(double *g, size_t n)
+{
+   for (size_t i=0; i < n; ++i)
+      g[i] = NextGaussian();
+}
+
+//-----------
+// FillPoisson
+//-----------
+void DRandom2::FillPoisson(const double *mean, int *k, size_t n)
+{
+   for (size_t i=0; i < n; ++i)
+      k[i] = NextPoisson(mean[i]);
+}
+
+//-----------
+// DRandomBuffer (constructor)
+//-----------
+DRandomBuffer::DRandomBuffer(size_t ngaussian, size_t nuniform)
+ : gaussian(ngaussian), uniform(nuniform), igaussian(0), iuniform(0)
+{
+   if (ngaussian > 0)
+      gDRandom.FillGaussian(&gaussian[0], ngaussian);
+   if (nuniform > 0)
+      gDRandom.FillUniform(&uniform[0], nuniform);
+}
+
+//-----------
+// Refill
+//-----------
+void DRandomBuffer::Refill(std::vector<double> &buf, size_t &next, bool gaus)
+{
+   buf.resize(std::max(buf.size(), (size_t)64));
+   if (gaus)
+      gDRandom.FillGaussian(&buf[0], buf.size());
+   else
+      gDRandom.FillUniform(&buf[0], buf.size());
+   next = 0;
+}
@@ -3,6 +3,10 @@
 
 // Random number generator used in mcsmear. All random numbers
 // should come from the global "gDRandom" object declared here.
+// It is thread_local so that every JANA processing thread draws
+// from its own stream. The stream is reseeded for every event
+// from the seeds stored in the event (see Smear::GetAndSetSeeds)
+// so results do not depend on which thread smeared the event.
 //
 // Because we want to record the seeds used for every event,
 // we use the TRandom2 class. This one has only 3 seed values
@@ -13,19 +17,34 @@
 // the class with no methods to access/set them, we derive
 // a new class, DRandom2 from TRandom2. This allows us access
 // to the numbers for easy recording/retrieving. 
+//
+// The smearers draw the noise for the hits of an event in blocks,
+// through FillUniform, FillGaussian and FillPoisson (or a DRandomBuffer
+// on top of them). These come from a counter-based generator
+// (Philox4x32-10) keyed by the three seeds at the start of the event,
+// with separate streams for uniform, Gaussian and Poisson numbers, so
+// they are reproducible from the seeds recorded in the event just as
+// the TRandom2 stream is. Gaussian numbers are made with the ziggurat
+// method. A stream gives the same numbers however its draws are split
+// into blocks. validation/DRandom2_validation.cc checks the generators.
 
 #ifndef _DRANDOM2_H_
 #define _DRANDOM2_H_
 
 #include <TRandom2.h>
 #include <iostream>
+#include <vector>
+#include <stdint.h>
+#include <math.h>
 using std::cerr;
 using std::endl;
 
 class DRandom2:public TRandom2{
 	public:
 		
-		DRandom2(UInt_t seed=1):TRandom2(seed){}
+		DRandom2(UInt_t seed=1):TRandom2(seed){
+			StartBlockStreams();
+		}
 	
 		void GetSeeds(UInt_t &seed, UInt_t &seed1, UInt_t &seed2){
 			seed = this->fSeed;
@@ -57,8 +76,22 @@ class DRandom2:public TRandom2{
 			this->fSeed = seed;		
 			this->fSeed1 = seed1;		
 			this->fSeed2 = seed2;		
+			StartBlockStreams();
 		}
 		
+		// Restart the block streams, keyed by the current seeds. This is
+		// done by SetSeeds and at the start of every event (see
+		// Smear::GetAndSetSeeds), also when the TRandom2 stream runs on;
+		// it is then stepped once per event so that the seeds change.
+		void StartBlockStreams();
+		
+		// Block interface: fill the n elements of the caller's buffer with
+		// numbers uniform in (0,1), normal with mean 0 and sigma 1, or
+		// Poisson distributed with the means given in mean[].
+		void FillUniform(double *u, size_t n);
+		void FillGaussian(double *g, size_t n);
+		void FillPoisson(const double *mean, int *k, size_t n);
+		
 		// legacy mcsmear interface
 		inline double SampleGaussian(double sigma) {
 			return Gaus(0.0, sigma);
@@ -91,6 +124,26 @@ class DRandom2:public TRandom2{
 			// in the data.  With the data/sim matching efficiency as an input parameter,
 			// this function decides if we should keep the hit or not
 			
+			bool accept;
+			if(HitAcceptanceIsCertain(prob, accept))
+				return accept;
+			
+			// Otherwise, our efficiency should be some number in (0,1)
+			// Throw a random number in that range, and reject if the random
+			// number is larger than our efficiency
+			if(Uniform() > prob)
+				return false;
+			return true;
+		}
+
+	private:
+		friend class DRandomBuffer;
+		friend struct DRandom2Validation;   // validation/DRandom2_validation.cc
+
+		// true if a hit with efficiency prob is always accepted or always
+		// rejected, with accept set accordingly
+		static inline bool HitAcceptanceIsCertain(double prob, bool &accept) {
+			
 			// Tolerance for seeing if a number is near zero
 			// Could use std::numeric_limits::epsilon(), but that's probably too restrictive
 			const double maxAbsDiff = 1.e-8;
@@ -99,33 +152,29 @@ class DRandom2:public TRandom2{
 			// For floating point numbers, using the absolute difference to see if a 
 			// number is consistent with zero is preferred.
 			// Reference: https://randomascii.wordpress.com/2012/02/25/comparing-floating-point-numbers-2012-edition/
+			accept = false;
 			if( fabs(prob - 0.0) < maxAbsDiff )
-				return false;
+				return true;
 			
 			// If the effiency is less than 0, then we always reject it
 			// This really shouldn't happen, though
 			if( prob < 0.0 )
-				return false;
+				return true;
 			
 			// If the efficiency is greater than 1, then always accept it
 			// (though why would it be larger?)
+			accept = true;
 			if( prob > 1.0 )
 				return true;
 			
 			// If the efficiency is equal to one, then always accept it
 			if(AlmostEqual(prob, 1.0))
 				return true;
-				
-			// Otherwise, our efficiency should be some number in (0,1)
-			// Throw a random number in that range, and reject if the random
-			// number is larger than our efficiency
-			if(Uniform() > prob)
-				return false;
-			return true;
+			
+			return false;
 		}
 
-	private:
-		bool AlmostEqual(double a, double b) {
+		static bool AlmostEqual(double a, double b) {
 			// Comparing floating point numbers is tough!
 			// This should work for numbers not near zero.
 			// Reference: https://randomascii.wordpress.com/2012/02/25/comparing-floating-point-numbers-2012-edition/
@@ -141,10 +190,72 @@ class DRandom2:public TRandom2{
 			return false;
 		}
 
+		// Philox4x32-10 output for the counter ctr, under the current key
+		void Philox(const uint32_t ctr[4], uint32_t out[4]) const;
+
+		enum { kUniformStream, kGaussianStream, kPoissonStream, kNumStreams };
+		struct block_stream_t {
+			uint64_t block;     // counter of the next Philox block
+			uint32_t word[4];   // output of the last block
+			int nused;          // words of it already handed out
+		};
+		uint32_t NextWord(int stream);
+		double NextUniform(int stream);   // in (0,1), 53 bits
+		double NextGaussian();
+		int NextPoisson(double mean);
+
+		uint32_t key[2];
+		uint32_t stream_tag;    // last counter word, also from the seeds
+		block_stream_t streams[kNumStreams];
+};
+
+// Noise for the hits of one loop over an event, drawn from the block
+// streams of gDRandom ahead of the loop and handed out hit by hit, with
+// the same calls as on gDRandom. If the loop needs more numbers than
+// were drawn, the next block is drawn from the same streams, so the
+// numbers do not depend on the sizes given here.
+class DRandomBuffer{
+	public:
+		DRandomBuffer(size_t ngaussian, size_t nuniform=0);
+
+		inline double SampleGaussian(double sigma) {
+			return sigma * NextGaussian();
+		}
+
+		inline double Gaus(double mean, double sigma) {
+			return mean + sigma * NextGaussian();
+		}
+
+		inline bool DecideToAcceptHit(double prob) {
+			bool accept;
+			if(DRandom2::HitAcceptanceIsCertain(prob, accept))
+				return accept;
+			if(NextUniform() > prob)
+				return false;
+			return true;
+		}
+
+	private:
+		inline double NextGaussian() {
+			if(igaussian == gaussian.size())
+				Refill(gaussian, igaussian, true);
+			return gaussian[igaussian++];
+		}
+		inline double NextUniform() {
+			if(iuniform == uniform.size())
+				Refill(uniform, iuniform, false);
+			return uniform[iuniform++];
+		}
+		void Refill(std::vector<double> &buf, size_t &next, bool gaus);
+
+		std::vector<double> gaussian;
+		std::vector<double> uniform;
+		size_t igaussian;
+		size_t iuniform;
 };
 
 #endif  // _DRANDOM2_H_
 
-extern DRandom2 gDRandom;
+extern thread_local DRandom2 gDRandom;
 
 
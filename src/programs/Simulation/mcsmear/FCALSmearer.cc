@@ -20,7 +20,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
 	// Get values from CCDB
 	cout << "Get FCAL/fcal_parms parameters from CCDB..." << endl;
     map<string, double> fcalparms;
-    if(loop->GetCalib("FCAL/fcal_parms", fcalparms)) { 
+    if(CalibSnapshot::GetCalib(loop, "FCAL/fcal_parms", fcalparms)) { 
      	jerr << "Problem loading FCAL/fcal_parms from CCDB!" << endl;
     } else {
        	FCAL_PHOT_STAT_COEF   = fcalparms["FCAL_PHOT_STAT_COEF"]; 
@@ -29,7 +29,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
 		
 	cout<<"get FCAL/gains from calibDB"<<endl;
     vector <double> FCAL_GAINS_TEMP;
-    if(loop->GetCalib("FCAL/gains", FCAL_GAINS_TEMP)) {
+    if(CalibSnapshot::GetCalib(loop, "FCAL/gains", FCAL_GAINS_TEMP)) {
     	jerr << "Problem loading FCAL/gains from CCDB!" << endl;
     } else {
     	for (unsigned int i = 0; i < FCAL_GAINS_TEMP.size(); i++) {
@@ -39,7 +39,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
      
    cout<<"get FCAL/pedestals from calibDB"<<endl;
    vector <double> FCAL_PEDS_TEMP;
-   if(loop->GetCalib("FCAL/pedestals", FCAL_PEDS_TEMP)) {
+   if(CalibSnapshot::GetCalib(loop, "FCAL/pedestals", FCAL_PEDS_TEMP)) {
       jerr << "Problem loading FCAL/pedestals from CCDB!" << endl;
    } else {
        for (unsigned int i = 0; i < FCAL_PEDS_TEMP.size(); i++) {
@@ -49,7 +49,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
    
    cout<<"get FCAL/MC/pedestal_rms from calibDB"<<endl;
    double FCAL_PED_RMS_TEMP;
-   if(loop->GetCalib("FCAL/MC/pedestal_rms", FCAL_PED_RMS_TEMP)) {
+   if(CalibSnapshot::GetCalib(loop, "FCAL/MC/pedestal_rms", FCAL_PED_RMS_TEMP)) {
       jerr << "Problem loading FCAL/MC/pedestal_rms from CCDB!" << endl;
    } else {
       FCAL_PED_RMS = FCAL_PED_RMS_TEMP;
@@ -57,7 +57,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
 	
    cout<<"get FCAL/MC/integral_peak_ratio from calibDB"<<endl;
    double FCAL_INT_PEAK_TEMP;
-   if(loop->GetCalib("FCAL/MC/integral_peak_ratio", FCAL_INT_PEAK_TEMP)) {
+   if(CalibSnapshot::GetCalib(loop, "FCAL/MC/integral_peak_ratio", FCAL_INT_PEAK_TEMP)) {
       jerr << "Problem loading FCAL/MC/integral_peak_ratio from CCDB!" << endl;
    } else {
       FCAL_INTEGRAL_PEAK = FCAL_INT_PEAK_TEMP;
@@ -65,7 +65,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
    
    cout<<"get FCAL/MC/threshold from calibDB"<<endl;
    double FCAL_THRESHOLD_TEMP;
-   if(loop->GetCalib("FCAL/MC/threshold", FCAL_THRESHOLD_TEMP)) {
+   if(CalibSnapshot::GetCalib(loop, "FCAL/MC/threshold", FCAL_THRESHOLD_TEMP)) {
       jerr << "Problem loading FCAL/MC/threshold from CCDB!" << endl;
    } else {
       FCAL_THRESHOLD = FCAL_THRESHOLD_TEMP;
@@ -73,7 +73,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
    
    cout<<"get FCAL/MC/threhsold_scaling from calibDB"<<endl;
    double FCAL_THRESHOLD_SCALING_TEMP;
-   if(loop->GetCalib("FCAL/MC/threshold_scaling", FCAL_THRESHOLD_SCALING_TEMP)) {
+   if(CalibSnapshot::GetCalib(loop, "FCAL/MC/threshold_scaling", FCAL_THRESHOLD_SCALING_TEMP)) {
        jerr << "Problem loading FCAL/MC/threshold_scaling from CCDB!" << endl;
    } else {
        FCAL_THRESHOLD_SCALING = FCAL_THRESHOLD_SCALING_TEMP;
@@ -81,7 +81,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
 
    cout<<"get FCAL/MC/mc_escale from calibDB"<<endl;
    double FCAL_MC_ESCALE_TEMP;
-   if(loop->GetCalib("FCAL/MC/mc_escale", FCAL_MC_ESCALE_TEMP)) {
+   if(CalibSnapshot::GetCalib(loop, "FCAL/MC/mc_escale", FCAL_MC_ESCALE_TEMP)) {
         jerr << "Problem loading FCAL/MC/mc_escale from CCDB!" << endl;
    } else {
         FCAL_MC_ESCALE = FCAL_MC_ESCALE_TEMP;
@@ -89,7 +89,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
 
     cout<<"get FCAL/MC/energy_width_floor from calibDB"<<endl;
     double FCAL_ENERGY_WIDTH_FLOOR_TEMP;
-    if(loop->GetCalib("FCAL/MC/energy_width_floor", FCAL_ENERGY_WIDTH_FLOOR_TEMP)) {
+    if(CalibSnapshot::GetCalib(loop, "FCAL/MC/energy_width_floor", FCAL_ENERGY_WIDTH_FLOOR_TEMP)) {
         jerr << "Problem loading FCAL/MC/energy_width_floor from CCDB!" << endl;
     } else {
         FCAL_ENERGY_WIDTH_FLOOR = FCAL_ENERGY_WIDTH_FLOOR_TEMP;
@@ -97,7 +97,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
 
     cout<<"get FCAL/digi_scales parameters from calibDB"<<endl;
     map<string, double> fcaldigiscales;
-    if(loop->GetCalib("FCAL/MC/digi_scales", fcaldigiscales)) {
+    if(CalibSnapshot::GetCalib(loop, "FCAL/MC/digi_scales", fcaldigiscales)) {
     	jerr << "Problem loading FCAL/MC/digi_scales from CCDB!" << endl;
     } else {
         FCAL_ADC_ASCALE = fcaldigiscales["FCAL_ADC_ASCALE"];
@@ -105,7 +105,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
 
     cout<<"get FCAL/mc_timing_smear parameters from calibDB"<<endl;
     map<string, double> fcalmctimingsmear;
-    if(loop->GetCalib("FCAL/mc_timing_smear", fcalmctimingsmear)) {
+    if(CalibSnapshot::GetCalib(loop, "FCAL/mc_timing_smear", fcalmctimingsmear)) {
     	jerr << "Problem loading FCAL/mc_timing_smear from CCDB!" << endl;
     } else {
         FCAL_TSIGMA = fcalmctimingsmear["FCAL_TSIGMA"];
@@ -121,7 +121,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
     // load efficiencies from CCDB and fill 
     vector<double> raw_table;
 
-    if(loop->GetCalib("FCAL/block_mc_efficiency", raw_table)) {
+    if(CalibSnapshot::GetCalib(loop, "FCAL/block_mc_efficiency", raw_table)) {
       jerr << "Problem loading FCAL/block_mc_efficiency from CCDB!" << endl;
     } else {
       for (int channel=0; channel < static_cast<int>(raw_table.size()); channel++) {
@@ -139,7 +139,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
 
     int primex_run = 0;
 
-    if (loop->GetCalib("/PHOTON_BEAM/pair_spectrometer/experiment", primex_run))
+    if (CalibSnapshot::GetCalib(loop, "/PHOTON_BEAM/pair_spectrometer/experiment", primex_run))
       jerr << "Problem loading /PHOTON_BEAM/pair_spectrometer/experment/run from CCDB!" << endl;
 
 
@@ -150,7 +150,7 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
       int BAD_CH = 1;
       
       
-      if (loop->GetCalib("/FCAL/block_quality", raw_block_qualities))
+      if (CalibSnapshot::GetCalib(loop, "/FCAL/block_quality", raw_block_qualities))
 	jout << "/FCAL/block_quality not used for this run" << endl;
       else {
 	
@@ -165,7 +165,49 @@ fcal_config_t::fcal_config_t(JEventLoop *loop, const DFCALGeometry *fcalGeom)
       }
     } 
                   
+
+    CalcDerivedConstants(fcalGeom);
 }
+
+//-----------
+// CalcDerivedConstants
+//-----------
+void fcal_config_t::CalcDerivedConstants(const DFCALGeometry *fcalGeom)
+{
+   // per-block constants, with no threshold and the nominal 8 GeV range
+   // for blocks whose gain or pedestal could not be loaded
+   blocks.resize(DFCALGeometry::kBlocksTall * DFCALGeometry::kBlocksWide);
+   for (int row=0; row < DFCALGeometry::kBlocksTall; row++) {
+      for (int column=0; column < DFCALGeometry::kBlocksWide; column++) {
+         block_t &block = blocks[row * DFCALGeometry::kBlocksWide + column];
+         block.active = fcalGeom->isBlockActive(row, column);
+         block.efficiency = block_efficiencies[row][column];
+         block.threshold_scale = 0;
+         block.threshold_offset = 0;
+         block.Erange = 0;
+         if (!block.active)
+            continue;
+
+         // per block gain constant and pedestal
+         int channelnum = fcalGeom->channel(row, column); 
+         if (channelnum < 0 || channelnum >= (int)FCAL_GAINS.size() ||
+             channelnum >= (int)FCAL_PEDS.size())
+         {
+            block.Erange = 8.0;
+            continue;
+         }
+         double FCAL_gain = FCAL_GAINS[channelnum];      
+         double pedestal = FCAL_PEDS[channelnum];
+         block.threshold_scale = FCAL_gain*FCAL_INTEGRAL_PEAK*FCAL_ADC_ASCALE;
+         block.threshold_offset = FCAL_THRESHOLD*FCAL_THRESHOLD_SCALING - pedestal;
+         block.Erange = 8.0 * FCAL_gain;
+      }
+   }
+
+   sigEstat2 = pow(FCAL_PHOT_STAT_COEF,2);
+   sigEfloor2 = pow(FCAL_ENERGY_WIDTH_FLOOR,2);
+}
+
 	
 //-----------
 // SmearEvent
@@ -186,47 +228,51 @@ void FCALSmearer::SmearEvent(hddm_s::HDDM *record)
    //if (!fcalGeom)
    //   fcalGeom = new DFCALGeometry();
 
+   // Noise for all hits of the event, drawn in one block
+   size_t nthits = record->getFcalTruthHits().size();
+   DRandomBuffer noise((config->SMEAR_HITS ? 3 : 1) * nthits,
+                       config->APPLY_EFFICIENCY_CORRECTIONS ? nthits : 0);
+
    hddm_s::FcalBlockList blocks = record->getFcalBlocks();
    hddm_s::FcalBlockList::iterator iter;
    for (iter = blocks.begin(); iter != blocks.end(); ++iter) {
       iter->deleteFcalHits();
       hddm_s::FcalTruthHitList thits = iter->getFcalTruthHits();
       hddm_s::FcalTruthHitList::iterator titer;
+
+      int row=iter->getRow();
+      int column=iter->getColumn();
+
+      // constants for this block, if it is one of the lead glass blocks
+      const fcal_config_t::block_t *block = NULL;
+      if (row>=0 && row<DFCALGeometry::kBlocksTall && column>=0 && column<DFCALGeometry::kBlocksWide)
+         block = &fcal_config->blocks[row*DFCALGeometry::kBlocksWide + column];
+
+      // Simulation simulates a grid of blocks for simplicity. 
+      // Do not bother smearing inactive blocks. They will be
+      // discarded in DEventSourceHDDM.cc while being read in
+      // anyway.
+      bool active = block ? block->active : fcalGeom->isBlockActive(row, column);
+
       for (titer = thits.begin(); titer != thits.end(); ++titer) {
-	int row=iter->getRow();
-	int column=iter->getColumn();
-
-         // Simulation simulates a grid of blocks for simplicity. 
-         // Do not bother smearing inactive blocks. They will be
-         // discarded in DEventSourceHDDM.cc while being read in
-         // anyway.
-         if (!fcalGeom->isBlockActive(row, column))
+         if (!active)
             continue;
 
 	 double E = titer->getE();
 	 double Ethreshold=fcal_config->FCAL_BLOCK_THRESHOLD;
-	 double sigEfloor=fcal_config->FCAL_ENERGY_WIDTH_FLOOR;
-	 double sigEstat=fcal_config->FCAL_PHOT_STAT_COEF;
+	 double sigEfloor2, sigEstat2;
 	 double Erange = 8.0;
          
-	 if (row<DFCALGeometry::kBlocksTall&&column<DFCALGeometry::kBlocksWide){
+	 if (block){
 	   // correct simulation efficiencies 
 	   if (config->APPLY_EFFICIENCY_CORRECTIONS
-	       && !gDRandom.DecideToAcceptHit(fcal_config->GetEfficiencyCorrectionFactor(row, column))) {
+	       && !noise.DecideToAcceptHit(block->efficiency)) {
 	     continue;
 	   } 
 	 
-	   // Get gain constant per block	      
-	   int channelnum = fcalGeom->channel(row, column); 
-	   double FCAL_gain = fcal_config->FCAL_GAINS.at(channelnum);      
-	   double pedestal_rms = fcal_config->FCAL_PED_RMS;
-	   double integral_peak = fcal_config->FCAL_INTEGRAL_PEAK;
-	   double MeV_FADC = fcal_config->FCAL_ADC_ASCALE;
-	   double pedestal = fcal_config->FCAL_PEDS.at(channelnum);
-	   double threshold = fcal_config->FCAL_THRESHOLD;
-	   double threshold_scaling = fcal_config->FCAL_THRESHOLD_SCALING;
-	   Ethreshold=FCAL_gain*integral_peak*MeV_FADC*(threshold*threshold_scaling - pedestal+gDRandom.SampleGaussian(pedestal_rms));
-	   Erange *= FCAL_gain;
+	   // Threshold and range scaled by the gain of the block
+	   Ethreshold=block->threshold_scale*(block->threshold_offset+noise.SampleGaussian(fcal_config->FCAL_PED_RMS));
+	   Erange = block->Erange;
 	   
 	   if(fcal_config->FCAL_ADD_LIGHTGUIDE_HITS) {
 	     hddm_s::FcalTruthLightGuideList lghits = titer->getFcalTruthLightGuides();
@@ -237,22 +283,25 @@ void FCALSmearer::SmearEvent(hddm_s::HDDM *record)
 	   }
 	   // Apply constant scale factor to MC energy. 06/22/2016 A. Subedi
 	   E *= fcal_config->FCAL_MC_ESCALE;
+
+	   sigEfloor2=fcal_config->sigEfloor2;
+	   sigEstat2=fcal_config->sigEstat2;
 	 }
 	 else { // deal with insert
-	   sigEfloor=fcal_config->INSERT_ENERGY_WIDTH_FLOOR;
-	   sigEstat=fcal_config->INSERT_PHOT_STAT_COEF;
+	   sigEfloor2=pow(fcal_config->INSERT_ENERGY_WIDTH_FLOOR,2);
+	   sigEstat2=pow(fcal_config->INSERT_PHOT_STAT_COEF,2);
 	 }
          
          double t = titer->getT(); 
 
          if(config->SMEAR_HITS) {
 	   // Smear the timing and energy of the hit
-	   t += gDRandom.SampleGaussian(fcal_config->FCAL_TSIGMA);
+	   t += noise.SampleGaussian(fcal_config->FCAL_TSIGMA);
 	   
 	   // Energy width has stochastic and floor terms
-	   double sigma = sqrt( pow(sigEstat,2)/titer->getE() 
-			     + pow(sigEfloor,2));
-	   E *= (1.0 + gDRandom.SampleGaussian(sigma));
+	   double sigma = sqrt( sigEstat2/titer->getE() 
+			     + sigEfloor2);
+	   E *= (1.0 + noise.SampleGaussian(sigma));
 	 }
 	 	 
 	 if (E > Erange)
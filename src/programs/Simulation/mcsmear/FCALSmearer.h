@@ -35,6 +35,25 @@ class fcal_config_t
 	double GetEfficiencyCorrectionFactor(double row, double column) {
 		return block_efficiencies.at(row).at(column);
 	}
+
+	// Constants derived from the ones above for the hit loop, once per
+	// run by CalcDerivedConstants, one entry per lead glass block
+	// indexed by row*kBlocksWide + column. They are computed with the
+	// same operations in the same order as the loop used to, so the
+	// smeared hits do not change. A block whose gain or pedestal is
+	// missing, because FCAL/gains or FCAL/pedestals could not be loaded,
+	// gets no threshold and the nominal range instead.
+	struct block_t {
+		bool active;
+		double efficiency;
+		double threshold_scale;    // gain * integral/peak * ADC scale
+		double threshold_offset;   // threshold * scaling - pedestal
+		double Erange;             // 8 GeV * gain
+	};
+	vector<block_t> blocks;
+	double sigEstat2, sigEfloor2;   // squared resolution terms, lead glass
+
+	void CalcDerivedConstants(const DFCALGeometry *fcalGeom);
 };
 
 
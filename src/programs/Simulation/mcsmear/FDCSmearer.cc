@@ -24,7 +24,7 @@ fdc_config_t::fdc_config_t(JEventLoop *loop)
 	// load data from CCDB
 	cout << "Get FDC/fdc_parms parameters from CCDB..." << endl;
     map<string, double> fdcparms;
-     if(loop->GetCalib("FDC/fdc_parms", fdcparms)) {
+     if(CalibSnapshot::GetCalib(loop, "FDC/fdc_parms", fdcparms)) {
      	jerr << "Problem loading FDC/fdc_parms from CCDB!" << endl;
      } else {
        	FDC_TDRIFT_SIGMA      = fdcparms["FDC_TDRIFT_SIGMA"];
@@ -49,13 +49,13 @@ fdc_config_t::fdc_config_t(JEventLoop *loop)
 
 		char ccdb_str[100];
 		sprintf(ccdb_str, "/FDC/package%d/strip_mc_efficiency", package);
-    	if(loop->GetCalib(ccdb_str, new_strip_efficiencies)) {
+    	if(CalibSnapshot::GetCalib(loop, ccdb_str, new_strip_efficiencies)) {
         	stringstream err_ss;
         	err_ss << "Error loading " << ccdb_str << " !";
         	throw JException(err_ss.str());
         }
 		sprintf(ccdb_str,"/FDC/package%d/wire_mc_efficiency", package);
-    	if(loop->GetCalib(ccdb_str, new_wire_efficiencies)) {
+    	if(CalibSnapshot::GetCalib(loop, ccdb_str, new_wire_efficiencies)) {
         	stringstream err_ss;
         	err_ss << "Error loading " << ccdb_str << " !";
         	throw JException(err_ss.str());
@@ -83,6 +83,12 @@ void FDCSmearer::SmearEvent(hddm_s::HDDM *record)
    double t_max = config->TRIGGER_LOOKBACK_TIME + fdc_config->FDC_TIME_WINDOW;
    double threshold = fdc_config->FDC_THRESHOLD_FACTOR * fdc_config->FDC_PED_NOISE; // for sparsification
 
+   // Noise for all hits of the event, drawn in one block
+   size_t nstrip = record->getFdcCathodeTruthHits().size();
+   size_t nwire = record->getFdcAnodeTruthHits().size();
+   DRandomBuffer noise(config->SMEAR_HITS ? 2*nstrip + nwire : 0,
+                       config->APPLY_EFFICIENCY_CORRECTIONS ? nstrip + 2*nwire : 0);
+
    hddm_s::FdcChamberList chambers = record->getFdcChambers();
    hddm_s::FdcChamberList::iterator iter;
    for (iter = chambers.begin(); iter != chambers.end(); ++iter) {
@@ -99,14 +105,14 @@ void FDCSmearer::SmearEvent(hddm_s::HDDM *record)
           for (titer = thits.begin(); titer != thits.end(); ++titer) {
             // correct simulation efficiencies 
             if (config->APPLY_EFFICIENCY_CORRECTIONS
-                  && !gDRandom.DecideToAcceptHit(fdc_config->GetEfficiencyCorrectionFactor(siter)))
+                  && !noise.DecideToAcceptHit(fdc_config->GetEfficiencyCorrectionFactor(siter)))
               	continue;
           
             double q = titer->getQ();
             double t = titer->getT();
           	if(config->SMEAR_HITS) {
-             	q += gDRandom.SampleGaussian(fdc_config->FDC_PED_NOISE);
-             	t += gDRandom.SampleGaussian(fdc_config->FDC_TDRIFT_SIGMA)*1.0e9;
+             	q += noise.SampleGaussian(fdc_config->FDC_PED_NOISE);
+             	t += noise.SampleGaussian(fdc_config->FDC_TDRIFT_SIGMA)*1.0e9;
 			}
             if (q > threshold && t > config->TRIGGER_LOOKBACK_TIME && t < t_max) {
                hddm_s::FdcCathodeHitList hits = siter->addFdcCathodeHits();
@@ -130,16 +136,16 @@ void FDCSmearer::SmearEvent(hddm_s::HDDM *record)
          for (titer = thits.begin(); titer != thits.end(); ++titer) {
              // correct simulation efficiencies 
 		     if (config->APPLY_EFFICIENCY_CORRECTIONS
-             		&& !gDRandom.DecideToAcceptHit(fdc_config->GetEfficiencyCorrectionFactor(witer)))
+             		&& !noise.DecideToAcceptHit(fdc_config->GetEfficiencyCorrectionFactor(witer)))
              		continue;
             double doca = titer->getD();
             if (config->APPLY_EFFICIENCY_CORRECTIONS
-                    && !gDRandom.DecideToAcceptHit(fdc_config->GetEfficiencyVsDOCA(doca)))
+                    && !noise.DecideToAcceptHit(fdc_config->GetEfficiencyVsDOCA(doca)))
                continue;
 
             double t = titer->getT();
           	if(config->SMEAR_HITS) {
-               t += gDRandom.SampleGaussian(fdc_config->FDC_TDRIFT_SIGMA)*1.0e9;
+               t += noise.SampleGaussian(fdc_config->FDC_TDRIFT_SIGMA)*1.0e9;
             }
             if (t > config->TRIGGER_LOOKBACK_TIME && t < t_max) {
                hddm_s::FdcAnodeHitList hits = witer->addFdcAnodeHits();
@@ -8,6 +8,7 @@
 #include <cmath>
 #include <vector>
 #include <map>
+#include <mutex>
 
 using namespace std;
 
@@ -15,6 +16,11 @@ using namespace std;
 
 #include "MyProcessor.h"
 #include "hddm_s_merger.h"
+#include "DEventSourceHDDMOrdered.h"
+#include "OrderedSection.h"
+#include "NoisePrefetcher.h"
+#include "NoiseLibrary.h"
+#include "CalibSnapshot.h"
 
 #include <JANA/JEvent.h>
 
@@ -25,14 +31,39 @@ using namespace std;
 #include <FDCSmearer.h>
 
 extern char *OUTFILENAME;
-extern std::map<hddm_s::istream*,double> files2merge;
-extern std::map<hddm_s::istream*,hddm_s::streamposition> start2merge;
-extern std::map<hddm_s::istream*,int> skip2merge;
+extern std::map<NoisePrefetcher*,double> files2merge;
+extern std::map<NoiseLibrary*,double> libraries2merge;
 
 static pthread_mutex_t output_file_mutex;
 static pthread_t output_file_mutex_last_owner;
-static pthread_mutex_t input_file_mutex;
-static pthread_t input_file_mutex_last_owner;
+
+// Held for reading while an event is smeared and merged, and for
+// writing by brun while it replaces the smearer and resets the
+// merger parameters.
+static pthread_rwlock_t smearer_rwlock;
+
+// Stages of MyProcessor::evnt that must see the events in input
+// order: taking events from the noise files and writing the output.
+static OrderedSection merge_section;
+static OrderedSection output_section;
+
+// Run number of the last event to take events from the noise files,
+// which are started over at the first event of every run.
+static std::mutex merge_run_mutex;
+static int32_t merge_run_number = 0;
+static bool merge_run_started = false;
+
+//-----------
+// mcsmear_release_event
+//-----------
+void mcsmear_release_event(uint64_t seq)
+{
+   // Called by DEventSourceHDDMOrdered when an event is freed so
+   // that events which skipped the ordered stages in evnt do not
+   // block the ones that come after them.
+   merge_section.Release(seq);
+   output_section.Release(seq);
+}
 
 #include <JANA/JCalibration.h>
 //static JCalibration *jcalib=NULL;
@@ -139,7 +170,7 @@ jerror_t MyProcessor::init(void)
    pthread_mutexattr_init(&attr);
    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ERRORCHECK);
    pthread_mutex_init(&output_file_mutex, NULL);
-   pthread_mutex_init(&input_file_mutex, NULL);
+   pthread_rwlock_init(&smearer_rwlock, NULL);
    
    // pthreads does not provide an "invalid" value for 
    // a pthread_t that we can initialize with. Furthermore,
@@ -147,7 +178,6 @@ jerror_t MyProcessor::init(void)
    // a complicated structure. Hence, to make this portable
    // we clear it with bzero.
    bzero(&output_file_mutex_last_owner, sizeof(pthread_t));
-   bzero(&input_file_mutex_last_owner, sizeof(pthread_t));
    
    // By default, the empirical fdc DOCA-dependent efficiency
    // is applied to fdc wire hits in FDCSmearer. This can be
@@ -157,6 +187,44 @@ jerror_t MyProcessor::init(void)
                           " \"0\"=no efficiency correction,"
                           " \"1\"=standard efficiency correction (default)");
 
+   // Events from the noise files are decoded ahead of time by one
+   // reader thread per file, this sets how many each keeps ready.
+   int NOISE_PREFETCH_DEPTH = 200;
+   gPARMS->SetDefaultParameter("MCSMEAR:NOISE_PREFETCH_DEPTH",
+                               NOISE_PREFETCH_DEPTH,
+                          "Number of events from each noise file to read"
+                          " ahead of the event loop (default 200)");
+   std::map<NoisePrefetcher*,double>::iterator noise;
+   for (noise = files2merge.begin(); noise != files2merge.end(); ++noise)
+      noise->first->Start(NOISE_PREFETCH_DEPTH);
+
+   NOISE_LIBRARY_SEED = 1;
+   gPARMS->SetDefaultParameter("MCSMEAR:NOISE_LIBRARY_SEED",
+                               NOISE_LIBRARY_SEED,
+                          "Random seed used to choose which events are kept"
+                          " when a preloaded noise file exceeds its memory cap");
+
+   // CCDB tables read by the smearers are kept for each run, and can
+   // also be saved to a file so that later jobs need not query CCDB.
+   string CALIB_SNAPSHOT = "";
+   gPARMS->SetDefaultParameter("MCSMEAR:CALIB_SNAPSHOT", CALIB_SNAPSHOT,
+                          "File in which to keep the calibration tables used"
+                          " for each run, read back by later jobs (default none)");
+   if (CALIB_SNAPSHOT.size() > 0)
+      CalibSnapshot::SetFile(CALIB_SNAPSHOT);
+
+   // Random number seeding depends on whether events are processed
+   // by more than one thread, see Smear::GetAndSetSeeds.
+   if (gPARMS->Exists("NTHREADS")) {
+      string nthreads;
+      gPARMS->GetParameter("NTHREADS", nthreads);
+      config->NTHREADS = (nthreads == "Ncores")? 0 : atoi(nthreads.c_str());
+   }
+   if (config->NTHREADS != 1) {
+      jout << " Smearing with multiple threads, output is written"
+           << " in input order" << std::endl;
+   }
+
    return NOERROR;
 }
 
@@ -174,6 +242,7 @@ jerror_t MyProcessor::brun(JEventLoop *loop, int locRunNumber)
     if(locCheckCCDBContext) {
         // only do this once
         locCheckCCDBContext = false;        
+        pthread_rwlock_wrlock(&smearer_rwlock);
 
         // load the CCDB context
         DApplication* locDApp = dynamic_cast<DApplication*>(japp);
@@ -191,23 +260,32 @@ jerror_t MyProcessor::brun(JEventLoop *loop, int locRunNumber)
         }
 
         std::map<string, float> parms;
-        jcalib->Get("TOF/tof_parms", parms);
+        CalibSnapshot::GetCalib(loop, "TOF/tof_parms", parms);
         hddm_s_merger::set_ftof_min_delta_t_ns(parms.at("TOF_TWO_HIT_RESOL"));
-        jcalib->Get("FDC/fdc_parms", parms);
+        CalibSnapshot::GetCalib(loop, "FDC/fdc_parms", parms);
         hddm_s_merger::set_fdc_wires_min_delta_t_ns(parms.at("FDC_TWO_HIT_RESOL"));
-        jcalib->Get("START_COUNTER/start_parms", parms);
+        CalibSnapshot::GetCalib(loop, "START_COUNTER/start_parms", parms);
         hddm_s_merger::set_stc_min_delta_t_ns(parms.at("START_TWO_HIT_RESOL"));
-        jcalib->Get("BCAL/bcal_parms", parms);
+        CalibSnapshot::GetCalib(loop, "BCAL/bcal_parms", parms);
         hddm_s_merger::set_bcal_min_delta_t_ns(parms.at("BCAL_TWO_HIT_RESOL"));
-        jcalib->Get("FCAL/fcal_parms", parms);
+        CalibSnapshot::GetCalib(loop, "FCAL/fcal_parms", parms);
         hddm_s_merger::set_fcal_min_delta_t_ns(parms.at("FCAL_TWO_HIT_RESOL"));
+        pthread_rwlock_unlock(&smearer_rwlock);
     }
    
+	// wait for other threads to finish smearing and merging
+	// before swapping out the configuration they are using
+	pthread_rwlock_wrlock(&smearer_rwlock);
 
 	// load configuration parameters for all the detectors
 	if(smearer != NULL)
 		delete smearer;
 	smearer = new Smear(config, loop, config->DETECTORS_TO_LOAD);
+	CalibSnapshot::Save();
+
+	if(config->MERGE_TAGGER_HITS == false) {
+		hddm_s_merger::set_tag_merging(false);
+	}
 
 #ifdef HAVE_RCDB
 	// Pull configuration parameters from RCDB
@@ -446,23 +524,16 @@ jerror_t MyProcessor::brun(JEventLoop *loop, int locRunNumber)
 
 #endif  // HAVE_RCDB
 
-    // fast forward any merger input files over skipped events
-    std::map<hddm_s::istream*,hddm_s::streamposition>::iterator iter;
-    for (iter = start2merge.begin(); iter != start2merge.end(); ++iter) {
-        hddm_s::HDDM record2;
-
-        iter->first->setPosition(start2merge.at(iter->first));
-        iter->first->skip(skip2merge[iter->first]);
-          
-		if (!(*iter->first >> record2)) {
-			std::cerr << "Trying to merge from empty input file, "
-					  << "cannot continue!" << std::endl;
-			exit(-1);
-		}
-
-        skip2merge[iter->first] = 0;
+    // preloaded noise files are read in once the merging parameters
+    // are known, since only the hits that would be merged are kept
+    std::map<NoiseLibrary*,double>::iterator lib;
+    for (lib = libraries2merge.begin(); lib != libraries2merge.end(); ++lib) {
+        if (!lib->first->IsLoaded())
+            lib->first->Load(NOISE_LIBRARY_SEED);
     }
 
+    pthread_rwlock_unlock(&smearer_rwlock);
+
     return NOERROR;
 }
 
@@ -481,7 +552,14 @@ jerror_t MyProcessor::evnt(JEventLoop *loop, uint64_t eventnumber)
    hddm_s::HDDM *record = (hddm_s::HDDM*)event.GetRef();
    if (!record)
       return NOERROR;
+
+   // Position of this event in the input file, used to put the
+   // merging and output stages back into input order
+   uint64_t seq = 0;
+   bool ordered = DEventSourceHDDMOrdered::GetSequenceNumber(event, seq);
  
+   pthread_rwlock_rdlock(&smearer_rwlock);
+
    // Handle geometry records
    hddm_s::GeometryList geom = record->getGeometrys();
    if (geom.size() > 0) {
@@ -499,51 +577,90 @@ jerror_t MyProcessor::evnt(JEventLoop *loop, uint64_t eventnumber)
    // Smear values
    smearer->SmearEvent(record);
 
-   // Load any external events to be merged during smearing
-   std::map<hddm_s::istream*,double>::iterator iter;
-   for (iter = files2merge.begin(); iter != files2merge.end(); ++ iter) {
-      int count = iter->second;
-      if (count != iter->second) {
-         count = gDRandom.Poisson(iter->second);
-      }
-      for (int i=0; i < count; ++i) {
-         hddm_s::HDDM record2;
-         if (!(*iter->first >> record2)) {
-            //pthread_mutex_lock(&input_file_mutex);
-            //input_file_mutex_last_owner = pthread_self();
-            iter->first->setPosition(start2merge.at(iter->first));
-            if (!(*iter->first >> record2)) {
-               //pthread_mutex_unlock(&input_file_mutex);
-               std::cerr << "Trying to merge from empty input file, "
-                         << "cannot continue!" << std::endl;
-               exit(-1);
-            }
-            //pthread_mutex_unlock(&input_file_mutex);
+   pthread_rwlock_unlock(&smearer_rwlock);
+
+   // Take any external events to be merged during smearing. They are
+   // taken in input order so every event is merged with the same
+   // background as in a single-threaded run.
+   std::vector<std::pair<NoisePrefetcher*, hddm_s::HDDM*> > records2;
+   if (files2merge.size() > 0) {
+      if (ordered)
+         merge_section.Enter(seq);
+      std::map<NoisePrefetcher*,double>::iterator iter;
+
+      // Go back to the start of the noise files, fast forwarded over
+      // any skipped events, at the first event of each run in input
+      // order. This is done here rather than in brun, which is called
+      // by whichever thread first sees the new run, while events of
+      // the old run may still be waiting to take their background.
+      {
+         std::lock_guard<std::mutex> lock(merge_run_mutex);
+         int32_t runnumber = event.GetRunNumber();
+         if (!merge_run_started || runnumber != merge_run_number) {
+            for (iter = files2merge.begin(); iter != files2merge.end(); ++iter)
+               iter->first->Rewind();
+            merge_run_number = runnumber;
+            merge_run_started = true;
          }
-         
-         if(config->MERGE_TAGGER_HITS == false) {
-         	hddm_s_merger::set_tag_merging(false);
+      }
+
+      for (iter = files2merge.begin(); iter != files2merge.end(); ++ iter) {
+         int count = iter->second;
+         if (count != iter->second) {
+            count = gDRandom.Poisson(iter->second);
          }
-         hddm_s_merger::set_t_shift_ns(0);
-         hddm_s::RFsubsystemList RFtimes = record2.getRFsubsystems();
-         hddm_s::RFsubsystemList::iterator RFiter;
-         for (RFiter = RFtimes.begin(); RFiter != RFtimes.end(); ++RFiter)
-            if (RFiter->getJtag() == "TAGH")
-               hddm_s_merger::set_t_shift_ns(-RFiter->getTsync());
-         *record += record2;
+         for (int i=0; i < count; ++i)
+            records2.push_back(std::make_pair(iter->first, iter->first->Take()));
+      }
+      if (ordered)
+         merge_section.Leave(seq);
+   }
+
+   pthread_rwlock_rdlock(&smearer_rwlock);
+
+   // Preloaded noise events are picked at random using the event's
+   // own random stream, so no ordering between threads is needed.
+   std::map<NoiseLibrary*,double>::iterator lib;
+   for (lib = libraries2merge.begin(); lib != libraries2merge.end(); ++lib) {
+      int count = lib->second;
+      if (count != lib->second) {
+         count = gDRandom.Poisson(lib->second);
+      }
+      for (int i=0; i < count; ++i) {
+         size_t ievent = gDRandom.Integer(lib->first->GetSize());
+         hddm_s_merger::set_t_shift_ns(lib->first->GetTimeShift(ievent));
+         *record += lib->first->GetEvent(ievent);
       }
    }
 
+   for (size_t i=0; i < records2.size(); ++i) {
+      hddm_s::HDDM &record2 = *records2[i].second;
+      hddm_s_merger::set_t_shift_ns(0);
+      hddm_s::RFsubsystemList RFtimes = record2.getRFsubsystems();
+      hddm_s::RFsubsystemList::iterator RFiter;
+      for (RFiter = RFtimes.begin(); RFiter != RFtimes.end(); ++RFiter)
+         if (RFiter->getJtag() == "TAGH")
+            hddm_s_merger::set_t_shift_ns(-RFiter->getTsync());
+      *record += record2;
+      records2[i].first->Recycle(records2[i].second);
+   }
+
    // Apply DAQ truncation to hit lists
    if (config->APPLY_HITS_TRUNCATION)
       hddm_s_merger::truncate_hits(*record);
 
-   // Write event to output file
-   //pthread_mutex_lock(&output_file_mutex);
-   //output_file_mutex_last_owner = pthread_self();
+   pthread_rwlock_unlock(&smearer_rwlock);
+
+   // Write event to output file, in the order the events were read
+   if (ordered)
+      output_section.Enter(seq);
+   pthread_mutex_lock(&output_file_mutex);
+   output_file_mutex_last_owner = pthread_self();
    *fout << *record;
    Nevents_written++;
-   //pthread_mutex_unlock(&output_file_mutex);
+   pthread_mutex_unlock(&output_file_mutex);
+   if (ordered)
+      output_section.Leave(seq);
 
    return NOERROR;
 }
@@ -553,6 +670,10 @@ jerror_t MyProcessor::evnt(JEventLoop *loop, uint64_t eventnumber)
 //------------------------------------------------------------------
 jerror_t MyProcessor::fini(void)
 {
+   std::map<NoisePrefetcher*,double>::iterator iter;
+   for (iter = files2merge.begin(); iter != files2merge.end(); ++iter)
+      iter->first->Stop();
+
    if (fout)
       delete fout;
    if (ofs) {
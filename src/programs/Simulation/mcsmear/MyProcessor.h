@@ -44,6 +44,7 @@ class MyProcessor:public JEventProcessor
    private:
       int  HDDM_USE_COMPRESSION;
       bool HDDM_USE_INTEGRITY_CHECKS;
+      unsigned int NOISE_LIBRARY_SEED;
       
       mcsmear_config_t *config;
       Smear *smearer;
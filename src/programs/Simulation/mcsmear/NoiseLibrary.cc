@@ -0,0 +1,118 @@
+// NoiseLibrary.cc
+//
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "NoiseLibrary.h"
+#include "hddm_s_merger.h"
+
+//-----------
+// NoiseLibrary (constructor)
+//-----------
+NoiseLibrary::NoiseLibrary(const std::string &fname, int nskip, double maxMB)
+ : filename(fname), skip(nskip), max_MB(maxMB), loaded(false)
+{
+}
+
+//-----------
+// NoiseLibrary (destructor)
+//-----------
+NoiseLibrary::~NoiseLibrary()
+{
+   for (size_t i=0; i < pool.size(); ++i)
+      delete pool[i].hits;
+}
+
+//-----------
+// Load
+//-----------
+void NoiseLibrary::Load(UInt_t seed)
+{
+   std::ifstream ifs(filename.c_str());
+   if (!ifs.is_open()) {
+      std::cerr << "Error opening noise file " << filename
+                << ", cannot continue!" << std::endl;
+      exit(-1);
+   }
+   hddm_s::istream istr(ifs);
+
+   // the first event is skipped, as when reading the file sequentially
+   hddm_s::HDDM record;
+   istr >> record;
+   istr.skip(skip);
+
+   TRandom2 rand(seed);
+   double MB_start = ResidentMB();
+   size_t capacity = 0;   // pool size once the memory cap is reached
+   size_t nread = 0;
+   while (true) {
+      record.clear();
+      if (!(istr >> record))
+         break;
+      ++nread;
+      if (capacity == 0) {
+         pool.push_back(Compact(record));
+         if (max_MB > 0 && pool.size() % 100 == 0 &&
+             ResidentMB() - MB_start > max_MB)
+         {
+            capacity = pool.size();
+         }
+      }
+      else {
+         // reservoir sampling: keep each event read so far with
+         // equal probability capacity/nread
+         size_t slot = rand.Integer(nread);
+         if (slot < capacity) {
+            delete pool[slot].hits;
+            pool[slot] = Compact(record);
+         }
+      }
+   }
+   if (pool.size() == 0) {
+      std::cerr << "Trying to merge from empty input file "
+                << filename << ", cannot continue!" << std::endl;
+      exit(-1);
+   }
+
+   std::cout << " Loaded " << pool.size() << " of " << nread
+             << " events from noise file " << filename
+             << " into memory" << std::endl;
+   loaded = true;
+}
+
+//-----------
+// Compact
+//-----------
+NoiseLibrary::entry_t NoiseLibrary::Compact(hddm_s::HDDM &record)
+{
+   // Merging into an empty record copies out just the hits,
+   // the time shift is kept aside and applied at merge time.
+   entry_t entry;
+   entry.t_shift_ns = 0;
+   hddm_s::RFsubsystemList RFtimes = record.getRFsubsystems();
+   hddm_s::RFsubsystemList::iterator RFiter;
+   for (RFiter = RFtimes.begin(); RFiter != RFtimes.end(); ++RFiter)
+      if (RFiter->getJtag() == "TAGH")
+         entry.t_shift_ns = -RFiter->getTsync();
+   entry.hits = new hddm_s::HDDM();
+   hddm_s_merger::set_t_shift_ns(0);
+   *entry.hits += record;
+   return entry;
+}
+
+//-----------
+// ResidentMB
+//-----------
+double NoiseLibrary::ResidentMB()
+{
+   // resident set size of this process, zero if it cannot be found
+   std::ifstream statm("/proc/self/statm");
+   long pages_total = 0;
+   long pages_resident = 0;
+   if (!(statm >> pages_total >> pages_resident))
+      return 0;
+   return pages_resident * (sysconf(_SC_PAGESIZE) / 1048576.);
+}
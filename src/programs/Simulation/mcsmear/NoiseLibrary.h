@@ -0,0 +1,56 @@
+// NoiseLibrary.h
+//
+// In-memory pool of background events for mcsmear, used instead of
+// NoisePrefetcher when noise files are preloaded (-p option). The
+// noise file is decoded once, and only the hits that would be
+// merged are kept for each event, together with the RF time shift
+// to apply when merging it. Events are then drawn from the pool at
+// random with replacement. If the pool would grow past its memory
+// cap, reservoir sampling keeps a uniform random subset of the file.
+//
+// Once loaded the pool is only read from, so it can be shared by
+// all processing threads.
+
+#ifndef _NOISELIBRARY_H_
+#define _NOISELIBRARY_H_
+
+#include <string>
+#include <vector>
+
+#include <TRandom2.h>
+#include <HDDM/hddm_s.hpp>
+
+class NoiseLibrary
+{
+   public:
+      NoiseLibrary(const std::string &filename, int skip, double max_MB);
+      ~NoiseLibrary();
+
+      // Read the whole file into the pool. This uses the hits merging
+      // parameters in effect at the time, so call it from brun.
+      void Load(UInt_t seed);
+      bool IsLoaded() const { return loaded; }
+
+      size_t GetSize() const { return pool.size(); }
+      hddm_s::HDDM &GetEvent(size_t i) { return *pool[i].hits; }
+      double GetTimeShift(size_t i) const { return pool[i].t_shift_ns; }
+
+      const std::string &GetFilename() const { return filename; }
+
+   private:
+      struct entry_t {
+         hddm_s::HDDM *hits;
+         double t_shift_ns;
+      };
+
+      entry_t Compact(hddm_s::HDDM &record);
+      static double ResidentMB();
+
+      std::string filename;
+      int skip;
+      double max_MB;
+      bool loaded;
+      std::vector<entry_t> pool;
+};
+
+#endif // _NOISELIBRARY_H_
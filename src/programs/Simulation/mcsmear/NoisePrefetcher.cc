@@ -0,0 +1,182 @@
+// NoisePrefetcher.cc
+//
+
+#include <iostream>
+#include <cstdlib>
+
+#include "NoisePrefetcher.h"
+
+//-----------
+// NoisePrefetcher (constructor)
+//-----------
+NoisePrefetcher::NoisePrefetcher(const std::string &fname, int nskip)
+ : filename(fname), skip(nskip), depth(1), generation(0),
+   stopping(false), empty_file(false)
+{
+   // The start of the file is taken to be just after its first event,
+   // this is where reading resumes each time the file runs out.
+   std::ifstream fin(filename.c_str());
+   hddm_s::istream stin(fin);
+   hddm_s::HDDM record;
+   stin >> record;
+   start = stin.getPosition();
+
+   ifs = new std::ifstream(filename.c_str());
+   istr = new hddm_s::istream(*ifs);
+}
+
+//-----------
+// NoisePrefetcher (destructor)
+//-----------
+NoisePrefetcher::~NoisePrefetcher()
+{
+   Stop();
+   std::deque<hddm_s::HDDM*>::iterator iter;
+   for (iter = ring.begin(); iter != ring.end(); ++iter)
+      delete *iter;
+   for (size_t i=0; i < spares.size(); ++i)
+      delete spares[i];
+   delete istr;
+   delete ifs;
+}
+
+//-----------
+// Start
+//-----------
+void NoisePrefetcher::Start(int ndepth)
+{
+   std::unique_lock<std::mutex> lock(ring_mutex);
+   depth = (ndepth > 0)? ndepth : 1;
+   if (!filler.joinable())
+      filler = std::thread(&NoisePrefetcher::FillLoop, this);
+}
+
+//-----------
+// Stop
+//-----------
+void NoisePrefetcher::Stop()
+{
+   {
+      std::unique_lock<std::mutex> lock(ring_mutex);
+      stopping = true;
+      ring_not_full.notify_all();
+      ring_not_empty.notify_all();
+   }
+   if (filler.joinable())
+      filler.join();
+}
+
+//-----------
+// Rewind
+//-----------
+void NoisePrefetcher::Rewind()
+{
+   std::unique_lock<std::mutex> lock(ring_mutex);
+   ++generation;
+   while (ring.size() > 0) {
+      spares.push_back(ring.front());
+      ring.pop_front();
+   }
+
+   std::unique_lock<std::mutex> stream_lock(stream_mutex);
+   istr->setPosition(start);
+   istr->skip(skip);
+   hddm_s::HDDM record;
+   if (!(*istr >> record)) {
+      std::cerr << "Trying to merge from empty input file "
+                << filename << ", cannot continue!" << std::endl;
+      exit(-1);
+   }
+   skip = 0;
+   ring_not_full.notify_all();
+}
+
+//-----------
+// Take
+//-----------
+hddm_s::HDDM *NoisePrefetcher::Take()
+{
+   std::unique_lock<std::mutex> lock(ring_mutex);
+   while (ring.size() == 0 && !empty_file && !stopping)
+      ring_not_empty.wait(lock);
+   if (ring.size() == 0) {
+      std::cerr << "Trying to merge from empty input file "
+                << filename << ", cannot continue!" << std::endl;
+      exit(-1);
+   }
+   hddm_s::HDDM *record = ring.front();
+   ring.pop_front();
+   ring_not_full.notify_one();
+   return record;
+}
+
+//-----------
+// Recycle
+//-----------
+void NoisePrefetcher::Recycle(hddm_s::HDDM *record)
+{
+   record->clear();
+   std::unique_lock<std::mutex> lock(ring_mutex);
+   spares.push_back(record);
+}
+
+//-----------
+// ReadNext
+//-----------
+bool NoisePrefetcher::ReadNext(hddm_s::HDDM &record)
+{
+   // caller holds stream_mutex
+   if (*istr >> record)
+      return true;
+   istr->setPosition(start);
+   return (*istr >> record);
+}
+
+//-----------
+// FillLoop
+//-----------
+void NoisePrefetcher::FillLoop()
+{
+   while (true) {
+      hddm_s::HDDM *record;
+      unsigned int gen;
+      {
+         std::unique_lock<std::mutex> lock(ring_mutex);
+         while (ring.size() >= depth && !stopping)
+            ring_not_full.wait(lock);
+         if (stopping)
+            return;
+         if (spares.size() > 0) {
+            record = spares.back();
+            spares.pop_back();
+         }
+         else {
+            record = new hddm_s::HDDM();
+         }
+         gen = generation;
+      }
+
+      bool ok;
+      {
+         std::unique_lock<std::mutex> stream_lock(stream_mutex);
+         ok = ReadNext(*record);
+      }
+
+      std::unique_lock<std::mutex> lock(ring_mutex);
+      if (!ok) {
+         empty_file = true;
+         delete record;
+         ring_not_empty.notify_all();
+         return;
+      }
+      else if (gen != generation) {
+         // file was rewound while this event was being read
+         record->clear();
+         spares.push_back(record);
+      }
+      else {
+         ring.push_back(record);
+         ring_not_empty.notify_one();
+      }
+   }
+}
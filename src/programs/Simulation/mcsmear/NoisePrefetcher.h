@@ -0,0 +1,68 @@
+// NoisePrefetcher.h
+//
+// Background reader for one of the noise files given to mcsmear on
+// the command line (noise.hddm:<N>). A dedicated thread decodes the
+// events of the file ahead of time into a bounded ring of HDDM
+// records, starting over from the beginning of the file whenever it
+// runs out, so the event loop never waits on file I/O. Any thread
+// may take events from the ring with Take(), and should hand the
+// record back with Recycle() once it has been merged.
+
+#ifndef _NOISEPREFETCHER_H_
+#define _NOISEPREFETCHER_H_
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <HDDM/hddm_s.hpp>
+
+class NoisePrefetcher
+{
+   public:
+      NoisePrefetcher(const std::string &filename, int skip);
+      ~NoisePrefetcher();
+
+      // Start the reader thread, keeping up to depth events decoded.
+      void Start(int depth);
+      void Stop();
+
+      // Go back to the start of the file, skipping over the events
+      // requested on the command line the first time this is called.
+      // Anything already read ahead is discarded.
+      void Rewind();
+
+      // Next event from the file, blocks until one is available.
+      hddm_s::HDDM *Take();
+      void Recycle(hddm_s::HDDM *record);
+
+      const std::string &GetFilename() const { return filename; }
+
+   private:
+      void FillLoop();
+      bool ReadNext(hddm_s::HDDM &record);
+
+      std::string filename;
+      std::ifstream *ifs;
+      hddm_s::istream *istr;
+      hddm_s::streamposition start;
+      int skip;
+
+      std::thread filler;
+      std::mutex stream_mutex;  // guards ifs, istr
+      std::mutex ring_mutex;    // guards everything below
+      std::condition_variable ring_not_empty;
+      std::condition_variable ring_not_full;
+      std::deque<hddm_s::HDDM*> ring;
+      std::vector<hddm_s::HDDM*> spares;
+      size_t depth;
+      unsigned int generation;
+      bool stopping;
+      bool empty_file;
+};
+
+#endif // _NOISEPREFETCHER_H_
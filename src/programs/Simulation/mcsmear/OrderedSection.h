@@ -0,0 +1,70 @@
+// OrderedSection.h
+//
+// Utility class that lets events being processed concurrently by
+// several JANA threads pass through a critical section strictly in
+// the order they were read from the input file. Each event carries
+// a sequence number assigned by DEventSourceHDDMOrdered. A thread
+// calls Enter(seq) to wait for its turn and Leave(seq) to hand the
+// section on to the next event. Events that will never enter (e.g.
+// they were dropped before reaching MyProcessor::evnt) must be passed
+// to Release(seq) so they do not hold up the events behind them.
+// Calling Release on an event that already left is harmless.
+
+#ifndef _ORDEREDSECTION_H_
+#define _ORDEREDSECTION_H_
+
+#include <stdint.h>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+
+class OrderedSection
+{
+   public:
+      OrderedSection() : next(0) {}
+
+      void Enter(uint64_t seq) {
+         std::unique_lock<std::mutex> lock(mtx);
+         while (seq > next)
+            cv.wait(lock);
+      }
+
+      void Leave(uint64_t seq) {
+         std::unique_lock<std::mutex> lock(mtx);
+         next = seq + 1;
+         Advance();
+         cv.notify_all();
+      }
+
+      void Release(uint64_t seq) {
+         std::unique_lock<std::mutex> lock(mtx);
+         if (seq < next)
+            return;
+         else if (seq == next) {
+            ++next;
+            Advance();
+            cv.notify_all();
+         }
+         else {
+            released.insert(seq);
+         }
+      }
+
+   private:
+      void Advance() {
+         // skip over any events that were released out of turn
+         std::set<uint64_t>::iterator iter = released.begin();
+         while (iter != released.end() && *iter <= next) {
+            if (*iter == next)
+               ++next;
+            released.erase(iter++);
+         }
+      }
+
+      std::mutex mtx;
+      std::condition_variable cv;
+      uint64_t next;
+      std::set<uint64_t> released;
+};
+
+#endif // _ORDEREDSECTION_H_
@@ -33,7 +33,7 @@ sc_config_t::sc_config_t(JEventLoop *loop)
 	// Load data from CCDB
     cout << "Get START_COUNTER/start_parms parameters from CCDB..." << endl;
     map<string, double> startparms;
-    if(loop->GetCalib("START_COUNTER/start_parms", startparms)) {
+    if(CalibSnapshot::GetCalib(loop, "START_COUNTER/start_parms", startparms)) {
 		jerr << "Problem loading START_COUNTER/start_parms from CCDB!" << endl;
 	} else {
      	START_SIGMA = startparms["START_SIGMA"] ;
@@ -41,13 +41,13 @@ sc_config_t::sc_config_t(JEventLoop *loop)
 	}
 	
 	cout<<"get START_COUNTER/paddle_mc_efficiency from calibDB"<<endl;
-    if(loop->GetCalib("START_COUNTER/paddle_mc_efficiency", paddle_efficiencies)) {
+    if(CalibSnapshot::GetCalib(loop, "START_COUNTER/paddle_mc_efficiency", paddle_efficiencies)) {
     	jerr << "Problem loading START_COUNTER/paddle_mc_efficiency from CCDB!" << endl;
     }
 
     // Start counter individual paddle resolutions
     vector< vector<double> > sc_paddle_resolution_params;
-    if(loop->GetCalib("START_COUNTER/TRvsPL", sc_paddle_resolution_params))
+    if(CalibSnapshot::GetCalib(loop, "START_COUNTER/TRvsPL", sc_paddle_resolution_params))
         jout << "Error in loading START_COUNTER/TRvsPL !" << endl;
     else {
         if(sc_paddle_resolution_params.size() != MAX_SECTORS)
@@ -71,7 +71,7 @@ sc_config_t::sc_config_t(JEventLoop *loop)
     }
 
     map<string,double> sc_mc_correction_factors;
-    if(loop->GetCalib("START_COUNTER/mc_time_resol_corr", sc_mc_correction_factors)) {
+    if(CalibSnapshot::GetCalib(loop, "START_COUNTER/mc_time_resol_corr", sc_mc_correction_factors)) {
         jout << "Error in loading START_COUNTER/mc_time_resol_corr !" << endl;
     } else {
         SC_MC_CORRECTION_P0 = sc_mc_correction_factors["P0"];
@@ -131,6 +131,11 @@ void SCSmearer::SmearEvent(hddm_s::HDDM *record)
 {
    hddm_s::StcTruthPointList truthPoints = record->getStcTruthPoints();
         
+   // Noise for all hits of the event, drawn in one block
+   size_t nthits = record->getStcTruthHits().size();
+   DRandomBuffer noise(config->SMEAR_HITS ? 2*nthits : 0,
+                       config->APPLY_EFFICIENCY_CORRECTIONS ? nthits : 0);
+
    hddm_s::StcPaddleList pads = record->getStcPaddles();
    hddm_s::StcPaddleList::iterator iter;
    for (iter = pads.begin(); iter != pads.end(); ++iter) {
@@ -140,7 +145,7 @@ void SCSmearer::SmearEvent(hddm_s::HDDM *record)
       for (titer = thits.begin(); titer != thits.end(); ++titer) {
       	 // correct simulation efficiencies 
 		 if(config->APPLY_EFFICIENCY_CORRECTIONS
-		 	&& !gDRandom.DecideToAcceptHit(sc_config->GetEfficiencyCorrectionFactor(iter->getSector())))
+		 	&& !noise.DecideToAcceptHit(sc_config->GetEfficiencyCorrectionFactor(iter->getSector())))
 		 	continue;
 
          // smear the time
@@ -154,10 +159,10 @@ void SCSmearer::SmearEvent(hddm_s::HDDM *record)
          double t = titer->getT();
          double NewE = titer->getDE();
          if(config->SMEAR_HITS) {
-         	t += gDRandom.SampleGaussian(sc_config->GetPaddleTimeResolution(iter->getSector()-1, z_pos));
+         	t += noise.SampleGaussian(sc_config->GetPaddleTimeResolution(iter->getSector()-1, z_pos));
          	// smear the energy
          	double npe = titer->getDE() * 1000. *  sc_config->START_PHOTONS_PERMEV;
-         	npe = npe +  gDRandom.SampleGaussian(sqrt(npe));
+         	npe = npe +  noise.SampleGaussian(sqrt(npe));
          	NewE = npe/sc_config->START_PHOTONS_PERMEV/1000.;
          }
          if (NewE > sc_config->START_PADDLE_THRESHOLD) {
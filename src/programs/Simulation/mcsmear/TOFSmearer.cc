@@ -27,7 +27,7 @@ tof_config_t::tof_config_t(JEventLoop *loop)
     string locTOFParmsTable = TOFGeom[0]->Get_CCDB_DirectoryName() + "/tof_parms";
     cout<<"Get "<<locTOFParmsTable<<" parameters from CCDB..."<<endl;
     map<string, double> tofparms;
-    if(loop->GetCalib(locTOFParmsTable.c_str(), tofparms)) {
+    if(CalibSnapshot::GetCalib(loop, locTOFParmsTable.c_str(), tofparms)) {
      	jerr << "Problem loading "<<locTOFParmsTable<<" from CCDB!" << endl;
      	return;
     }
@@ -40,7 +40,7 @@ tof_config_t::tof_config_t(JEventLoop *loop)
     string locTOFPaddleResolTable = TOFGeom[0]->Get_CCDB_DirectoryName() + "/paddle_resolutions";
 	cout<<"get "<<locTOFPaddleResolTable<<" from calibDB"<<endl;
     vector <double> TOF_PADDLE_TIME_RESOLUTIONS_TEMP;
-    if(loop->GetCalib(locTOFPaddleResolTable.c_str(), TOF_PADDLE_TIME_RESOLUTIONS_TEMP)) {
+    if(CalibSnapshot::GetCalib(loop, locTOFPaddleResolTable.c_str(), TOF_PADDLE_TIME_RESOLUTIONS_TEMP)) {
     	jerr << "Problem loading "<<locTOFPaddleResolTable<<" from CCDB!" << endl;
     } else {
     	for (unsigned int i = 0; i < TOF_PADDLE_TIME_RESOLUTIONS_TEMP.size(); i++) {
@@ -51,7 +51,7 @@ tof_config_t::tof_config_t(JEventLoop *loop)
 	// load per-channel efficiencies
     string locTOFChannelEffTable = TOFGeom[0]->Get_CCDB_DirectoryName() + "/channel_mc_efficiency";
 	vector<double> raw_table;
-	if(loop->GetCalib(locTOFChannelEffTable.c_str(), raw_table)) {
+	if(CalibSnapshot::GetCalib(loop, locTOFChannelEffTable.c_str(), raw_table)) {
     	jerr << "Problem loading "<<locTOFChannelEffTable<<" from CCDB!" << endl;
     } else {
     	int channel = 0;
@@ -77,7 +77,7 @@ tof_config_t::tof_config_t(JEventLoop *loop)
 	// Load data from CCDB
 	cout<<"Get TOF/tof_parms parameters from CCDB..."<<endl;
 	map<string, double> tofparms;
-	if(loop->GetCalib("TOF/tof_parms", tofparms)) {
+	if(CalibSnapshot::GetCalib(loop, "TOF/tof_parms", tofparms)) {
 	  jerr << "Problem loading TOF/tof_parms from CCDB!" << endl;
 	  return;
 	}
@@ -87,7 +87,7 @@ tof_config_t::tof_config_t(JEventLoop *loop)
 	
 	cout<<"get TOF/paddle_resolutions from calibDB"<<endl;
 	vector <double> TOF_PADDLE_TIME_RESOLUTIONS_TEMP;
-	if(loop->GetCalib("TOF/paddle_resolutions", TOF_PADDLE_TIME_RESOLUTIONS_TEMP)) {
+	if(CalibSnapshot::GetCalib(loop, "TOF/paddle_resolutions", TOF_PADDLE_TIME_RESOLUTIONS_TEMP)) {
 	  jerr << "Problem loading TOF/paddle_resolutions from CCDB!" << endl;
 	} else {
 	  for (unsigned int i = 0; i < TOF_PADDLE_TIME_RESOLUTIONS_TEMP.size(); i++) {
@@ -97,7 +97,7 @@ tof_config_t::tof_config_t(JEventLoop *loop)
 
 	// load per-channel efficiencies
 	vector<double> raw_table;
-	if(loop->GetCalib("TOF/channel_mc_efficiency", raw_table)) {
+	if(CalibSnapshot::GetCalib(loop, "TOF/channel_mc_efficiency", raw_table)) {
 	  jerr << "Problem loading TOF/channel_mc_efficiency from CCDB!" << endl;
 	} else {
 	  int channel = 0;
@@ -124,6 +124,11 @@ tof_config_t::tof_config_t(JEventLoop *loop)
 //-----------
 void TOFSmearer::SmearEvent(hddm_s::HDDM *record)
 {
+   // Noise for all hits of the event, drawn in one block
+   size_t nthits = record->getFtofTruthHits().size();
+   DRandomBuffer noise(config->SMEAR_HITS ? 2*nthits : 0,
+                       config->APPLY_EFFICIENCY_CORRECTIONS ? nthits : 0);
+
    hddm_s::FtofCounterList tofs = record->getFtofCounters();
    hddm_s::FtofCounterList::iterator iter;
    for (iter = tofs.begin(); iter != tofs.end(); ++iter) {
@@ -134,7 +139,7 @@ void TOFSmearer::SmearEvent(hddm_s::HDDM *record)
       for (titer = thits.begin(); titer != thits.end(); ++titer) {
          // correct simulation efficiencies 
 		 if (config->APPLY_EFFICIENCY_CORRECTIONS
-		 		&& !gDRandom.DecideToAcceptHit(tof_config->GetEfficiencyCorrectionFactor(titer)))
+		 		&& !noise.DecideToAcceptHit(tof_config->GetEfficiencyCorrectionFactor(titer)))
 		 			continue;
 		 			
          // Smear the time
@@ -143,9 +148,9 @@ void TOFSmearer::SmearEvent(hddm_s::HDDM *record)
          // Smear the energy
          float NewE = titer->getDE();
          if(config->SMEAR_HITS) {
-			 t += gDRandom.SampleGaussian(tof_config->GetHitTimeResolution(iter->getPlane(),iter->getBar()));
+			 t += noise.SampleGaussian(tof_config->GetHitTimeResolution(iter->getPlane(),iter->getBar()));
          	 double npe = titer->getDE() * 1000. * tof_config->TOF_PHOTONS_PERMEV;
-         	 npe += gDRandom.SampleGaussian(sqrt(npe));
+         	 npe += noise.SampleGaussian(sqrt(npe));
           	 NewE = npe/tof_config->TOF_PHOTONS_PERMEV/1000.;
 		 }
          // Apply an average attenuation correction to set the energy scale
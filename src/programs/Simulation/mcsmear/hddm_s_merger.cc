@@ -20,76 +20,84 @@
 //    subsequent analysis.
 
 #include <iostream>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <algorithm>
 #include <hddm_s_merger.h>
 #include <mcsmear_config.h>
 
 const double fadc125_period_ns(8.);
 const double fadc250_period_ns(4.);
 
+// The time shift applies to the record currently being merged, so
+// each thread keeps its own. The merging and truncation parameters
+// below are run configuration, set from MyProcessor::brun while no
+// merging is going on, and are shared by all threads.
 static thread_local double t_shift_ns(0);
 
-static thread_local bool   enable_cdc_merging(true);
-static thread_local int    cdc_max_hits(1);
-static thread_local double cdc_integration_window_ns(800.);
-
-static thread_local bool   enable_fdc_merging(true);
-static thread_local int    fdc_wires_max_hits(8);
-static thread_local double fdc_wires_min_delta_t_ns(35.);
-static thread_local int    fdc_strips_max_hits(1);
-static thread_local double fdc_strips_integration_window_ns(200.);
-
-static thread_local bool   enable_stc_merging(true);
-static thread_local int    stc_adc_max_hits(3);
-static thread_local int    stc_tdc_max_hits(8);
-static thread_local double stc_min_delta_t_ns(25.);
-static thread_local double stc_integration_window_ns(100.);
-
-static thread_local bool   enable_bcal_merging(true);
-static thread_local int    bcal_adc_max_hits(1);
-static thread_local int    bcal_tdc_max_hits(8);
-static thread_local double bcal_min_delta_t_ns(25.);
-static thread_local double bcal_integration_window_ns(114.);
-static thread_local double bcal_fadc_counts_per_ns(16.);
-static thread_local double bcal_tdc_counts_per_ns(16.13);
-
-static thread_local bool   enable_ftof_merging(true);
-static thread_local int    ftof_adc_max_hits(3);
-static thread_local int    ftof_tdc_max_hits(64);
-static thread_local double ftof_min_delta_t_ns(25.);
-static thread_local double ftof_integration_window_ns(104.);
-
-static thread_local bool   enable_fcal_merging(true);
-static thread_local int    fcal_max_hits(3);
-static thread_local double fcal_min_delta_t_ns(70.);
-static thread_local double fcal_integration_window_ns(64.);
-
-static thread_local bool   enable_ccal_merging(true);
-static thread_local int    ccal_max_hits(3);
-static thread_local double ccal_min_delta_t_ns(70.);
-static thread_local double ccal_integration_window_ns(64.);
-
-static thread_local bool   enable_ps_merging(true);
-static thread_local int    ps_max_hits(3);
-static thread_local double ps_integration_window_ns(72.);
-static thread_local bool   enable_psc_merging(true);
-static thread_local int    psc_adc_max_hits(3);
-static thread_local int    psc_tdc_max_hits(3);
-static thread_local double psc_min_delta_t_ns(25.);
-static thread_local double psc_integration_window_ns(36.);
-
-static thread_local bool   enable_tag_merging(true);
-static thread_local int    tag_adc_max_hits(3);
-static thread_local int    tag_tdc_max_hits(8);
-static thread_local double tag_min_delta_t_ns(25.);
-static thread_local double tag_integration_window_ns(36.);
-
-static thread_local bool   enable_tpol_merging(true);
-static thread_local int    tpol_max_hits(1);
-static thread_local double tpol_integration_window_ns(2500.);
-
-static thread_local bool   enable_fmwpc_merging(true);
-static thread_local int    fmwpc_max_hits(1);
-static thread_local double fmwpc_min_delta_t_ns(400.);
+static bool   enable_cdc_merging(true);
+static int    cdc_max_hits(1);
+static double cdc_integration_window_ns(800.);
+
+static bool   enable_fdc_merging(true);
+static int    fdc_wires_max_hits(8);
+static double fdc_wires_min_delta_t_ns(35.);
+static int    fdc_strips_max_hits(1);
+static double fdc_strips_integration_window_ns(200.);
+
+static bool   enable_stc_merging(true);
+static int    stc_adc_max_hits(3);
+static int    stc_tdc_max_hits(8);
+static double stc_min_delta_t_ns(25.);
+static double stc_integration_window_ns(100.);
+
+static bool   enable_bcal_merging(true);
+static int    bcal_adc_max_hits(1);
+static int    bcal_tdc_max_hits(8);
+static double bcal_min_delta_t_ns(25.);
+static double bcal_integration_window_ns(114.);
+static double bcal_fadc_counts_per_ns(16.);
+static double bcal_tdc_counts_per_ns(16.13);
+
+static bool   enable_ftof_merging(true);
+static int    ftof_adc_max_hits(3);
+static int    ftof_tdc_max_hits(64);
+static double ftof_min_delta_t_ns(25.);
+static double ftof_integration_window_ns(104.);
+
+static bool   enable_fcal_merging(true);
+static int    fcal_max_hits(3);
+static double fcal_min_delta_t_ns(70.);
+static double fcal_integration_window_ns(64.);
+
+static bool   enable_ccal_merging(true);
+static int    ccal_max_hits(3);
+static double ccal_min_delta_t_ns(70.);
+static double ccal_integration_window_ns(64.);
+
+static bool   enable_ps_merging(true);
+static int    ps_max_hits(3);
+static double ps_integration_window_ns(72.);
+static bool   enable_psc_merging(true);
+static int    psc_adc_max_hits(3);
+static int    psc_tdc_max_hits(3);
+static double psc_min_delta_t_ns(25.);
+static double psc_integration_window_ns(36.);
+
+static bool   enable_tag_merging(true);
+static int    tag_adc_max_hits(3);
+static int    tag_tdc_max_hits(8);
+static double tag_min_delta_t_ns(25.);
+static double tag_integration_window_ns(36.);
+
+static bool   enable_tpol_merging(true);
+static int    tpol_max_hits(1);
+static double tpol_integration_window_ns(2500.);
+
+static bool   enable_fmwpc_merging(true);
+static int    fmwpc_max_hits(1);
+static double fmwpc_min_delta_t_ns(400.);
 
 extern const mcsmear_config_t *mcsmear_config;
 
@@ -516,6 +524,78 @@ namespace hddm_s_merger {
    }
 }
 
+// Merges a list of detector channels (straws, wires, blocks, counters, ...)
+// from src into dst, keeping dst sorted by channel. Each channel that is
+// not yet present in dst is inserted in its sorted place and initialized
+// by new_channel, then merge_hits adds the src channel's hits to it.
+//
+// The src channels are first sorted by key into a per-thread scratch buffer
+// (stable, so repeated channels in src are merged in their original order)
+// and then merged with dst in a single forward pass. Runs of new channels
+// that fall between the same two dst channels are inserted with one add()
+// call. The result is the same as inserting the src channels one at a
+// time, but avoids the repeated indexed lookups into dst, which are linear
+// in the list position, and make the merge quadratic in the number of
+// channels hit.
+
+template <class Key, class List, class KeyOf, class NewChannel, class MergeHits>
+static List &merge_channels(List &dst, List &src, KeyOf key_of,
+                            NewChannel new_channel, MergeHits merge_hits)
+{
+   typedef typename List::iterator iter_t;
+   typedef std::pair<Key, iter_t> entry_t;
+   static thread_local std::vector<entry_t> sorted;
+   sorted.clear();
+   for (iter_t iter = src.begin(); iter != src.end(); ++iter)
+      sorted.push_back(entry_t(key_of(*iter), iter));
+   std::stable_sort(sorted.begin(), sorted.end(),
+                    [](const entry_t &a, const entry_t &b) {
+                       return a.first < b.first;
+                    });
+
+   iter_t dit = dst.begin();
+   int index = 0;
+   size_t j = 0;
+   while (j < sorted.size()) {
+      const Key &key = sorted[j].first;
+      while (dit != dst.end() && key_of(*dit) < key) {
+         ++dit;
+         ++index;
+      }
+      if (dit != dst.end() && !(key < key_of(*dit))) {
+         merge_hits(*dit, *sorted[j].second);
+         ++j;
+         continue;
+      }
+
+      // collect the run of new channels that go in before dit
+      size_t jend = j + 1;
+      int nnew = 1;
+      while (jend < sorted.size() &&
+             (dit == dst.end() || sorted[jend].first < key_of(*dit)))
+      {
+         if (sorted[jend - 1].first < sorted[jend].first)
+            ++nnew;
+         ++jend;
+      }
+      List added = dst.add(nnew, (dit != dst.end())? index : -1);
+      iter_t ait = added.begin();
+      new_channel(*ait, *sorted[j].second);
+      merge_hits(*ait, *sorted[j].second);
+      for (size_t k = j + 1; k < jend; ++k) {
+         if (sorted[k - 1].first < sorted[k].first) {
+            ++ait;
+            new_channel(*ait, *sorted[k].second);
+         }
+         merge_hits(*ait, *sorted[k].second);
+      }
+      index += nnew;
+      j = jend;
+   }
+   sorted.clear();
+   return dst;
+}
+
 hddm_s::HDDM &operator+=(hddm_s::HDDM &dst, hddm_s::HDDM &src)
 {
    dst.getPhysicsEvents() += src.getPhysicsEvents();
@@ -573,40 +653,17 @@ hddm_s::CdcStrawList &operator+=(hddm_s::CdcStrawList &dst,
                                  hddm_s::CdcStrawList &src)
 {
    // order first by ring, then straw
-   int iord = 0;
-   hddm_s::CdcStrawList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int ring = iter->getRing();
-      int straw = iter->getStraw();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getRing() > ring ||
-             (dst(iord).getRing() == ring && dst(iord).getStraw() > straw))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getRing() < ring ||
-             (dst(iord).getRing() == ring && dst(iord).getStraw() < straw))
-         {
-            ++iord;
-         }
-         else
-            break;
-      }
-      if (iord == dst.size() ||
-          dst(iord).getRing() != ring || 
-          dst(iord).getStraw() != straw)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setRing(ring);
-         dst(iord).setStraw(straw);
-      }
-      dst(iord).getCdcStrawHits() += iter->getCdcStrawHits();
-   }
-   return dst;
+   return merge_channels<std::pair<int,int>>(dst, src,
+         [](hddm_s::CdcStraw &c) {
+            return std::make_pair(c.getRing(), c.getStraw());
+         },
+         [](hddm_s::CdcStraw &c, hddm_s::CdcStraw &s) {
+            c.setRing(s.getRing());
+            c.setStraw(s.getStraw());
+         },
+         [](hddm_s::CdcStraw &c, hddm_s::CdcStraw &s) {
+            c.getCdcStrawHits() += s.getCdcStrawHits();
+         });
 }
 
 hddm_s::CdcStrawHitList &operator+=(hddm_s::CdcStrawHitList &dst,
@@ -664,70 +721,34 @@ hddm_s::FdcChamberList &operator+=(hddm_s::FdcChamberList &dst,
                                    hddm_s::FdcChamberList &src)
 {
    // order first by module, then layer
-   int iord = 0;
-   hddm_s::FdcChamberList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int layer = iter->getLayer();
-      int module = iter->getModule();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getModule() > module ||
-             (dst(iord).getModule() == module && dst(iord).getLayer() > layer))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getModule() < module ||
-             (dst(iord).getModule() == module && dst(iord).getLayer() < layer))
-         {
-            ++iord;
-         }
-         else
-            break;
-      }
-      if (iord == dst.size() ||
-          dst(iord).getModule() != module || 
-          dst(iord).getLayer() != layer)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setModule(module);
-         dst(iord).setLayer(layer);
-      }
-      dst(iord).getFdcAnodeWires() += iter->getFdcAnodeWires();
-      dst(iord).getFdcCathodeStrips() += iter->getFdcCathodeStrips();
-   }
-   return dst;
+   return merge_channels<std::pair<int,int>>(dst, src,
+         [](hddm_s::FdcChamber &c) {
+            return std::make_pair(c.getModule(), c.getLayer());
+         },
+         [](hddm_s::FdcChamber &c, hddm_s::FdcChamber &s) {
+            c.setModule(s.getModule());
+            c.setLayer(s.getLayer());
+         },
+         [](hddm_s::FdcChamber &c, hddm_s::FdcChamber &s) {
+            c.getFdcAnodeWires() += s.getFdcAnodeWires();
+            c.getFdcCathodeStrips() += s.getFdcCathodeStrips();
+         });
 }
 
 hddm_s::FdcAnodeWireList &operator+=(hddm_s::FdcAnodeWireList &dst,
                                      hddm_s::FdcAnodeWireList &src)
 {
    // order by anode wire
-   int iord = 0;
-   hddm_s::FdcAnodeWireList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int wire = iter->getWire();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getWire() > wire)
-            --iord;
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getWire() < wire)
-            ++iord;
-         else
-            break;
-      }
-      if (iord == dst.size() || dst(iord).getWire() != wire) {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setWire(wire);
-      }
-      dst(iord).getFdcAnodeHits() += iter->getFdcAnodeHits();
-   }
-   return dst;
+   return merge_channels<int>(dst, src,
+         [](hddm_s::FdcAnodeWire &c) {
+            return c.getWire();
+         },
+         [](hddm_s::FdcAnodeWire &c, hddm_s::FdcAnodeWire &s) {
+            c.setWire(s.getWire());
+         },
+         [](hddm_s::FdcAnodeWire &c, hddm_s::FdcAnodeWire &s) {
+            c.getFdcAnodeHits() += s.getFdcAnodeHits();
+         });
 }
 
 hddm_s::FdcAnodeHitList &operator+=(hddm_s::FdcAnodeHitList &dst,
@@ -767,38 +788,18 @@ hddm_s::FdcAnodeHitList &operator+=(hddm_s::FdcAnodeHitList &dst,
 hddm_s::FdcCathodeStripList &operator+=(hddm_s::FdcCathodeStripList &dst,
                                         hddm_s::FdcCathodeStripList &src)
 {
-   // order by plane, then cathode strip 
-   int iord = 0;
-   hddm_s::FdcCathodeStripList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int plane = iter->getPlane();
-      int strip = iter->getStrip();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getPlane() > plane ||
-             (dst(iord).getPlane() == plane && dst(iord).getStrip() > strip))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getPlane() < plane ||
-             (dst(iord).getPlane() == plane && dst(iord).getStrip() < strip))
-            ++iord;
-         else
-            break;
-      }
-      if (iord == dst.size() || dst(iord).getPlane() != plane ||
-                                dst(iord).getStrip() != strip)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setPlane(plane);
-         dst(iord).setStrip(strip);
-      }
-      dst(iord).getFdcCathodeHits() += iter->getFdcCathodeHits();
-   }
-   return dst;
+   // order by plane, then cathode strip
+   return merge_channels<std::pair<int,int>>(dst, src,
+         [](hddm_s::FdcCathodeStrip &c) {
+            return std::make_pair(c.getPlane(), c.getStrip());
+         },
+         [](hddm_s::FdcCathodeStrip &c, hddm_s::FdcCathodeStrip &s) {
+            c.setPlane(s.getPlane());
+            c.setStrip(s.getStrip());
+         },
+         [](hddm_s::FdcCathodeStrip &c, hddm_s::FdcCathodeStrip &s) {
+            c.getFdcCathodeHits() += s.getFdcCathodeHits();
+         });
 }
 
 hddm_s::FdcCathodeHitList &operator+=(hddm_s::FdcCathodeHitList &dst,
@@ -856,29 +857,16 @@ hddm_s::StcPaddleList &operator+=(hddm_s::StcPaddleList &dst,
                                   hddm_s::StcPaddleList &src)
 {
    // order by sector index
-   int iord = 0;
-   hddm_s::StcPaddleList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int sector = iter->getSector();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getSector() > sector)
-            --iord;
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getSector() < sector)
-            ++iord;
-         else
-            break;
-      }
-      if (iord == dst.size() || dst(iord).getSector() != sector) {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setSector(sector);
-      }
-      dst(iord).getStcHits() += iter->getStcHits();
-   }
-   return dst;
+   return merge_channels<int>(dst, src,
+         [](hddm_s::StcPaddle &c) {
+            return c.getSector();
+         },
+         [](hddm_s::StcPaddle &c, hddm_s::StcPaddle &s) {
+            c.setSector(s.getSector());
+         },
+         [](hddm_s::StcPaddle &c, hddm_s::StcPaddle &s) {
+            c.getStcHits() += s.getStcHits();
+         });
 }
 
 hddm_s::StcHitList &operator+=(hddm_s::StcHitList &dst,
@@ -950,51 +938,21 @@ hddm_s::BcalCellList &operator+=(hddm_s::BcalCellList &dst,
                                  hddm_s::BcalCellList &src)
 {
    // order by module, then layer, then sector
-   int iord = 0;
-   hddm_s::BcalCellList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int module = iter->getModule();
-      int sector = iter->getSector();
-      int layer = iter->getLayer();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getModule() > module ||
-             (dst(iord).getModule() == module && dst(iord).getLayer() > layer)
-             || (dst(iord).getModule() == module && 
-                 dst(iord).getLayer() == layer && 
-                 dst(iord).getSector() > sector))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getModule() < module ||
-             (dst(iord).getModule() == module && dst(iord).getLayer() < layer)
-             || (dst(iord).getModule() == module && 
-                 dst(iord).getLayer() == layer && 
-                 dst(iord).getSector() < sector))
-         {
-            ++iord;
-         }
-         else
-            break;
-      }
-      if (iord == dst.size() || dst(iord).getModule() != module ||
-                                dst(iord).getLayer() != layer ||
-                                dst(iord).getSector() != sector)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setModule(module);
-         dst(iord).setLayer(layer);
-         dst(iord).setSector(sector);
-      }
-      dst(iord).getBcalfADCDigiHits() += iter->getBcalfADCDigiHits();
-      dst(iord).getBcalTDCDigiHits() += iter->getBcalTDCDigiHits();
-      dst(iord).getBcalfADCHits() += iter->getBcalfADCHits();
-      dst(iord).getBcalTDCHits() += iter->getBcalTDCHits();
-   }
-   return dst;
+   return merge_channels<std::tuple<int,int,int>>(dst, src,
+         [](hddm_s::BcalCell &c) {
+            return std::make_tuple(c.getModule(), c.getLayer(), c.getSector());
+         },
+         [](hddm_s::BcalCell &c, hddm_s::BcalCell &s) {
+            c.setModule(s.getModule());
+            c.setLayer(s.getLayer());
+            c.setSector(s.getSector());
+         },
+         [](hddm_s::BcalCell &c, hddm_s::BcalCell &s) {
+            c.getBcalfADCDigiHits() += s.getBcalfADCDigiHits();
+            c.getBcalTDCDigiHits() += s.getBcalTDCDigiHits();
+            c.getBcalfADCHits() += s.getBcalfADCHits();
+            c.getBcalTDCHits() += s.getBcalTDCHits();
+         });
 }
 
 hddm_s::BcalfADCHitList &operator+=(hddm_s::BcalfADCHitList &dst,
@@ -1217,40 +1175,17 @@ hddm_s::FtofCounterList &operator+=(hddm_s::FtofCounterList &dst,
                                     hddm_s::FtofCounterList &src)
 {
    // order first by plane, then bar
-   int iord = 0;
-   hddm_s::FtofCounterList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int bar = iter->getBar();
-      int plane = iter->getPlane();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getPlane() > plane ||
-             (dst(iord).getPlane() == plane && dst(iord).getBar() > bar))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getPlane() < plane ||
-             (dst(iord).getPlane() == plane && dst(iord).getBar() < bar))
-         {
-            ++iord;
-         }
-         else
-            break;
-      }
-      if (iord == dst.size() ||
-          dst(iord).getPlane() != plane || 
-          dst(iord).getBar() != bar)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setPlane(plane);
-         dst(iord).setBar(bar);
-      }
-      dst(iord).getFtofHits() += iter->getFtofHits();
-   }
-   return dst;
+   return merge_channels<std::pair<int,int>>(dst, src,
+         [](hddm_s::FtofCounter &c) {
+            return std::make_pair(c.getPlane(), c.getBar());
+         },
+         [](hddm_s::FtofCounter &c, hddm_s::FtofCounter &s) {
+            c.setPlane(s.getPlane());
+            c.setBar(s.getBar());
+         },
+         [](hddm_s::FtofCounter &c, hddm_s::FtofCounter &s) {
+            c.getFtofHits() += s.getFtofHits();
+         });
 }
 
 hddm_s::FtofHitList &operator+=(hddm_s::FtofHitList &dst,
@@ -1344,40 +1279,17 @@ hddm_s::FcalBlockList &operator+=(hddm_s::FcalBlockList &dst,
                                   hddm_s::FcalBlockList &src)
 {
    // order first by column, then row
-   int iord = 0;
-   hddm_s::FcalBlockList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int row = iter->getRow();
-      int column = iter->getColumn();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getColumn() > column ||
-             (dst(iord).getColumn() == column && dst(iord).getRow() > row))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getColumn() < column ||
-             (dst(iord).getColumn() == column && dst(iord).getRow() < row))
-         {
-            ++iord;
-         }
-         else
-            break;
-      }
-      if (iord == dst.size() ||
-          dst(iord).getColumn() != column || 
-          dst(iord).getRow() != row)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setColumn(column);
-         dst(iord).setRow(row);
-      }
-      dst(iord).getFcalHits() += iter->getFcalHits();
-   }
-   return dst;
+   return merge_channels<std::pair<int,int>>(dst, src,
+         [](hddm_s::FcalBlock &c) {
+            return std::make_pair(c.getColumn(), c.getRow());
+         },
+         [](hddm_s::FcalBlock &c, hddm_s::FcalBlock &s) {
+            c.setColumn(s.getColumn());
+            c.setRow(s.getRow());
+         },
+         [](hddm_s::FcalBlock &c, hddm_s::FcalBlock &s) {
+            c.getFcalHits() += s.getFcalHits();
+         });
 }
 
 hddm_s::FcalHitList &operator+=(hddm_s::FcalHitList &dst,
@@ -1435,40 +1347,17 @@ hddm_s::CcalBlockList &operator+=(hddm_s::CcalBlockList &dst,
                                   hddm_s::CcalBlockList &src)
 {
    // order first by column, then row
-   int iord = 0;
-   hddm_s::CcalBlockList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int row = iter->getRow();
-      int column = iter->getColumn();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getColumn() > column ||
-             (dst(iord).getColumn() == column && dst(iord).getRow() > row))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getColumn() < column ||
-             (dst(iord).getColumn() == column && dst(iord).getRow() < row))
-         {
-            ++iord;
-         }
-         else
-            break;
-      }
-      if (iord == dst.size() ||
-          dst(iord).getColumn() != column || 
-          dst(iord).getRow() != row)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setColumn(column);
-         dst(iord).setRow(row);
-      }
-      dst(iord).getCcalHits() += iter->getCcalHits();
-   }
-   return dst;
+   return merge_channels<std::pair<int,int>>(dst, src,
+         [](hddm_s::CcalBlock &c) {
+            return std::make_pair(c.getColumn(), c.getRow());
+         },
+         [](hddm_s::CcalBlock &c, hddm_s::CcalBlock &s) {
+            c.setColumn(s.getColumn());
+            c.setRow(s.getRow());
+         },
+         [](hddm_s::CcalBlock &c, hddm_s::CcalBlock &s) {
+            c.getCcalHits() += s.getCcalHits();
+         });
 }
 
 hddm_s::CcalHitList &operator+=(hddm_s::CcalHitList &dst,
@@ -1527,70 +1416,35 @@ hddm_s::MicroChannelList &operator+=(hddm_s::MicroChannelList &dst,
                                      hddm_s::MicroChannelList &src)
 {
    // order by column, row index
-   int iord = 0;
-   hddm_s::MicroChannelList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int column = iter->getColumn();
-      int row = iter->getRow();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getColumn() > column ||
-             (dst(iord).getColumn() == column && dst(iord).getRow() > row))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getColumn() < column ||
-             (dst(iord).getColumn() == column && dst(iord).getRow() < row))
-         {
-            ++iord;
-         }
-         else
-            break;
-      }
-      if (iord == dst.size() || dst(iord).getColumn() != column ||
-                                dst(iord).getRow() != row)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setColumn(column);
-         dst(iord).setRow(row);
-         dst(iord).setE(iter->getE());
-      }
-      dst(iord).getTaggerHits() += iter->getTaggerHits();
-   }
-   return dst;
+   return merge_channels<std::pair<int,int>>(dst, src,
+         [](hddm_s::MicroChannel &c) {
+            return std::make_pair(c.getColumn(), c.getRow());
+         },
+         [](hddm_s::MicroChannel &c, hddm_s::MicroChannel &s) {
+            c.setColumn(s.getColumn());
+            c.setRow(s.getRow());
+            c.setE(s.getE());
+         },
+         [](hddm_s::MicroChannel &c, hddm_s::MicroChannel &s) {
+            c.getTaggerHits() += s.getTaggerHits();
+         });
 }
 
 hddm_s::HodoChannelList &operator+=(hddm_s::HodoChannelList &dst,
                                     hddm_s::HodoChannelList &src)
 {
    // order by counter index
-   int iord = 0;
-   hddm_s::HodoChannelList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int cid = iter->getCounterId();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getCounterId() > cid)
-            --iord;
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getCounterId() < cid)
-            ++iord;
-         else
-            break;
-      }
-      if (iord == dst.size() || dst(iord).getCounterId() != cid) {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setCounterId(cid);
-         dst(iord).setE(iter->getE());
-      }
-      dst(iord).getTaggerHits() += iter->getTaggerHits();
-   }
-   return dst;
+   return merge_channels<int>(dst, src,
+         [](hddm_s::HodoChannel &c) {
+            return c.getCounterId();
+         },
+         [](hddm_s::HodoChannel &c, hddm_s::HodoChannel &s) {
+            c.setCounterId(s.getCounterId());
+            c.setE(s.getE());
+         },
+         [](hddm_s::HodoChannel &c, hddm_s::HodoChannel &s) {
+            c.getTaggerHits() += s.getTaggerHits();
+         });
 }
 
 hddm_s::TaggerHitList &operator+=(hddm_s::TaggerHitList &dst,
@@ -1665,40 +1519,17 @@ hddm_s::PsTileList &operator+=(hddm_s::PsTileList &dst,
                                hddm_s::PsTileList &src)
 {
    // order first by arm, then column
-   int iord = 0;
-   hddm_s::PsTileList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int column = iter->getColumn();
-      int arm = iter->getArm();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getArm() > arm ||
-             (dst(iord).getArm() == arm && dst(iord).getColumn() > column))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getArm() < arm ||
-             (dst(iord).getArm() == arm && dst(iord).getColumn() < column))
-         {
-            ++iord;
-         }
-         else
-            break;
-      }
-      if (iord == dst.size() ||
-          dst(iord).getArm() != arm || 
-          dst(iord).getColumn() != column)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setArm(arm);
-         dst(iord).setColumn(column);
-      }
-      dst(iord).getPsHits() += iter->getPsHits();
-   }
-   return dst;
+   return merge_channels<std::pair<int,int>>(dst, src,
+         [](hddm_s::PsTile &c) {
+            return std::make_pair(c.getArm(), c.getColumn());
+         },
+         [](hddm_s::PsTile &c, hddm_s::PsTile &s) {
+            c.setArm(s.getArm());
+            c.setColumn(s.getColumn());
+         },
+         [](hddm_s::PsTile &c, hddm_s::PsTile &s) {
+            c.getPsHits() += s.getPsHits();
+         });
 }
 
 hddm_s::PsHitList &operator+=(hddm_s::PsHitList &dst,
@@ -1757,40 +1588,17 @@ hddm_s::PscPaddleList &operator+=(hddm_s::PscPaddleList &dst,
                                   hddm_s::PscPaddleList &src)
 {
    // order first by arm, then module
-   int iord = 0;
-   hddm_s::PscPaddleList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int module = iter->getModule();
-      int arm = iter->getArm();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getArm() > arm ||
-             (dst(iord).getArm() == arm && dst(iord).getModule() > module))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getArm() < arm ||
-             (dst(iord).getArm() == arm && dst(iord).getModule() < module))
-         {
-            ++iord;
-         }
-         else
-            break;
-      }
-      if (iord == dst.size() ||
-          dst(iord).getArm() != arm || 
-          dst(iord).getModule() != module)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setArm(arm);
-         dst(iord).setModule(module);
-      }
-      dst(iord).getPscHits() += iter->getPscHits();
-   }
-   return dst;
+   return merge_channels<std::pair<int,int>>(dst, src,
+         [](hddm_s::PscPaddle &c) {
+            return std::make_pair(c.getArm(), c.getModule());
+         },
+         [](hddm_s::PscPaddle &c, hddm_s::PscPaddle &s) {
+            c.setArm(s.getArm());
+            c.setModule(s.getModule());
+         },
+         [](hddm_s::PscPaddle &c, hddm_s::PscPaddle &s) {
+            c.getPscHits() += s.getPscHits();
+         });
 }
 
 hddm_s::PscHitList &operator+=(hddm_s::PscHitList &dst,
@@ -1863,29 +1671,16 @@ hddm_s::TpolSectorList &operator+=(hddm_s::TpolSectorList &dst,
                                    hddm_s::TpolSectorList &src)
 {
    // order by sector index
-   int iord = 0;
-   hddm_s::TpolSectorList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int sector = iter->getSector();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getSector() > sector)
-            --iord;
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getSector() < sector)
-            ++iord;
-         else
-            break;
-      }
-      if (iord == dst.size() || dst(iord).getSector() != sector) {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setSector(sector);
-      }
-      dst(iord).getTpolHits() += iter->getTpolHits();
-   }
-   return dst;
+   return merge_channels<int>(dst, src,
+         [](hddm_s::TpolSector &c) {
+            return c.getSector();
+         },
+         [](hddm_s::TpolSector &c, hddm_s::TpolSector &s) {
+            c.setSector(s.getSector());
+         },
+         [](hddm_s::TpolSector &c, hddm_s::TpolSector &s) {
+            c.getTpolHits() += s.getTpolHits();
+         });
 }
 
 hddm_s::TpolHitList &operator+=(hddm_s::TpolHitList &dst,
@@ -1943,40 +1738,17 @@ hddm_s::FmwpcChamberList &operator+=(hddm_s::FmwpcChamberList &dst,
                                      hddm_s::FmwpcChamberList &src)
 {
    // order first by layer, then wire
-   int iord = 0;
-   hddm_s::FmwpcChamberList::iterator iter;
-   for (iter = src.begin(); iter != src.end(); ++iter) {
-      int layer = iter->getLayer();
-      int wire = iter->getWire();
-      while (iord > 0) {
-         if (iord == dst.size() || dst(iord).getLayer() > layer ||
-             (dst(iord).getLayer() == layer && dst(iord).getWire() > wire))
-         {
-            --iord;
-         }
-         else
-            break;
-      }
-      while (iord < dst.size()) {
-         if (dst(iord).getLayer() < layer ||
-             (dst(iord).getLayer() == layer && dst(iord).getWire() < wire))
-         {
-            ++iord;
-         }
-         else
-            break;
-      }
-      if (iord == dst.size() ||
-          dst(iord).getLayer() != layer || 
-          dst(iord).getWire() != wire)
-      {
-         dst.add(1, (iord < dst.size())? iord : -1);
-         dst(iord).setLayer(layer);
-         dst(iord).setWire(wire);
-      }
-      dst(iord).getFmwpcHits() += iter->getFmwpcHits();
-   }
-   return dst;
+   return merge_channels<std::pair<int,int>>(dst, src,
+         [](hddm_s::FmwpcChamber &c) {
+            return std::make_pair(c.getLayer(), c.getWire());
+         },
+         [](hddm_s::FmwpcChamber &c, hddm_s::FmwpcChamber &s) {
+            c.setLayer(s.getLayer());
+            c.setWire(s.getWire());
+         },
+         [](hddm_s::FmwpcChamber &c, hddm_s::FmwpcChamber &s) {
+            c.getFmwpcHits() += s.getFmwpcHits();
+         });
 }
 
 hddm_s::FmwpcHitList &operator+=(hddm_s::FmwpcHitList &dst,
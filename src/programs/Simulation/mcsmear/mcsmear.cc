@@ -5,6 +5,7 @@
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <sstream>
 #include <vector>
 #include <map>
 
@@ -21,6 +22,9 @@ using namespace std;
 #include <DANA/DApplication.h>
 #include "MyProcessor.h"
 #include "JFactoryGenerator_ThreadCancelHandler.h"
+#include "DEventSourceHDDMOrdered.h"
+#include "NoisePrefetcher.h"
+#include "NoiseLibrary.h"
 #include "mcsmear_config.h" 
 #include "hddm_s_merger.h"
 
@@ -37,9 +41,8 @@ char *INFILENAME = NULL;
 char *OUTFILENAME = NULL;
 int QUIT = 0;
 
-std::map<hddm_s::istream*,double> files2merge;
-std::map<hddm_s::istream*,hddm_s::streamposition> start2merge;
-std::map<hddm_s::istream*,int> skip2merge;
+std::map<NoisePrefetcher*,double> files2merge;
+std::map<NoiseLibrary*,double> libraries2merge;
 
 using namespace jana;
 
@@ -51,8 +54,9 @@ using namespace jana;
 // be initialized using the UUID (see code for ROOT's
 // TRandom2 constructor) No argument, or an argument 
 // greater than zero will result in the same seeds 
-// being set every time mcsmear is run.
-DRandom2 gDRandom(0); // declared extern in DRandom2.h
+// being set every time mcsmear is run. There is one
+// instance per thread.
+thread_local DRandom2 gDRandom(0); // declared extern in DRandom2.h
 
 const mcsmear_config_t *mcsmear_config;
 
@@ -68,6 +72,17 @@ int main(int narg,char* argv[])
    // Create DApplication object
    DApplication dapp(narg, argv);
    dapp.AddFactoryGenerator(new JFactoryGenerator_ThreadCancelHandler());
+   dapp.AddEventSourceGenerator(new DEventSourceHDDMOrderedGenerator());
+
+   // -j is shorthand for the JANA NTHREADS parameter
+   if (config->NTHREADS != 1) {
+      stringstream nthreads;
+      if (config->NTHREADS > 0)
+         nthreads << config->NTHREADS;
+      else
+         nthreads << "Ncores";
+      gPARMS->SetParameter("NTHREADS", nthreads.str());
+   }
 
    TFile *hfile = new TFile("smear.root","RECREATE","smearing histograms");  // note: not used for anything right now
 
@@ -88,6 +103,12 @@ int main(int narg,char* argv[])
 //-----------
 void ParseCommandLineArguments(int narg, char* argv[], mcsmear_config_t *config)
 {
+   struct noise_file_t {
+      std::string filename;
+      double wgt;
+      int skip;
+   };
+   std::vector<noise_file_t> noise_files;
 
    for (int i=1; i<narg; i++) {
       char *ptr = argv[i];
@@ -107,6 +128,13 @@ void ParseCommandLineArguments(int narg, char* argv[], mcsmear_config_t *config)
           case 'E': config->FCAL_ADD_LIGHTGUIDE_HITS=true;       break;
 	      case 'R': config->SKIP_READING_RCDB=true;              break;
 	      case 't': config->MERGE_TAGGER_HITS=false;             break;
+	      case 'j': config->NTHREADS=(ptr[2])? atoi(&ptr[2]) : 0; break;
+	      case 'p': {
+	        config->PRELOAD_NOISE=true;
+	        if (ptr[2])
+	           config->NOISE_LIBRARY_MB = atof(&ptr[2]);
+	        break;
+	      }
 	      case 'l': {
 	   		config->DETECTORS_TO_LOAD=&ptr[2];
 	   		cout << "Detector list: " << config->DETECTORS_TO_LOAD << endl;  
@@ -135,15 +163,8 @@ void ParseCommandLineArguments(int narg, char* argv[], mcsmear_config_t *config)
             int skip = 0;
             if (plus != filename.npos)
                skip = std::stoi(filename.substr(colon + plus + 1));
-            std::ifstream fin(filename.substr(0, colon));
-            hddm_s::istream stin(fin);
-            hddm_s::HDDM record;
-            stin >> record;
-            std::ifstream *ifs = new std::ifstream(filename.substr(0, colon));
-            hddm_s::istream *istr = new hddm_s::istream(*ifs);
-            start2merge[istr] = stin.getPosition();
-            files2merge[istr] = wgt;
-            skip2merge[istr] = skip;
+            noise_file_t noise = {filename.substr(0, colon), wgt, skip};
+            noise_files.push_back(noise);
             std::fill(ptr, ptr + strlen(ptr), '-');
             continue;
          }
@@ -155,6 +176,20 @@ void ParseCommandLineArguments(int narg, char* argv[], mcsmear_config_t *config)
       cout << endl << "You must enter a filename!" << endl << endl;
       Usage();
    }
+
+   for (size_t i=0; i < noise_files.size(); ++i) {
+      if (config->PRELOAD_NOISE) {
+         NoiseLibrary *noise = new NoiseLibrary(noise_files[i].filename,
+                                                noise_files[i].skip,
+                                                config->NOISE_LIBRARY_MB);
+         libraries2merge[noise] = noise_files[i].wgt;
+      }
+      else {
+         NoisePrefetcher *noise = new NoisePrefetcher(noise_files[i].filename,
+                                                      noise_files[i].skip);
+         files2merge[noise] = noise_files[i].wgt;
+      }
+   }
   
    
    // Generate output filename based on input filename
@@ -198,6 +233,11 @@ void Usage(void)
    cout << "again and reading of noise events restarts from the beginning" << endl;
    cout << "of the file. If you want to skip S events at the beginning of" << endl;
    cout << "the noise file at startup, append \"+S\" to the <N> argument." << endl;
+   cout << "With the -p option, each noise file is instead read into" << endl;
+   cout << "memory once, keeping only the hits, and the events to merge" << endl;
+   cout << "are picked from it at random (with replacement). Files that" << endl;
+   cout << "do not fit in the memory cap are represented by a random" << endl;
+   cout << "subset of their events." << endl;
    cout << "Note that all smearing is done using Gaussians." << endl;
    cout << endl;
    cout << "  options:" << endl;
@@ -205,6 +245,12 @@ void Usage(void)
    cout << "    -s       Don't smear real hits (default is to smear)" << endl;
    cout << "    -i       Ignore random number seeds found in input HDDM file" << endl;
    cout << "    -r\"s1 s2 s3\" Set initial random number seeds" << endl;
+   cout << "    -p[MB]   Preload noise files into memory, at most MB megabytes" << endl;
+   cout << "             each (default 2000)" << endl;
+   cout << "    -jN      Smear with N threads (default 1, -j alone for one per core)." << endl;
+   cout << "             Output is identical to a single-threaded run unless" << endl;
+   cout << "             -i or -r is given, in which case each event is seeded" << endl;
+   cout << "             from the initial seeds plus its event number." << endl;
    cout << "    -e       Don't apply channel dependent efficiency corrections" << endl;
 //   cout << "    -u#      Sigma CDC anode drift time in ns (def:" << CDC_TDRIFT_SIGMA*1.0E9 << "ns)" << endl;
 //   cout << "             (NOTE: this is only used if -y is also specified!)" << endl;
@@ -23,6 +23,9 @@ mcsmear_config_t::mcsmear_config_t()
 	SMEAR_HITS     = true;
 	//SMEAR_BCAL     = true;
 	IGNORE_SEEDS   = false;
+	NTHREADS       = 1;
+	PRELOAD_NOISE  = false;
+	NOISE_LIBRARY_MB = 2000;
 	DUMP_RCDB_CONFIG = false;
 	APPLY_EFFICIENCY_CORRECTIONS = true;
 	APPLY_HITS_TRUNCATION  = true;
@@ -39,6 +42,10 @@ mcsmear_config_t::mcsmear_config_t()
 	  BCAL_NO_SIPM_SATURATION = false;    
 		
 	TRIGGER_LOOKBACK_TIME = -100; // ns
+
+	// starting seeds for runs that ignore the seeds in the input file,
+	// overridden by -r on the command line
+	gDRandom.GetSeeds(SEED1, SEED2, SEED3);
 		
 #ifdef HAVE_RCDB
 	// RCDB configuration
@@ -78,6 +85,7 @@ void mcsmear_config_t::SetSeeds(const char *vals)
    	UInt_t *useed2 = reinterpret_cast<UInt_t*>(&seed2);
    	UInt_t *useed3 = reinterpret_cast<UInt_t*>(&seed3);
    	gDRandom.SetSeeds(*useed1, *useed2, *useed3);
+   	gDRandom.GetSeeds(SEED1, SEED2, SEED3);
 
    	cout << "Seeds set from command line. Any random number" << endl;
    	cout << "seeds found in the input file will be ignored!" << endl;
@@ -41,6 +41,10 @@ class mcsmear_config_t
 	//bool SMEAR_BCAL;
 	//bool FDC_ELOSS_OFF;
 	bool IGNORE_SEEDS;
+	UInt_t SEED1, SEED2, SEED3;  // initial seeds used when IGNORE_SEEDS is set
+	int NTHREADS;                // number of JANA processing threads
+	bool PRELOAD_NOISE;          // sample noise events from memory (-p)
+	double NOISE_LIBRARY_MB;     // memory cap per preloaded noise file
 	double TRIGGER_LOOKBACK_TIME;
 	bool APPLY_EFFICIENCY_CORRECTIONS;
 	bool APPLY_HITS_TRUNCATION;
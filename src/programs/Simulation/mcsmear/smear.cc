@@ -179,10 +179,40 @@ void Smear::GetAndSetSeeds(hddm_s::HDDM *record)
       // Set the seeds in the random generator.
       gDRandom.SetSeeds(seed1, seed2, seed3);
    }
+   else if (config->NTHREADS != 1) {
+      // Events are spread over several threads, so there is no single
+      // stream to continue from one event to the next. Derive the seeds
+      // from the starting seeds and the event number instead, so that
+      // the output does not depend on which thread smeared the event.
+      uint64_t eventNo = record->getPhysicsEvent().getEventNo();
+      seed1 = config->SEED1 + eventNo;
+      seed2 = config->SEED2 + eventNo;
+      seed3 = config->SEED3 + eventNo;
+      gDRandom.SetSeeds(seed1, seed2, seed3);
+   }
+   else {
+      // Single processing thread: start its stream from the initial
+      // seeds and let it run on from event to event.
+      static thread_local bool thread_seeded = false;
+      if (!thread_seeded) {
+         seed1 = config->SEED1;
+         seed2 = config->SEED2;
+         seed3 = config->SEED3;
+         gDRandom.SetSeeds(seed1, seed2, seed3);
+         thread_seeded = true;
+      }
+      // Step the stream once per event. Smearers that draw only from
+      // the block streams leave it untouched, and without this step the
+      // next event would get the same seeds and the same noise.
+      gDRandom.Rndm();
+   }
 
    // Copy seeds from generator to local variables
    gDRandom.GetSeeds(seed1, seed2, seed3);
 
+   // The block streams start from the seeds recorded for this event
+   gDRandom.StartBlockStreams();
+
    // Copy seeds from local variables to event record
    my_rand.setSeed1(seed1);
    my_rand.setSeed2(seed2);
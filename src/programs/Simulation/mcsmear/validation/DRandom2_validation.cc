@@ -0,0 +1,301 @@
+// DRandom2_validation.cc
+//
+// Standalone checks of the block streams of DRandom2 (see DRandom2.h):
+//
+//  - Philox4x32-10 against the known-answer vectors of Random123
+//  - Gaussian numbers: moments, tails, Kolmogorov-Smirnov and chi2
+//  - uniform numbers: chi2, range and lag-1 correlation
+//  - Poisson numbers: chi2 for means on both sides of the switch
+//    from inversion to PTRS at 10
+//  - the same numbers however a stream is split into blocks or
+//    refilled through a DRandomBuffer, and different ones for
+//    different seeds
+//  - different seeds and noise for consecutive events when the
+//    TRandom2 stream runs on, as in Smear::GetAndSetSeeds with one
+//    thread and no smearer drawing from TRandom2
+//
+// It is not part of the mcsmear build. From this directory:
+//
+//   g++ -O2 -I.. DRandom2_validation.cc ../DRandom2.cc
+//       `root-config --cflags --libs` -o DRandom2_validation
+//   ./DRandom2_validation [number of draws, default 10000000]
+//
+// Every line ends in "ok" or "FAILED", and the exit status is the
+// number of failed checks. The statistical checks have 99.9% limits,
+// so with a fixed seed they fail only if the generator is broken.
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <vector>
+#include <set>
+#include <algorithm>
+
+#include "DRandom2.h"
+
+thread_local DRandom2 gDRandom(0);
+
+static int nfailed = 0;
+
+static void Report(bool ok, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+static void Report(bool ok, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+	printf("  %s\n", ok ? "ok" : "FAILED");
+	if (!ok)
+		++nfailed;
+}
+
+// limit on chi2 with ndf degrees of freedom, about 99.9%
+static double Chi2Limit(int ndf)
+{
+	return ndf + 3.1 * sqrt(2.0 * ndf);
+}
+
+static double Phi(double x)
+{
+	return 0.5 * erfc(-x / sqrt(2.0));
+}
+
+struct DRandom2Validation {
+
+	static void Philox()
+	{
+		// Random123 kat_vectors, philox4x32 with 10 rounds
+		struct { uint32_t key[2], ctr[4], out[4]; } kat[3] = {
+			{{0, 0}, {0, 0, 0, 0},
+			 {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+			{{0xffffffff, 0xffffffff},
+			 {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+			 {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+			{{0xa4093822, 0x299f31d0},
+			 {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+			 {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}
+		};
+		DRandom2 r;
+		for (int i=0; i < 3; ++i) {
+			uint32_t out[4];
+			r.key[0] = kat[i].key[0];
+			r.key[1] = kat[i].key[1];
+			r.Philox(kat[i].ctr, out);
+			bool ok = true;
+			for (int j=0; j < 4; ++j)
+				ok = ok && out[j] == kat[i].out[j];
+			Report(ok, "Philox known-answer vector %d: %08x %08x %08x %08x",
+			       i, out[0], out[1], out[2], out[3]);
+		}
+	}
+};
+
+static void Gaussian(size_t n)
+{
+	std::vector<double> g(n);
+	gDRandom.FillGaussian(&g[0], n);
+
+	double mean = 0;
+	for (size_t i=0; i < n; ++i)
+		mean += g[i];
+	mean /= n;
+	double var = 0, m3 = 0, m4 = 0;
+	size_t tail3 = 0, tail5 = 0;
+	for (size_t i=0; i < n; ++i) {
+		double d = g[i] - mean;
+		var += d * d;
+		m3 += d * d * d;
+		m4 += d * d * d * d;
+		if (fabs(g[i]) > 3)
+			++tail3;
+		if (fabs(g[i]) > 5)
+			++tail5;
+	}
+	var /= n;
+	double skew = m3 / n / pow(var, 1.5);
+	double kurt = m4 / n / (var * var) - 3;
+	double sd = 1 / sqrt((double)n);
+	Report(fabs(mean) < 3.3 * sd, "Gaussian mean %.2e (sd %.1e)", mean, sd);
+	Report(fabs(var - 1) < 3.3 * sqrt(2.0) * sd,
+	       "Gaussian variance %.5f (sd %.1e)", var, sqrt(2.0) * sd);
+	Report(fabs(skew) < 3.3 * sqrt(6.0) * sd,
+	       "Gaussian skewness %.2e (sd %.1e)", skew, sqrt(6.0) * sd);
+	Report(fabs(kurt) < 3.3 * sqrt(24.0) * sd,
+	       "Gaussian excess kurtosis %.2e (sd %.1e)", kurt, sqrt(24.0) * sd);
+	double p3 = 2 * Phi(-3);
+	Report(fabs(tail3 - n * p3) < 3.3 * sqrt(n * p3),
+	       "Gaussian |x| > 3: %zu (expected %.0f)", tail3, n * p3);
+	double p5 = 2 * Phi(-5);
+	Report(fabs(tail5 - n * p5) < 3.3 * sqrt(n * p5) + 3,
+	       "Gaussian |x| > 5: %zu (expected %.1f)", tail5, n * p5);
+
+	// chi2 in 100 bins over [-4,4]
+	std::vector<double> h(100, 0.);
+	for (size_t i=0; i < n; ++i)
+		if (fabs(g[i]) < 4)
+			h[(int)((g[i] + 4) / 0.08)]++;
+	double chi2 = 0;
+	for (int i=0; i < 100; ++i) {
+		double e = n * (Phi(-4 + 0.08 * (i + 1)) - Phi(-4 + 0.08 * i));
+		chi2 += (h[i] - e) * (h[i] - e) / e;
+	}
+	Report(chi2 < Chi2Limit(100), "Gaussian chi2/ndf %.1f/100", chi2);
+
+	std::sort(g.begin(), g.end());
+	double D = 0;
+	for (size_t i=0; i < n; ++i) {
+		double F = Phi(g[i]);
+		D = std::max(D, std::max(fabs(F - (double)i / n),
+		                         fabs(F - (double)(i + 1) / n)));
+	}
+	Report(D * sqrt((double)n) < 1.95,
+	       "Gaussian Kolmogorov-Smirnov sqrt(N)*D = %.3f", D * sqrt((double)n));
+}
+
+static void Uniform(size_t n)
+{
+	std::vector<double> u(n);
+	gDRandom.FillUniform(&u[0], n);
+
+	std::vector<double> h(1000, 0.);
+	double umin = 1, umax = 0, corr = 0;
+	for (size_t i=0; i < n; ++i) {
+		h[(int)(u[i] * 1000)]++;
+		umin = std::min(umin, u[i]);
+		umax = std::max(umax, u[i]);
+		if (i > 0)
+			corr += (u[i] - 0.5) * (u[i-1] - 0.5);
+	}
+	double chi2 = 0, e = n / 1000.;
+	for (int i=0; i < 1000; ++i)
+		chi2 += (h[i] - e) * (h[i] - e) / e;
+	Report(chi2 < Chi2Limit(999), "uniform chi2/ndf %.1f/999", chi2);
+	Report(umin > 0 && umax < 1, "uniform range (%.2e, 1-%.2e)", umin, 1 - umax);
+	corr *= 12.0 / n;
+	Report(fabs(corr) < 3.3 / sqrt((double)n),
+	       "uniform lag-1 correlation %.2e (sd %.1e)", corr, 1 / sqrt((double)n));
+}
+
+static void Poisson(size_t n)
+{
+	const double means[] = {0.3, 2.5, 9.9, 10, 37, 250, 5000};
+	for (unsigned int m=0; m < sizeof(means) / sizeof(means[0]); ++m) {
+		double mu = means[m];
+		std::vector<double> mean(n, mu);
+		std::vector<int> k(n);
+		gDRandom.FillPoisson(&mean[0], &k[0], n);
+
+		int kmax = *std::max_element(k.begin(), k.end());
+		std::vector<double> h(kmax + 1, 0.);
+		for (size_t i=0; i < n; ++i)
+			h[k[i]]++;
+
+		// chi2 with neighbouring k merged to at least 20 expected
+		double chi2 = 0, eacc = 0, oacc = 0;
+		int nbins = 0;
+		for (int j=0; j <= kmax; ++j) {
+			eacc += n * exp(-mu + j * log(mu) - lgamma(j + 1.0));
+			oacc += h[j];
+			if (eacc > 20) {
+				chi2 += (oacc - eacc) * (oacc - eacc) / eacc;
+				++nbins;
+				eacc = oacc = 0;
+			}
+		}
+		Report(chi2 < Chi2Limit(nbins - 1),
+		       "Poisson mean %g chi2/ndf %.1f/%d", mu, chi2, nbins - 1);
+	}
+}
+
+static void Blocks()
+{
+	UInt_t s0 = 12345, s1 = 678, s2 = 91011;
+	const size_t n = 1000;
+	std::vector<double> whole(n), split(n), u(7);
+
+	gDRandom.SetSeeds(s0, s1, s2);
+	gDRandom.FillGaussian(&whole[0], n);
+
+	// other streams in between do not matter either
+	gDRandom.SetSeeds(s0, s1, s2);
+	gDRandom.FillGaussian(&split[0], 1);
+	gDRandom.FillGaussian(&split[1], 333);
+	gDRandom.FillUniform(&u[0], 7);
+	gDRandom.FillGaussian(&split[334], n - 334);
+	Report(whole == split, "same Gaussians when split into blocks");
+
+	gDRandom.SetSeeds(s0, s1, s2);
+	DRandomBuffer buf(3);
+	size_t ndiff = 0;
+	for (size_t i=0; i < n; ++i)
+		if (buf.SampleGaussian(1.0) != whole[i])
+			++ndiff;
+	Report(ndiff == 0, "same Gaussians through a refilled DRandomBuffer (%zu differ)", ndiff);
+
+	UInt_t s0b = s0 + 1;
+	gDRandom.SetSeeds(s0b, s1, s2);
+	gDRandom.FillGaussian(&split[0], n);
+	size_t nsame = 0;
+	for (size_t i=0; i < n; ++i)
+		if (split[i] == whole[i])
+			++nsame;
+	Report(nsame == 0, "different Gaussians for another seed (%zu equal)", nsame);
+}
+
+static void ConsecutiveEvents()
+{
+	// as Smear::GetAndSetSeeds with one thread and -i/-r, for events
+	// whose smearers draw only from the block streams
+	UInt_t s0 = 2, s1 = 8, s2 = 16;
+	gDRandom.SetSeeds(s0, s1, s2);
+
+	const int nevents = 10000;
+	std::set<std::vector<UInt_t> > seeds;
+	std::set<double> first;
+	for (int i=0; i < nevents; ++i) {
+		gDRandom.Rndm();
+		UInt_t e0, e1, e2;
+		gDRandom.GetSeeds(e0, e1, e2);
+		gDRandom.StartBlockStreams();
+		std::vector<UInt_t> s(3);
+		s[0] = e0;
+		s[1] = e1;
+		s[2] = e2;
+		seeds.insert(s);
+		DRandomBuffer buf(4);
+		first.insert(buf.SampleGaussian(1.0));
+	}
+	Report((int)seeds.size() == nevents && (int)first.size() == nevents,
+	       "%d events: %zu different seeds, %zu different first Gaussians",
+	       nevents, seeds.size(), first.size());
+}
+
+int main(int narg, char *argv[])
+{
+	size_t n = 10000000;
+	if (narg > 1)
+		n = strtoul(argv[1], 0, 10);
+
+	DRandom2Validation::Philox();
+
+	UInt_t s0 = 12345, s1 = 678, s2 = 91011;
+	gDRandom.SetSeeds(s0, s1, s2);
+	Gaussian(n);
+	Uniform(n);
+	Poisson(n / 10);
+	Blocks();
+	ConsecutiveEvents();
+
+	std::vector<double> g(n);
+	clock_t start = clock();
+	gDRandom.FillGaussian(&g[0], n);
+	double seconds = (clock() - start) / (double)CLOCKS_PER_SEC;
+	printf("%.1f M Gaussians/s\n", n / seconds / 1e6);
+
+	printf("%d checks failed\n", nfailed);
+	return nfailed;
+}
@@ -0,0 +1,216 @@
+// Smearer_check.cc
+//
+// Regression check of CDCSmearer::SmearEvent and FCALSmearer::SmearEvent,
+// for comparing two versions of them built into two copies of this
+// program. The events of an hddm_s file from hdgeant are smeared by the
+// two smearers, set up at brun from CCDB as in mcsmear, with the random
+// seeds that mcsmear would use for them: the ones stored in the event,
+// or if there are none, the ones derived from the event number (see
+// Smear::GetAndSetSeeds). The smeared cdcStrawHits, with the peak
+// amplitude of their cdcDigihit, and fcalHits are summed into a
+// checksum of their exact bits, and with -o written out one per line
+// with the floating point values in hex.
+//
+// It is not part of the mcsmear build. From this directory, in a shell
+// set up for halld_recon:
+//
+//   g++ -O2 -std=c++11 -I.. -I$HALLD_RECON_HOME/$BMS_OSNAME/include
+//       -I$JANA_HOME/include `root-config --cflags`
+//       Smearer_check.cc ../CDCSmearer.cc ../FCALSmearer.cc
+//       ../CalibSnapshot.cc ../DRandom2.cc ../mcsmear_config.cc
+//       -o Smearer_check
+//
+// linked like mcsmear against the halld_recon libraries (DANA and those
+// it needs), JANA, CCDB and ROOT. To compare with the smearers from
+// before their constants were precomputed per channel, get those
+//
+//   rev=$(git log --format=%h -S CalcDerivedConstants
+//       -- ../CDCSmearer.cc | tail -1)
+//   mkdir old
+//   for f in CDCSmearer.cc CDCSmearer.h FCALSmearer.cc FCALSmearer.h; do
+//      git show $rev^:./../$f > old/$f; done
+//
+// and build the same with -Iold ahead of -I.. and old/CDCSmearer.cc
+// old/FCALSmearer.cc, into Smearer_check_old. Then
+//
+//   ./Smearer_check [-o hits.txt] [-e] file.hddm [JANA options]
+//
+// for both, with the same options and CCDB: the checksums, and the
+// files written with -o, must be the same. -e turns the efficiency
+// corrections off, as mcsmear -e does. JANA -P options, such as
+// -PJANA_CALIB_URL and -PJANA_CALIB_CONTEXT, are passed on to the
+// application.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+#include <DANA/DApplication.h>
+#include <JANA/JEventProcessor.h>
+#include <HDDM/hddm_s.hpp>
+
+#include "mcsmear_config.h"
+#include "CDCSmearer.h"
+#include "FCALSmearer.h"
+
+thread_local DRandom2 gDRandom(0);   // declared extern in DRandom2.h
+
+// as Smear::GetAndSetSeeds, without -i
+static void SetSeeds(hddm_s::HDDM *record)
+{
+	UInt_t seed1 = 0, seed2 = 0, seed3 = 0;
+	hddm_s::ReactionList reactions = record->getReactions();
+	if (reactions.size() > 0 && reactions().getRandoms().size() > 0) {
+		hddm_s::Random &random = reactions().getRandom();
+		seed1 = random.getSeed1();
+		seed2 = random.getSeed2();
+		seed3 = random.getSeed3();
+	}
+	if ((seed1 == 0) || (seed2 == 0) || (seed3 == 0)) {
+		uint64_t eventNo = record->getPhysicsEvent().getEventNo();
+		seed1 = 259921049 + eventNo;
+		seed2 = 442249570 + eventNo;
+		seed3 = 709975946 + eventNo;
+	}
+	gDRandom.SetSeeds(seed1, seed2, seed3);
+	gDRandom.StartBlockStreams();
+}
+
+class SmearerCheck : public JEventProcessor
+{
+  public:
+	SmearerCheck(mcsmear_config_t *in_config, FILE *in_out)
+	 : config(in_config), out(in_out), cdc(NULL), fcal(NULL),
+	   checksum(14695981039346656037ULL), nevents(0), ncdc(0), nfcal(0) {}
+
+	jerror_t brun(JEventLoop *loop, int32_t runnumber) {
+		delete cdc;
+		delete fcal;
+		cdc = new CDCSmearer(loop, config);
+		fcal = new FCALSmearer(loop, config);
+		return NOERROR;
+	}
+
+	jerror_t evnt(JEventLoop *loop, uint64_t eventnumber) {
+		hddm_s::HDDM *record = (hddm_s::HDDM*)loop->GetJEvent().GetRef();
+		if (!record)
+			return NOERROR;
+		SetSeeds(record);
+		cdc->SmearEvent(record);
+		fcal->SmearEvent(record);
+		uint64_t eventNo = record->getPhysicsEvent().getEventNo();
+
+		hddm_s::CdcStrawList straws = record->getCdcStraws();
+		hddm_s::CdcStrawList::iterator straw;
+		for (straw = straws.begin(); straw != straws.end(); ++straw) {
+			hddm_s::CdcStrawHitList hits = straw->getCdcStrawHits();
+			hddm_s::CdcStrawHitList::iterator hit;
+			for (hit = hits.begin(); hit != hits.end(); ++hit) {
+				float t = hit->getT();
+				float q = hit->getQ();
+				float amp = 0;
+				if (hit->getCdcDigihits().size() > 0)
+					amp = hit->getCdcDigihits()(0).getPeakAmp();
+				int ring = straw->getRing();
+				int number = straw->getStraw();
+				Add(&ring, sizeof(ring));
+				Add(&number, sizeof(number));
+				Add(&t, sizeof(t));
+				Add(&q, sizeof(q));
+				Add(&amp, sizeof(amp));
+				if (out)
+					fprintf(out, "%lu cdc %d %d %a %a %a\n",
+					        (unsigned long)eventNo, ring, number, t, q, amp);
+				++ncdc;
+			}
+		}
+
+		hddm_s::FcalBlockList blocks = record->getFcalBlocks();
+		hddm_s::FcalBlockList::iterator block;
+		for (block = blocks.begin(); block != blocks.end(); ++block) {
+			hddm_s::FcalHitList hits = block->getFcalHits();
+			hddm_s::FcalHitList::iterator hit;
+			for (hit = hits.begin(); hit != hits.end(); ++hit) {
+				float E = hit->getE();
+				float t = hit->getT();
+				int row = block->getRow();
+				int column = block->getColumn();
+				Add(&row, sizeof(row));
+				Add(&column, sizeof(column));
+				Add(&E, sizeof(E));
+				Add(&t, sizeof(t));
+				if (out)
+					fprintf(out, "%lu fcal %d %d %a %a\n",
+					        (unsigned long)eventNo, row, column, E, t);
+				++nfcal;
+			}
+		}
+		++nevents;
+		return NOERROR;
+	}
+
+	jerror_t fini(void) {
+		printf("%lu events, %lu cdcStrawHits, %lu fcalHits, checksum %016llx\n",
+		       nevents, ncdc, nfcal, (unsigned long long)checksum);
+		delete cdc;
+		delete fcal;
+		cdc = NULL;
+		fcal = NULL;
+		return NOERROR;
+	}
+
+  private:
+	// FNV-1a
+	void Add(const void *data, size_t size) {
+		const unsigned char *bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; ++i) {
+			checksum ^= bytes[i];
+			checksum *= 1099511628211ULL;
+		}
+	}
+
+	mcsmear_config_t *config;
+	FILE *out;
+	Smearer *cdc;
+	Smearer *fcal;
+	uint64_t checksum;
+	unsigned long nevents;
+	unsigned long ncdc;
+	unsigned long nfcal;
+};
+
+int main(int narg, char *argv[])
+{
+	mcsmear_config_t *config = new mcsmear_config_t();
+	FILE *out = NULL;
+	std::vector<char*> args;
+	for (int i = 0; i < narg; ++i) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < narg) {
+			out = fopen(argv[++i], "w");
+			if (!out) {
+				printf("cannot open %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "-e") == 0)
+			config->APPLY_EFFICIENCY_CORRECTIONS = false;
+		else
+			args.push_back(argv[i]);
+	}
+	if (args.size() < 2) {
+		printf("Usage: Smearer_check [-o hits.txt] [-e] file.hddm"
+		       " [JANA options]\n");
+		return -1;
+	}
+
+	// one thread, so that the events are smeared in file order
+	int nargs = args.size();
+	DApplication dapp(nargs, &args[0]);
+	SmearerCheck check(config, out);
+	jerror_t error = dapp.Run(&check, 1);
+	if (out)
+		fclose(out);
+	return (error == NOERROR)? dapp.GetExitCode() : (int)error;
+}
@@ -0,0 +1,649 @@
+// hddm_s_merger_check.cc
+//
+// Regression check of the hits merging in hddm_s_merger.cc, for
+// comparing two versions of it built into two copies of this program.
+// Records are merged the way MyProcessor::evnt merges random triggers
+// into an event, with hddm_s_merger::set_t_shift_ns, operator+= and
+// hddm_s_merger::truncate_hits, and the merged records are written
+// out through an hddm_s::ostream, of which a checksum is printed:
+//
+//  - random records from a fixed seed, with hits in every channel list
+//    that the merger handles. The destination has its channels sorted
+//    and unique, as mcsmear writes them. The source has the same kinds
+//    of channels out of order and repeated, some of them also in the
+//    destination and some not, so every path through the merging of
+//    channels is taken.
+//  - with -i, the events of an hddm_s file, each of which has the next
+//    event and then one of the random source records merged into it.
+//
+// For each channel list it also checks that the merged channels are
+// in order and unique.
+//
+// It is not part of the mcsmear build. From this directory, in a shell
+// set up for halld_recon:
+//
+//   g++ -O2 -std=c++11 -I.. -I$HALLD_RECON_HOME/$BMS_OSNAME/include
+//       -I$JANA_HOME/include `root-config --cflags`
+//       hddm_s_merger_check.cc ../hddm_s_merger.cc
+//       -L$HALLD_RECON_HOME/$BMS_OSNAME/lib -lHDDM -lxstream -lbz2 -lz
+//       -o hddm_s_merger_check
+//
+// and the same with the hddm_s_merger.cc to compare against, e.g. the
+// one from before the channels were merged by merge_channels,
+//
+//   git show $(git log --format=%h -S merge_channels
+//       -- ../hddm_s_merger.cc | tail -1)^:./../hddm_s_merger.cc
+//       > /tmp/hddm_s_merger_old.cc
+//
+// into hddm_s_merger_check_old. Then
+//
+//   ./hddm_s_merger_check [-n records] [-i file.hddm] [-o merged.hddm]
+//
+// for both, with the same options: the checksums, and the files written
+// with -o, must be the same. Every check line ends in "ok" or "FAILED",
+// and the exit status is the number of failed checks.
+
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+
+#include <HDDM/hddm_s.hpp>
+#include "hddm_s_merger.h"
+
+static int nfailed = 0;
+
+static void Report(bool ok, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+static void Report(bool ok, const char *fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+	printf("  %s\n", ok ? "ok" : "FAILED");
+	if (!ok)
+		++nfailed;
+}
+
+typedef std::vector<int> channel_t;
+
+// Channel keys, each element k drawn from 0 ... range[k]-1. For a
+// destination they are sorted and unique; for a source they come in
+// random order, with repeats.
+static std::vector<channel_t> Channels(const std::vector<int> &range, bool dst)
+{
+	int n = lrand48() % 7;
+	std::vector<channel_t> keys;
+	for (int i = 0; i < n; ++i) {
+		channel_t key;
+		for (size_t k = 0; k < range.size(); ++k)
+			key.push_back(lrand48() % range[k]);
+		keys.push_back(key);
+	}
+	if (dst) {
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	}
+	return keys;
+}
+
+// Hit times in a channel, sorted as in the records mcsmear writes, with
+// enough of them close together to be merged
+static std::vector<double> Times()
+{
+	int n = lrand48() % 4;
+	std::vector<double> t;
+	for (int i = 0; i < n; ++i)
+		t.push_back(-100 + ((drand48() < 0.5) ? 100 : 1000) * drand48());
+	std::sort(t.begin(), t.end());
+	return t;
+}
+
+static double Amplitude()
+{
+	return 0.1 + 10 * drand48();
+}
+
+// one record with random hits in every channel list
+static void RandomRecord(hddm_s::HDDM &record, bool dst)
+{
+	hddm_s::HitView &view = record.addPhysicsEvents()(0).addHitViews()(0);
+	std::vector<channel_t> keys;
+	std::vector<double> t;
+
+	keys = Channels({3, 4}, dst);
+	if (keys.size() > 0) {
+		hddm_s::CdcStrawList straws =
+			view.addCentralDCs()(0).addCdcStraws(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			straws(i).setRing(keys[i][0] + 1);
+			straws(i).setStraw(keys[i][1] + 1);
+			t = Times();
+			hddm_s::CdcStrawHitList hits =
+				straws(i).addCdcStrawHits(t.size());
+			for (size_t j = 0; j < t.size(); ++j) {
+				hits(j).setQ(Amplitude());
+				hits(j).setT(t[j]);
+			}
+		}
+	}
+
+	keys = Channels({2, 2}, dst);
+	if (keys.size() > 0) {
+		hddm_s::FdcChamberList chambers =
+			view.addForwardDCs()(0).addFdcChambers(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			chambers(i).setModule(keys[i][0] + 1);
+			chambers(i).setLayer(keys[i][1] + 1);
+			std::vector<channel_t> wkeys = Channels({4}, dst);
+			hddm_s::FdcAnodeWireList wires =
+				chambers(i).addFdcAnodeWires(wkeys.size());
+			for (size_t w = 0; w < wkeys.size(); ++w) {
+				wires(w).setWire(wkeys[w][0] + 1);
+				t = Times();
+				hddm_s::FdcAnodeHitList hits =
+					wires(w).addFdcAnodeHits(t.size());
+				for (size_t j = 0; j < t.size(); ++j) {
+					hits(j).setDE(Amplitude());
+					hits(j).setT(t[j]);
+				}
+			}
+			std::vector<channel_t> skeys = Channels({2, 3}, dst);
+			hddm_s::FdcCathodeStripList strips =
+				chambers(i).addFdcCathodeStrips(skeys.size());
+			for (size_t s = 0; s < skeys.size(); ++s) {
+				strips(s).setPlane(2 * skeys[s][0] + 1);
+				strips(s).setStrip(skeys[s][1] + 1);
+				t = Times();
+				hddm_s::FdcCathodeHitList hits =
+					strips(s).addFdcCathodeHits(t.size());
+				for (size_t j = 0; j < t.size(); ++j) {
+					hits(j).setQ(Amplitude());
+					hits(j).setT(t[j]);
+				}
+			}
+		}
+	}
+
+	keys = Channels({5}, dst);
+	if (keys.size() > 0) {
+		hddm_s::StcPaddleList paddles =
+			view.addStartCntrs()(0).addStcPaddles(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			paddles(i).setSector(keys[i][0] + 1);
+			t = Times();
+			hddm_s::StcHitList hits = paddles(i).addStcHits(t.size());
+			for (size_t j = 0; j < t.size(); ++j) {
+				hits(j).setDE(Amplitude());
+				hits(j).setT(t[j]);
+			}
+		}
+	}
+
+	keys = Channels({2, 2, 2}, dst);
+	if (keys.size() > 0) {
+		hddm_s::BcalCellList cells =
+			view.addBarrelEMcals()(0).addBcalCells(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			cells(i).setModule(keys[i][0] + 1);
+			cells(i).setLayer(keys[i][1] + 1);
+			cells(i).setSector(keys[i][2] + 1);
+			// ordered by end, then time
+			for (int end = 0; end < 2; ++end) {
+				t = Times();
+				hddm_s::BcalfADCHitList adcs =
+					cells(i).addBcalfADCHits(t.size());
+				for (size_t j = 0; j < t.size(); ++j) {
+					adcs(j).setEnd(end);
+					adcs(j).setE(Amplitude());
+					adcs(j).setT(t[j]);
+				}
+				t = Times();
+				hddm_s::BcalTDCHitList tdcs =
+					cells(i).addBcalTDCHits(t.size());
+				for (size_t j = 0; j < t.size(); ++j) {
+					tdcs(j).setEnd(end);
+					tdcs(j).setT(t[j]);
+				}
+				t = Times();
+				hddm_s::BcalfADCDigiHitList adcdigis =
+					cells(i).addBcalfADCDigiHits(t.size());
+				for (size_t j = 0; j < t.size(); ++j) {
+					adcdigis(j).setEnd(end);
+					adcdigis(j).setPulse_integral(1000 * Amplitude());
+					adcdigis(j).setPulse_time(16 * (t[j] + 100));
+				}
+				t = Times();
+				hddm_s::BcalTDCDigiHitList tdcdigis =
+					cells(i).addBcalTDCDigiHits(t.size());
+				for (size_t j = 0; j < t.size(); ++j) {
+					tdcdigis(j).setEnd(end);
+					tdcdigis(j).setTime(16 * (t[j] + 100));
+				}
+			}
+		}
+	}
+
+	keys = Channels({2, 4}, dst);
+	if (keys.size() > 0) {
+		hddm_s::FtofCounterList counters =
+			view.addForwardTOFs()(0).addFtofCounters(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			counters(i).setPlane(keys[i][0]);
+			counters(i).setBar(keys[i][1] + 1);
+			for (int end = 0; end < 2; ++end) {
+				t = Times();
+				hddm_s::FtofHitList hits =
+					counters(i).addFtofHits(t.size());
+				for (size_t j = 0; j < t.size(); ++j) {
+					hits(j).setEnd(end);
+					hits(j).setDE(Amplitude());
+					hits(j).setT(t[j]);
+				}
+			}
+		}
+	}
+
+	keys = Channels({3, 3}, dst);
+	if (keys.size() > 0) {
+		hddm_s::FcalBlockList blocks =
+			view.addForwardEMcals()(0).addFcalBlocks(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			blocks(i).setColumn(keys[i][0]);
+			blocks(i).setRow(keys[i][1]);
+			t = Times();
+			hddm_s::FcalHitList hits = blocks(i).addFcalHits(t.size());
+			for (size_t j = 0; j < t.size(); ++j) {
+				hits(j).setE(Amplitude());
+				hits(j).setT(t[j]);
+			}
+		}
+	}
+
+	keys = Channels({3, 3}, dst);
+	if (keys.size() > 0) {
+		hddm_s::CcalBlockList blocks =
+			view.addComptonEMcals()(0).addCcalBlocks(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			blocks(i).setColumn(keys[i][0]);
+			blocks(i).setRow(keys[i][1]);
+			t = Times();
+			hddm_s::CcalHitList hits = blocks(i).addCcalHits(t.size());
+			for (size_t j = 0; j < t.size(); ++j) {
+				hits(j).setE(Amplitude());
+				hits(j).setT(t[j]);
+			}
+		}
+	}
+
+	std::vector<channel_t> mkeys = Channels({3, 2}, dst);
+	std::vector<channel_t> hkeys = Channels({6}, dst);
+	if (mkeys.size() > 0 || hkeys.size() > 0) {
+		hddm_s::Tagger &tagger = view.addTaggers()(0);
+		hddm_s::MicroChannelList micros =
+			tagger.addMicroChannels(mkeys.size());
+		for (size_t i = 0; i < mkeys.size(); ++i) {
+			micros(i).setColumn(mkeys[i][0] + 1);
+			micros(i).setRow(mkeys[i][1]);
+			micros(i).setE(8 + 0.01 * mkeys[i][0]);
+			t = Times();
+			hddm_s::TaggerHitList hits =
+				micros(i).addTaggerHits(t.size());
+			for (size_t j = 0; j < t.size(); ++j) {
+				hits(j).setNpe(100 * Amplitude());
+				hits(j).setT(t[j]);
+				hits(j).setTADC(t[j] + 0.5);
+			}
+		}
+		hddm_s::HodoChannelList hodos =
+			tagger.addHodoChannels(hkeys.size());
+		for (size_t i = 0; i < hkeys.size(); ++i) {
+			hodos(i).setCounterId(hkeys[i][0] + 1);
+			hodos(i).setE(11 - 0.1 * hkeys[i][0]);
+			t = Times();
+			hddm_s::TaggerHitList hits =
+				hodos(i).addTaggerHits(t.size());
+			for (size_t j = 0; j < t.size(); ++j) {
+				hits(j).setNpe(100 * Amplitude());
+				hits(j).setT(t[j]);
+				hits(j).setTADC(t[j] + 0.5);
+			}
+		}
+	}
+
+	keys = Channels({2, 4}, dst);
+	if (keys.size() > 0) {
+		hddm_s::PsTileList tiles =
+			view.addPairSpectrometerFines()(0).addPsTiles(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			tiles(i).setArm(keys[i][0]);
+			tiles(i).setColumn(keys[i][1] + 1);
+			t = Times();
+			hddm_s::PsHitList hits = tiles(i).addPsHits(t.size());
+			for (size_t j = 0; j < t.size(); ++j) {
+				hits(j).setDE(Amplitude());
+				hits(j).setT(t[j]);
+			}
+		}
+	}
+
+	keys = Channels({2, 3}, dst);
+	if (keys.size() > 0) {
+		hddm_s::PscPaddleList paddles =
+			view.addPairSpectrometerCoarses()(0).addPscPaddles(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			paddles(i).setArm(keys[i][0]);
+			paddles(i).setModule(keys[i][1] + 1);
+			t = Times();
+			hddm_s::PscHitList hits = paddles(i).addPscHits(t.size());
+			for (size_t j = 0; j < t.size(); ++j) {
+				hits(j).setDE(Amplitude());
+				hits(j).setT(t[j]);
+			}
+		}
+	}
+
+	keys = Channels({4}, dst);
+	if (keys.size() > 0) {
+		hddm_s::TpolSectorList sectors =
+			view.addTripletPolarimeters()(0).addTpolSectors(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			sectors(i).setSector(keys[i][0] + 1);
+			t = Times();
+			hddm_s::TpolHitList hits = sectors(i).addTpolHits(t.size());
+			for (size_t j = 0; j < t.size(); ++j) {
+				hits(j).setDE(Amplitude());
+				hits(j).setT(t[j]);
+			}
+		}
+	}
+
+	keys = Channels({2, 4}, dst);
+	if (keys.size() > 0) {
+		hddm_s::FmwpcChamberList chambers =
+			view.addForwardMWPCs()(0).addFmwpcChambers(keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			chambers(i).setLayer(keys[i][0] + 1);
+			chambers(i).setWire(keys[i][1] + 1);
+			t = Times();
+			hddm_s::FmwpcHitList hits = chambers(i).addFmwpcHits(t.size());
+			for (size_t j = 0; j < t.size(); ++j) {
+				hits(j).setDE(Amplitude());
+				hits(j).setT(t[j]);
+			}
+		}
+	}
+}
+
+// Number of channel lists checked and of those not in order or with a
+// channel twice, for each kind of channel
+struct order_t {
+	const char *name;
+	long int nlists;
+	long int nbad;
+};
+
+enum {kCdcStraw, kFdcChamber, kFdcAnodeWire, kFdcCathodeStrip, kStcPaddle,
+      kBcalCell, kFtofCounter, kFcalBlock, kCcalBlock, kMicroChannel,
+      kHodoChannel, kPsTile, kPscPaddle, kTpolSector, kFmwpcChamber,
+      kNumChannelKinds};
+
+static order_t order[kNumChannelKinds] = {
+	{"cdcStraw", 0, 0}, {"fdcChamber", 0, 0}, {"fdcAnodeWire", 0, 0},
+	{"fdcCathodeStrip", 0, 0}, {"stcPaddle", 0, 0}, {"bcalCell", 0, 0},
+	{"ftofCounter", 0, 0}, {"fcalBlock", 0, 0}, {"ccalBlock", 0, 0},
+	{"microChannel", 0, 0}, {"hodoChannel", 0, 0}, {"psTile", 0, 0},
+	{"pscPaddle", 0, 0}, {"tpolSector", 0, 0}, {"fmwpcChamber", 0, 0}
+};
+
+template <class List, class KeyOf>
+static void CheckOrder(int kind, List list, KeyOf key_of)
+{
+	typename List::iterator iter = list.begin();
+	if (iter == list.end())
+		return;
+	++order[kind].nlists;
+	typename List::iterator prev = iter;
+	for (++iter; iter != list.end(); prev = iter++) {
+		if (!(key_of(*prev) < key_of(*iter))) {
+			++order[kind].nbad;
+			return;
+		}
+	}
+}
+
+static void CheckOrder(hddm_s::HDDM &record)
+{
+	// the channel lists of each parent element on their own
+	hddm_s::CentralDCList cdcs = record.getCentralDCs();
+	for (hddm_s::CentralDCList::iterator it = cdcs.begin();
+	     it != cdcs.end(); ++it)
+	{
+		CheckOrder(kCdcStraw, it->getCdcStraws(), [](hddm_s::CdcStraw &c) {
+			return std::make_pair(c.getRing(), c.getStraw());
+		});
+	}
+	hddm_s::ForwardDCList fdcs = record.getForwardDCs();
+	for (hddm_s::ForwardDCList::iterator it = fdcs.begin();
+	     it != fdcs.end(); ++it)
+	{
+		CheckOrder(kFdcChamber, it->getFdcChambers(), [](hddm_s::FdcChamber &c) {
+			return std::make_pair(c.getModule(), c.getLayer());
+		});
+	}
+	hddm_s::FdcChamberList chambers = record.getFdcChambers();
+	for (hddm_s::FdcChamberList::iterator it = chambers.begin();
+	     it != chambers.end(); ++it)
+	{
+		CheckOrder(kFdcAnodeWire, it->getFdcAnodeWires(),
+		           [](hddm_s::FdcAnodeWire &c) {
+			return c.getWire();
+		});
+		CheckOrder(kFdcCathodeStrip, it->getFdcCathodeStrips(),
+		           [](hddm_s::FdcCathodeStrip &c) {
+			return std::make_pair(c.getPlane(), c.getStrip());
+		});
+	}
+	hddm_s::StartCntrList stcs = record.getStartCntrs();
+	for (hddm_s::StartCntrList::iterator it = stcs.begin();
+	     it != stcs.end(); ++it)
+	{
+		CheckOrder(kStcPaddle, it->getStcPaddles(), [](hddm_s::StcPaddle &c) {
+			return c.getSector();
+		});
+	}
+	hddm_s::BarrelEMcalList bcals = record.getBarrelEMcals();
+	for (hddm_s::BarrelEMcalList::iterator it = bcals.begin();
+	     it != bcals.end(); ++it)
+	{
+		CheckOrder(kBcalCell, it->getBcalCells(), [](hddm_s::BcalCell &c) {
+			return std::make_tuple(c.getModule(), c.getLayer(), c.getSector());
+		});
+	}
+	hddm_s::ForwardTOFList ftofs = record.getForwardTOFs();
+	for (hddm_s::ForwardTOFList::iterator it = ftofs.begin();
+	     it != ftofs.end(); ++it)
+	{
+		CheckOrder(kFtofCounter, it->getFtofCounters(), [](hddm_s::FtofCounter &c) {
+			return std::make_pair(c.getPlane(), c.getBar());
+		});
+	}
+	hddm_s::ForwardEMcalList fcals = record.getForwardEMcals();
+	for (hddm_s::ForwardEMcalList::iterator it = fcals.begin();
+	     it != fcals.end(); ++it)
+	{
+		CheckOrder(kFcalBlock, it->getFcalBlocks(), [](hddm_s::FcalBlock &c) {
+			return std::make_pair(c.getColumn(), c.getRow());
+		});
+	}
+	hddm_s::ComptonEMcalList ccals = record.getComptonEMcals();
+	for (hddm_s::ComptonEMcalList::iterator it = ccals.begin();
+	     it != ccals.end(); ++it)
+	{
+		CheckOrder(kCcalBlock, it->getCcalBlocks(), [](hddm_s::CcalBlock &c) {
+			return std::make_pair(c.getColumn(), c.getRow());
+		});
+	}
+	hddm_s::TaggerList taggers = record.getTaggers();
+	for (hddm_s::TaggerList::iterator it = taggers.begin();
+	     it != taggers.end(); ++it)
+	{
+		CheckOrder(kMicroChannel, it->getMicroChannels(),
+		           [](hddm_s::MicroChannel &c) {
+			return std::make_pair(c.getColumn(), c.getRow());
+		});
+		CheckOrder(kHodoChannel, it->getHodoChannels(),
+		           [](hddm_s::HodoChannel &c) {
+			return c.getCounterId();
+		});
+	}
+	hddm_s::PairSpectrometerFineList pss = record.getPairSpectrometerFines();
+	for (hddm_s::PairSpectrometerFineList::iterator it = pss.begin();
+	     it != pss.end(); ++it)
+	{
+		CheckOrder(kPsTile, it->getPsTiles(), [](hddm_s::PsTile &c) {
+			return std::make_pair(c.getArm(), c.getColumn());
+		});
+	}
+	hddm_s::PairSpectrometerCoarseList pscs = record.getPairSpectrometerCoarses();
+	for (hddm_s::PairSpectrometerCoarseList::iterator it = pscs.begin();
+	     it != pscs.end(); ++it)
+	{
+		CheckOrder(kPscPaddle, it->getPscPaddles(), [](hddm_s::PscPaddle &c) {
+			return std::make_pair(c.getArm(), c.getModule());
+		});
+	}
+	hddm_s::TripletPolarimeterList tpols = record.getTripletPolarimeters();
+	for (hddm_s::TripletPolarimeterList::iterator it = tpols.begin();
+	     it != tpols.end(); ++it)
+	{
+		CheckOrder(kTpolSector, it->getTpolSectors(), [](hddm_s::TpolSector &c) {
+			return c.getSector();
+		});
+	}
+	hddm_s::ForwardMWPCList fmwpcs = record.getForwardMWPCs();
+	for (hddm_s::ForwardMWPCList::iterator it = fmwpcs.begin();
+	     it != fmwpcs.end(); ++it)
+	{
+		CheckOrder(kFmwpcChamber, it->getFmwpcChambers(),
+		           [](hddm_s::FmwpcChamber &c) {
+			return std::make_pair(c.getLayer(), c.getWire());
+		});
+	}
+}
+
+// as in MyProcessor::evnt, with a random trigger shifted by a whole
+// number of beam bunches
+static void Merge(hddm_s::HDDM &dst, hddm_s::HDDM &src)
+{
+	hddm_s_merger::set_t_shift_ns(4.008 * (int)(lrand48() % 201 - 100));
+	dst += src;
+	hddm_s_merger::set_t_shift_ns(0);
+	hddm_s_merger::truncate_hits(dst);
+	CheckOrder(dst);
+}
+
+// FNV-1a
+static uint64_t Checksum(const std::string &bytes)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < bytes.size(); ++i) {
+		hash ^= (unsigned char)bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static void Usage()
+{
+	printf("Usage: hddm_s_merger_check [-n records] [-i file.hddm]"
+	       " [-o merged.hddm]\n");
+	exit(-1);
+}
+
+int main(int argc, char *argv[])
+{
+	int nrecords = 10000;
+	const char *infile = 0;
+	const char *outfile = 0;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			nrecords = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+			infile = argv[++i];
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			outfile = argv[++i];
+		else
+			Usage();
+	}
+
+	srand48(12345);
+	std::ostringstream merged;
+	hddm_s::ostream ostr(merged);
+
+	for (int i = 0; i < nrecords; ++i) {
+		hddm_s::HDDM dst;
+		hddm_s::HDDM src;
+		RandomRecord(dst, true);
+		RandomRecord(src, false);
+		Merge(dst, src);
+		ostr << dst;
+	}
+	printf("%d random records merged\n", nrecords);
+
+	if (infile) {
+		std::ifstream ifs(infile);
+		if (!ifs.is_open()) {
+			printf("cannot open %s\n", infile);
+			return -1;
+		}
+		hddm_s::istream istr(ifs);
+		hddm_s::HDDM record[2];
+		int nevents = 0;
+		istr >> record[0];
+		while (ifs.good()) {
+			hddm_s::HDDM &dst = record[nevents % 2];
+			hddm_s::HDDM &next = record[(nevents + 1) % 2];
+			next.clear();
+			istr >> next;
+			if (!ifs.good())
+				break;
+			hddm_s::HDDM src;
+			RandomRecord(src, false);
+			Merge(dst, next);
+			Merge(dst, src);
+			ostr << dst;
+			++nevents;
+		}
+		printf("%d events of %s merged\n", nevents, infile);
+	}
+
+	for (int kind = 0; kind < kNumChannelKinds; ++kind) {
+		Report(order[kind].nbad == 0 && order[kind].nlists > 0,
+		       "%-16s %7ld merged lists, %ld out of order or repeated",
+		       order[kind].name, order[kind].nlists, order[kind].nbad);
+	}
+
+	std::string bytes = merged.str();
+	printf("checksum %016llx of %lu bytes\n",
+	       (unsigned long long)Checksum(bytes), (unsigned long)bytes.size());
+	if (outfile) {
+		std::ofstream ofs(outfile);
+		ofs.write(bytes.data(), bytes.size());
+		if (!ofs.good()) {
+			printf("cannot write %s\n", outfile);
+			return -1;
+		}
+	}
+
+	return nfailed;
+}